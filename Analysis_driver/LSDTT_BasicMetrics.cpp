@@ -49,6 +49,7 @@
 #include <ctime>
 #include <sys/time.h>
 #include <fstream>
+#include <algorithm>
 #include "../LSDStatsTools.hpp"
 #include "../LSDRaster.hpp"
 #include "../LSDRasterInfo.hpp"
@@ -313,21 +314,6 @@ int main (int nNumberofArgs,char *argv[])
 
 
 
-  //============================================================================
-  // Compute hillshade and print
-  //============================================================================
-  if (this_bool_map["write_hillshade"])
-  {
-    cout << "Let me print the hillshade for you. " << endl;
-    float hs_azimuth = 315;
-    float hs_altitude = 45;
-    float hs_z_factor = 1;
-    LSDRaster hs_raster = topography_raster.hillshade(hs_altitude,hs_azimuth,hs_z_factor);
-
-    string hs_fname = OUT_DIR+OUT_ID+"_hs";
-    hs_raster.write_raster(hs_fname,raster_ext);
-  }
-
   //============================================================================
   // The surface fitting metrics
   //============================================================================
@@ -364,8 +350,102 @@ int main (int nNumberofArgs,char *argv[])
   {
     raster_selection[7] = 1;
   }
+
+  // The hillshade, and the slope, aspect and curvatures if the fitting window
+  // is just the 3x3 neighbourhood, come out of a single pass of the terrain
+  // kernel. The kernel returns slope and aspect in its first two rasters
+  // rather than after the smoothed elevation.
+  bool fit_in_kernel = (this_float_map["surface_fitting_radius"]
+                          <= sqrt(2)*topography_raster.get_DataResolution());
+  vector<int> kernel_selection(8, 0);
+  if (this_bool_map["write_hillshade"])
+  {
+    kernel_selection[2] = 1;
+  }
+  if (fit_in_kernel)
+  {
+    kernel_selection[0] = raster_selection[1];
+    kernel_selection[1] = raster_selection[2];
+    raster_selection[1] = 0;
+    raster_selection[2] = 0;
+    for (int k = 3; k<7; k++)
+    {
+      kernel_selection[k] = raster_selection[k];
+      raster_selection[k] = 0;
+    }
+  }
+  vector<LSDRaster> terrain_derivatives;
+  if (find(kernel_selection.begin(),kernel_selection.end(),1) != kernel_selection.end())
+  {
+    float hs_azimuth = 315;
+    float hs_altitude = 45;
+    float hs_z_factor = 1;
+    terrain_derivatives = topography_raster.calculate_terrain_derivatives(kernel_selection,
+                                              hs_altitude, hs_azimuth, hs_z_factor);
+  }
+
+  if (this_bool_map["write_hillshade"])
+  {
+    cout << "Let me print the hillshade for you. " << endl;
+    string hs_fname = OUT_DIR+OUT_ID+"_hs";
+    terrain_derivatives[2].write_raster(hs_fname,raster_ext);
+  }
+
   vector<LSDRaster> surface_fitting;
-  surface_fitting = topography_raster.calculate_polyfit_surface_metrics(this_float_map["surface_fitting_radius"], raster_selection);
+  if (find(raster_selection.begin(),raster_selection.end(),1) != raster_selection.end())
+  {
+    surface_fitting = topography_raster.calculate_polyfit_surface_metrics(this_float_map["surface_fitting_radius"], raster_selection);
+  }
+  else
+  {
+    surface_fitting.resize(8);
+  }
+  if (fit_in_kernel)
+  {
+    // polyfit rounds this window up to a 5x5 kernel, so it gives nodata on a
+    // two cell border and wherever there is nodata in the 5x5 window. The
+    // kernel only needs the 3x3 window, so mask its rasters to the same cells
+    // to keep the output the same as polyfit.
+    int NRows = topography_raster.get_NRows();
+    int NCols = topography_raster.get_NCols();
+    float NoDataValue = topography_raster.get_NoDataValue();
+    int polyfit_kr = 2;
+    Array2D<int> polyfit_nodata(NRows,NCols,0);
+    for (int row = 0; row<NRows; row++)
+    {
+      for (int col = 0; col<NCols; col++)
+      {
+        if (row < polyfit_kr || row >= NRows-polyfit_kr
+            || col < polyfit_kr || col >= NCols-polyfit_kr)
+        {
+          polyfit_nodata[row][col] = 1;
+        }
+        if (topography_raster.get_data_element(row,col) == NoDataValue)
+        {
+          // mark every cell whose window contains this one
+          for (int r = max(row-polyfit_kr,0); r<=min(row+polyfit_kr,NRows-1); r++)
+          {
+            for (int c = max(col-polyfit_kr,0); c<=min(col+polyfit_kr,NCols-1); c++)
+            {
+              polyfit_nodata[r][c] = 1;
+            }
+          }
+        }
+      }
+    }
+    LSDIndexRaster polyfit_mask(NRows,NCols,topography_raster.get_XMinimum(),
+                                topography_raster.get_YMinimum(),
+                                topography_raster.get_DataResolution(),
+                                int(NoDataValue),polyfit_nodata,
+                                topography_raster.get_GeoReferencingStrings());
+
+    if (kernel_selection[0] == 1)  surface_fitting[1] = terrain_derivatives[0].apply_mask(polyfit_mask);
+    if (kernel_selection[1] == 1)  surface_fitting[2] = terrain_derivatives[1].apply_mask(polyfit_mask);
+    for (int k = 3; k<7; k++)
+    {
+      if (kernel_selection[k] == 1)  surface_fitting[k] = terrain_derivatives[k].apply_mask(polyfit_mask);
+    }
+  }
   if(this_bool_map["print_smoothed_elevation"])
   {
     cout << "Let me print the smoothed elevation raster for you."  << endl;
@@ -519,7 +599,7 @@ int main (int nNumberofArgs,char *argv[])
     {
       cout << "I am writing dinf drainage area to raster." << endl;
       string DA_raster_name = OUT_DIR+OUT_ID+"_dinf_area";
-      LSDRaster DA1 = filled_topography.D_inf();
+      LSDRaster DA1 = filled_topography.D_inf(true);
       LSDRaster DA2 = DA1.D_inf_ConvertFlowToArea();
       DA2.write_raster(DA_raster_name,raster_ext);
     }
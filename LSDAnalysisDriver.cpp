@@ -53,8 +53,12 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <sstream>
+#include <iomanip>
+#include <stdint.h>
 #include "LSDStatsTools.hpp"
 #include "LSDRaster.hpp"
+#include "LSDCompressedRaster.hpp"
 #include "LSDAnalysisDriver.hpp"
 #include "LSDJunctionNetwork.hpp"
 #include "LSDChannel.hpp"
@@ -63,6 +67,20 @@ using namespace std;
 #ifndef LSDAnalysisDriver_CPP
 #define LSDAnalysisDriver_CPP
 
+namespace
+{
+  //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  // Formats a 64 bit hash (see fnv1a_hash in LSDStatsTools) as the hex string
+  // used to name derived product cache files
+  //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  string hash_to_hex(uint64_t hash)
+  {
+    ostringstream oss;
+    oss << hex << setw(16) << setfill('0') << hash;
+    return oss.str();
+  }
+}
+
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 // The default constructor. This asks the user for a pathname and
 // param filename
@@ -78,6 +96,9 @@ void LSDAnalysisDriver::create()
   got_flowinfo = false;
   got_polyfit = false;
   got_JunctionNetwork = false;
+  use_product_cache = false;
+  n_cache_hits = 0;
+  n_cache_misses = 0;
 
   ingest_data(pathname, param_fname);
 }
@@ -94,6 +115,9 @@ void LSDAnalysisDriver::create(string pname, string fname)
   got_flowinfo = false;
   got_polyfit = false;
   got_JunctionNetwork = false;
+  use_product_cache = false;
+  n_cache_hits = 0;
+  n_cache_misses = 0;
 
   ingest_data(pathname, param_fname);
 }
@@ -172,6 +196,22 @@ void LSDAnalysisDriver::ingest_data(string pname, string p_fname)
       //cout << "Got the read name, it is: " << read_fname << endl;
     }
 
+    //=-=-=-=-=-=--=-=-=-=-
+    // parameters for the derived product cache
+    //-=-=-=-=-=-=-=-=-=-=-=-
+    else if (lower == "use product cache")
+    {
+      use_product_cache = (value == "true") ? true : false;
+      cout << "You have set use of the derived product cache to "
+           << use_product_cache << endl;
+    }
+    else if (lower == "product cache path")
+    {
+      product_cache_path = value;
+      // get rid of any control characters from the end (if param file was made in DOS)
+      product_cache_path = RemoveControlCharactersFromEndOfString(product_cache_path);
+    }
+
     //=-=-=-=-=-=--=-=-=-=-
     // paramters for fill
     //-=-=-=-=-=-=-=-=-=-=-=-
@@ -552,6 +592,11 @@ void LSDAnalysisDriver::ingest_data(string pname, string p_fname)
        << "I am now moving on to writing the data. \n\n";
   write_rasters_from_analysis_switches();
 
+  if (use_product_cache)
+  {
+    print_product_cache_report();
+  }
+
   cout << "Well I guess I am all finished now. I sure hope you got what you wanted! Have a nice day." << endl;
 
 
@@ -1155,6 +1200,12 @@ void LSDAnalysisDriver::read_base_raster()
     cout << full_raster_name + "." + dem_read_extension << endl;
     LSDRaster BaseRaster(full_raster_name,dem_read_extension);
     map_of_LSDRasters["base_raster"] =  BaseRaster;
+
+    // the cache keys start from the contents of the DEM
+    if (use_product_cache)
+    {
+      base_raster_hash = hash_raster(BaseRaster);
+    }
   }
   else
   {
@@ -1187,6 +1238,19 @@ void LSDAnalysisDriver::fill_raster()
   // first check to see if it has already been calculated
   if(map_of_LSDRasters.find("fill") == map_of_LSDRasters.end())
   {
+    // see if an earlier run has already filled this DEM
+    LSDRaster cached_fill;
+    if (load_cached_product("fill", cached_fill))
+    {
+      // the sea removal also changes the base raster, so it still needs doing
+      if(method_map["fill_method"] == "remove_seas")
+      {
+        map_of_LSDRasters["base_raster"].remove_seas();
+      }
+      map_of_LSDRasters["fill"] = cached_fill;
+      return;
+    }
+
       cout << "Filling raster"  << endl;
   
     // check to see if a method has been designated
@@ -1208,6 +1272,7 @@ void LSDAnalysisDriver::fill_raster()
       LSDRaster temp_fill = map_of_LSDRasters["base_raster"].fill( float_parameters["min_slope_for_fill"] );
       map_of_LSDRasters["fill"] =  temp_fill;
     }
+    save_cached_product("fill", map_of_LSDRasters["fill"]);
   }
 
 
@@ -1233,9 +1298,14 @@ void LSDAnalysisDriver::calculate_trimmed_and_nodata_filled()
   
   if(map_of_LSDRasters.find("trimmed_hole_filled") == map_of_LSDRasters.end())
   {
-    LSDRaster temp_hole_filled = 
+    LSDRaster temp_hole_filled;
+    if (not load_cached_product("trimmed_hole_filled", temp_hole_filled))
+    {
+      temp_hole_filled =
         map_of_LSDRasters["base_raster"].alternating_direction_nodata_fill_with_trimmer( 
                     int(float_parameters["nodata_hole_filling_window_width"]));
+      save_cached_product("trimmed_hole_filled", temp_hole_filled);
+    }
     map_of_LSDRasters["trimmed_hole_filled"] = temp_hole_filled;
   }
   
@@ -1343,6 +1413,14 @@ void LSDAnalysisDriver::calculate_drainage_area()
       method_map["drainage_area_method"] = "dinf";
     }
 
+    // see if an earlier run has already calculated the area
+    LSDRaster cached_area;
+    if (load_cached_product("drainage_area", cached_area))
+    {
+      map_of_LSDRasters["drainage_area"] = cached_area;
+      return;
+    }
+
     // check to see if you need the flow info object
     if(method_map["drainage_area_method"] == "d8")
     {
@@ -1378,13 +1456,14 @@ void LSDAnalysisDriver::calculate_drainage_area()
       }
       else if(method_map["drainage_area_method"] == "dinf")
       {
-        map_of_LSDRasters["drainage_area"] = map_of_LSDRasters["fill"].D_inf_units();
+        map_of_LSDRasters["drainage_area"] = map_of_LSDRasters["fill"].D_inf_units(true);
       }
       else
       {
-        map_of_LSDRasters["drainage_area"] = map_of_LSDRasters["fill"].D_inf_units();
+        map_of_LSDRasters["drainage_area"] = map_of_LSDRasters["fill"].D_inf_units(true);
       }
     }
+    save_cached_product("drainage_area", map_of_LSDRasters["drainage_area"]);
   }
 }
 
@@ -1656,6 +1735,14 @@ void LSDAnalysisDriver::calculate_flowinfo()
   // first check to see if this already exists
   if (not got_flowinfo)
   {
+    // see if an earlier run has already calculated it. If so the fill is
+    // not needed at all
+    if (load_cached_flowinfo())
+    {
+      got_flowinfo = true;
+      return;
+    }
+
     // it doens't exist. Calculate it here.
     //cout << "LINE 457 Flow info doesn't exist. Getting it from the fill raster" << endl;
     // this requires the fill raster. See if it exists
@@ -1675,6 +1762,7 @@ void LSDAnalysisDriver::calculate_flowinfo()
     // set the data members
     FlowInfo = temp_FI;
     got_flowinfo = true;
+    save_cached_flowinfo();
     //cout << "LINE 715, got flowinfo" << endl;
   }
 }
@@ -1694,7 +1782,13 @@ void LSDAnalysisDriver::calculate_flow_distance()
       calculate_flowinfo();
     }
 
-    map_of_LSDRasters["flow_distance"] = FlowInfo.distance_from_outlet();
+    LSDRaster temp_FD;
+    if (not load_cached_product("flow_distance", temp_FD))
+    {
+      temp_FD = FlowInfo.distance_from_outlet();
+      save_cached_product("flow_distance", temp_FD);
+    }
+    map_of_LSDRasters["flow_distance"] = temp_FD;
   }
 }
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -1894,6 +1988,20 @@ void LSDAnalysisDriver::calculate_sources()
   // see if you've already got this raster
   if(map_of_LSDIndexRasters.find("sources") == map_of_LSDIndexRasters.end())
   {
+    // set to default if no parameters
+    if(float_parameters.find("pixel_threshold_for_channel_net") == float_parameters.end())
+    {
+      float_parameters["pixel_threshold_for_channel_net"] = 10;
+    }
+
+    // see if an earlier run has already found these sources
+    vector<int> cached_sources;
+    if (load_cached_product("sources", cached_sources))
+    {
+      integer_vector_map["sources"] = cached_sources;
+      return;
+    }
+
     // you don't have it. Calculate it here.
     // this requires the flow info object. See if it exists
     if(not got_flowinfo)
@@ -1910,17 +2018,12 @@ void LSDAnalysisDriver::calculate_sources()
       calculate_ContributingPixels();
     }
 
-    // set to default if no parameters
-    if(float_parameters.find("pixel_threshold_for_channel_net") == float_parameters.end())
-    {
-      float_parameters["pixel_threshold_for_channel_net"] = 10;
-    }
-
     int thres =   int(float_parameters["pixel_threshold_for_channel_net"]);
     vector<int> temp_sources = FlowInfo.get_sources_index_threshold(
         map_of_LSDIndexRasters["ContributingPixels"],thres);
 
     integer_vector_map["sources"] = temp_sources;
+    save_cached_product("sources", temp_sources);
     //cout << "LINE 841 Got the sources" << endl;
 
   }
@@ -2284,4 +2387,278 @@ string LSDAnalysisDriver::get_string_before_dot(string this_string)
 }
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// DERIVED PRODUCT CACHE
+// Expensive products (fill, flow info, drainage area...) are saved to disk
+// under a name made from a hash of everything that went into them: the
+// contents of the DEM and the parameters of each step on the way. A later
+// run that asks for the same product with the same inputs loads it instead
+// of calculating it, whatever else it has been asked to do.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Hashes the georeferencing and data of a raster
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+string LSDAnalysisDriver::hash_raster(LSDRaster& Raster)
+{
+  int NRows = Raster.get_NRows();
+  int NCols = Raster.get_NCols();
+  float georef[4] = { Raster.get_XMinimum(), Raster.get_YMinimum(),
+                      Raster.get_DataResolution(), float(Raster.get_NoDataValue()) };
+
+  uint64_t hash = fnv1a_hash(&NRows, sizeof(NRows));
+  hash = fnv1a_hash(&NCols, sizeof(NCols), hash);
+  hash = fnv1a_hash(georef, sizeof(georef), hash);
+
+  // the rows of an Array2D are one contiguous block
+  Array2D<float> data = Raster.get_RasterData();
+  if (NRows > 0 && NCols > 0)
+  {
+    hash = fnv1a_hash(&data[0][0], size_t(NRows)*size_t(NCols)*sizeof(float), hash);
+  }
+  return hash_to_hex(hash);
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Describes everything a product depends on. Products built from other
+// products include the description of those products, so changing the fill
+// slope, for example, changes the key of the flow info and everything after it.
+// Defaults are set here the same way the calculate functions set them.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+string LSDAnalysisDriver::get_product_description(string product)
+{
+  if (base_raster_hash.empty())
+  {
+    read_base_raster();
+    if (base_raster_hash.empty())
+    {
+      base_raster_hash = hash_raster(map_of_LSDRasters["base_raster"]);
+    }
+  }
+
+  ostringstream desc;
+  desc << setprecision(9) << product << "|";
+  if (product == "fill")
+  {
+    if(float_parameters.find("min_slope_for_fill") == float_parameters.end())
+    {
+      float_parameters["min_slope_for_fill"] = 0.0001;
+    }
+    desc << base_raster_hash << "|" << method_map["fill_method"] << "|"
+         << float_parameters["min_slope_for_fill"];
+  }
+  else if (product == "trimmed_hole_filled")
+  {
+    if(float_parameters.find("nodata_hole_filling_window_width") == float_parameters.end())
+    {
+      float_parameters["nodata_hole_filling_window_width"] = 1;
+    }
+    desc << base_raster_hash << "|" << float_parameters["nodata_hole_filling_window_width"];
+  }
+  else if (product == "flowinfo")
+  {
+    check_boundary_conditions();
+    desc << get_product_description("fill");
+    for (int i = 0; i<4; i++)
+    {
+      desc << "|" << boundary_conditions[i];
+    }
+  }
+  else if (product == "sources")
+  {
+    if(float_parameters.find("pixel_threshold_for_channel_net") == float_parameters.end())
+    {
+      float_parameters["pixel_threshold_for_channel_net"] = 10;
+    }
+    desc << get_product_description("flowinfo") << "|"
+         << int(float_parameters["pixel_threshold_for_channel_net"]);
+  }
+  else if (product == "drainage_area")
+  {
+    string method = method_map["drainage_area_method"];
+    desc << method << "|";
+    desc << ((method == "d8") ? get_product_description("flowinfo") : get_product_description("fill"));
+  }
+  else if (product == "flow_distance")
+  {
+    desc << get_product_description("flowinfo");
+  }
+  else
+  {
+    cout << "The derived product cache doesn't know about the product " << product << endl;
+    exit(EXIT_FAILURE);
+  }
+  return desc.str();
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// The path and name, without extension, of the cache file of a product
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+string LSDAnalysisDriver::get_product_cache_prefix(string product)
+{
+  if (product_cache_path.length() == 0)
+  {
+    product_cache_path = write_path;
+  }
+  product_cache_path = check_pathname_for_slash(product_cache_path);
+
+  string description = get_product_description(product);
+  uint64_t key = fnv1a_hash(description.data(), description.size());
+  return product_cache_path+"LSDCache_"+product+"_"+hash_to_hex(key);
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Keeps count of hits and misses and says what happened
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void LSDAnalysisDriver::record_cache_result(string product, string prefix, bool hit)
+{
+  string result = (hit) ? "hit" : "miss";
+  if (hit)
+  {
+    n_cache_hits++;
+  }
+  else
+  {
+    n_cache_misses++;
+  }
+  cout << "Product cache " << result << " for " << product << ": " << prefix << endl;
+  product_cache_log.push_back(product+" "+result+" "+prefix);
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Loads a raster product. Rasters are kept in the tiled compressed format.
+// Every tile is checked against the checksum in the tile table first, so a
+// truncated or damaged file counts as a miss and the product is recalculated.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+bool LSDAnalysisDriver::load_cached_product(string product, LSDRaster& Product)
+{
+  if (not use_product_cache)
+  {
+    return false;
+  }
+  string prefix = get_product_cache_prefix(product);
+  bool hit = LSDCompressedRasterReader::is_intact(prefix+".lsdc");
+  record_cache_result(product, prefix, hit);
+  if (hit)
+  {
+    LSDRaster cached_raster(prefix, "lsdc");
+    Product = cached_raster;
+  }
+  return hit;
+}
+
+void LSDAnalysisDriver::save_cached_product(string product, LSDRaster& Product)
+{
+  if (use_product_cache)
+  {
+    Product.write_raster(get_product_cache_prefix(product), "lsdc");
+  }
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Loads an integer vector product, such as the sources. The file is the
+// number of values, the values, and a hash of the values.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+bool LSDAnalysisDriver::load_cached_product(string product, vector<int>& Product)
+{
+  if (not use_product_cache)
+  {
+    return false;
+  }
+  string prefix = get_product_cache_prefix(product);
+  string fname = prefix+".ivec";
+  ifstream vec_in(fname.c_str(), ios::in | ios::binary);
+
+  bool hit = false;
+  uint32_t n_values = 0;
+  vector<int> values;
+  if (vec_in.read(reinterpret_cast<char*>(&n_values), sizeof(n_values)))
+  {
+    values.resize(n_values);
+    uint64_t stored_hash = 0;
+    if (n_values > 0)
+    {
+      vec_in.read(reinterpret_cast<char*>(&values[0]), streamsize(n_values*sizeof(int)));
+    }
+    vec_in.read(reinterpret_cast<char*>(&stored_hash), sizeof(stored_hash));
+    uint64_t hash = (n_values > 0) ?
+        fnv1a_hash(&values[0], n_values*sizeof(int)) : FNV1A_OFFSET_BASIS;
+    hit = (not vec_in.fail()) && hash == stored_hash;
+  }
+  vec_in.close();
+
+  record_cache_result(product, prefix, hit);
+  if (hit)
+  {
+    Product = values;
+  }
+  return hit;
+}
+
+void LSDAnalysisDriver::save_cached_product(string product, vector<int>& Product)
+{
+  if (use_product_cache)
+  {
+    string fname = get_product_cache_prefix(product)+".ivec";
+    ofstream vec_out(fname.c_str(), ios::out | ios::binary);
+    uint32_t n_values = uint32_t(Product.size());
+    uint64_t hash = FNV1A_OFFSET_BASIS;
+    vec_out.write(reinterpret_cast<const char*>(&n_values), sizeof(n_values));
+    if (n_values > 0)
+    {
+      vec_out.write(reinterpret_cast<const char*>(&Product[0]), streamsize(n_values*sizeof(int)));
+      hash = fnv1a_hash(&Product[0], n_values*sizeof(int), hash);
+    }
+    vec_out.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    vec_out.close();
+  }
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Loads the flow info object from its binary file. A missing or damaged file
+// is a miss and leaves the FlowInfo object alone.
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+bool LSDAnalysisDriver::load_cached_flowinfo()
+{
+  if (not use_product_cache)
+  {
+    return false;
+  }
+  string prefix = get_product_cache_prefix("flowinfo");
+  bool hit = FlowInfo.unpickle_binary(prefix);
+  record_cache_result("flowinfo", prefix, hit);
+  return hit;
+}
+
+void LSDAnalysisDriver::save_cached_flowinfo()
+{
+  if (use_product_cache)
+  {
+    FlowInfo.pickle_binary(get_product_cache_prefix("flowinfo"));
+  }
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Prints the hits and misses of this run
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void LSDAnalysisDriver::print_product_cache_report()
+{
+  cout << "=========================================================" << endl;
+  cout << "Derived product cache in " << product_cache_path << endl;
+  cout << "Hits: " << n_cache_hits << " Misses: " << n_cache_misses << endl;
+  for (int i = 0; i< int(product_cache_log.size()); i++)
+  {
+    cout << "  " << product_cache_log[i] << endl;
+  }
+  cout << "=========================================================" << endl;
+}
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
 #endif
@@ -289,6 +289,90 @@ class LSDAnalysisDriver
     /// @date 29/07/2014
     string get_string_before_dot(string this_string);
 
+    //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+    //
+    // Derived product cache
+    //
+    //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+    /// @brief This hashes the georeferencing and data of a raster
+    /// @param Raster the raster
+    /// @return the hash as 16 hex digits
+    /// @author agent
+    /// @date 16/10/2026
+    string hash_raster(LSDRaster& Raster);
+
+    /// @brief This describes everything a derived product depends on: the hash
+    /// of the DEM and the parameters of every step that leads to the product
+    /// @param product the name of the product: fill, trimmed_hole_filled,
+    /// flowinfo, sources, drainage_area or flow_distance
+    /// @return the description
+    /// @author agent
+    /// @date 16/10/2026
+    string get_product_description(string product);
+
+    /// @brief This gets the path and name, without extension, of the cache
+    /// file of a product. The name contains a hash of the product description.
+    /// @param product the name of the product
+    /// @return the prefix of the cache file
+    /// @author agent
+    /// @date 16/10/2026
+    string get_product_cache_prefix(string product);
+
+    /// @brief This counts and reports a cache hit or miss
+    /// @param product the name of the product
+    /// @param prefix the cache file prefix
+    /// @param hit true for a hit
+    /// @author agent
+    /// @date 16/10/2026
+    void record_cache_result(string product, string prefix, bool hit);
+
+    /// @brief This loads a raster product from the cache
+    /// @param product the name of the product
+    /// @param Product the raster. Replaced in function on a hit.
+    /// @return true on a hit. Always false if the cache is not in use.
+    /// @author agent
+    /// @date 16/10/2026
+    bool load_cached_product(string product, LSDRaster& Product);
+
+    /// @brief This saves a raster product to the cache, if the cache is in use
+    /// @param product the name of the product
+    /// @param Product the raster
+    /// @author agent
+    /// @date 16/10/2026
+    void save_cached_product(string product, LSDRaster& Product);
+
+    /// @brief This loads an integer vector product (e.g. sources) from the cache
+    /// @param product the name of the product
+    /// @param Product the vector. Replaced in function on a hit.
+    /// @return true on a hit. Always false if the cache is not in use.
+    /// @author agent
+    /// @date 16/10/2026
+    bool load_cached_product(string product, vector<int>& Product);
+
+    /// @brief This saves an integer vector product to the cache, if the cache is in use
+    /// @param product the name of the product
+    /// @param Product the vector
+    /// @author agent
+    /// @date 16/10/2026
+    void save_cached_product(string product, vector<int>& Product);
+
+    /// @brief This loads the FlowInfo data member from the cache
+    /// @return true on a hit. Always false if the cache is not in use.
+    /// @author agent
+    /// @date 16/10/2026
+    bool load_cached_flowinfo();
+
+    /// @brief This saves the FlowInfo data member to the cache, if the cache is in use
+    /// @author agent
+    /// @date 16/10/2026
+    void save_cached_flowinfo();
+
+    /// @brief This prints the cache hits and misses of this run
+    /// @author agent
+    /// @date 16/10/2026
+    void print_product_cache_report();
+
 
     //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
     //
@@ -336,6 +420,25 @@ class LSDAnalysisDriver
     /// file prefix of files to be written. Default is the param name prefix 
     string read_fname;       
 
+    /// If true, expensive products are loaded from and saved to the derived
+    /// product cache
+    bool use_product_cache;
+
+    /// Path to the derived product cache. Default is write_path
+    string product_cache_path;
+
+    /// Hash of the base raster, which starts the key of every cached product
+    string base_raster_hash;
+
+    /// Number of products loaded from the cache
+    int n_cache_hits;
+
+    /// Number of products that were not in the cache
+    int n_cache_misses;
+
+    /// One line for each cache lookup, for the report
+    vector<string> product_cache_log;
+
     //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=--=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
     //
     // Parameters for various analyses
@@ -65,6 +65,7 @@
 #include "LSDBasin.hpp"
 #include "LSDParticle.hpp"
 #include "LSDCRNParameters.hpp"
+#include "LSDCRNKernel.hpp"
 using namespace std;
 using namespace TNT;
 
@@ -220,7 +221,7 @@ void LSDBasin::create(int JunctionNumber, LSDFlowInfo& FlowInfo, LSDJunctionNetw
 // Calculate mean basin value.
 // SWDG 12/12/13
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-float LSDBasin::CalculateBasinMean(LSDFlowInfo& FlowInfo, LSDRaster Data){
+float LSDBasin::CalculateBasinMean(LSDFlowInfo& FlowInfo, LSDRaster& Data){
 
   int i;
   int j;
@@ -440,7 +441,7 @@ float LSDBasin::CalculateBasinStdError(LSDFlowInfo& FlowInfo, LSDRaster Data){
 // Calculate basin range.
 // SWDG 17/2/14
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-float LSDBasin::CalculateBasinRange(LSDFlowInfo& FlowInfo, LSDRaster Data){
+float LSDBasin::CalculateBasinRange(LSDFlowInfo& FlowInfo, LSDRaster& Data){
 
   int i;
   int j;
@@ -2789,27 +2790,38 @@ void LSDCosmoBasin::populate_scaling_vectors(LSDFlowInfo& FlowInfo,
   // decalre converter object
   LSDCoordinateConverterLLandUTM Converter;
 
+  // first get the location and elevation of every pixel with data so that
+  // the pressures can be interpolated in one batch
+  vector<double> lat_vec, long_vec, elev_vec;
   for (int q = 0; q < int(BasinNodes.size()); ++q)
   {
-
     FlowInfo.retrieve_current_row_and_col(BasinNodes[q], row, col);
-
-    //exclude NDV from average
     if (Elevation_Data.get_data_element(row,col) != NoDataValue)
     {
       // To get pressure, first get the lat and long
       Elevation_Data.get_lat_and_long_locations(row, col, lat, longitude, Converter);
-      //Elevation_Data.get_lat_and_long_locations(row, col, lat, longitude);
+      lat_vec.push_back(double(lat));
+      long_vec.push_back(double(longitude));
 
       // now the elevation
       this_elevation = Elevation_Data.get_data_element(row,col);
+      elev_vec.push_back(double(this_elevation));
+    }
+  }
+  vector<double> pressure_vec = LSDCRNP.NCEPatm_2(lat_vec, long_vec, elev_vec);
 
-      // now the pressure
-      this_pressure = LSDCRNP.NCEPatm_2(double(lat), double(longitude),
-                                        double(this_elevation));
+  int n_data = 0;
+  for (int q = 0; q < int(BasinNodes.size()); ++q)
+  {
 
-      //cout << "r: " << row << " c: " << col << " lat: " << lat << " long: " << longitude
-      //     << " elevation: " << this_elevation << " pressure: " << this_pressure << endl;
+    FlowInfo.retrieve_current_row_and_col(BasinNodes[q], row, col);
+
+    //exclude NDV from average
+    if (Elevation_Data.get_data_element(row,col) != NoDataValue)
+    {
+      lat = lat_vec[n_data];
+      this_pressure = pressure_vec[n_data];
+      n_data++;
 
       // now get the scaling
       prod_temp.push_back(LSDCRNP.stone2000sp(lat,this_pressure, Fsp));
@@ -2873,27 +2885,38 @@ void LSDCosmoBasin::populate_scaling_vectors(LSDFlowInfo& FlowInfo,
   // decalre converter object
   LSDCoordinateConverterLLandUTM Converter;
 
+  // first get the location and elevation of every pixel with data so that
+  // the pressures can be interpolated in one batch
+  vector<double> lat_vec, long_vec, elev_vec;
   for (int q = 0; q < int(BasinNodes.size()); ++q)
   {
-
     FlowInfo.retrieve_current_row_and_col(BasinNodes[q], row, col);
-
-    //exclude NDV from average
     if (Elevation_Data.get_data_element(row,col) != NoDataValue)
     {
       // To get pressure, first get the lat and long
       Elevation_Data.get_lat_and_long_locations(row, col, lat, longitude, Converter);
-      //Elevation_Data.get_lat_and_long_locations(row, col, lat, longitude);
+      lat_vec.push_back(double(lat));
+      long_vec.push_back(double(longitude));
 
       // now the elevation
       this_elevation = Elevation_Data.get_data_element(row,col);
+      elev_vec.push_back(double(this_elevation));
+    }
+  }
+  vector<double> pressure_vec = LSDCRNP.NCEPatm_2(lat_vec, long_vec, elev_vec);
 
-      // now the pressure
-      this_pressure = LSDCRNP.NCEPatm_2(double(lat), double(longitude),
-                                        double(this_elevation));
+  int n_data = 0;
+  for (int q = 0; q < int(BasinNodes.size()); ++q)
+  {
 
-      //cout << "r: " << row << " c: " << col << " lat: " << lat << " long: " << longitude
-      //     << " elevation: " << this_elevation << " pressure: " << this_pressure << endl;
+    FlowInfo.retrieve_current_row_and_col(BasinNodes[q], row, col);
+
+    //exclude NDV from average
+    if (Elevation_Data.get_data_element(row,col) != NoDataValue)
+    {
+      lat = lat_vec[n_data];
+      this_pressure = pressure_vec[n_data];
+      n_data++;
 
 
       // now get the scaling
@@ -3185,14 +3208,7 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis(double Nuclide_conc, str
   double dEdExternal;             // change in erosion rate for change in AMS atoms/g
   double External_uncert;         // uncertainty of effective erosion rate g/cm^2/yr for AMS
 
-
-  double production_uncertainty;  // a lumped production uncertainty value.
-                                  // not generally used but needs to be passed
-                                  // to the erosion finding routines as a parameter
-
   // variables for the muon uncertainty
-  double average_production_rate; // The average production rate, used in uncertainty
-                                  // calculations
   double erate_muon_scheme_schaller;  // erosion rate using schaller scheme
   double erate_muon_scheme_braucher;  // erosion rate using braucher scheme
 
@@ -3210,39 +3226,10 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis(double Nuclide_conc, str
 
   double this_prod_difference; // the difference in production for production uncertainty
 
-  // initially we do not modify production rates
-  bool is_production_uncertainty_plus_on = false;
-  bool is_production_uncertainty_minus_on = false;
-
-  // first get the prediction of the erosion rate
-  erate = predict_CRN_erosion(Nuclide_conc, Nuclide, prod_uncert_factor,
-                              Muon_scaling, production_uncertainty,
-                              average_production_rate,
-                              is_production_uncertainty_plus_on,
-                              is_production_uncertainty_minus_on);
-
   double no_prod_uncert = 1.0;    // set the scheme to no production uncertainty
-                                  // for the external uncertainty
-  // now get the external uncertainty
-  erate_external_plus = predict_CRN_erosion(Nuclide_conc+Nuclide_conc_err, Nuclide,
-                                             no_prod_uncert, Muon_scaling,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on);
-  erate_external_minus = predict_CRN_erosion(Nuclide_conc-Nuclide_conc_err, Nuclide,
-                                             no_prod_uncert, Muon_scaling,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on);
-  dEdExternal = (erate_external_plus-erate_external_minus)/(2*Nuclide_conc_err);
-  External_uncert = fabs(dEdExternal*Nuclide_conc_err);
-
-  //cout << "LSDCosmoBasin, line 1160, erate: " << erate << " and uncertainty: "
-  //     << External_uncert << endl;
+                                  // for the uncertainty inversions
 
-  // now calculate uncertainty from different muon scaling schemes.
+  // The uncertainty from different muon scaling schemes.
   // The end members are Braucher and Schaller
   string braucher_string = "Braucher";
   string schaller_string = "Schaller";
@@ -3268,28 +3255,6 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis(double Nuclide_conc, str
     this_muon_uncert_dif = muon_uncert_diff[0];
   }
 
-  // now get the muon uncertainty
-  erate_muon_scheme_schaller = predict_CRN_erosion(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, schaller_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on);
-  erate_muon_scheme_braucher = predict_CRN_erosion(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, braucher_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on);
-  dEdMuonScheme = (erate_muon_scheme_schaller-erate_muon_scheme_braucher)/
-                  this_muon_uncert_dif;
-  Muon_uncert = fabs(dEdMuonScheme*this_muon_uncert_dif);
-
-  //cout << "LSDCosmoBasin, Line 1292, change in scaling production rate: "
-  //     << this_muon_uncert_dif << " erate Schal: "
-  //     << erate_muon_scheme_schaller << " erate Braucher: "
-  //     << erate_muon_scheme_braucher << " and erate uncert: " << Muon_uncert << endl;
-
   // now get the production uncertainty
   // first set the scaling
   // reset scaling parameters. This is necessary since the F values are
@@ -3330,45 +3295,73 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis(double Nuclide_conc, str
     prod = LSDCRNP.set_P0_CRONUS_uncertainty_minus();
     prod_minus = prod[0];
   }
-  else if (Nuclide == "Al26")
+  else
   {
     prod = LSDCRNP.set_P0_CRONUS_uncertainty_plus();
     prod_plus = prod[1];
     prod = LSDCRNP.set_P0_CRONUS_uncertainty_minus();
     prod_minus = prod[1];
   }
-  else
-  {
-    cout << "You didn't give a valid nuclide. You chose: " << Nuclide << endl;
-    cout << "Choices are 10Be, 26Al.  Note these case sensitive and cannot" << endl;
-    cout << "contain spaces or control characters. Defaulting to 10Be." << endl;
-    prod = LSDCRNP.set_P0_CRONUS_uncertainty_plus();
-    prod_plus = prod[0];
-    prod = LSDCRNP.set_P0_CRONUS_uncertainty_minus();
-    prod_minus = prod[0];
-  }
   //cout << "Prod plus: " << prod_plus << " prod minus: " << prod_minus << endl;
   this_prod_difference = prod_plus+prod_minus;
 
+  // The erosion rate and the six inversions used for its uncertainty:
+  // the concentration plus and minus the AMS uncertainty, the Schaller and
+  // Braucher muon schemes and the production plus and minus its uncertainty.
+  // They do not depend on each other so they are prepared in parallel (in
+  // turn if the samples are already being run in parallel) and then their
+  // Newton-Raphson iterations are advanced together.
+  const int n_inversions = 7;
+  double inversion_conc[n_inversions] = {Nuclide_conc, Nuclide_conc+Nuclide_conc_err,
+                                         Nuclide_conc-Nuclide_conc_err, Nuclide_conc,
+                                         Nuclide_conc, Nuclide_conc, Nuclide_conc};
+  double inversion_prod_uncert_factor[n_inversions] = {prod_uncert_factor, no_prod_uncert,
+                                         no_prod_uncert, no_prod_uncert, no_prod_uncert,
+                                         no_prod_uncert, no_prod_uncert};
+  string inversion_muon_scaling[n_inversions] = {Muon_scaling, Muon_scaling, Muon_scaling,
+                                         schaller_string, braucher_string,
+                                         schaller_string, schaller_string};
+  bool inversion_plus_on[n_inversions] = {false,false,false,false,false,true,false};
+  bool inversion_minus_on[n_inversions] = {false,false,false,false,false,false,true};
+
+  vector<double> inversion_conc_vec(inversion_conc, inversion_conc+n_inversions);
+  vector<double> inversion_prod_uncert_vec(inversion_prod_uncert_factor,
+                                           inversion_prod_uncert_factor+n_inversions);
+  vector<string> inversion_muon_scaling_vec(inversion_muon_scaling,
+                                            inversion_muon_scaling+n_inversions);
+  vector<bool> inversion_plus_on_vec(inversion_plus_on, inversion_plus_on+n_inversions);
+  vector<bool> inversion_minus_on_vec(inversion_minus_on, inversion_minus_on+n_inversions);
+  vector<double> inversion_erate = predict_CRN_erosion(inversion_conc_vec, Nuclide,
+                                 inversion_prod_uncert_vec,
+                                 inversion_muon_scaling_vec,
+                                 inversion_plus_on_vec,
+                                 inversion_minus_on_vec);
+  erate = inversion_erate[0];
+  erate_external_plus = inversion_erate[1];
+  erate_external_minus = inversion_erate[2];
+  erate_muon_scheme_schaller = inversion_erate[3];
+  erate_muon_scheme_braucher = inversion_erate[4];
+  erate_prod_plus = inversion_erate[5];
+  erate_prod_minus = inversion_erate[6];
+
+  // now get the external uncertainty
+  dEdExternal = (erate_external_plus-erate_external_minus)/(2*Nuclide_conc_err);
+  External_uncert = fabs(dEdExternal*Nuclide_conc_err);
+
+  //cout << "LSDCosmoBasin, line 1160, erate: " << erate << " and uncertainty: "
+  //     << External_uncert << endl;
+
+  // now get the muon uncertainty
+  dEdMuonScheme = (erate_muon_scheme_schaller-erate_muon_scheme_braucher)/
+                  this_muon_uncert_dif;
+  Muon_uncert = fabs(dEdMuonScheme*this_muon_uncert_dif);
 
-  is_production_uncertainty_plus_on = true;
-  is_production_uncertainty_minus_on = false;
-  erate_prod_plus = predict_CRN_erosion(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, schaller_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on);
-
-  is_production_uncertainty_plus_on = false;
-  is_production_uncertainty_minus_on = true;
-  erate_prod_minus = predict_CRN_erosion(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, schaller_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on);
+  //cout << "LSDCosmoBasin, Line 1292, change in scaling production rate: "
+  //     << this_muon_uncert_dif << " erate Schal: "
+  //     << erate_muon_scheme_schaller << " erate Braucher: "
+  //     << erate_muon_scheme_braucher << " and erate uncert: " << Muon_uncert << endl;
 
+  // now get the production uncertainty
   dEdProduction = (erate_prod_plus-erate_prod_minus)/
                    this_prod_difference;
   Prod_uncert = fabs(dEdProduction*this_prod_difference);
@@ -3415,14 +3408,7 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis_nested(LSDRaster& known_
   double dEdExternal;             // change in erosion rate for change in AMS atoms/g
   double External_uncert;         // uncertainty of effective erosion rate g/cm^2/yr for AMS
 
-
-  double production_uncertainty;  // a lumped production uncertainty value.
-                                  // not generally used but needs to be passed
-                                  // to the erosion finding routines as a parameter
-
   // variables for the muon uncertainty
-  double average_production_rate; // The average production rate, used in uncertainty
-                                  // calculations
   double erate_muon_scheme_schaller;  // erosion rate using schaller scheme
   double erate_muon_scheme_braucher;  // erosion rate using braucher scheme
 
@@ -3440,44 +3426,10 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis_nested(LSDRaster& known_
 
   double this_prod_difference; // the difference in production for production uncertainty
 
-  // initially we do not modify production rates
-  bool is_production_uncertainty_plus_on = false;
-  bool is_production_uncertainty_minus_on = false;
-
-  // first get the prediction of the erosion rate
-  erate = predict_CRN_erosion_nested(Nuclide_conc, Nuclide, prod_uncert_factor,
-                              Muon_scaling, production_uncertainty,
-                              average_production_rate,
-                              is_production_uncertainty_plus_on,
-                              is_production_uncertainty_minus_on,
-                              known_eff_erosion, FlowInfo);
-
-  cout << "Hey Bubba, I got the erosion rate!!!: " << erate << endl << endl << endl;
-
   double no_prod_uncert = 1.0;    // set the scheme to no production uncertainty
-                                  // for the external uncertainty
-  // now get the external uncertainty
-  erate_external_plus = predict_CRN_erosion_nested(Nuclide_conc+Nuclide_conc_err, Nuclide,
-                                             no_prod_uncert, Muon_scaling,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on,
-                                             known_eff_erosion, FlowInfo);
-  erate_external_minus = predict_CRN_erosion_nested(Nuclide_conc-Nuclide_conc_err, Nuclide,
-                                             no_prod_uncert, Muon_scaling,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on,
-                                             known_eff_erosion, FlowInfo);
-  dEdExternal = (erate_external_plus-erate_external_minus)/(2*Nuclide_conc_err);
-  External_uncert = fabs(dEdExternal*Nuclide_conc_err);
+                                  // for the uncertainty inversions
 
-  //cout << "LSDCosmoBasin, line 1160, erate: " << erate << " and uncertainty: "
-  //     << External_uncert << endl;
-
-  // now calculate uncertainty from different muon scaling schemes.
+  // The uncertainty from different muon scaling schemes.
   // The end members are Braucher and Schaller
   string braucher_string = "Braucher";
   string schaller_string = "Schaller";
@@ -3503,30 +3455,6 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis_nested(LSDRaster& known_
     this_muon_uncert_dif = muon_uncert_diff[0];
   }
 
-  // now get the muon uncertainty
-  erate_muon_scheme_schaller = predict_CRN_erosion_nested(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, schaller_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on,
-                                             known_eff_erosion, FlowInfo);
-  erate_muon_scheme_braucher = predict_CRN_erosion_nested(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, braucher_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on,
-                                             known_eff_erosion, FlowInfo);
-  dEdMuonScheme = (erate_muon_scheme_schaller-erate_muon_scheme_braucher)/
-                  this_muon_uncert_dif;
-  Muon_uncert = fabs(dEdMuonScheme*this_muon_uncert_dif);
-
-  //cout << "LSDCosmoBasin, Line 1292, change in scaling production rate: "
-  //     << this_muon_uncert_dif << " erate Schal: "
-  //     << erate_muon_scheme_schaller << " erate Braucher: "
-  //     << erate_muon_scheme_braucher << " and erate uncert: " << Muon_uncert << endl;
-
   // now get the production uncertainty
   // first set the scaling
   // reset scaling parameters. This is necessary since the F values are
@@ -3567,47 +3495,76 @@ vector<double> LSDCosmoBasin::full_CRN_erosion_analysis_nested(LSDRaster& known_
     prod = LSDCRNP.set_P0_CRONUS_uncertainty_minus();
     prod_minus = prod[0];
   }
-  else if (Nuclide == "Al26")
+  else
   {
     prod = LSDCRNP.set_P0_CRONUS_uncertainty_plus();
     prod_plus = prod[1];
     prod = LSDCRNP.set_P0_CRONUS_uncertainty_minus();
     prod_minus = prod[1];
   }
-  else
-  {
-    cout << "You didn't give a valid nuclide. You chose: " << Nuclide << endl;
-    cout << "Choices are 10Be, 26Al.  Note these case sensitive and cannot" << endl;
-    cout << "contain spaces or control characters. Defaulting to 10Be." << endl;
-    prod = LSDCRNP.set_P0_CRONUS_uncertainty_plus();
-    prod_plus = prod[0];
-    prod = LSDCRNP.set_P0_CRONUS_uncertainty_minus();
-    prod_minus = prod[0];
-  }
   //cout << "Prod plus: " << prod_plus << " prod minus: " << prod_minus << endl;
   this_prod_difference = prod_plus+prod_minus;
 
+  // The erosion rate and the six inversions used for its uncertainty:
+  // the concentration plus and minus the AMS uncertainty, the Schaller and
+  // Braucher muon schemes and the production plus and minus its uncertainty.
+  // They do not depend on each other so they are prepared in parallel (in
+  // turn if the samples are already being run in parallel) and then their
+  // Newton-Raphson iterations are advanced together.
+  const int n_inversions = 7;
+  double inversion_conc[n_inversions] = {Nuclide_conc, Nuclide_conc+Nuclide_conc_err,
+                                         Nuclide_conc-Nuclide_conc_err, Nuclide_conc,
+                                         Nuclide_conc, Nuclide_conc, Nuclide_conc};
+  double inversion_prod_uncert_factor[n_inversions] = {prod_uncert_factor, no_prod_uncert,
+                                         no_prod_uncert, no_prod_uncert, no_prod_uncert,
+                                         no_prod_uncert, no_prod_uncert};
+  string inversion_muon_scaling[n_inversions] = {Muon_scaling, Muon_scaling, Muon_scaling,
+                                         schaller_string, braucher_string,
+                                         schaller_string, schaller_string};
+  bool inversion_plus_on[n_inversions] = {false,false,false,false,false,true,false};
+  bool inversion_minus_on[n_inversions] = {false,false,false,false,false,false,true};
+
+  vector<double> inversion_conc_vec(inversion_conc, inversion_conc+n_inversions);
+  vector<double> inversion_prod_uncert_vec(inversion_prod_uncert_factor,
+                                           inversion_prod_uncert_factor+n_inversions);
+  vector<string> inversion_muon_scaling_vec(inversion_muon_scaling,
+                                            inversion_muon_scaling+n_inversions);
+  vector<bool> inversion_plus_on_vec(inversion_plus_on, inversion_plus_on+n_inversions);
+  vector<bool> inversion_minus_on_vec(inversion_minus_on, inversion_minus_on+n_inversions);
+  vector<double> inversion_erate = predict_CRN_erosion_nested(inversion_conc_vec, Nuclide,
+                                 inversion_prod_uncert_vec,
+                                 inversion_muon_scaling_vec,
+                                 inversion_plus_on_vec,
+                                 inversion_minus_on_vec,
+                                 known_eff_erosion, FlowInfo);
+  erate = inversion_erate[0];
+  erate_external_plus = inversion_erate[1];
+  erate_external_minus = inversion_erate[2];
+  erate_muon_scheme_schaller = inversion_erate[3];
+  erate_muon_scheme_braucher = inversion_erate[4];
+  erate_prod_plus = inversion_erate[5];
+  erate_prod_minus = inversion_erate[6];
+
+  cout << "Hey Bubba, I got the erosion rate!!!: " << erate << endl << endl << endl;
+
+  // now get the external uncertainty
+  dEdExternal = (erate_external_plus-erate_external_minus)/(2*Nuclide_conc_err);
+  External_uncert = fabs(dEdExternal*Nuclide_conc_err);
 
-  is_production_uncertainty_plus_on = true;
-  is_production_uncertainty_minus_on = false;
-  erate_prod_plus = predict_CRN_erosion_nested(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, schaller_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on,
-                                             known_eff_erosion, FlowInfo);
-
-  is_production_uncertainty_plus_on = false;
-  is_production_uncertainty_minus_on = true;
-  erate_prod_minus = predict_CRN_erosion_nested(Nuclide_conc, Nuclide,
-                                             no_prod_uncert, schaller_string,
-                                             production_uncertainty,
-                                             average_production_rate,
-                                             is_production_uncertainty_plus_on,
-                                             is_production_uncertainty_minus_on,
-                                             known_eff_erosion, FlowInfo);
+  //cout << "LSDCosmoBasin, line 1160, erate: " << erate << " and uncertainty: "
+  //     << External_uncert << endl;
+
+  // now get the muon uncertainty
+  dEdMuonScheme = (erate_muon_scheme_schaller-erate_muon_scheme_braucher)/
+                  this_muon_uncert_dif;
+  Muon_uncert = fabs(dEdMuonScheme*this_muon_uncert_dif);
 
+  //cout << "LSDCosmoBasin, Line 1292, change in scaling production rate: "
+  //     << this_muon_uncert_dif << " erate Schal: "
+  //     << erate_muon_scheme_schaller << " erate Braucher: "
+  //     << erate_muon_scheme_braucher << " and erate uncert: " << Muon_uncert << endl;
+
+  // now get the production uncertainty
   dEdProduction = (erate_prod_plus-erate_prod_minus)/
                    this_prod_difference;
   Prod_uncert = fabs(dEdProduction*this_prod_difference);
@@ -3829,9 +3786,9 @@ double LSDCosmoBasin::predict_CRN_erosion(double Nuclide_conc, string Nuclide,
   // now using this as the initial guess, use Newton-Raphson to zero in on the
   // correct erosion rate
   double eff_e_new = eff_erate_guess; // the erosion rate upon which we iterate
-  double eff_e_change;                // the change in erosion rate between iterations
   double tolerance = 1e-10;           // tolerance for a change in the erosion rate
                                       // between Newton-Raphson iterations
+  int max_steps = 200;                // the most Newton-Raphson iterations
   double eff_e_displace = 1e-6;       // A small displacment in the erosion rate used
                                       // to calculate the derivative
   double N_this_step;                 // the concentration of the nuclide reported this step
@@ -3848,12 +3805,30 @@ double LSDCosmoBasin::predict_CRN_erosion(double Nuclide_conc, string Nuclide,
   double this_step_average_production;// the average production rate for this step
   double displace_average_production; // aveage production for the displace step
 
-  do
+  // With effective depth driven shielding the concentrations come from a
+  // kernel that does everything that does not depend on the erosion rate once,
+  // before the iterations
+  bool use_eff_depth_shielding = (self_shield_eff_depth.size() >= 1 ||
+                                  snow_shield_eff_depth.size() >= 1);
+  LSDCRNConcentrationKernel ConcKernel;
+  if (use_eff_depth_shielding)
   {
-    // get the new values
-    //cout << "Taking a step, eff_e: " << eff_e_new << " data_outlet? " <<  data_from_outlet_only;
-    if(self_shield_eff_depth.size() < 1 && snow_shield_eff_depth.size() < 1)
+    ConcKernel = LSDCRNConcentrationKernel(production_scaling, topographic_shielding,
+                                           snow_shield_eff_depth, self_shield_eff_depth,
+                                           NoDataValue, Nuclide, Muon_scaling, prod_uncert_factor,
+                                           is_production_uncertainty_plus_on,
+                                           is_production_uncertainty_minus_on);
+  }
+
+  if(!use_eff_depth_shielding)
+  {
+    // The derivative comes from a displaced erosion rate. The steps are
+    // Newton-Raphson steps kept within a bracket around the root.
+    LSDCRNErosionRoot ErosionRoot(Nuclide_conc, eff_e_new);
+    do
     {
+      // get the new values
+      //cout << "Taking a step, eff_e: " << eff_e_new << " data_outlet? " <<  data_from_outlet_only;
       //cout << "LSDBasin line 1630, You are doing this wihout the effective depth driven shielding" << endl;
 
       N_this_step = predict_mean_CRN_conc(eff_e_new, Nuclide,prod_uncert_factor,
@@ -3870,48 +3845,32 @@ double LSDCosmoBasin::predict_CRN_erosion(double Nuclide_conc, string Nuclide,
                                        displace_average_production,
                                        is_production_uncertainty_plus_on,
                                        is_production_uncertainty_minus_on);
-    }
-    else   // if self and snow sheilding are caluclated based on effective depths
-    {
-      //cout << "LSDBasin line 1649 You are doing this wih the effective depth driven shielding" << endl;
 
-      N_this_step = predict_mean_CRN_conc_with_snow_and_self(eff_e_new, Nuclide,
-                                        prod_uncert_factor,
-                                        Muon_scaling,data_from_outlet_only,
-                                        this_step_prod_uncert,
-                                        this_step_average_production,
-                                        is_production_uncertainty_plus_on,
-                                        is_production_uncertainty_minus_on);
-      //cout << " Conc: " << N_this_step << endl;
-
-      // now get the derivative
-      N_displace = predict_mean_CRN_conc_with_snow_and_self(eff_e_new+eff_e_displace,Nuclide,
-                                       prod_uncert_factor,Muon_scaling,
-                                       data_from_outlet_only,displace_uncertainty,
-                                       displace_average_production,
-                                       is_production_uncertainty_plus_on,
-                                       is_production_uncertainty_minus_on);
-    }
-
-    f_x =  N_this_step-Nuclide_conc;
-    f_x_displace =  N_displace-Nuclide_conc;
-
-    N_derivative = (f_x_displace-f_x)/eff_e_displace;
+      f_x =  N_this_step-Nuclide_conc;
+      f_x_displace =  N_displace-Nuclide_conc;
 
-    if(N_derivative != 0)
-    {
-      eff_e_new = eff_e_new-f_x/N_derivative;
+      N_derivative = (f_x_displace-f_x)/eff_e_displace;
 
-      // check to see if the difference in erosion rates meet a tolerance
-      eff_e_change = f_x/N_derivative;
-      //cout << "Change is: " << eff_e_change << " and erosion rate is: " << eff_e_new << endl;
-    }
-    else
-    {
-      eff_e_change = 0;
-    }
+      ErosionRoot.step(N_this_step, N_derivative);
+      eff_e_new = ErosionRoot.get_erosion_rate();
+    } while(!ErosionRoot.is_converged() && ErosionRoot.get_NSteps() < max_steps);
+  }
+  else   // if self and snow sheilding are caluclated based on effective depths
+  {
+    //cout << "LSDBasin line 1649 You are doing this wih the effective depth driven shielding" << endl;
 
-  } while(fabs(eff_e_change) > tolerance);
+    // the derivative of the concentration is in closed form
+    vector<const LSDCRNConcentrationKernel*> kernels(1,&ConcKernel);
+    vector<double> target_conc(1,Nuclide_conc);
+    vector<double> eff_erates(1,eff_e_new);
+    LSDCRNErosionSolver ErosionSolver;
+    ErosionSolver.set_tolerance(tolerance);
+    ErosionSolver.set_max_steps(max_steps);
+    ErosionSolver.solve(kernels, target_conc, eff_erates);
+    eff_e_new = eff_erates[0];
+    this_step_prod_uncert = ConcKernel.get_production_uncertainty();
+    this_step_average_production = ConcKernel.get_average_production();
+  }
 
   // replace the production uncertainty
   production_uncertainty = this_step_prod_uncert;
@@ -4110,24 +4069,12 @@ double LSDCosmoBasin::predict_CRN_erosion_nested(double Nuclide_conc, string Nuc
   // now using this as the initial guess, use Newton-Raphson to zero in on the
   // correct erosion rate
   double eff_e_new = eff_erate_guess; // the erosion rate upon which we iterate
-  double eff_e_change;                // the change in erosion rate between iterations
   double tolerance = 1e-10;           // tolerance for a change in the erosion rate
                                       // between Newton-Raphson iterations
-  double eff_e_displace = 1e-6;       // A small displacment in the erosion rate used
-                                      // to calculate the derivative
-  double N_this_step;                 // the concentration of the nuclide reported this step
-  double N_displace;                  // the concentration at the displaced erosion rate
-  double N_derivative;                // dN/de derivative for Newton-Raphson
-  double f_x;                         // the function being tested by newton raphson
-  double f_x_displace;                // the displaced function (for calculating the derivative)
-
-  double this_step_prod_uncert;       // the uncertainty in the production rate
-                                      // from this step
-  double displace_uncertainty;        // the uncertainty from the displaced calculations
-                                      // is not used so a dummy variable is used here
+  int max_steps = 200;                // the most Newton-Raphson iterations
 
-  double this_step_average_production;// the average production rate for this step
-  double displace_average_production; // aveage production for the displace step
+  double this_step_prod_uncert = 0;   // the uncertainty in the production rate
+  double this_step_average_production = 0;// the average production rate
 
   // now check if there are unknown erosion rates in basin
   bool there_are_unknowns = are_there_unknown_erosion_rates_in_basin(eff_erosion_raster,FlowInfo);
@@ -4150,56 +4097,283 @@ double LSDCosmoBasin::predict_CRN_erosion_nested(double Nuclide_conc, string Nuc
       populate_snow_and_self_eff_depth_vectors(snow_eff_depth, self_eff_depth);
     }
 
-    // now use newton iteration to get the correct cocentration
-    do
+    // Everything that does not depend on the erosion rate, including the
+    // pixels with known erosion rates, is worked out once. The concentration
+    // and its derivative then come from this kernel for every
+    // Newton-Raphson iteration.
+    vector<double> known_eff_erosion = get_known_eff_erosion(eff_erosion_raster,FlowInfo);
+    LSDCRNConcentrationKernel ConcKernel(production_scaling, topographic_shielding,
+                                         snow_shield_eff_depth, self_shield_eff_depth,
+                                         known_eff_erosion, NoDataValue, Nuclide,
+                                         Muon_scaling, prod_uncert_factor,
+                                         is_production_uncertainty_plus_on,
+                                         is_production_uncertainty_minus_on);
+    vector<const LSDCRNConcentrationKernel*> kernels(1,&ConcKernel);
+    vector<double> target_conc(1,Nuclide_conc);
+    vector<double> eff_erates(1,eff_e_new);
+    LSDCRNErosionSolver ErosionSolver;
+    ErosionSolver.set_tolerance(tolerance);
+    ErosionSolver.set_max_steps(max_steps);
+    ErosionSolver.solve(kernels, target_conc, eff_erates);
+    eff_e_new = eff_erates[0];
+    this_step_prod_uncert = ConcKernel.get_production_uncertainty();
+    this_step_average_production = ConcKernel.get_average_production();
+  }
+
+  // replace the production uncertainty
+  production_uncertainty = this_step_prod_uncert;
+
+  // replace the average production
+  average_production = this_step_average_production;
+
+  return eff_e_new;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+//
+// This gets the erosion rates of several variants of the basin (different
+// concentrations, production uncertainties or muon schemes) at once.
+// If the shielding is from effective depths the concentration kernels of the
+// variants are prepared in parallel and then the Newton-Raphson iterations
+// of all of them are advanced together, using the derivative of the
+// concentration from the kernels. Otherwise each variant is solved on its own
+// with predict_CRN_erosion.
+//
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+vector<double> LSDCosmoBasin::predict_CRN_erosion(vector<double>& Nuclide_conc,
+                                          string Nuclide,
+                                          vector<double>& prod_uncert_factor,
+                                          vector<string>& Muon_scaling,
+                                          vector<bool>& is_production_uncertainty_plus_on,
+                                          vector<bool>& is_production_uncertainty_minus_on)
+{
+  int n_variants = int(Nuclide_conc.size());
+  vector<double> eff_erates(n_variants,0.0);
+
+  bool use_eff_depth_shielding = (self_shield_eff_depth.size() >= 1 ||
+                                  snow_shield_eff_depth.size() >= 1);
+  if (!use_eff_depth_shielding)
+  {
+    #pragma omp parallel for schedule(dynamic)
+    for (int v = 0; v<n_variants; v++)
     {
-      N_this_step = predict_mean_CRN_conc_with_snow_and_self_nested(eff_e_new,
-                                        eff_erosion_raster,FlowInfo,
-                                        Nuclide,
-                                        prod_uncert_factor,
-                                        Muon_scaling,
-                                        this_step_prod_uncert,
-                                        this_step_average_production,
-                                        is_production_uncertainty_plus_on,
-                                        is_production_uncertainty_minus_on);
-      //cout << " Conc: " << N_this_step << endl;
+      double production_uncertainty;   // not used here but needs to be passed
+      double average_production_rate;  // to the erosion finding routines
+      eff_erates[v] = predict_CRN_erosion(Nuclide_conc[v], Nuclide,
+                                 prod_uncert_factor[v], Muon_scaling[v],
+                                 production_uncertainty, average_production_rate,
+                                 is_production_uncertainty_plus_on[v],
+                                 is_production_uncertainty_minus_on[v]);
+    }
+    return eff_erates;
+  }
 
-      // now get the derivative
-      N_displace = predict_mean_CRN_conc_with_snow_and_self_nested(eff_e_new+eff_e_displace,
-                                       eff_erosion_raster,FlowInfo,Nuclide,
-                                       prod_uncert_factor,Muon_scaling,
-                                       displace_uncertainty,
-                                       displace_average_production,
-                                       is_production_uncertainty_plus_on,
-                                       is_production_uncertainty_minus_on);
+  vector<LSDCRNConcentrationKernel> ConcKernels(n_variants);
+  #pragma omp parallel for schedule(dynamic)
+  for (int v = 0; v<n_variants; v++)
+  {
+    ConcKernels[v] = LSDCRNConcentrationKernel(production_scaling, topographic_shielding,
+                                           snow_shield_eff_depth, self_shield_eff_depth,
+                                           NoDataValue, Nuclide, Muon_scaling[v],
+                                           prod_uncert_factor[v],
+                                           is_production_uncertainty_plus_on[v],
+                                           is_production_uncertainty_minus_on[v]);
+    eff_erates[v] = get_CRN_erosion_guess(Nuclide_conc[v], Nuclide, Muon_scaling[v]);
+  }
 
-      f_x =  N_this_step-Nuclide_conc;
-      f_x_displace =  N_displace-Nuclide_conc;
+  vector<const LSDCRNConcentrationKernel*> kernels(n_variants);
+  for (int v = 0; v<n_variants; v++)
+  {
+    kernels[v] = &ConcKernels[v];
+  }
+  LSDCRNErosionSolver ErosionSolver;
+  ErosionSolver.solve(kernels, Nuclide_conc, eff_erates);
 
-      N_derivative = (f_x_displace-f_x)/eff_e_displace;
+  return eff_erates;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
-      if(N_derivative != 0)
-      {
-        eff_e_new = eff_e_new-f_x/N_derivative;
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+//
+// This gets the erosion rates of several variants of a nested basin at once,
+// as above. The pixels with known erosion rates are the same for every
+// variant.
+//
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+vector<double> LSDCosmoBasin::predict_CRN_erosion_nested(vector<double>& Nuclide_conc,
+                                          string Nuclide,
+                                          vector<double>& prod_uncert_factor,
+                                          vector<string>& Muon_scaling,
+                                          vector<bool>& is_production_uncertainty_plus_on,
+                                          vector<bool>& is_production_uncertainty_minus_on,
+                                          LSDRaster& eff_erosion_raster,
+                                          LSDFlowInfo& FlowInfo)
+{
+  int n_variants = int(Nuclide_conc.size());
+  vector<double> eff_erates(n_variants,0.0);
 
-        // check to see if the difference in erosion rates meet a tolerance
-        eff_e_change = f_x/N_derivative;
-        //cout << "Change is: " << eff_e_change << " and erosion rate is: " << eff_e_new << endl;
-      }
-      else
-      {
-        eff_e_change = 0;
-      }
-    } while(fabs(eff_e_change) > tolerance);
+  // now check if there are unknown erosion rates in basin
+  bool there_are_unknowns = are_there_unknown_erosion_rates_in_basin(eff_erosion_raster,FlowInfo);
+  if (not there_are_unknowns)
+  {
+    cout << "There are no unknown erosion rates in this basin." << endl;
+    cout << " Taking the average of the known erosion rates." << endl;
+    double eff_e_mean = CalculateBasinMean(FlowInfo, eff_erosion_raster);
+    eff_erates.assign(n_variants,eff_e_mean);
+    return eff_erates;
   }
 
-  // replace the production uncertainty
-  production_uncertainty = this_step_prod_uncert;
+  // check to see if there are snow and shielding values, if not populate the vecotrs
+  if(self_shield_eff_depth.size() < 1 && snow_shield_eff_depth.size() < 1)
+  {
+    cout << "You don't seem to have populated the snow and self shielding vectors." << endl;
+    cout << "Setting these to 0 shielding" << endl;
+    double snow_eff_depth = 0;
+    double self_eff_depth = 0;
+    populate_snow_and_self_eff_depth_vectors(snow_eff_depth, self_eff_depth);
+  }
 
-  // replace the average production
-  average_production = this_step_average_production;
+  vector<double> known_eff_erosion = get_known_eff_erosion(eff_erosion_raster,FlowInfo);
+  vector<LSDCRNConcentrationKernel> ConcKernels(n_variants);
+  #pragma omp parallel for schedule(dynamic)
+  for (int v = 0; v<n_variants; v++)
+  {
+    ConcKernels[v] = LSDCRNConcentrationKernel(production_scaling, topographic_shielding,
+                                           snow_shield_eff_depth, self_shield_eff_depth,
+                                           known_eff_erosion, NoDataValue, Nuclide,
+                                           Muon_scaling[v], prod_uncert_factor[v],
+                                           is_production_uncertainty_plus_on[v],
+                                           is_production_uncertainty_minus_on[v]);
+    eff_erates[v] = get_CRN_erosion_guess(Nuclide_conc[v], Nuclide, Muon_scaling[v]);
+  }
 
-  return eff_e_new;
+  vector<const LSDCRNConcentrationKernel*> kernels(n_variants);
+  for (int v = 0; v<n_variants; v++)
+  {
+    kernels[v] = &ConcKernels[v];
+  }
+  LSDCRNErosionSolver ErosionSolver;
+  ErosionSolver.solve(kernels, Nuclide_conc, eff_erates);
+
+  return eff_erates;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+//
+// This is the first guess of the erosion rate for the Newton-Raphson
+// iterations: the neutron only apparent erosion rate of a particle with the
+// scaling of the outlet. It is the guess used in predict_CRN_erosion.
+// It is in g/cm^2/yr
+//
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+double LSDCosmoBasin::get_CRN_erosion_guess(double Nuclide_conc, string Nuclide,
+                                            string Muon_scaling)
+{
+  double rho = 2650;  // the density drops out of the effective erosion rate
+
+  // a particle at zero depth
+  int startType = 0;
+  double Xloc = 0;
+  double Yloc = 0;
+  double  startdLoc = 0.0;
+  double  start_effdloc = 0.0;
+  double startzLoc = 0.0;
+  LSDCRNParticle eroded_particle(startType, Xloc, Yloc,
+                               startdLoc, start_effdloc, startzLoc);
+
+  LSDCRNParameters LSDCRNP;
+  if (Muon_scaling == "Schaller" )
+  {
+    LSDCRNP.set_Schaller_parameters();
+  }
+  else if (Muon_scaling == "Granger" )
+  {
+    LSDCRNP.set_Granger_parameters();
+  }
+  else if (Muon_scaling == "newCRONUS" )
+  {
+    LSDCRNP.set_newCRONUS_parameters();
+  }
+  else
+  {
+    LSDCRNP.set_Braucher_parameters();
+  }
+
+  vector<bool> nuclide_scaling_switches(4,false);
+  if (Nuclide == "Al26")
+  {
+    nuclide_scaling_switches[1] = true;
+  }
+  else
+  {
+    nuclide_scaling_switches[0] = true;
+  }
+
+  // the scaling of the outlet
+  double total_shielding;
+  if (snow_shielding[0] == 0)
+  {
+    total_shielding =  production_scaling[0]*topographic_shielding[0];
+  }
+  else
+  {
+    total_shielding =  production_scaling[0]*topographic_shielding[0]*
+                        snow_shielding[0];
+  }
+  LSDCRNP.scale_F_values(total_shielding,nuclide_scaling_switches);
+  if (snow_shielding[0] == 0)
+  {
+    LSDCRNP.set_neutron_scaling(production_scaling[0],topographic_shielding[0],
+                             snow_shielding[0]);
+  }
+  else
+  {
+    double this_sshield = 1.0;
+    LSDCRNP.set_neutron_scaling(production_scaling[0],topographic_shielding[0],
+                                this_sshield);
+  }
+
+  double erate_guess;
+  if (Nuclide == "Al26")
+  {
+    eroded_particle.setConc_26Al(Nuclide_conc);
+    erate_guess = eroded_particle.apparent_erosion_26Al_neutron_only(rho, LSDCRNP);
+  }
+  else
+  {
+    eroded_particle.setConc_10Be(Nuclide_conc);
+    erate_guess = eroded_particle.apparent_erosion_10Be_neutron_only(rho, LSDCRNP);
+  }
+
+  // convert to  g/cm^2/yr
+  return 0.1*erate_guess*rho;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+//
+// This gets the known erosion rate of every pixel in the basin from a raster,
+// in the order of the basin nodes. Pixels without a known erosion rate have
+// the NoDataValue of the raster.
+//
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+vector<double> LSDCosmoBasin::get_known_eff_erosion(LSDRaster& known_effective_erosion,
+                                                    LSDFlowInfo& FlowInfo)
+{
+  int row,col;
+  vector<double> known_eff_erosion(BasinNodes.size());
+  for (int q = 0; q < int(BasinNodes.size()); ++q)
+  {
+    FlowInfo.retrieve_current_row_and_col(BasinNodes[q], row, col);
+    known_eff_erosion[q] = known_effective_erosion.get_data_element(row,col);
+  }
+  return known_eff_erosion;
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -154,7 +154,7 @@ class LSDBasin
   /// @return Mean value.
   /// @author SWDG
   /// @date 11/12/13
-  float CalculateBasinMean(LSDFlowInfo& FlowInfo, LSDRaster Data);
+  float CalculateBasinMean(LSDFlowInfo& FlowInfo, LSDRaster& Data);
 
   /// @brief Calculate the max value of an LSDRaster which falls inside a basin.
   /// @param FlowInfo Flowinfo object.
@@ -210,7 +210,7 @@ class LSDBasin
   /// @return Range value.
   /// @author SWDG
   /// @date 17/2/14
-  float CalculateBasinRange(LSDFlowInfo& FlowInfo, LSDRaster Data);
+  float CalculateBasinRange(LSDFlowInfo& FlowInfo, LSDRaster& Data);
 
   /// @brief Calculate the number of data points of an LSDRaster which fall inside a basin.
   ///
@@ -1104,6 +1104,9 @@ class LSDCosmoBasin: public LSDBasin
     /// @param Muon_scaling string that gives the muon scaling scheme
     ///  options are Schaller, Granger and Braucher
     /// @return  a vector of both the erosion rates and the uncertainties of the sample
+    /// @details The seven erosion rate inversions (the erosion rate and the
+    ///  six used for the uncertainties) are independent and are run in
+    ///  parallel if there are threads to spare.
     /// @author SMM
     /// @date 01/02/2015
     vector<double> full_CRN_erosion_analysis(double Nuclide_conc, string Nuclide,
@@ -1124,6 +1127,8 @@ class LSDCosmoBasin: public LSDBasin
     /// @param Muon_scaling string that gives the muon scaling scheme
     ///  options are Schaller, Granger and Braucher
     /// @return  a vector of both the erosion rates and the uncertainties of the sample
+    /// @details As in full_CRN_erosion_analysis the inversions are run in
+    ///  parallel if there are threads to spare.
     /// @author SMM
     /// @date 11/02/2016
     vector<double> full_CRN_erosion_analysis_nested(LSDRaster& known_eff_erosion,
@@ -1207,6 +1212,48 @@ class LSDCosmoBasin: public LSDBasin
                                           LSDRaster& eff_erosion_raster,
                                           LSDFlowInfo& FlowInfo);
 
+    /// @brief Gets the erosion rates of several variants of the basin at once,
+    ///  e.g. the uncertainty inversions of full_CRN_erosion_analysis.
+    ///
+    /// @details If the shielding is from effective depths the concentration
+    ///  kernel of each variant is prepared (in parallel) and the
+    ///  Newton-Raphson iterations of all of them are advanced together,
+    ///  using the derivative of the concentration from the kernels rather
+    ///  than from a displaced erosion rate. Otherwise each variant is solved
+    ///  with the single variant predict_CRN_erosion.
+    /// @param Nuclide_conc the concentration of each variant
+    /// @param Nuclide a string with the nuclide name: Be10 or Al26
+    /// @param prod_uncert_factor the production uncertainty factor of each variant
+    /// @param Muon_scaling the muon scaling scheme of each variant
+    /// @param is_production_uncertainty_plus_on whether the production rate
+    ///  uncertainty (+) is switched on in each variant
+    /// @param is_production_uncertainty_minus_on whether the production rate
+    ///  uncertainty (-) is switched on in each variant
+    /// @return The effective erosion rate of each variant in g/cm^-2/yr
+    /// @author agent
+    /// @date 16/10/2026
+    vector<double> predict_CRN_erosion(vector<double>& Nuclide_conc, string Nuclide,
+                               vector<double>& prod_uncert_factor,
+                               vector<string>& Muon_scaling,
+                               vector<bool>& is_production_uncertainty_plus_on,
+                               vector<bool>& is_production_uncertainty_minus_on);
+
+    /// @brief Gets the erosion rates of several variants of a nested basin at
+    ///  once. The parameters are as in the version above.
+    /// @param eff_erosion_raster the known erosion rates in g/cm^2/yr, which
+    ///  are the same for every variant
+    /// @param FlowInfo the LSDFlowInfo object
+    /// @return The effective erosion rate of each variant in g/cm^-2/yr
+    /// @author agent
+    /// @date 16/10/2026
+    vector<double> predict_CRN_erosion_nested(vector<double>& Nuclide_conc, string Nuclide,
+                               vector<double>& prod_uncert_factor,
+                               vector<string>& Muon_scaling,
+                               vector<bool>& is_production_uncertainty_plus_on,
+                               vector<bool>& is_production_uncertainty_minus_on,
+                               LSDRaster& eff_erosion_raster,
+                               LSDFlowInfo& FlowInfo);
+
 
     /// @brief this predicts the mean concentration of a nuclide within
     /// a basin
@@ -1551,6 +1598,26 @@ class LSDCosmoBasin: public LSDBasin
                            double N10Be, double delN10Be,
                            double N26Al, double delN26Al);
 
+    /// @brief The first guess of the erosion rate for the Newton-Raphson
+    ///  iterations: the neutron only apparent erosion rate at the outlet
+    /// @param Nuclide_conc the concentration in atoms/g
+    /// @param Nuclide Be10 or Al26
+    /// @param Muon_scaling the muon scaling scheme
+    /// @return the erosion rate in g/cm^2/yr
+    /// @author agent
+    /// @date 16/10/2026
+    double get_CRN_erosion_guess(double Nuclide_conc, string Nuclide, string Muon_scaling);
+
+    /// @brief Gets the known erosion rates of the basin nodes from a raster
+    /// @param known_effective_erosion the known erosion rates, NoData where
+    ///  they are not known
+    /// @param FlowInfo the LSDFlowInfo object
+    /// @return the erosion rate of each basin node
+    /// @author agent
+    /// @date 16/10/2026
+    vector<double> get_known_eff_erosion(LSDRaster& known_effective_erosion,
+                                         LSDFlowInfo& FlowInfo);
+
 };
 
 
@@ -0,0 +1,745 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDCRNKernel
+// Land Surface Dynamics Cosmogenic Nuclide Kernel
+//
+// The basin averaged concentration of a cosmogenic nuclide as a function of
+// the erosion rate, for the Newton-Raphson iterations of the basinwide
+// erosion rate calculations, within the University of Edinburgh Land Surface
+// Dynamics group topographic toolbox
+//
+// In LSDCosmoBasin::predict_mean_CRN_conc_with_snow_and_self every pixel
+// resets its parameters, rescales the F values (itself a Newton-Raphson
+// search for an effective depth) and integrates the steady state
+// concentration over the shielding depths, and all of this is repeated for
+// every erosion rate tried. Only the (e + Gamma*lambda) terms depend on the
+// erosion rate, so here the rest is worked out once per basin: each pixel
+// gets a weight for each of the four production pathways, held in arrays by
+// pathway. The basin average at any erosion rate is then the sum over
+// pathways of the summed weights divided by (e + Gamma*lambda).
+//
+// For nested basins (predict_mean_CRN_conc_with_snow_and_self_nested) some
+// pixels have a known erosion rate, and the basin average is weighted by the
+// erosion rate of each pixel. The known pixels then add a fixed amount of
+// nuclide and of mass, worked out once as well.
+//
+// Because the concentration is in closed form so is its derivative with the
+// erosion rate, and the erosion rate that gives a measured concentration is
+// found with Newton-Raphson steps that use it. LSDCRNErosionRoot keeps those
+// steps inside a bracket around the root, and LSDCRNErosionSolver advances
+// the roots of many kernels (different basins, or the uncertainty inversions
+// of one basin) together.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDCRNKernel_H
+#define LSDCRNKernel_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include "LSDCRNParameters.hpp"
+using namespace std;
+
+///@brief The basin averaged concentration of 10Be or 26Al, with snow and
+/// self shielding given as effective depths, at any erosion rate.
+///@details Gives the same concentrations as
+/// LSDCosmoBasin::predict_mean_CRN_conc_with_snow_and_self, to within
+/// rounding, or as predict_mean_CRN_conc_with_snow_and_self_nested if it is
+/// given the known erosion rates. The weights of the pixels are computed in parallel when the code
+/// is compiled with OpenMP.
+///@author agent
+///@date 16/10/2026
+class LSDCRNConcentrationKernel
+{
+  public:
+    /// @brief An empty kernel
+    LSDCRNConcentrationKernel() : NPixels(0), NUnknown(0), KnownN(0), KnownMass(0) {}
+
+    /// @brief Prepares the kernel for a basin
+    /// @param production_scaling the production scaling of each pixel
+    /// @param topographic_shielding the topographic shielding of each pixel.
+    ///  Pixels where this is NoDataValue are left out.
+    /// @param snow_shield_eff_depth the effective depth of snow in g/cm^2.
+    ///  Either empty (no snow), one value for the whole basin or one per pixel.
+    /// @param self_shield_eff_depth the effective thickness of the eroded layer
+    ///  in g/cm^2. Empty, one value or one per pixel, as for the snow.
+    /// @param NoDataValue the nodata value
+    /// @param Nuclide "Be10" or "Al26"
+    /// @param Muon_scaling "Schaller", "Braucher", "Granger" or "newCRONUS"
+    /// @param prod_uncert_factor multiplies the production
+    /// @param is_production_uncertainty_plus_on uses the upper CRONUS P0
+    /// @param is_production_uncertainty_minus_on uses the lower CRONUS P0
+    LSDCRNConcentrationKernel(vector<double>& production_scaling,
+                              vector<double>& topographic_shielding,
+                              vector<double>& snow_shield_eff_depth,
+                              vector<double>& self_shield_eff_depth,
+                              double NoDataValue, string Nuclide, string Muon_scaling,
+                              double prod_uncert_factor,
+                              bool is_production_uncertainty_plus_on,
+                              bool is_production_uncertainty_minus_on)
+    {
+      vector<double> no_known_eff_erosion;
+      create(production_scaling, topographic_shielding, snow_shield_eff_depth,
+             self_shield_eff_depth, no_known_eff_erosion, NoDataValue, Nuclide,
+             Muon_scaling, prod_uncert_factor, is_production_uncertainty_plus_on,
+             is_production_uncertainty_minus_on);
+    }
+
+    /// @brief Prepares the kernel for a nested basin, in which some pixels
+    ///  have a known erosion rate. The other parameters are as above.
+    /// @param known_eff_erosion the erosion rate of each pixel in g/cm^2/yr,
+    ///  or NoDataValue where it is not known
+    LSDCRNConcentrationKernel(vector<double>& production_scaling,
+                              vector<double>& topographic_shielding,
+                              vector<double>& snow_shield_eff_depth,
+                              vector<double>& self_shield_eff_depth,
+                              vector<double>& known_eff_erosion,
+                              double NoDataValue, string Nuclide, string Muon_scaling,
+                              double prod_uncert_factor,
+                              bool is_production_uncertainty_plus_on,
+                              bool is_production_uncertainty_minus_on)
+    {
+      create(production_scaling, topographic_shielding, snow_shield_eff_depth,
+             self_shield_eff_depth, known_eff_erosion, NoDataValue, Nuclide,
+             Muon_scaling, prod_uncert_factor, is_production_uncertainty_plus_on,
+             is_production_uncertainty_minus_on);
+    }
+
+    /// @return the basin averaged concentration in atoms/g
+    /// @param eff_erosion_rate the erosion rate in g/cm^2/yr
+    double mean_concentration(double eff_erosion_rate) const
+    {
+      double Total_N = 0;
+      for (int i = 0; i<4; i++)
+      {
+        Total_N += SummedWeights[i]/(eff_erosion_rate+GammaLambda[i]);
+      }
+      if (KnownPixels.empty())
+      {
+        return Total_N/double(NPixels);
+      }
+      return (KnownN+eff_erosion_rate*Total_N)/
+             (KnownMass+double(NUnknown)*eff_erosion_rate);
+    }
+
+    /// @return the basin averaged concentration in atoms/g
+    /// @param eff_erosion_rate the erosion rate in g/cm^2/yr
+    /// @param dN_de replaced with the derivative of the concentration with
+    ///  the erosion rate, in atoms/g per g/cm^2/yr
+    double mean_concentration(double eff_erosion_rate, double& dN_de) const
+    {
+      double Total_N = 0;
+      double dTotal_N = 0;
+      for (int i = 0; i<4; i++)
+      {
+        double this_N = SummedWeights[i]/(eff_erosion_rate+GammaLambda[i]);
+        Total_N += this_N;
+        dTotal_N -= this_N/(eff_erosion_rate+GammaLambda[i]);
+      }
+      if (KnownPixels.empty())
+      {
+        dN_de = dTotal_N/double(NPixels);
+        return Total_N/double(NPixels);
+      }
+      double mass = KnownMass+double(NUnknown)*eff_erosion_rate;
+      double N = (KnownN+eff_erosion_rate*Total_N)/mass;
+      dN_de = (Total_N+eff_erosion_rate*dTotal_N-double(NUnknown)*N)/mass;
+      return N;
+    }
+
+    /// @brief Gets the concentration of every pixel with data. Pixels with a
+    ///  known erosion rate have the concentration at that rate.
+    /// @param eff_erosion_rate the erosion rate in g/cm^2/yr
+    /// @param concentrations replaced with the concentrations in atoms/g, in
+    ///  the order of the pixels with data
+    void pixel_concentrations(double eff_erosion_rate, vector<double>& concentrations) const
+    {
+      concentrations.resize(NPixels);
+      double inverse[4];
+      for (int i = 0; i<4; i++)
+      {
+        inverse[i] = 1.0/(eff_erosion_rate+GammaLambda[i]);
+      }
+      if (NPixels == 0)
+      {
+        return;
+      }
+      const double* W0 = &Weights[0][0];
+      const double* W1 = &Weights[1][0];
+      const double* W2 = &Weights[2][0];
+      const double* W3 = &Weights[3][0];
+      double* N = &concentrations[0];
+      #pragma omp simd
+      for (int p = 0; p<NPixels; p++)
+      {
+        N[p] = W0[p]*inverse[0]+W1[p]*inverse[1]+W2[p]*inverse[2]+W3[p]*inverse[3];
+      }
+      for (int k = 0; k<int(KnownPixels.size()); k++)
+      {
+        N[KnownPixels[k]] = known_concentration(k);
+      }
+    }
+
+    /// @return the number of pixels with data
+    int get_NPixels() const { return NPixels; }
+
+    /// @return the number of pixels with data whose erosion rate is not known
+    int get_NUnknown() const { return NUnknown; }
+
+    /// @return the average production scaling times topographic shielding
+    double get_average_production() const { return AverageProduction; }
+
+    /// @return the average production times the production uncertainty
+    double get_production_uncertainty() const { return ProductionUncertainty; }
+
+  private:
+    void create(vector<double>& production_scaling,
+                vector<double>& topographic_shielding,
+                vector<double>& snow_shield_eff_depth,
+                vector<double>& self_shield_eff_depth,
+                vector<double>& known_eff_erosion,
+                double NoDataValue, string Nuclide, string Muon_scaling,
+                double prod_uncert_factor,
+                bool is_production_uncertainty_plus_on,
+                bool is_production_uncertainty_minus_on)
+    {
+      if (prod_uncert_factor <=0)
+      {
+        cout << "You have set an unrealistic production uncertainty factor." << endl;
+        cout << "Defaulting to 1." << endl;
+        prod_uncert_factor = 1;
+      }
+
+      LSDCRNParameters LSDCRNP;
+      if (Muon_scaling == "Schaller" )
+      {
+        LSDCRNP.set_Schaller_parameters();
+      }
+      else if (Muon_scaling == "Braucher" )
+      {
+        LSDCRNP.set_Braucher_parameters();
+      }
+      else if (Muon_scaling == "Granger" )
+      {
+        LSDCRNP.set_Granger_parameters();
+      }
+      else if (Muon_scaling == "newCRONUS" )
+      {
+        LSDCRNP.set_newCRONUS_parameters();
+      }
+      else
+      {
+        cout << "You didn't set the muon scaling." << endl
+             << "Options are Schaller, Braucher, newCRONUS, and Granger." << endl
+             << "You chose: " << Muon_scaling << endl
+             << "Defaulting to Braucher et al (2009) scaling" << endl;
+        LSDCRNP.set_Braucher_parameters();
+      }
+
+      if(is_production_uncertainty_plus_on)
+      {
+        if(is_production_uncertainty_minus_on)
+        {
+          cout << "You can't have both plus and minus production uncertainty on" << endl;
+          cout << "Setting minus uncertainty to false" << endl;
+        }
+        LSDCRNP.set_P0_CRONUS_uncertainty_plus();
+      }
+      else if(is_production_uncertainty_minus_on)
+      {
+        LSDCRNP.set_P0_CRONUS_uncertainty_minus();
+      }
+
+      // the parameters of the nuclide
+      double F[4];
+      double lambda;
+      double P0;
+      if (Nuclide == "Al26")
+      {
+        for (int i = 0; i<4; i++)
+        {
+          F[i] = LSDCRNP.F_26Al[i];
+        }
+        lambda = LSDCRNP.lambda_26Al;
+        P0 = LSDCRNP.P0_26Al;
+      }
+      else
+      {
+        if (Nuclide != "Be10")
+        {
+          cout << "LSDCRNConcentrationKernel, You didn't choose a valid nuclide. Defaulting"
+               << " to 10Be." << endl;
+        }
+        for (int i = 0; i<4; i++)
+        {
+          F[i] = LSDCRNP.F_10Be[i];
+        }
+        lambda = LSDCRNP.lambda_10Be;
+        P0 = LSDCRNP.P0_10Be;
+      }
+      double Gamma[4];
+      for (int i = 0; i<4; i++)
+      {
+        Gamma[i] = LSDCRNP.Gamma[i];
+        GammaLambda[i] = LSDCRNP.Gamma[i]*lambda;
+      }
+      double Pref = LSDCRNP.S_t*P0;
+
+      // the pixels with data
+      vector<int> pixels;
+      double cumulative_production_rate = 0;
+      for (int q = 0; q<int(topographic_shielding.size()); q++)
+      {
+        if(topographic_shielding[q] != NoDataValue)
+        {
+          pixels.push_back(q);
+          cumulative_production_rate += production_scaling[q]*topographic_shielding[q];
+        }
+      }
+      NPixels = int(pixels.size());
+      AverageProduction = cumulative_production_rate/double(NPixels);
+      ProductionUncertainty = AverageProduction*fabs(1-prod_uncert_factor);
+
+      for (int i = 0; i<4; i++)
+      {
+        Weights[i].assign(NPixels,0.0);
+      }
+
+      int n_snow = int(snow_shield_eff_depth.size());
+      int n_self = int(self_shield_eff_depth.size());
+      int n_reversed = 0;
+
+      #pragma omp parallel for reduction(+:n_reversed)
+      for (int p = 0; p<NPixels; p++)
+      {
+        int q = pixels[p];
+
+        // the F values scaled to the shielding of this pixel
+        double total_shielding = prod_uncert_factor*production_scaling[q]*topographic_shielding[q];
+        double depth = scaling_depth(total_shielding, F, Gamma);
+
+        // the snow and then the self shielding
+        double top_eff_depth = 0;
+        if (n_snow == 1)
+        {
+          top_eff_depth = snow_shield_eff_depth[0];
+        }
+        else if (n_snow > 1)
+        {
+          top_eff_depth = snow_shield_eff_depth[q];
+        }
+        double bottom_eff_depth = top_eff_depth;
+        if (n_self == 1)
+        {
+          bottom_eff_depth = top_eff_depth+self_shield_eff_depth[0];
+        }
+        else if (n_self > 1)
+        {
+          bottom_eff_depth = top_eff_depth+self_shield_eff_depth[q];
+        }
+        if (top_eff_depth > bottom_eff_depth)
+        {
+          double temp_eff_depth = bottom_eff_depth;
+          bottom_eff_depth = top_eff_depth;
+          top_eff_depth = temp_eff_depth;
+          n_reversed++;
+        }
+
+        // the steady state concentration of each pathway is
+        // weight/(erosion_rate+Gamma*lambda)
+        for (int i = 0; i<4; i++)
+        {
+          double scaled_F = exp(-depth/Gamma[i])*F[i];
+          if (top_eff_depth == bottom_eff_depth)
+          {
+            Weights[i][p] = Pref*scaled_F*Gamma[i]*exp(-top_eff_depth/Gamma[i]);
+          }
+          else
+          {
+            Weights[i][p] = Pref*scaled_F*Gamma[i]*Gamma[i]*
+                            (exp(-top_eff_depth/Gamma[i])-exp(-bottom_eff_depth/Gamma[i]))/
+                            (bottom_eff_depth-top_eff_depth);
+          }
+        }
+      }
+      if (n_reversed > 0)
+      {
+        cout << "LSDCRNConcentrationKernel, the effective depths for integration of "
+             << n_reversed << " pixels are reversed" << endl;
+        cout << "Reversing the two depths. Check your inputs!" << endl;
+      }
+
+      // the pixels with a known erosion rate, if this is a nested basin
+      KnownPixels.clear();
+      KnownErosion.clear();
+      vector<bool> is_known(NPixels,false);
+      if (known_eff_erosion.size() > 0)
+      {
+        for (int p = 0; p<NPixels; p++)
+        {
+          if (known_eff_erosion[pixels[p]] != NoDataValue)
+          {
+            KnownPixels.push_back(p);
+            KnownErosion.push_back(known_eff_erosion[pixels[p]]);
+            is_known[p] = true;
+          }
+        }
+      }
+      NUnknown = NPixels-int(KnownPixels.size());
+      KnownN = 0;
+      KnownMass = 0;
+      for (int k = 0; k<int(KnownPixels.size()); k++)
+      {
+        KnownN += KnownErosion[k]*known_concentration(k);
+        KnownMass += KnownErosion[k];
+      }
+
+      for (int i = 0; i<4; i++)
+      {
+        double sum = 0;
+        for (int p = 0; p<NPixels; p++)
+        {
+          if (!is_known[p])
+          {
+            sum += Weights[i][p];
+          }
+        }
+        SummedWeights[i] = sum;
+      }
+    }
+
+    /// @return the concentration of a pixel with a known erosion rate
+    /// @param k the index of the pixel in KnownPixels
+    double known_concentration(int k) const
+    {
+      int p = KnownPixels[k];
+      double N = 0;
+      for (int i = 0; i<4; i++)
+      {
+        N += Weights[i][p]/(KnownErosion[k]+GammaLambda[i]);
+      }
+      return N;
+    }
+
+    /// @return the effective depth at which the production, with the F values
+    ///  given, falls to single_scaling. This is the Newton-Raphson search of
+    ///  LSDCRNParameters::scale_F_values, which then multiplies each F value
+    ///  by exp(-depth/Gamma).
+    static double scaling_depth(double single_scaling, const double F[4], const double Gamma[4])
+    {
+      double new_x = 0;
+      double displace_x = 1e-6;
+      double tolerance = 1e-7;
+      double x_change;
+      do
+      {
+        double fx = exp(-new_x/Gamma[0])*F[0]+
+                    exp(-new_x/Gamma[1])*F[1]+
+                    exp(-new_x/Gamma[2])*F[2]+
+                    exp(-new_x/Gamma[3])*F[3]-single_scaling;
+        double fx_displace = exp(-(new_x+displace_x)/Gamma[0])*F[0]+
+                             exp(-(new_x+displace_x)/Gamma[1])*F[1]+
+                             exp(-(new_x+displace_x)/Gamma[2])*F[2]+
+                             exp(-(new_x+displace_x)/Gamma[3])*F[3]-single_scaling;
+        double fx_derivative = (fx_displace-fx)/displace_x;
+        if(fx_derivative != 0)
+        {
+          x_change = fx/fx_derivative;
+          new_x = new_x-x_change;
+        }
+        else
+        {
+          x_change = 0;
+        }
+      } while(fabs(x_change) > tolerance);
+      return new_x;
+    }
+
+    /// The number of pixels with data
+    int NPixels;
+    /// The weight of each pixel for each production pathway
+    vector<double> Weights[4];
+    /// The number of pixels with data whose erosion rate is not known
+    int NUnknown;
+    /// The weights summed over the pixels whose erosion rate is not known
+    double SummedWeights[4];
+    /// Gamma*lambda of each pathway
+    double GammaLambda[4];
+    /// The average production scaling times topographic shielding
+    double AverageProduction;
+    /// The production uncertainty
+    double ProductionUncertainty;
+    /// The pixels (in the order of the pixels with data) with a known erosion rate
+    vector<int> KnownPixels;
+    /// The known erosion rates of those pixels in g/cm^2/yr
+    vector<double> KnownErosion;
+    /// The sum of erosion rate times concentration of the known pixels
+    double KnownN;
+    /// The sum of the erosion rates of the known pixels
+    double KnownMass;
+};
+
+///@brief The search for the erosion rate that gives a measured concentration.
+///@details Each step is a Newton-Raphson step, given the concentration and its
+/// derivative at the current erosion rate. The concentration falls as the
+/// erosion rate goes up, so every step also narrows a bracket around the
+/// root: erosion rates whose concentration is too high are below it and those
+/// whose concentration is too low are above it. If a Newton step would leave
+/// the bracket, or the derivative does not fall, the step bisects the bracket
+/// instead (or, before there is a bracket, moves the erosion rate towards the
+/// root). Before there is a lower bracket a positive erosion rate is not
+/// stepped to zero or below; it is divided by ten instead. The search has converged when a step changes the erosion rate by
+/// less than the tolerance, which is the test of the Newton-Raphson
+/// iterations in LSDCosmoBasin::predict_CRN_erosion.
+///@author agent
+///@date 16/10/2026
+class LSDCRNErosionRoot
+{
+  public:
+    /// @brief An empty search
+    LSDCRNErosionRoot() : Target(0), ErosionRate(0), Change(0), Tolerance(1e-10),
+                          Lower(0), Upper(0), HasLower(false), HasUpper(false),
+                          NSteps(0), Converged(false) {}
+
+    /// @brief Starts a search
+    /// @param Nuclide_conc the measured concentration in atoms/g
+    /// @param eff_erosion_guess the first erosion rate in g/cm^2/yr
+    LSDCRNErosionRoot(double Nuclide_conc, double eff_erosion_guess)
+                        : Target(Nuclide_conc), ErosionRate(eff_erosion_guess),
+                          Change(0), Tolerance(1e-10), Lower(0), Upper(0),
+                          HasLower(false), HasUpper(false), NSteps(0), Converged(false) {}
+
+    /// @brief Takes a step
+    /// @param N the concentration at the current erosion rate in atoms/g
+    /// @param dN_de its derivative with the erosion rate
+    void step(double N, double dN_de)
+    {
+      double f_x = N-Target;
+      NSteps++;
+      if (f_x == 0)
+      {
+        Change = 0;
+        Converged = true;
+        return;
+      }
+
+      // narrow the bracket
+      if (f_x > 0)
+      {
+        Lower = ErosionRate;
+        HasLower = true;
+      }
+      else
+      {
+        Upper = ErosionRate;
+        HasUpper = true;
+      }
+
+      double new_erosion_rate = ErosionRate;
+      bool use_newton = (dN_de < 0);
+      if (use_newton)
+      {
+        new_erosion_rate = ErosionRate-f_x/dN_de;
+        use_newton = ((!HasLower || new_erosion_rate > Lower) &&
+                      (!HasUpper || new_erosion_rate < Upper));
+
+        // without a lower bracket a step from a positive erosion rate
+        // stays positive: the concentration has a pole just below zero
+        // (at -Gamma*lambda) and a step past it never comes back
+        if (use_newton && !HasLower && ErosionRate > 0 && new_erosion_rate <= 0)
+        {
+          new_erosion_rate = 0.1*ErosionRate;
+        }
+      }
+      if (!use_newton)
+      {
+        if (HasLower && HasUpper)
+        {
+          new_erosion_rate = 0.5*(Lower+Upper);
+        }
+        else if (f_x > 0)
+        {
+          new_erosion_rate = ErosionRate+max(fabs(ErosionRate), Tolerance);
+        }
+        else
+        {
+          new_erosion_rate = (ErosionRate > 0) ? 0.1*ErosionRate : ErosionRate-Tolerance;
+        }
+      }
+
+      Change = new_erosion_rate-ErosionRate;
+      ErosionRate = new_erosion_rate;
+      Converged = (fabs(Change) <= Tolerance);
+    }
+
+    /// @return the current erosion rate in g/cm^2/yr, which is the root once
+    ///  the search has converged
+    double get_erosion_rate() const { return ErosionRate; }
+
+    /// @return true once the search has converged
+    bool is_converged() const { return Converged; }
+
+    /// @return the number of steps taken
+    int get_NSteps() const { return NSteps; }
+
+    /// @brief Sets the largest change in erosion rate of a converged step
+    /// @param tolerance the change in g/cm^2/yr
+    void set_tolerance(double tolerance) { Tolerance = tolerance; }
+
+  private:
+    /// The measured concentration in atoms/g
+    double Target;
+    /// The current erosion rate in g/cm^2/yr
+    double ErosionRate;
+    /// The change in erosion rate of the last step
+    double Change;
+    /// The largest change in erosion rate of a converged step
+    double Tolerance;
+    /// The largest erosion rate found whose concentration is too high
+    double Lower;
+    /// The smallest erosion rate found whose concentration is too low
+    double Upper;
+    /// Whether Lower has been found
+    bool HasLower;
+    /// Whether Upper has been found
+    bool HasUpper;
+    /// The number of steps taken
+    int NSteps;
+    /// Whether the search has converged
+    bool Converged;
+};
+
+///@brief Finds the erosion rates of many kernels at once.
+///@details The kernels can be different basins, or the same basin with
+/// different production or muon schemes as in the uncertainty inversions of
+/// LSDCosmoBasin::full_CRN_erosion_analysis. All the searches are advanced one
+/// step at a time together, each using the concentration and derivative of
+/// its kernel, and a search drops out once it has converged. Once a kernel
+/// is prepared a step costs a handful of operations, so there are no passes
+/// over the pixels of the basin during the search.
+///@author agent
+///@date 16/10/2026
+class LSDCRNErosionSolver
+{
+  public:
+    /// @brief A solver with the default tolerance (1e-10 g/cm^2/yr) and
+    ///  limit of steps
+    LSDCRNErosionSolver() : Tolerance(1e-10), MaxSteps(200) {}
+
+    /// @brief Sets the largest change in erosion rate of a converged step
+    /// @param tolerance the change in g/cm^2/yr
+    void set_tolerance(double tolerance) { Tolerance = tolerance; }
+
+    /// @brief Sets the largest number of steps of any search
+    /// @param max_steps the number of steps
+    void set_max_steps(int max_steps) { MaxSteps = max_steps; }
+
+    /// @brief Finds the erosion rates
+    /// @param kernels the kernels
+    /// @param Nuclide_conc the measured concentration of each kernel in atoms/g
+    /// @param eff_erosion_rates the first guesses of the erosion rates in
+    ///  g/cm^2/yr, replaced with the erosion rates found
+    /// @return the number of steps taken, which is that of the slowest search.
+    ///  Searches that reach the limit of steps are reported to the screen.
+    int solve(vector<const LSDCRNConcentrationKernel*>& kernels,
+              vector<double>& Nuclide_conc, vector<double>& eff_erosion_rates) const
+    {
+      int n_roots = int(kernels.size());
+      vector<LSDCRNErosionRoot> roots(n_roots);
+      vector<int> active;
+      for (int r = 0; r<n_roots; r++)
+      {
+        roots[r] = LSDCRNErosionRoot(Nuclide_conc[r], eff_erosion_rates[r]);
+        roots[r].set_tolerance(Tolerance);
+        active.push_back(r);
+      }
+
+      int n_steps = 0;
+      while (!active.empty() && n_steps < MaxSteps)
+      {
+        n_steps++;
+        int n_active = int(active.size());
+        #pragma omp parallel for if(n_active > 256)
+        for (int a = 0; a<n_active; a++)
+        {
+          LSDCRNErosionRoot& root = roots[active[a]];
+          double dN_de;
+          double N = kernels[active[a]]->mean_concentration(root.get_erosion_rate(), dN_de);
+          root.step(N, dN_de);
+        }
+
+        // keep the searches that have not converged
+        int n_kept = 0;
+        for (int a = 0; a<n_active; a++)
+        {
+          if (!roots[active[a]].is_converged())
+          {
+            active[n_kept] = active[a];
+            n_kept++;
+          }
+        }
+        active.resize(n_kept);
+      }
+      if (!active.empty())
+      {
+        cout << "LSDCRNErosionSolver, " << active.size() << " erosion rates did not"
+             << " converge in " << MaxSteps << " steps" << endl;
+      }
+
+      for (int r = 0; r<n_roots; r++)
+      {
+        eff_erosion_rates[r] = roots[r].get_erosion_rate();
+      }
+      return n_steps;
+    }
+
+  private:
+    /// The largest change in erosion rate of a converged step
+    double Tolerance;
+    /// The largest number of steps of any search
+    int MaxSteps;
+};
+
+#endif
@@ -0,0 +1,305 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDCRNMuonTable
+// Land Surface Dynamics Cosmogenic Radionuclide Muon Table
+//
+// A lookup table of the flux of vertically travelling muons at a site, as a
+// function of depth and atmospheric pressure, for the CRONUS (Heisinger)
+// muon production scheme, within the University of Edinburgh Land Surface
+// Dynamics group topographic toolbox
+//
+// In LSDCRNParameters::P_mu_total this flux is a numerical integral of the
+// muon stopping rate from the sample depth to 2e5 g/cm^2, and it is the only
+// part of the muon production that is not in closed form. The table holds it
+// on a grid of depths and pressures, together with its derivative with depth
+// (which is in closed form), and it is interpolated with cubics. The table
+// is built (in LSDCRNParameters) by refining the grid until the
+// interpolation error at the midpoints of every cell and cell edge, plus the
+// error of the integration, is below a tolerance; that error is kept with
+// the table. Tables can be written to and read from disk so they only need
+// to be built once.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDCRNMuonTable_H
+#define LSDCRNMuonTable_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+///@brief The site flux of vertically travelling muons (phi_vert_site in
+/// LSDCRNParameters::P_mu_total) on a grid of depth and pressure.
+///@details Depths go from 0 to 2e5 g/cm^2 and can be anywhere in between;
+/// the attenuation length of muons in the atmosphere is interpolated from a
+/// table of range and momentum, so the muon stopping rate has kinks at the
+/// ranges of that table and these should be depths of the grid. Pressures go
+/// from 250 to 1050 hPa, evenly spaced. Between two depths the log of the
+/// flux is interpolated with a cubic Hermite polynomial, using its derivative
+/// with depth at the two depths; across the pressures it is interpolated with
+/// cubic Lagrange polynomials through four pressures.
+///@author agent
+///@date 16/10/2026
+class LSDCRNMuonTable
+{
+  public:
+    /// @brief An empty table
+    LSDCRNMuonTable() : NDepths(0), NPressures(0), dH(0),
+                        Tolerance(0), MaxError(0) {}
+
+    /// @brief Sets up an empty grid
+    /// @param depths the depths in g/cm^2, increasing from 0 to MaxDepth()
+    /// @param n_pressures the number of pressures, at least 4
+    void set_grid(vector<double>& depths, int n_pressures)
+    {
+      Depths = depths;
+      NDepths = int(Depths.size());
+      NPressures = n_pressures;
+      dH = (MaxPressure()-MinPressure())/double(NPressures-1);
+      LogPhi.assign(NDepths*NPressures, 0.0);
+      DLogPhi.assign(NDepths*NPressures, 0.0);
+    }
+
+    /// @return a depth (g/cm^2) of the grid
+    double get_depth(int i) const { return Depths[i]; }
+
+    /// @return a pressure (hPa) of the grid
+    double get_pressure(int j) const { return MinPressure()+double(j)*dH; }
+
+    /// @brief Sets the flux at a node
+    /// @param i the depth index
+    /// @param j the pressure index
+    /// @param phi the flux in muons/cm^2/s/sr
+    /// @param dphi_dz the derivative of the flux with depth, which is minus
+    ///  the stopping rate of vertical muons
+    void set_phi(int i, int j, double phi, double dphi_dz)
+    {
+      LogPhi[i*NPressures+j] = log(phi);
+      DLogPhi[i*NPressures+j] = dphi_dz/phi;
+    }
+
+    /// @return true if a depth and pressure are in the table
+    /// @param z depth in g/cm^2
+    /// @param h pressure in hPa
+    bool covers(double z, double h) const
+    {
+      return (NDepths > 0 && z >= 0 && z <= MaxDepth() && h >= MinPressure() && h <= MaxPressure());
+    }
+
+    /// @return the interpolated flux in muons/cm^2/s/sr. The depth and
+    ///  pressure must be in the table (see covers).
+    /// @param z depth in g/cm^2
+    /// @param h pressure in hPa
+    double phi_vert_site(double z, double h) const
+    {
+      // the depths either side
+      int i = int(upper_bound(Depths.begin(), Depths.end()-1, z)-Depths.begin())-1;
+      if (i < 0)
+      {
+        i = 0;
+      }
+      double dz = Depths[i+1]-Depths[i];
+      double t = (z-Depths[i])/dz;
+      double h00 = (1.0+2.0*t)*(1.0-t)*(1.0-t);
+      double h10 = t*(1.0-t)*(1.0-t)*dz;
+      double h01 = t*t*(3.0-2.0*t);
+      double h11 = t*t*(t-1.0)*dz;
+
+      // the four pressures around
+      double wh[4];
+      int j = stencil((h-MinPressure())/dH, NPressures, wh);
+      const double* top = &LogPhi[i*NPressures+j];
+      const double* bottom = &LogPhi[(i+1)*NPressures+j];
+      const double* dtop = &DLogPhi[i*NPressures+j];
+      const double* dbottom = &DLogPhi[(i+1)*NPressures+j];
+      double log_phi = 0;
+      for (int b = 0; b<4; b++)
+      {
+        log_phi += wh[b]*(h00*top[b]+h10*dtop[b]+h01*bottom[b]+h11*dbottom[b]);
+      }
+      return exp(log_phi);
+    }
+
+    /// @brief Sets the tolerance the table was built to and the error it has
+    /// @param tolerance the largest relative error that was asked for
+    /// @param max_error the largest relative error found when it was built
+    void set_errors(double tolerance, double max_error)
+    {
+      Tolerance = tolerance;
+      MaxError = max_error;
+    }
+
+    /// @return the largest relative error that was asked for
+    double get_tolerance() const { return Tolerance; }
+
+    /// @return the largest relative error of the flux found when the table
+    ///  was built
+    double get_max_error() const { return MaxError; }
+
+    /// @return the number of depths
+    int get_NDepths() const { return NDepths; }
+
+    /// @return the number of pressures
+    int get_NPressures() const { return NPressures; }
+
+    /// @brief Writes the table to a binary file
+    /// @param filename the name of the file, with extension
+    /// @return false if the file could not be written
+    bool write(string filename) const
+    {
+      ofstream out(filename.c_str(), ios::out | ios::binary);
+      if (out.fail())
+      {
+        return false;
+      }
+      int version = FileVersion();
+      out.write(reinterpret_cast<const char*>(&version), sizeof(int));
+      out.write(reinterpret_cast<const char*>(&NDepths), sizeof(int));
+      out.write(reinterpret_cast<const char*>(&NPressures), sizeof(int));
+      out.write(reinterpret_cast<const char*>(&Tolerance), sizeof(double));
+      out.write(reinterpret_cast<const char*>(&MaxError), sizeof(double));
+      out.write(reinterpret_cast<const char*>(&Depths[0]), sizeof(double)*Depths.size());
+      out.write(reinterpret_cast<const char*>(&LogPhi[0]), sizeof(double)*LogPhi.size());
+      out.write(reinterpret_cast<const char*>(&DLogPhi[0]), sizeof(double)*DLogPhi.size());
+      out.close();
+      return !out.fail();
+    }
+
+    /// @brief Reads a table written by write
+    /// @param filename the name of the file, with extension
+    /// @return false if there is no such file or it is not a table
+    bool read(string filename)
+    {
+      ifstream in(filename.c_str(), ios::in | ios::binary);
+      if (in.fail())
+      {
+        return false;
+      }
+      int version = 0;
+      int n_depths = 0;
+      int n_pressures = 0;
+      double tolerance, max_error;
+      in.read(reinterpret_cast<char*>(&version), sizeof(int));
+      in.read(reinterpret_cast<char*>(&n_depths), sizeof(int));
+      in.read(reinterpret_cast<char*>(&n_pressures), sizeof(int));
+      in.read(reinterpret_cast<char*>(&tolerance), sizeof(double));
+      in.read(reinterpret_cast<char*>(&max_error), sizeof(double));
+      if (in.fail() || version != FileVersion() || n_depths < 2 || n_pressures < 4)
+      {
+        return false;
+      }
+      vector<double> depths(n_depths);
+      in.read(reinterpret_cast<char*>(&depths[0]), sizeof(double)*n_depths);
+      set_grid(depths, n_pressures);
+      in.read(reinterpret_cast<char*>(&LogPhi[0]), sizeof(double)*LogPhi.size());
+      in.read(reinterpret_cast<char*>(&DLogPhi[0]), sizeof(double)*DLogPhi.size());
+      if (in.fail())
+      {
+        NDepths = 0;
+        NPressures = 0;
+        return false;
+      }
+      set_errors(tolerance, max_error);
+      return true;
+    }
+
+    /// The shift in the log depth spacing of the grid, in g/cm^2
+    static double DepthShift() { return 10.0; }
+    /// The deepest depth in g/cm^2, the bottom of the integral of the flux
+    static double MaxDepth() { return 2.0e5; }
+    /// The lowest pressure in hPa
+    static double MinPressure() { return 250.0; }
+    /// The highest pressure in hPa
+    static double MaxPressure() { return 1050.0; }
+
+  private:
+    /// @brief The cubic Lagrange weights of the four nodes around a point
+    /// @param t the location in units of the node spacing
+    /// @param n_nodes the number of nodes
+    /// @param w replaced with the weights of nodes i, i+1, i+2 and i+3
+    /// @return i, the first node. The point is between nodes i+1 and i+2
+    ///  except in the first and last cells.
+    static int stencil(double t, int n_nodes, double* w)
+    {
+      int i = int(t)-1;
+      if (i < 0)
+      {
+        i = 0;
+      }
+      else if (i > n_nodes-4)
+      {
+        i = n_nodes-4;
+      }
+      double s = t-double(i+1);
+      w[0] = -s*(s-1.0)*(s-2.0)/6.0;
+      w[1] = (s+1.0)*(s-1.0)*(s-2.0)/2.0;
+      w[2] = -(s+1.0)*s*(s-2.0)/2.0;
+      w[3] = (s+1.0)*s*(s-1.0)/6.0;
+      return i;
+    }
+
+    /// The version of the file layout
+    static int FileVersion() { return 1; }
+
+    /// The number of depths
+    int NDepths;
+    /// The number of pressures
+    int NPressures;
+    /// The spacing of the pressures in hPa
+    double dH;
+    /// The largest relative error that was asked for
+    double Tolerance;
+    /// The largest relative error found when the table was built
+    double MaxError;
+    /// The depths in g/cm^2
+    vector<double> Depths;
+    /// The log of the flux, by depth then pressure
+    vector<double> LogPhi;
+    /// The derivative of the log of the flux with depth, by depth then pressure
+    vector<double> DLogPhi;
+};
+
+#endif
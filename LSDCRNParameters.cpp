@@ -53,6 +53,8 @@
 //
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 #include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <math.h>
 #include <iostream>
 #include <vector>
@@ -75,6 +77,9 @@ void LSDCRNParameters::create()
 {
   version = "1.0";
   
+  NCEPData = NULL;
+  CRONUSMuonTable = NULL;
+  
   S_t = 1;
   neutron_S_t = 1;
 
@@ -124,148 +129,12 @@ void LSDCRNParameters::create()
 }
 
 // this function gets the parameters used to convert elevation to 
-// pressure
+// pressure. The data are shared by all the parameter objects, so they are
+// only read the first time
 void LSDCRNParameters::load_parameters_for_atmospheric_scaling(string path_to_data)
 {
   cout.precision(8);
-  
-  // first load the levels
-  levels.push_back(1000);
-  levels.push_back(925);
-  levels.push_back(850);
-  levels.push_back(700);
-  levels.push_back(600);
-  levels.push_back(500);
-  levels.push_back(400);
-  levels.push_back(300);
-  
-  // the dimensions of the data
-  int n_levels = 8;
-  int NRows = 73;
-  int NCols = 145;
-  Array2D<double> new_slp(NRows,NCols,0.0);
-  Array2D<double> new_meant(NRows,NCols,0.0);
-    
-  // now load the mean sea level pressure
-  string filename = "NCEP2.bin";
-  filename = path_to_data+filename;
-  //cout << "Loading mean sea level, file is: " << endl << filename << endl;
-
-  ifstream ifs_data(filename.c_str(), ios::in | ios::binary);
-  if( ifs_data.fail() )
-  {
-    cout << "\nFATAL ERROR: the data file \"" << filename
-         << "\" doesn't exist" << endl;
-    exit(EXIT_FAILURE);
-  }  
-  
-
-  double temp;
-  //cout << "The size of a double is: " << sizeof(temp) << endl;
-  for (int i=0; i<NCols; ++i)
-  {
-    for (int j=0; j<NRows; ++j)
-    {
-      ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-      new_slp[j][i] = temp;
-      //cout << "new_slp["<<j+1<<"]["<<i+1<<"]: " << new_slp[j][i] << endl;
-    }
-  }
-  
-  for (int i=0; i<NCols; ++i)
-  {
-    for (int j=0; j<NRows; ++j)
-    {
-      ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-      new_meant[j][i] = temp;
-      //cout << "new_meant100["<<j+1<<"]["<<i+1<<"]: " << new_meant[j][i] << endl;
-    }
-  }  
-  
-  // now get the indices
-  vector<double> temp_lat(NRows,0.0);
-  for (int i=0; i<NRows; ++i)
-  {
-    ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-    temp_lat[i] = temp;
-    //cout << "Lat["<<i+1<<"]: " << temp_lat[i] << endl;
-  }
-  vector<double> temp_long(NCols,0.0);
-  for (int i=0; i<NCols; ++i)
-  {
-    ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-    temp_long[i] = temp;
-    //cout << "Long["<<i+1<<"]: " << temp_long[i] << endl;
-  }  
-  
-  ifs_data.close();
-  
-  
-  // now the data with levels
-  filename = "NCEP_hgt.bin";
-  filename = path_to_data+filename;
-  //cout << "Loading hgt, file is: " << endl << filename << endl;
-
-  ifstream ifs_data2(filename.c_str(), ios::in | ios::binary);
-  if( ifs_data2.fail() )
-  {
-    cout << "\nFATAL ERROR: the data file \"" << filename
-         << "\" doesn't exist" << endl;
-    exit(EXIT_FAILURE);
-  }  
-  
-
-  // get the gm heights
-  vector< Array2D<double> > vec_hgt_gm_array;
-  for (int lvl = 0; lvl < n_levels; lvl++)
-  {
-    Array2D<double> current_hgt_array(NRows,NCols,0.0);
-    for (int i=0; i<NCols; ++i)
-    {
-      for (int j=0; j<NRows; ++j)
-      {
-        ifs_data2.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-        current_hgt_array[j][i] = temp;
-        //cout << "new_slp["<<lvl<<"]["<<j+1<<"]["<<i+1<<"]: " << current_hgt_array[j][i] << endl;
-      }
-    }
-    //cout << "new_slp["<<j+1<<"]["<<i+1<<"]: " << new_slp[j][i] << endl;
-    vec_hgt_gm_array.push_back(current_hgt_array.copy());
-  }
-
-  // now the gp heights
-  vector< Array2D<double> > vec_hgt_gp_array;
-  for (int lvl = 0; lvl < n_levels; lvl++)
-  {
-    Array2D<double> current_hgt_array(NRows,NCols,0.0);
-    for (int i=0; i<NCols; ++i)
-    {
-      for (int j=0; j<NRows; ++j)            
-      {
-        ifs_data2.read(reinterpret_cast<char*>(&temp), sizeof(temp));
-        current_hgt_array[j][i] = temp;
-        //cout << "new_slp["<<lvl<<"]["<<j+1<<"]["<<i+1<<"]: " << current_hgt_array[j][i] << endl;
-      }
-    }
-    //cout << "new_slp["<<j+1<<"]["<<i+1<<"]: " << new_slp[j][i] << endl;
-    vec_hgt_gp_array.push_back(current_hgt_array.copy());
-  }
-  ifs_data2.close();
-  
-  // now update the data elements
-  NCEPlat = temp_lat;
-  NCEPlon = temp_long;
-  
-  meanslp = new_slp.copy();
-  meant1000 = new_meant.copy();
-  gp_hgt = vec_hgt_gp_array;
-  gm_hgt = vec_hgt_gp_array;  
-  
-  //cout << "Size lat: " << NCEPlat.size() << " size long: " << NCEPlon.size() << endl;
-  //cout << "size slp:" << meanslp.dim1() << " " << meanslp.dim2() << endl;
-  //cout << "size t1000: " << meant1000.dim1() << " " << meant1000.dim2() << endl;
-  
-
+  NCEPData = &LSDNCEPAtmosphere::get(path_to_data);
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -508,6 +377,12 @@ vector<double> LSDCRNParameters::get_Stone_Pref()
 vector<double> LSDCRNParameters::calculate_muon_production_CRONUS(double z, double h)
 {
   vector<double> Muon_production(4,0.0);
+  if (CRONUSMuonTable != NULL && CRONUSMuonTable->covers(z,h))
+  {
+    P_mu_total_from_table(z,h,Muon_production[0],Muon_production[1],
+                          Muon_production[2],Muon_production[3]);
+    return Muon_production;
+  }
   P_mu_total(z,h);
   
   
@@ -715,6 +590,16 @@ void LSDCRNParameters::P_mu_total(double z,double h)
 void LSDCRNParameters::P_mu_total_return_nuclides(double z,double h, 
                                    double& Be10_total_mu, double& Al26_total_mu)
 {
+  // if there is a muon table, the flux is interpolated
+  if (CRONUSMuonTable != NULL && CRONUSMuonTable->covers(z,h))
+  {
+    double P_fast_10Be, P_fast_26Al, P_neg_10Be, P_neg_26Al;
+    P_mu_total_from_table(z,h,P_fast_10Be,P_fast_26Al,P_neg_10Be,P_neg_26Al);
+    Be10_total_mu = P_fast_10Be+P_neg_10Be;
+    Al26_total_mu = P_fast_26Al+P_neg_26Al;
+    return;
+  }
+
   // get the muon roduction
   P_mu_total(z,h);
   
@@ -734,6 +619,8 @@ void LSDCRNParameters::P_mu_total_return_nuclides(double z,double h,
 // Will probably need to come back and try to speed up. 
 // The best way is to retain previously calculated balues, so at new
 // node spacings only the intermediate values are recalculated. 
+// set_CRONUS_muon_table replaces this with a lookup table of the flux in the
+// muon production functions; this stays as the reference.
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 double LSDCRNParameters::integrate_muon_flux(double z, double H, double tolerance)
 {
@@ -865,7 +752,39 @@ double LSDCRNParameters::Rv0(double z)
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 double LSDCRNParameters::LZ(double z)
 {
+  // the range/momentum table in logs. This is only set up the first time
+  // LZ is called
+  static vector< vector<double> > log_table = LZ_log_table();
 
+  // deal with zero situation
+  if(z < 1)
+  {
+    z = 1.0;
+  }
+
+  double log_z = log(z);
+  //cout << "z is:" << z << " and log z is: " << log_z << endl;
+
+
+  // obtain momenta
+  // use log-linear interpolation
+  double P_MeVc = exp(interp1D_ordered(log_table[0],log_table[1],log_z));
+  //cout << "log_z: " <<  log_z << " interp: " 
+  //     << interp1D_ordered(log_table[0],log_table[1],log_z) << " P_MeVc: " << P_MeVc << endl;
+
+  // obtain attenuation lengths
+  double out = 263.0 + 150*(P_MeVc/1000.0);
+  return out;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// The range/momentum table used by LZ, in logs
+// The log range is in element 0 and the log momentum in element 1
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+vector< vector<double> > LSDCRNParameters::LZ_log_table()
+{
   //define range/momentum relation
   // table for muons in standard rock in Groom and others 2001
   // units are range in g cm-2 (column 2)
@@ -933,18 +852,6 @@ double LSDCRNParameters::LZ(double z)
   data_for_LZ_momentum.push_back(8.001e5);
   data_for_LZ_range.push_back(2.129e5);
 
-  // deal with zero situation
-  if(z < 1)
-  {
-    z = 1.0;
-  }
-
-  double log_z = log(z);
-  //cout << "z is:" << z << " and log z is: " << log_z << endl;
-
-
-  // obtain momenta
-  // use log-linear interpolation
   int n_momentum_dpoints = int(data_for_LZ_momentum.size());
   vector<double> log_momentum;
   vector<double> log_range;
@@ -952,15 +859,370 @@ double LSDCRNParameters::LZ(double z)
   {
     log_momentum.push_back(log(data_for_LZ_momentum[i]));
     log_range.push_back(log(data_for_LZ_range[i]));
-    //cout << "Momentum: " << log_momentum[i] << " range: " << log_range[i] << endl;
   }
-  double P_MeVc = exp(interp1D_ordered(log_range,log_momentum,log_z));
-  //cout << "log_z: " <<  log_z << " interp: " 
-  //     << interp1D_ordered(log_range,log_momentum,log_z) << " P_MeVc: " << P_MeVc << endl;
+  vector< vector<double> > log_table;
+  log_table.push_back(log_range);
+  log_table.push_back(log_momentum);
+  return log_table;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
-  // obtain attenuation lengths
-  double out = 263.0 + 150*(P_MeVc/1000.0);
-  return out;
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This integrates the muon stopping rate to get the flux of vertical muons at
+// the site (as in P_mu_total) at many depths and pressures.
+// The stopping rate and the attenuation length only depend on depth, so they
+// are calculated once at each quadrature point and used for every pressure.
+// Each pressure then needs one exponential per quadrature point, rather than
+// an integration with refinement for every depth as in integrate_muon_flux.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDCRNParameters::integrate_muon_flux_on_grid(vector<double>& z, vector<double>& h,
+                                   int n_panels, vector< vector<double> >& phi)
+{
+  // 4 point Gauss-Legendre nodes and weights on [-1,1]
+  double gl_x[4] = {-0.86113631159405258, -0.33998104358485626,
+                     0.33998104358485626,  0.86113631159405258};
+  double gl_w[4] = { 0.34785484513745386,  0.65214515486254614,
+                     0.65214515486254614,  0.34785484513745386};
+
+  // the panels are evenly spaced in log(z+shift)
+  double shift = LSDCRNMuonTable::DepthShift();
+
+  // the integral ends at 200,001 g/cm2 as in integrate_muon_flux. Piece k
+  // goes from z[k] to z[k+1], and the last piece to the end
+  int n_z = int(z.size());
+  int n_points = n_z*n_panels*4;
+  vector<double> weight(n_points);
+  vector<double> stopping(n_points);
+  vector<double> inverse_LZ(n_points);
+  int p = 0;
+  for(int k = 0; k<n_z; k++)
+  {
+    double top = log(z[k]+shift);
+    double bottom = (k < n_z-1) ? log(z[k+1]+shift) : log(2.0e5+1.0+shift);
+    double du = (bottom-top)/double(n_panels);
+    for(int panel = 0; panel<n_panels; panel++)
+    {
+      double centre = top+(double(panel)+0.5)*du;
+      for(int q = 0; q<4; q++)
+      {
+        double u = centre+0.5*du*gl_x[q];
+        double this_z = exp(u)-shift;
+        weight[p] = 0.5*du*gl_w[q]*exp(u);
+        stopping[p] = Rv0(this_z);
+        inverse_LZ[p] = 1.0/LZ(this_z);
+        p++;
+      }
+    }
+  }
+
+  // invariant flux at 2e5 g/cm2 depth, as in P_mu_total
+  double a = 258.5*(pow(100,2.66));
+  double b = 75*(pow(100,1.66));
+  double phi_200k = (a/((2.0e5+21000.0)*((pow((2.0e5+1000.0),1.66)) + b)))
+                      *exp(-5.5e-6 * 2.0e5);
+
+  int n_h = int(h.size());
+  phi.assign(n_z, vector<double>(n_h,0.0));
+  int points_per_piece = n_panels*4;
+  for(int j = 0; j<n_h; j++)
+  {
+    // atmospheric depth in g/cm2
+    double H = (1013.25 - h[j])*1.019716;
+
+    // add up the pieces from the bottom
+    double sum = phi_200k;
+    for(int k = n_z-1; k>=0; k--)
+    {
+      double piece = 0;
+      for(int q = k*points_per_piece; q<(k+1)*points_per_piece; q++)
+      {
+        piece += weight[q]*stopping[q]*exp(H*inverse_LZ[q]);
+      }
+      sum += piece;
+      phi[k][j] = sum;
+    }
+  }
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This builds the lookup table of the muon flux
+// The depths are spaced evenly in log(z+shift), plus the ranges of the LZ
+// table and 1 g/cm^2 (below which LZ is constant), where the stopping rate
+// has kinks, so the flux is smooth between any two depths. The flux is
+// integrated on a grid with the depths and pressures of the table and the
+// midpoints between them, which is where the interpolation is checked. The
+// integration is checked with twice as many panels. Whichever of the depth
+// spacing, the pressure spacing and the panels has too large an error is
+// refined, until the interpolation error and the integration error add up
+// to less than the tolerance.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDCRNParameters::build_CRONUS_muon_table(double tolerance, LSDCRNMuonTable& table)
+{
+  int n_log_depths = 17;
+  int n_pressures = 9;
+  int n_panels = 2;
+
+  // limits on the refinement so a tolerance that is too small still stops
+  int max_log_depths = 16385;
+  int max_pressures = 1025;
+  int max_panels = 64;
+
+  // the depths where the stopping rate has kinks
+  double shift = LSDCRNMuonTable::DepthShift();
+  double max_depth = LSDCRNMuonTable::MaxDepth();
+  vector<double> kinks(1,1.0);
+  vector< vector<double> > log_table = LZ_log_table();
+  for(int k = 0; k<int(log_table[0].size()); k++)
+  {
+    double range = exp(log_table[0][k]);
+    if (range > 1.0 && range < max_depth)
+    {
+      kinks.push_back(range);
+    }
+  }
+
+  bool finished = false;
+  do
+  {
+    // the depths of the table
+    vector<double> depths = kinks;
+    double dx = (log(max_depth+shift)-log(shift))/double(n_log_depths-1);
+    for(int i = 0; i<n_log_depths-1; i++)
+    {
+      depths.push_back(exp(log(shift)+double(i)*dx)-shift);
+    }
+    depths.push_back(max_depth);
+    sort(depths.begin(),depths.end());
+    depths.erase(unique(depths.begin(),depths.end()),depths.end());
+    int n_depths = int(depths.size());
+    table.set_grid(depths, n_pressures);
+
+    // the grid with the table nodes and the check points
+    vector<double> z;
+    for(int i = 0; i<n_depths; i++)
+    {
+      z.push_back(depths[i]);
+      if (i < n_depths-1)
+      {
+        z.push_back(0.5*(depths[i]+depths[i+1]));
+      }
+    }
+    vector<double> h;
+    for(int j = 0; j<n_pressures; j++)
+    {
+      h.push_back(table.get_pressure(j));
+      if (j < n_pressures-1)
+      {
+        h.push_back(table.get_pressure(j)+0.5*(table.get_pressure(j+1)-table.get_pressure(j)));
+      }
+    }
+
+    // integrate with the panels and twice the panels
+    vector< vector<double> > phi_check;
+    vector< vector<double> > phi;
+    integrate_muon_flux_on_grid(z, h, n_panels, phi_check);
+    integrate_muon_flux_on_grid(z, h, 2*n_panels, phi);
+
+    // the table nodes, with the derivative of the flux, which is minus the
+    // stopping rate
+    for(int i = 0; i<n_depths; i++)
+    {
+      double stopping = Rv0(depths[i]);
+      double inverse_LZ = 1.0/LZ(depths[i]);
+      for(int j = 0; j<n_pressures; j++)
+      {
+        double H = (1013.25 - table.get_pressure(j))*1.019716;
+        table.set_phi(i,j,phi[2*i][2*j],-stopping*exp(H*inverse_LZ));
+      }
+    }
+
+    // check the integration everywhere, and the interpolation at the
+    // midpoints of the depth edges, the pressure edges and the cells
+    double integration_error = 0;
+    double depth_error = 0;
+    double pressure_error = 0;
+    double cell_error = 0;
+    for(int i = 0; i<int(z.size()); i++)
+    {
+      for(int j = 0; j<int(h.size()); j++)
+      {
+        double this_error = fabs(phi_check[i][j]-phi[i][j])/phi[i][j];
+        integration_error = max(integration_error,this_error);
+        if (i%2 == 0 && j%2 == 0)
+        {
+          continue;
+        }
+        this_error = fabs(table.phi_vert_site(z[i],h[j])-phi[i][j])/phi[i][j];
+        if (j%2 == 0)
+        {
+          depth_error = max(depth_error,this_error);
+        }
+        else if (i%2 == 0)
+        {
+          pressure_error = max(pressure_error,this_error);
+        }
+        else
+        {
+          cell_error = max(cell_error,this_error);
+        }
+      }
+    }
+    double interpolation_error = max(max(depth_error,pressure_error),cell_error);
+    double max_error = interpolation_error+integration_error;
+    table.set_errors(tolerance,max_error);
+
+    if (max_error <= tolerance)
+    {
+      finished = true;
+    }
+    else
+    {
+      // refine whatever has too much error. The error in the middle of the
+      // cells goes with the direction that has more error on the edges
+      bool refine_depths = (depth_error > 0.5*tolerance) ||
+                           (cell_error > 0.5*tolerance && depth_error >= pressure_error);
+      bool refine_pressures = (pressure_error > 0.5*tolerance) ||
+                              (cell_error > 0.5*tolerance && pressure_error > depth_error);
+      bool refined = false;
+      if (integration_error > 0.5*tolerance && 2*n_panels <= max_panels)
+      {
+        n_panels = 2*n_panels;
+        refined = true;
+      }
+      if (refine_depths && 2*n_log_depths-1 <= max_log_depths)
+      {
+        n_log_depths = 2*n_log_depths-1;
+        refined = true;
+      }
+      if (refine_pressures && 2*n_pressures-1 <= max_pressures)
+      {
+        n_pressures = 2*n_pressures-1;
+        refined = true;
+      }
+      if (refined == false)
+      {
+        cout << "LSDCRNParameters::build_CRONUS_muon_table, the muon table can't "
+             << "be refined any further. Its relative error is " << max_error
+             << ", the tolerance was " << tolerance << endl;
+        finished = true;
+      }
+    }
+  } while(finished == false);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This sets the muon table used for the CRONUS muon production. There is one
+// table per tolerance (and file) in a run; they are built the first time
+// they are asked for and then shared by all the parameter objects.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDCRNParameters::set_CRONUS_muon_table(double tolerance)
+{
+  string table_fname = "";
+  set_CRONUS_muon_table(tolerance, table_fname);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This sets the muon table, reading it from a file if the file holds a
+// table that is good enough and otherwise building it and writing it there.
+// An empty file name means the table is only kept in memory.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDCRNParameters::set_CRONUS_muon_table(double tolerance, string table_fname)
+{
+  static map<string, LSDCRNMuonTable> shared_tables;
+  #pragma omp critical(LSDCRNParameters_muon_table)
+  {
+    ostringstream key;
+    key << table_fname << "|" << tolerance;
+    map<string, LSDCRNMuonTable>::iterator iter = shared_tables.find(key.str());
+    if (iter == shared_tables.end())
+    {
+      iter = shared_tables.insert(make_pair(key.str(), LSDCRNMuonTable())).first;
+      LSDCRNMuonTable& table = iter->second;
+      if (table_fname.empty() == false && table.read(table_fname) &&
+          table.get_tolerance() <= tolerance)
+      {
+        cout << "Read the muon table from " << table_fname << endl;
+      }
+      else
+      {
+        build_CRONUS_muon_table(tolerance, table);
+        cout << "Built the muon table, " << table.get_NDepths() << " depths by "
+             << table.get_NPressures() << " pressures, relative error "
+             << table.get_max_error() << endl;
+        if (table_fname.empty() == false)
+        {
+          if (table.write(table_fname))
+          {
+            cout << "Wrote the muon table to " << table_fname << endl;
+          }
+          else
+          {
+            cout << "Warning, couldn't write the muon table to " << table_fname << endl;
+          }
+        }
+      }
+    }
+    CRONUSMuonTable = &(iter->second);
+  }
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// The CRONUS muon production with the flux of vertical muons at the site
+// from the muon table. Everything else is in closed form and is calculated
+// as in P_mu_total.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDCRNParameters::P_mu_total_from_table(double z, double h, double& P_fast_10Be,
+                             double& P_fast_26Al, double& P_neg_10Be,
+                             double& P_neg_26Al)
+{
+  // first check to see if CRONUS data maps are set
+  if(CRONUS_data_map.find("l10") == CRONUS_data_map.end())
+  {
+    cout << "You haven't set the CRONUS data map. I'm doing that for you now!" << endl;
+    set_CRONUS_data_maps();
+  }
+
+  // the atmospheric depth in g/cm2
+  double H = (1013.25 - h)*1.019716;
+
+  // the stopping rate and the flux of vertical muons at site
+  double R_vert_site = Rv0(z)*exp(H/LZ(z));
+  double phi_vert_site = CRONUSMuonTable->phi_vert_site(z,h);
+
+  // the total flux of muons at site
+  double nofz = 3.21 - 0.297*log((z+H)/100.0 + 42.0) + 1.21e-5*(z+H);
+  double dndz = (-0.297/100.0)/((z+H)/100.0 + 42.0) + 1.21e-5;
+  double phi_temp = (phi_vert_site*2* M_PI) / (nofz+1.0);
+  double phi = phi_temp*60.0*60.0*24.0*365.0;
+
+  // the total stopping rate of negative muons at site in muons/g/yr
+  double R_temp = (2*M_PI/(nofz+1.0))*R_vert_site 
+                  - phi_vert_site*(-2*M_PI*(1/((nofz+1.0)*(nofz+1.0))))*dndz;
+  double R = R_temp*0.44*60.0*60.0*24.0*365.0;
+
+  // Depth-dependent parts of the fast muon reaction cross-section
+  double Beta = 0.846 - 0.015 * log((z/100.0)+1.0) 
+                      + 0.003139 * (log((z/100.0)+1.0)*log((z/100.0)+1.0));
+  double Ebar = 7.6 + 321.7*(1 - exp(-8.059e-6*z)) 
+                    + 50.7*(1-exp(-5.05e-7*z));
+  double aalpha = 0.75;
+  double sigma0_Be10 = CRONUS_data_map["sigma190_10"]/(pow(190.0,aalpha));
+  double sigma0_Al26 = CRONUS_data_map["sigma190_26"]/(pow(190.0,aalpha));
+
+  // fast muon production and negative muon capture
+  double fast = phi*Beta*(pow(Ebar,aalpha));
+  P_fast_10Be = fast*sigma0_Be10*CRONUS_data_map["Natoms10"];
+  P_fast_26Al = fast*sigma0_Al26*CRONUS_data_map["Natoms26"];
+  P_neg_10Be = R*CRONUS_data_map["k_neg10"];
+  P_neg_26Al = R*CRONUS_data_map["k_neg26"];
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -2263,53 +2525,44 @@ void LSDCRNParameters::print_parameters_to_screen(vector<bool> nuclides_for_scal
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 double LSDCRNParameters::NCEPatm_2(double site_lat, double site_lon, double site_elev)
 {
-  // deal with negative longitudes
-  if(site_lon < 0)
-  {
-    site_lon = site_lon+360.0;
-  }
-  
-  //cout << "LSDCRNP, line 1618, Site lat: " << site_lat << " and long: " << site_lon << endl;
-  
   // check to see if data is loaded:
-  if (int(gm_hgt.size()) != 8)
+  if (NCEPData == NULL)
   {
     string path_to_data;
-    cout << "You didn't load the NCEP data. Doing that now. " << endl;
-    cout << "Enter path to data files: " << endl;
-    cin >> path_to_data;
+    if (!LSDNCEPAtmosphere::has_embedded_data())
+    {
+      cout << "You didn't load the NCEP data. Doing that now. " << endl;
+      cout << "Enter path to data files: " << endl;
+      cin >> path_to_data;
+    }
     load_parameters_for_atmospheric_scaling(path_to_data);
   }
   
-  // now, interpolate sea level pressure and temperature
-  //cout << "interpolating pressure " << endl;
-  double site_slp = interp2D_bilinear(NCEPlat, NCEPlon, meanslp, 
-                        site_lat, site_lon);
-  //cout << "Did pressure, now temp:" << endl;                      
-  double site_T = interp2D_bilinear(NCEPlat, NCEPlon, meant1000, 
-                        site_lat, site_lon);
-  //cout << "Did temp" << endl;                      
-  
-  
-  double site_T_degK = site_T + 273.15;
-
-  // Some More parameters
-  double gmr = -0.03417; // Assorted constants (this has come from Greg Balco's code)
-  double dtdz = 0.0065;  // Lapse rate from standard atmosphere 
-  
-  // Calculate site pressure using the site-specific SLP and T1000 with the
-  // standard atmosphere equation.
-
-  //cout << site_T_degK << endl;
-  //cout << "Log term: " << log(site_T_degK) - log(site_T_degK - (site_elev*dtdz)) << endl;
-  //cout << "Exp term: " << exp( (gmr/dtdz)*( log(site_T_degK) - log(site_T_degK - (site_elev*dtdz)) ) ) << endl;
+  // the interpolation of sea level pressure and temperature and the
+  // standard atmosphere equation are in LSDNCEPAtmosphere
+  return NCEPData->NCEPatm_2(site_lat, site_lon, site_elev);
+}
 
-  double out = site_slp*exp( (gmr/dtdz)*( log(site_T_degK) - log(site_T_degK - (site_elev*dtdz)) ) );
-  
-  //cout << endl;
-  //cout << "Site sea level pressure: " << site_slp << " and site Temp: "<< site_T 
-  //     << " and pressure: " << out << endl << endl <<endl;
-  return out;
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// The pressure of many sites at once. There is no I/O once the data are
+// loaded.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+vector<double> LSDCRNParameters::NCEPatm_2(vector<double>& site_lat, vector<double>& site_lon,
+                                           vector<double>& site_elev)
+{
+  if (NCEPData == NULL)
+  {
+    string path_to_data;
+    if (!LSDNCEPAtmosphere::has_embedded_data())
+    {
+      cout << "You didn't load the NCEP data. Doing that now. " << endl;
+      cout << "Enter path to data files: " << endl;
+      cin >> path_to_data;
+    }
+    load_parameters_for_atmospheric_scaling(path_to_data);
+  }
+  return NCEPData->NCEPatm_2(site_lat, site_lon, site_elev);
 }
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
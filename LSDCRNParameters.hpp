@@ -56,6 +56,8 @@
 #include <vector>
 #include <map>
 #include "TNT/tnt.h"
+#include "LSDNCEPAtmosphere.hpp"
+#include "LSDCRNMuonTable.hpp"
 using namespace std;
 using namespace TNT;
 
@@ -76,8 +78,14 @@ class LSDCRNParameters
   /// This is a friend class so that it can be called from the particle 
   friend class LSDCRNParticle;
 
+  /// The concentration kernel reads the parameters of the nuclide
+  friend class LSDCRNConcentrationKernel;
+
   /// @brief function for loading parameters that allow pressure calculation
   /// from elevation
+  /// @details The data are only read from disk the first time they are
+  /// loaded in a run; after that (and if they are compiled in) every
+  /// LSDCRNParameters object shares them. See LSDNCEPAtmosphere.
   /// @author SMM
   /// @date 02/12/2014
   void load_parameters_for_atmospheric_scaling(string path_to_params);
@@ -117,6 +125,9 @@ class LSDCRNParameters
   ///   Muon_production[1] = 26Al fast
   ///   Muon_production[2] = 10Be neg
   ///   Muon_production[3] = 26Al neg
+  /// @details If a muon table has been set (set_CRONUS_muon_table) and it
+  ///  covers z and h the muon flux is interpolated from it; otherwise
+  ///  P_mu_total is used.
   /// @author SMM
   /// @date 14/10/2014
   vector<double> calculate_muon_production_CRONUS(double z, double h);
@@ -152,6 +163,7 @@ class LSDCRNParameters
   ///  is replaced by the function. 
   /// @param 26Al_total_mu the total muon production for 26Al. This
   ///  is replaced by the function.  
+  /// @details Uses the muon table if one has been set and it covers z and h
   /// @author SMM
   /// @date 15/12/2014
   void P_mu_total_return_nuclides(double z,double h, double& Be10_total_mu,
@@ -188,6 +200,68 @@ class LSDCRNParameters
   /// @author SMM
   /// @date 07/12/2014
   double integrate_muon_flux(double z, double H, double tolerance);
+
+  /// @brief The flux of vertically travelling muons at the site (phi_vert_site
+  ///  in P_mu_total) at many depths and pressures, with one integration
+  ///  per pressure.
+  /// @detail The integral from each depth down to 2e5 g/cm^2 is split at the
+  ///  depths and each piece is integrated with 4 point Gauss-Legendre
+  ///  quadrature on panels evenly spaced in log depth. The integrals of all
+  ///  the depths are then running sums of the pieces.
+  /// @param z the depths in g/cm^2, increasing and no deeper than 2e5 g/cm^2
+  /// @param h the pressures in hPa
+  /// @param n_panels the number of quadrature panels between two depths
+  /// @param phi replaced with the fluxes in muons/cm^2/s/sr, phi[depth][pressure]
+  /// @author agent
+  /// @date 16/10/2026
+  void integrate_muon_flux_on_grid(vector<double>& z, vector<double>& h,
+                                   int n_panels, vector< vector<double> >& phi);
+
+  /// @brief Builds a lookup table of the site muon flux over depth and
+  ///  pressure for the CRONUS muon production.
+  /// @detail The depths are spaced evenly in log depth and include the
+  ///  ranges of the LZ table, where the stopping rate has kinks. The flux is
+  ///  also integrated at the midpoints of every cell and cell edge, where the
+  ///  interpolation is checked, and the integration is checked by doubling
+  ///  the number of quadrature panels. The grid and the panels are refined
+  ///  until the sum of the two relative errors is below the tolerance, and
+  ///  that sum is kept with the table.
+  /// @param tolerance the largest relative error of the flux, e.g. 1e-6
+  /// @param table replaced with the table
+  /// @author agent
+  /// @date 16/10/2026
+  void build_CRONUS_muon_table(double tolerance, LSDCRNMuonTable& table);
+
+  /// @brief Has the CRONUS muon production (calculate_muon_production_CRONUS,
+  ///  P_mu_total_return_nuclides and so get_CRONUS_P_mu_vectors) use a lookup
+  ///  table of the muon flux rather than integrating it at every depth.
+  /// @detail The table is built once per run for each tolerance and shared by
+  ///  all the parameter objects. P_mu_total and integrate_muon_flux are not
+  ///  changed and can still be used as the reference.
+  /// @param tolerance the largest relative error of the flux, e.g. 1e-6
+  /// @author agent
+  /// @date 16/10/2026
+  void set_CRONUS_muon_table(double tolerance);
+
+  /// @brief Has the CRONUS muon production use a lookup table of the muon
+  ///  flux, which is kept in a file.
+  /// @detail If the file holds a table built to the tolerance (or a smaller
+  ///  one) it is read; otherwise the table is built and written to the file.
+  /// @param tolerance the largest relative error of the flux, e.g. 1e-6
+  /// @param table_fname the name of the file with extension
+  /// @author agent
+  /// @date 16/10/2026
+  void set_CRONUS_muon_table(double tolerance, string table_fname);
+
+  /// @brief Goes back to integrating the muon flux at every depth
+  /// @author agent
+  /// @date 16/10/2026
+  void clear_CRONUS_muon_table()   { CRONUSMuonTable = NULL; }
+
+  /// @return the muon table in use, or NULL if the flux is integrated
+  /// @author agent
+  /// @date 16/10/2026
+  const LSDCRNMuonTable* get_CRONUS_muon_table()   { return CRONUSMuonTable; }
  
   // functions for altering the parameter values
   
@@ -398,6 +472,17 @@ class LSDCRNParameters
   /// @author SMM
   /// @date 04/12/2014
   double NCEPatm_2(double site_lat, double site_lon, double site_elev);
+
+  /// @brief The atmospheric pressure of many sites at once, e.g. all the
+  /// pixels of a basin
+  /// @param site_lat latitudes (DD). Southern hemisphere is negative.
+  /// @param site_lon longitudes (DD). Western hemisphere is negative.
+  /// @param site_elev elevations (m).
+  /// @return site pressures in hPa.
+  /// @author agent
+  /// @date 16/10/2026
+  vector<double> NCEPatm_2(vector<double>& site_lat, vector<double>& site_lon,
+                           vector<double>& site_elev);
   
   /// @brief This gets the attenuation depth in g/cm^2
   ///  You tell it if you want the CRONUS values
@@ -524,6 +609,24 @@ class LSDCRNParameters
   /// @brief This is called by the default constructor. 
   /// It is the only possible constructor
   void create();
+
+  /// @brief The CRONUS muon production with the site muon flux interpolated
+  ///  from the muon table. The rest is as in P_mu_total.
+  /// @param z depth below the surface z (g/cm2)
+  /// @param h atmospheric pressure (hPa)
+  /// @param P_fast_10Be replaced with the 10Be fast muon production
+  /// @param P_fast_26Al replaced with the 26Al fast muon production
+  /// @param P_neg_10Be replaced with the 10Be negative muon production
+  /// @param P_neg_26Al replaced with the 26Al negative muon production
+  /// @author agent
+  /// @date 16/10/2026
+  void P_mu_total_from_table(double z, double h, double& P_fast_10Be,
+                             double& P_fast_26Al, double& P_neg_10Be,
+                             double& P_neg_26Al);
+
+  /// @return the log range (g/cm^2, [0]) and log momentum (MeV/c, [1]) table
+  ///  for muons in standard rock used by LZ
+  static vector< vector<double> > LZ_log_table();
   
   /// the version number of this CRNParameters object
   string version;
@@ -594,26 +697,13 @@ class LSDCRNParameters
   /// This is a data map used for storing CRONUS muon parameters
   map<string,double> CRONUS_muon_data;
   
-  /// levels: the levels for the atmospheric scaling of pressure
-  vector<double> levels;
-  
-  /// This is an index for the latitudes for atmospheric scaling
-  vector<double> NCEPlat;
-  
-  /// This is an index for the longitudes for atmospheric scaling
-  vector<double> NCEPlon;
-  
-  /// This is an array holding sea level perssures
-  Array2D<double> meanslp;
-  
-  /// This is an array healing mean temperatures
-  Array2D<double> meant1000;
-  
-  /// This is a vector of arrays holding something called gp_hgt;
-  vector< Array2D<double> > gp_hgt;
-  
-  /// This is a vector of arrays holding something called gp_hgt;
-  vector< Array2D<double> > gm_hgt;  
+  /// The NCEP sea level pressure and temperature, shared by all the
+  /// parameter objects. NULL until they are loaded.
+  const LSDNCEPAtmosphere* NCEPData;
+
+  /// The lookup table of the CRONUS muon flux, shared by all the parameter
+  /// objects. NULL if the flux is integrated at every depth.
+  const LSDCRNMuonTable* CRONUSMuonTable;
   
   
 };
@@ -96,6 +96,9 @@ using namespace TNT;
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 void LSDChiNetwork::create(string channel_network_fname)
 {
+  RandomStream = NULL;
+  LogStream = &cout;
+
   ifstream channel_data_in;
   channel_data_in.open(channel_network_fname.c_str());
 
@@ -222,6 +225,9 @@ void LSDChiNetwork::create(string channel_network_fname)
 void LSDChiNetwork::create(LSDFlowInfo& FlowInfo, int SourceNode, int OutletNode, LSDRaster& Elevation,
                            LSDRaster& FlowDistance, LSDRaster& DrainageArea)
 {
+  RandomStream = NULL;
+  LogStream = &cout;
+
   int current_node, reciever_node;
   int row;
   int col;
@@ -322,6 +328,9 @@ void LSDChiNetwork::create(LSDFlowInfo& FlowInfo, int SourceNode, int OutletNode
                            LSDRaster& FlowDistance, LSDRaster& DrainageArea, 
                            LSDRaster& Chi)
 {
+  RandomStream = NULL;
+  LogStream = &cout;
+
   int current_node, reciever_node;
   int row;
   int col;
@@ -1751,7 +1760,7 @@ void LSDChiNetwork::find_most_likeley_segments_monte_carlo(int channel, int mini
   //int n_nodes = reverse_Chi.size();
 
   // now thin the data, preserving the data (not interpolating)
-  channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference);
+  channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference, RandomStream);
   //n_nodes = node_reference.size();
 
   // now create a single sigma value vector
@@ -1807,7 +1816,7 @@ void LSDChiNetwork::find_most_likeley_segments_monte_carlo_dchi(int channel, int
   //int n_nodes = reverse_Chi.size();
 
   // now thin the data, preserving the data (not interpolating)
-  channel_MLE_finder.thin_data_monte_carlo_dchi(mean_dchi, variation_dchi, node_reference);
+  channel_MLE_finder.thin_data_monte_carlo_dchi(mean_dchi, variation_dchi, node_reference, RandomStream);
   //n_nodes = node_reference.size();
 
   // now create a single sigma value vector
@@ -2337,7 +2346,7 @@ void LSDChiNetwork::monte_carlo_split_channel(float A_0, float m_over_n, int n_i
         LSDMostLikelyPartitionsFinder channel_MLE_finder(minimum_segment_length, br_chi, br_elev);
 
         // now thin the data, preserving the data (not interpolating)
-        channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference);
+        channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference, RandomStream);
         n_data_nodes = node_reference.size();
 
         // now create a single sigma value vector
@@ -2652,7 +2661,7 @@ void LSDChiNetwork::monte_carlo_split_channel_colinear(float A_0, float m_over_n
         LSDMostLikelyPartitionsFinder channel_MLE_finder(minimum_segment_length, br_chi, br_elev);
 
         // now thin the data, preserving the data (not interpolating)
-        channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference);
+        channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference, RandomStream);
         n_data_nodes = node_reference.size();
 
         //cout << "n data Nodes: " << n_data_nodes << endl;
@@ -3096,7 +3105,7 @@ vector<float> LSDChiNetwork::calculate_AICc_after_breaks_monte_carlo(float A_0,
       LSDMostLikelyPartitionsFinder channel_MLE_finder(minimum_segment_length, br_chi, br_elev);
 
       // now thin the data, preserving the data (not interpolating)
-      channel_MLE_finder.thin_data_monte_carlo_skip(target_skip, skip_range, node_reference);
+      channel_MLE_finder.thin_data_monte_carlo_skip(target_skip, skip_range, node_reference, RandomStream);
       n_data_nodes = node_reference.size();
 
       // now create a single sigma value vector
@@ -3418,7 +3427,7 @@ vector<float> LSDChiNetwork::calculate_AICc_after_breaks_colinear_monte_carlo(fl
       LSDMostLikelyPartitionsFinder channel_MLE_finder(minimum_segment_length, br_chi, br_elev);
 
       // now thin the data, preserving the data (not interpolating)
-      channel_MLE_finder.thin_data_monte_carlo_skip(skip, skip_range, node_reference);
+      channel_MLE_finder.thin_data_monte_carlo_skip(skip, skip_range, node_reference, RandomStream);
       n_data_nodes = node_reference.size();
 
       // now create a single sigma value vector
@@ -3900,14 +3909,14 @@ void LSDChiNetwork::monte_carlo_sample_river_network_for_best_fit_after_breaks(f
   vector<int> node_reference;
   int n_segments;
 
-  cout << "LSDChiNetwork::sample after breaks, iteration: ";
+  *LogStream << "LSDChiNetwork::sample after breaks, iteration: ";
 
   // loop through the iterations
   for (int it = 1; it <= n_iterations; it++)
   {
     if (it%10 == 0)
     {
-      cout << " " << it;
+      *LogStream << " " << it;
     }
 
     //cout << "LSDChiNetwork::monte_carlo_sample_river_network_for_best_fit_after_breaks, iteration: " << it << endl;
@@ -3967,7 +3976,7 @@ void LSDChiNetwork::monte_carlo_sample_river_network_for_best_fit_after_breaks(f
         LSDMostLikelyPartitionsFinder channel_MLE_finder(minimum_segment_length, br_chi, br_elev);
 
         // now thin the data, preserving the data (not interpolating)
-        channel_MLE_finder.thin_data_monte_carlo_skip(skip, skip_range, node_reference);
+        channel_MLE_finder.thin_data_monte_carlo_skip(skip, skip_range, node_reference, RandomStream);
         n_data_nodes = node_reference.size();
         //cout << "n_data_nodes after skip" << n_data_nodes << " and before: " << br_chi.size() << endl;
 
@@ -4024,7 +4033,7 @@ void LSDChiNetwork::monte_carlo_sample_river_network_for_best_fit_after_breaks(f
 
     }    // end channel loop
   }      // end iteration loop
-  cout << endl;
+  *LogStream << endl;
 
   // reset the data holding the fitted network properties
   vector< vector<float> > empty_vecvec;
@@ -4899,7 +4908,7 @@ float LSDChiNetwork::search_for_best_fit_m_over_n_colinearity_test(float A_0, in
 
       vector<int> node_reference;
       // now thin the data, preserving the data (not interpolating)
-      channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference);
+      channel_MLE_finder.thin_data_monte_carlo_skip(mean_skip, skip_range, node_reference, RandomStream);
       //cout << "The thinned number of nodes is: " << node_reference.size() << " and overall nodes: " << reverse_Chi.size() << endl;
 
       // now create a single sigma value vector
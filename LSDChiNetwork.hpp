@@ -68,9 +68,11 @@
 
 #include <vector>
 #include <string>
+#include <iostream>
 #include "TNT/tnt.h"
 #include "LSDRaster.hpp"
 #include "LSDFlowInfo.hpp"
+#include "LSDStatsTools.hpp"
 using namespace std;
 using namespace TNT;
 
@@ -862,6 +864,23 @@ class LSDChiNetwork
     vector< vector<float> > get_chis()
       { return chis; }
 
+    /// @brief Sets the stream that the Monte Carlo thinning draws its random
+    /// numbers from. Without one the global ran3 state, seeded from the clock,
+    /// is used. The stream is not owned by the network and must outlive it.
+    /// Networks fitted on different threads each need their own stream.
+    /// @param stream The random stream.
+    /// @author agent
+    /// @date 16/10/2026
+    void set_random_stream(ran3_stream& stream) { RandomStream = &stream; }
+
+    /// @brief Sets the stream that the Monte Carlo sampling writes its progress
+    /// to. Without one the progress goes to cout. The stream is not owned by
+    /// the network and must outlive it.
+    /// @param log The output stream.
+    /// @author agent
+    /// @date 17/10/2026
+    void set_log_stream(ostream& log) { LogStream = &log; }
+
 
   protected:
 
@@ -941,6 +960,12 @@ class LSDChiNetwork
     /// This vector holds the vectors containing the node locations of breaks in the segments.
     vector< vector<int> > break_nodes_vecvec;
 
+    /// The stream used by the Monte Carlo thinning. NULL for the global ran3 state.
+    ran3_stream* RandomStream;
+
+    /// The stream the Monte Carlo sampling writes its progress to.
+    ostream* LogStream;
+
   private:
     void create(string channel_network_fname);
     void create(LSDFlowInfo& FlowInfo, int SourceNode, int OutletNode, LSDRaster& Elevation,
@@ -74,6 +74,7 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <algorithm>
 #include "TNT/tnt.h"
 #include "LSDFlowInfo.hpp"
@@ -103,6 +104,7 @@ void LSDChiTools::create(LSDRaster& ThisRaster)
   DataResolution = ThisRaster.get_DataResolution();
   NoDataValue = ThisRaster.get_NoDataValue();
   GeoReferencingStrings = ThisRaster.get_GeoReferencingStrings();
+  attach_node_columns();
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -118,6 +120,7 @@ void LSDChiTools::create(LSDIndexRaster& ThisRaster)
   DataResolution = ThisRaster.get_DataResolution();
   NoDataValue = ThisRaster.get_NoDataValue();
   GeoReferencingStrings = ThisRaster.get_GeoReferencingStrings();
+  attach_node_columns();
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -133,6 +136,7 @@ void LSDChiTools::create(LSDFlowInfo& ThisFI)
   DataResolution = ThisFI.get_DataResolution();
   NoDataValue = ThisFI.get_NoDataValue();
   GeoReferencingStrings = ThisFI.get_GeoReferencingStrings();
+  attach_node_columns();
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -148,25 +152,82 @@ void LSDChiTools::create(LSDJunctionNetwork& ThisJN)
   DataResolution = ThisJN.get_DataResolution();
   NoDataValue = ThisJN.get_NoDataValue();
   GeoReferencingStrings = ThisJN.get_GeoReferencingStrings();
+  attach_node_columns();
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This points all the node columns at the slots of this object
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDChiTools::attach_node_columns()
+{
+  M_chi_data_map.attach(&NodeSlots);
+  b_chi_data_map.attach(&NodeSlots);
+  elev_data_map.attach(&NodeSlots);
+  chi_data_map.attach(&NodeSlots);
+  flow_distance_data_map.attach(&NodeSlots);
+  drainage_area_data_map.attach(&NodeSlots);
+  segmented_elevation_map.attach(&NodeSlots);
+  segment_counter_map.attach(&NodeSlots);
+  segment_counter_knickpoint_map.attach(&NodeSlots);
+  segment_knickpoint_sign_map.attach(&NodeSlots);
+  segment_length_map.attach(&NodeSlots);
+  raw_dksndchi_kp_map.attach(&NodeSlots);
+  raw_KDE_kp_map.attach(&NodeSlots);
+  map_outlier_MZS_dksndchi.attach(&NodeSlots);
+  lumped_m_chi_map.attach(&NodeSlots);
+  TVD_m_chi_map.attach(&NodeSlots);
+  TVD_b_chi_map.attach(&NodeSlots);
+  map_outlier_MZS_combined.attach(&NodeSlots);
+  TVD_segelev_diff.attach(&NodeSlots);
+  segelev_diff.attach(&NodeSlots);
+  segelev_diff_second.attach(&NodeSlots);
+  raw_delta_segelev_from_TVDb_chi.attach(&NodeSlots);
+  mean_for_kp.attach(&NodeSlots);
+  std_for_kp.attach(&NodeSlots);
+  source_keys_map.attach(&NodeSlots);
+  baselevel_keys_map.attach(&NodeSlots);
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 //
-// This resets all the data maps
+// This resets all the data maps. The node slots are only cleared along with
+// every column that uses them.
 //
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 void LSDChiTools::reset_data_maps()
 {
-  map<int,float> empty_map;
   vector<int> empty_vec;
 
-  M_chi_data_map = empty_map;
-  b_chi_data_map = empty_map;
-  elev_data_map = empty_map;
-  chi_data_map = empty_map;
-  flow_distance_data_map = empty_map;
-  drainage_area_data_map = empty_map;
+  M_chi_data_map.clear();
+  b_chi_data_map.clear();
+  elev_data_map.clear();
+  chi_data_map.clear();
+  flow_distance_data_map.clear();
+  drainage_area_data_map.clear();
+  segmented_elevation_map.clear();
+  segment_counter_map.clear();
+  segment_counter_knickpoint_map.clear();
+  segment_knickpoint_sign_map.clear();
+  segment_length_map.clear();
+  raw_dksndchi_kp_map.clear();
+  raw_KDE_kp_map.clear();
+  map_outlier_MZS_dksndchi.clear();
+  lumped_m_chi_map.clear();
+  TVD_m_chi_map.clear();
+  TVD_b_chi_map.clear();
+  map_outlier_MZS_combined.clear();
+  TVD_segelev_diff.clear();
+  segelev_diff.clear();
+  segelev_diff_second.clear();
+  raw_delta_segelev_from_TVDb_chi.clear();
+  mean_for_kp.clear();
+  std_for_kp.clear();
+  source_keys_map.clear();
+  baselevel_keys_map.clear();
+  NodeSlots.clear();
   node_sequence = empty_vec;
 }
 
@@ -765,20 +826,18 @@ void LSDChiTools::chi_map_automator_chi_only(LSDFlowInfo& FlowInfo,
   vector<float> these_chi_coordinates;
   vector<int> these_chi_node_indices;
 
-  // these are maps that will store the data
-  map<int,float> chi_coord_map;
-  map<int,float> elev_map;
-  map<int,float> area_map;
-  map<int,float> flow_distance_map;
+  // the data go straight into the node columns, which are emptied first
   vector<int> node_sequence_vec;
+  NodeSlots.reserve(FlowInfo.get_NDataNodes(),0);
+  chi_data_map.clear();
+  elev_data_map.clear();
+  drainage_area_data_map.clear();
+  flow_distance_data_map.clear();
 
-  // these are vectors that will store information about the individual nodes
-  // that allow us to map the nodes to specific channels during data visualisation
-
-  // These two maps have each node in the channel (the index)
-  // linked to a key (either the baselevel key or source key)
-  map<int,int> these_source_keys;
-  map<int,int> these_baselevel_keys;
+  // The source and baselevel key columns have each node in the channel (the
+  // index) linked to a key (either the baselevel key or source key)
+  source_keys_map.clear();
+  baselevel_keys_map.clear();
 
   // These two maps link keys, which are incrmented by one, to the
   // junction or node of the baselevel or source
@@ -873,19 +932,19 @@ void LSDChiTools::chi_map_automator_chi_only(LSDFlowInfo& FlowInfo,
       //cout << "This node is " << this_node << endl;
 
       // only take the nodes that have not been found
-      if (chi_coord_map.find(this_node) == chi_coord_map.end() )
+      if (chi_data_map.count(this_node) == 0)
       {
         FlowInfo.retrieve_current_row_and_col(this_node,row,col);
 
         //cout << "This is a new node; " << this_node << endl;
-        chi_coord_map[this_node] = these_chi_coordinates[node];
-        elev_map[this_node] = Elevation.get_data_element(row,col);
-        area_map[this_node] = DrainageArea.get_data_element(row,col);
-        flow_distance_map[this_node] = FlowDistance.get_data_element(row,col);
+        chi_data_map[this_node] = these_chi_coordinates[node];
+        elev_data_map[this_node] = Elevation.get_data_element(row,col);
+        drainage_area_data_map[this_node] = DrainageArea.get_data_element(row,col);
+        flow_distance_data_map[this_node] = FlowDistance.get_data_element(row,col);
         node_sequence_vec.push_back(this_node);
 
-        these_source_keys[this_node] = source_node_tracker;
-        these_baselevel_keys[this_node] = baselevel_tracker;
+        source_keys_map[this_node] = source_node_tracker;
+        baselevel_keys_map[this_node] = baselevel_tracker;
       }
       else
       {
@@ -897,14 +956,8 @@ void LSDChiTools::chi_map_automator_chi_only(LSDFlowInfo& FlowInfo,
   //cout << "I am all finished segmenting the channels!" << endl;
 
   // set the object data members
-  elev_data_map = elev_map;
-  chi_data_map = chi_coord_map;
-  flow_distance_data_map = flow_distance_map;
-  drainage_area_data_map = area_map;
   node_sequence = node_sequence_vec;
 
-  source_keys_map = these_source_keys;
-  baselevel_keys_map = these_baselevel_keys;
   key_to_source_map = this_key_to_source_map;
   key_to_baselevel_map = this_key_to_baselevel_map;
   //cout << "BUG TRACKER" << endl; exit(EXIT_FAILURE);
@@ -918,6 +971,7 @@ void LSDChiTools::chi_map_automator_chi_only(LSDFlowInfo& FlowInfo,
 // The sources and their outlets are supplied by the source and outlet nodes
 // vectors. These are generated from the LSDJunctionNetwork function
 // get_overlapping_channels
+// The random numbers are seeded from the clock
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
                                     vector<int> source_nodes,
@@ -929,6 +983,40 @@ void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
                                     int n_iterations, int skip,
                                     int minimum_segment_length, float sigma)
 {
+  long random_seed = time(NULL);
+  chi_map_automator(FlowInfo, source_nodes, outlet_nodes, baselevel_node_of_each_basin,
+                    Elevation, FlowDistance, DrainageArea, chi_coordinate,
+                    target_nodes, n_iterations, skip, minimum_segment_length, sigma,
+                    random_seed);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This function is for calculating segments from all sources in a DEM
+// The sources and their outlets are supplied by the source and outlet nodes
+// vectors. These are generated from the LSDJunctionNetwork function
+// get_overlapping_channels
+//
+// The channels are fitted independently of each other, so they are fitted in
+// parallel. Each channel draws its random numbers from its own stream, seeded
+// from random_seed and the channel number, so the result only depends on the
+// seed and not on the number of threads or the order they run in. The results
+// are then merged in channel order: where channels overlap the first channel
+// keeps the node, as in the serial version. The progress of each channel is
+// kept in its own buffer and printed in channel order.
+//
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
+                                    vector<int> source_nodes,
+                                    vector<int> outlet_nodes,
+                                    vector<int> baselevel_node_of_each_basin,
+                                    LSDRaster& Elevation, LSDRaster& FlowDistance,
+                                    LSDRaster& DrainageArea, LSDRaster& chi_coordinate,
+                                    int target_nodes,
+                                    int n_iterations, int skip,
+                                    int minimum_segment_length, float sigma,
+                                    long random_seed)
+{
 
   // IMPORTANT THESE PARAMETERS ARE NOT USED BECAUSE CHI IS CALCULATED SEPARATELY
   // However we need to give something to pass to the Monte carlo functions
@@ -936,11 +1024,63 @@ void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
   float A_0 = 1;
   float m_over_n = 0.5;
 
-  // These elements access the chi data
-  vector< vector<float> > chi_m_means;
-  vector< vector<float> > chi_b_means;
-  vector< vector<float> > chi_coordinates;
-  vector< vector<int> > chi_node_indices;
+  int n_channels = int(source_nodes.size());
+
+  // These hold the fitted data of each channel until they are merged
+  vector< vector<float> > channel_m_means(n_channels);
+  vector< vector<float> > channel_b_means(n_channels);
+  vector< vector<float> > channel_chi_coordinates(n_channels);
+  vector< vector<int> > channel_node_indices(n_channels);
+
+  #pragma omp parallel for ordered schedule(dynamic)
+  for(int chan = 0; chan<n_channels; chan++)
+  {
+    //cout << "Sampling channel " << chan+1 << " of " << n_channels << endl;
+
+    // the random numbers for this channel
+    ran3_stream channel_stream(ran3_stream_seed(random_seed,chan));
+
+    // the messages for this channel are printed once it is done
+    ostringstream channel_log;
+
+    // get this particular channel (it is a chi network with only one channel)
+    LSDChiNetwork ThisChiChannel(FlowInfo, source_nodes[chan], outlet_nodes[chan],
+                                Elevation, FlowDistance, DrainageArea,chi_coordinate);
+    ThisChiChannel.set_random_stream(channel_stream);
+    ThisChiChannel.set_log_stream(channel_log);
+
+    // split the channel
+    //cout << "Splitting channels" << endl;
+    ThisChiChannel.split_all_channels(A_0, m_over_n, n_iterations, skip, target_nodes, minimum_segment_length, sigma);
+
+    // monte carlo sample all channels
+    //cout << "Entering the monte carlo sampling" << endl;
+    ThisChiChannel.monte_carlo_sample_river_network_for_best_fit_after_breaks(A_0, m_over_n, n_iterations, skip, minimum_segment_length, sigma);
+
+    // okay the ChiNetwork has all the data about the m vales at this stage.
+    vector< vector<float> > chi_m_means = ThisChiChannel.get_m_means();
+    vector< vector<float> > chi_b_means = ThisChiChannel.get_b_means();
+    vector< vector<float> > chi_coordinates = ThisChiChannel.get_chis();
+    vector< vector<int> > chi_node_indices = ThisChiChannel.get_node_indices();
+
+    // now get the number of channels. This should be 1!
+    if (int(chi_m_means.size()) != 1)
+    {
+      channel_log << "Whoa there, I am trying to make a chi map but something seems to have gone wrong with the channel extraction."  << endl;
+      channel_log << "I should only have one channel per look but I have " << chi_m_means.size() << " channels." << endl;
+    }
+
+    // now get the m_means out
+    channel_m_means[chan] = chi_m_means[0];
+    channel_b_means[chan] = chi_b_means[0];
+    channel_chi_coordinates[chan] = chi_coordinates[0];
+    channel_node_indices[chan] = chi_node_indices[0];
+
+    #pragma omp ordered
+    {
+      cout << channel_log.str();
+    }
+  }
 
   // these are for the individual channels
   vector<float> these_chi_m_means;
@@ -948,22 +1088,20 @@ void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
   vector<float> these_chi_coordinates;
   vector<int> these_chi_node_indices;
 
-  // these are maps that will store the data
-  map<int,float> m_means_map;
-  map<int,float> b_means_map;
-  map<int,float> chi_coord_map;
-  map<int,float> elev_map;
-  map<int,float> area_map;
-  map<int,float> flow_distance_map;
+  // the data go straight into the node columns, which are emptied first
   vector<int> node_sequence_vec;
-
-  // these are vectors that will store information about the individual nodes
-  // that allow us to map the nodes to specific channels during data visualisation
-
-  // These two maps have each node in the channel (the index)
-  // linked to a key (either the baselevel key or source key)
-  map<int,int> these_source_keys;
-  map<int,int> these_baselevel_keys;
+  NodeSlots.reserve(FlowInfo.get_NDataNodes(),0);
+  M_chi_data_map.clear();
+  b_chi_data_map.clear();
+  chi_data_map.clear();
+  elev_data_map.clear();
+  drainage_area_data_map.clear();
+  flow_distance_data_map.clear();
+
+  // The source and baselevel key columns have each node in the channel (the
+  // index) linked to a key (either the baselevel key or source key)
+  source_keys_map.clear();
+  baselevel_keys_map.clear();
 
   // These two maps link keys, which are incrmented by one, to the
   // junction or node of the baselevel or source
@@ -978,11 +1116,8 @@ void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
   int source_node_tracker = -1;
   int baselevel_tracker = -1;
   int ranked_source_node_tracker = -1;
-  int n_channels = int(source_nodes.size());
   for(int chan = 0; chan<n_channels; chan++)
   {
-    //cout << "Sampling channel " << chan+1 << " of " << n_channels << endl;
-
     // get the base level
     this_base_level = baselevel_node_of_each_basin[chan];
     //cout << "Got the base level" << endl;
@@ -1019,38 +1154,11 @@ void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
 
     //cout << "The source key is: " << source_node_tracker << " and basin key is: " << baselevel_tracker << endl;
 
-    // get this particular channel (it is a chi network with only one channel)
-    LSDChiNetwork ThisChiChannel(FlowInfo, source_nodes[chan], outlet_nodes[chan],
-                                Elevation, FlowDistance, DrainageArea,chi_coordinate);
-
-    // split the channel
-    //cout << "Splitting channels" << endl;
-    ThisChiChannel.split_all_channels(A_0, m_over_n, n_iterations, skip, target_nodes, minimum_segment_length, sigma);
-
-    // monte carlo sample all channels
-    //cout << "Entering the monte carlo sampling" << endl;
-    ThisChiChannel.monte_carlo_sample_river_network_for_best_fit_after_breaks(A_0, m_over_n, n_iterations, skip, minimum_segment_length, sigma);
-
-    // okay the ChiNetwork has all the data about the m vales at this stage.
-    // Get these vales and print them to a raster
-    chi_m_means = ThisChiChannel.get_m_means();
-    chi_b_means = ThisChiChannel.get_b_means();
-    chi_coordinates = ThisChiChannel.get_chis();
-    chi_node_indices = ThisChiChannel.get_node_indices();
-
-    // now get the number of channels. This should be 1!
-    int n_channels = int(chi_m_means.size());
-    if (n_channels != 1)
-    {
-      cout << "Whoa there, I am trying to make a chi map but something seems to have gone wrong with the channel extraction."  << endl;
-      cout << "I should only have one channel per look but I have " << n_channels << " channels." << endl;
-    }
-
-    // now get the m_means out
-    these_chi_m_means = chi_m_means[0];
-    these_chi_b_means = chi_b_means[0];
-    these_chi_coordinates = chi_coordinates[0];
-    these_chi_node_indices = chi_node_indices[0];
+    // get the fitted data of this channel
+    these_chi_m_means.swap(channel_m_means[chan]);
+    these_chi_b_means.swap(channel_b_means[chan]);
+    these_chi_coordinates.swap(channel_chi_coordinates[chan]);
+    these_chi_node_indices.swap(channel_node_indices[chan]);
 
     //cout << "I have " << these_chi_m_means.size() << " nodes." << endl;
 
@@ -1063,21 +1171,21 @@ void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
       //cout << "This node is " << this_node << endl;
 
       // only take the nodes that have not been found
-      if (m_means_map.find(this_node) == m_means_map.end() )
+      if (M_chi_data_map.count(this_node) == 0)
       {
         FlowInfo.retrieve_current_row_and_col(this_node,row,col);
 
         //cout << "This is a new node; " << this_node << endl;
-        m_means_map[this_node] = these_chi_m_means[node];
-        b_means_map[this_node] = these_chi_b_means[node];
-        chi_coord_map[this_node] = these_chi_coordinates[node];
-        elev_map[this_node] = Elevation.get_data_element(row,col);
-        area_map[this_node] = DrainageArea.get_data_element(row,col);
-        flow_distance_map[this_node] = FlowDistance.get_data_element(row,col);
+        M_chi_data_map[this_node] = these_chi_m_means[node];
+        b_chi_data_map[this_node] = these_chi_b_means[node];
+        chi_data_map[this_node] = these_chi_coordinates[node];
+        elev_data_map[this_node] = Elevation.get_data_element(row,col);
+        drainage_area_data_map[this_node] = DrainageArea.get_data_element(row,col);
+        flow_distance_data_map[this_node] = FlowDistance.get_data_element(row,col);
         node_sequence_vec.push_back(this_node);
 
-        these_source_keys[this_node] = source_node_tracker;
-        these_baselevel_keys[this_node] = baselevel_tracker;
+        source_keys_map[this_node] = source_node_tracker;
+        baselevel_keys_map[this_node] = baselevel_tracker;
 
       }
       else
@@ -1090,16 +1198,8 @@ void LSDChiTools::chi_map_automator(LSDFlowInfo& FlowInfo,
   //cout << "I am all finished segmenting the channels!" << endl;
 
   // set the object data members
-  M_chi_data_map =m_means_map;
-  b_chi_data_map = b_means_map;
-  elev_data_map = elev_map;
-  chi_data_map = chi_coord_map;
-  flow_distance_data_map = flow_distance_map;
-  drainage_area_data_map = area_map;
   node_sequence = node_sequence_vec;
 
-  source_keys_map = these_source_keys;
-  baselevel_keys_map = these_baselevel_keys;
   key_to_source_map = this_key_to_source_map;
   key_to_baselevel_map = this_key_to_baselevel_map;
 
@@ -1124,18 +1224,16 @@ void LSDChiTools::chi_map_automator_rudimentary(LSDFlowInfo& FlowInfo,
                                     int regression_nodes)
 {
 
-  // the data is stored in maps, for easier testing if a node has been
-  // visited.
-  // You might consider having these as data elements in the object so you don't
-  // have to pass them
-  map<int,float> gradient_data_map;
-  map<int,float> intercept_data_map;
-  map<int,float> R2_data_map;
-  map<int,float> chi_coordinate_data_map;
-  map<int,float> elevation_data_map;
-  map<int,float> flow_distance_map;
-  map<int,float> area_map;
+  // the data go straight into the node columns, which are emptied first.
+  // The M_chi column is also used to test if a node has been visited.
   vector<int> node_order;
+  NodeSlots.reserve(FlowInfo.get_NDataNodes(),0);
+  M_chi_data_map.clear();
+  b_chi_data_map.clear();
+  chi_data_map.clear();
+  elev_data_map.clear();
+  flow_distance_data_map.clear();
+  drainage_area_data_map.clear();
 
   // check if the number of nodes are odd .If not add 1
   if (regression_nodes % 2 == 0)
@@ -1275,16 +1373,15 @@ void LSDChiTools::chi_map_automator_rudimentary(LSDFlowInfo& FlowInfo,
       // only take data that has not been calculated before
       // The channels are in order of descending length so data from
       // longer channels take precidence.
-      if (gradient_data_map.find(this_mp_node) == gradient_data_map.end() )
+      if (M_chi_data_map.count(this_mp_node) == 0)
       {
         FlowInfo.retrieve_current_row_and_col(this_mp_node,row,col);
-        gradient_data_map[this_mp_node] = gradient;
-        intercept_data_map[this_mp_node] = intercept;
-        R2_data_map[this_mp_node] = R_squared;
-        chi_coordinate_data_map[this_mp_node] = chi_coordinate.get_data_element(row,col);
-        elevation_data_map[this_mp_node] = Elevation.get_data_element(row,col);
-        flow_distance_map[this_mp_node] = FlowDistance.get_data_element(row,col);
-        area_map[this_mp_node] = DrainageArea.get_data_element(row,col);
+        M_chi_data_map[this_mp_node] = gradient;
+        b_chi_data_map[this_mp_node] = intercept;
+        chi_data_map[this_mp_node] = chi_coordinate.get_data_element(row,col);
+        elev_data_map[this_mp_node] = Elevation.get_data_element(row,col);
+        flow_distance_data_map[this_mp_node] = FlowDistance.get_data_element(row,col);
+        drainage_area_data_map[this_mp_node] = DrainageArea.get_data_element(row,col);
         node_order.push_back(this_mp_node);
       }
       else
@@ -1318,12 +1415,6 @@ void LSDChiTools::chi_map_automator_rudimentary(LSDFlowInfo& FlowInfo,
   }            // This finishes the channel and resets channel start and end nodes
 
   // set the data objects
-  M_chi_data_map = gradient_data_map;
-  b_chi_data_map = intercept_data_map;
-  elev_data_map = elevation_data_map;
-  chi_data_map = chi_coordinate_data_map;
-  flow_distance_data_map = flow_distance_map;
-  drainage_area_data_map = area_map;
   node_sequence = node_order;
 
 
@@ -1428,7 +1519,7 @@ void LSDChiTools::segment_counter(LSDFlowInfo& FlowInfo, float maximum_segment_l
   // these are for extracting element-wise data from the channel profiles.
   int this_node;
   int segment_counter = 0;
-  map<int,int> this_segment_counter_map;
+  segment_counter_map.clear();
   float last_M_chi, this_M_chi, last_flow_length, this_flow_length, segment_length;
 
   // find the number of nodes
@@ -1470,10 +1561,9 @@ void LSDChiTools::segment_counter(LSDFlowInfo& FlowInfo, float maximum_segment_l
       }
 
       // Print the segment counter to the data map
-      this_segment_counter_map[this_node]  = segment_counter;
+      segment_counter_map[this_node]  = segment_counter;
     }
   }
-  segment_counter_map = this_segment_counter_map;
 }
 
 
@@ -1490,7 +1580,7 @@ LSDIndexRaster LSDChiTools::segment_mapping(LSDFlowInfo& FlowInfo, float maximum
   // these are for extracting element-wise data from the channel profiles.
   int this_node, row, col;
   int segment_counter = 0;
-  map<int,int> this_segment_counter_map;
+  segment_counter_map.clear();
   float last_M_chi, this_M_chi, last_flow_length, this_flow_length, segment_length;
 
   //declare empty array for raster generation
@@ -1539,12 +1629,10 @@ LSDIndexRaster LSDChiTools::segment_mapping(LSDFlowInfo& FlowInfo, float maximum
       }
 
       // Print the segment counter to the data map and raster
-      this_segment_counter_map[this_node]  = segment_counter;
+      segment_counter_map[this_node]  = segment_counter;
       SegmentedStreamNetworkArray[row][col] = segment_counter;
     }
   }
-  segment_counter_map = this_segment_counter_map;
-
   return LSDIndexRaster(NRows,NCols,XMinimum,YMinimum,DataResolution,NoDataValue,SegmentedStreamNetworkArray,GeoReferencingStrings);
 }
 
@@ -3335,7 +3423,7 @@ void LSDChiTools::ksn_knickpoint_outlier_automator(LSDFlowInfo& FlowInfo, float
     vecnode = salazar->second;
     if(vecnode.size()>0)
     {
-      vecval = get_value_from_map_and_node(vecnode,raw_dksndchi_kp_map);
+      vecval = raw_dksndchi_kp_map.get_values(vecnode);
       vecoutlier_MZS_dkdc = is_outlier_MZS(vecval, NoDataValue, MZS_th);
 
       for(size_t hi = 0; hi < vecnode.size(); hi++)
@@ -4322,7 +4410,7 @@ void LSDChiTools::calculate_segmented_elevation(LSDFlowInfo& FlowInfo)
 {
   // these are for extracting element-wise data from the channel profiles.
   int this_node;
-  map<int,float> this_segmented_elevation_map;
+  segmented_elevation_map.clear();
   float this_M_chi, this_b_chi, this_chi, this_segemented_elevation;
 
   // find the number of nodes
@@ -4347,10 +4435,9 @@ void LSDChiTools::calculate_segmented_elevation(LSDFlowInfo& FlowInfo)
       this_segemented_elevation = this_M_chi*this_chi+this_b_chi;
 
       // Print the segment counter to the data map
-      this_segmented_elevation_map[this_node]  = this_segemented_elevation;
+      segmented_elevation_map[this_node]  = this_segemented_elevation;
     }
   }
-  segmented_elevation_map = this_segmented_elevation_map;
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -83,6 +83,7 @@
 #include "LSDIndexChannel.hpp"
 #include "LSDStatsTools.hpp"
 #include "LSDShapeTools.hpp"
+#include "LSDNodeColumn.hpp"
 using namespace std;
 using namespace TNT;
 
@@ -1009,6 +1010,23 @@ class LSDChiTools
                            int target_nodes, int n_iterations, int skip,
                            int minimum_segment_length, float sigma);
 
+    /// @brief As chi_map_automator above, but with the seed of the random
+    ///  numbers used by the Monte Carlo segment fitting.
+    /// @detail The channels are fitted in parallel (with OpenMP). Each channel
+    ///  draws from its own random stream, seeded from random_seed and the
+    ///  channel number, so a given seed gives the same result with any
+    ///  number of threads.
+    /// @param random_seed the seed of the random streams
+    /// @author agent
+    /// @date 16/10/2026
+    void chi_map_automator(LSDFlowInfo& FlowInfo, vector<int> source_nodes,
+                           vector<int> outlet_nodes, vector<int> baselevel_node_of_each_basin,
+                           LSDRaster& Elevation, LSDRaster& FlowDistance,
+                           LSDRaster& DrainageArea, LSDRaster& chi_coordinate,
+                           int target_nodes, int n_iterations, int skip,
+                           int minimum_segment_length, float sigma,
+                           long random_seed);
+
     /// @brief This function maps out the chi steepness and other channel
     ///  metrics in chi space from all the sources supplied in the
     ///  source_nodes vector. The source and outlet nodes vector is
@@ -1338,30 +1356,35 @@ class LSDChiTools
     ///A map of strings for holding georeferencing information
     map<string,string> GeoReferencingStrings;
 
-    // Some maps to store the data
+    /// The slots of the channel nodes, shared by all the node columns below.
+    /// The columns hold one value per slot rather than a tree of nodes, and
+    /// are read and written like the maps they replaced: column[node]
+    LSDNodeSlots NodeSlots;
+
+    // The node columns and maps that store the data
     /// A map of the M_chi values. The indices are node numbers from FlowInfo
-    map<int,float> M_chi_data_map;
+    LSDNodeColumn<float> M_chi_data_map;
     /// A map of the M_chi values. The indices are node numbers from FlowInfo
-    map<int,float> b_chi_data_map;
+    LSDNodeColumn<float> b_chi_data_map;
     /// A map of the M_chi values. The indices are node numbers from FlowInfo
-    map<int,float> elev_data_map;
+    LSDNodeColumn<float> elev_data_map;
     /// A map of the M_chi values. The indices are node numbers from FlowInfo
-    map<int,float> chi_data_map;
+    LSDNodeColumn<float> chi_data_map;
     /// A map of the M_chi values. The indices are node numbers from FlowInfo
-    map<int,float>  flow_distance_data_map;
+    LSDNodeColumn<float> flow_distance_data_map;
     /// A map of the M_chi values. The indices are node numbers from FlowInfo
-    map<int,float>  drainage_area_data_map;
+    LSDNodeColumn<float> drainage_area_data_map;
     /// A map that holds elevations regressed from fitted sections.
-    map<int,float> segmented_elevation_map;
+    LSDNodeColumn<float> segmented_elevation_map;
     /// A map that holds segment numbers: used with skip = 0. Can be used to map
     /// distinct segments
-    map<int,int> segment_counter_map;
+    LSDNodeColumn<int> segment_counter_map;
     /// A map that holds knickpoints information
-    map<int,float> segment_counter_knickpoint_map;
+    LSDNodeColumn<float> segment_counter_knickpoint_map;
     /// A map that holds knickpoints signs
-    map<int,int> segment_knickpoint_sign_map;
+    LSDNodeColumn<int> segment_knickpoint_sign_map;
     /// A map that holds knickpoints signs
-    map<int,int> segment_length_map;
+    LSDNodeColumn<int> segment_length_map;
     /// A map that holds knickpoints ratio
     map<int,float> ksn_ratio_knickpoint_map;
     /// A map that holds knickpoints difference_between_segments
@@ -1407,9 +1430,9 @@ class LSDChiTools
     /// map of raw changes in ksn, key is node and value is delta ksn from bottom to top
     map<int,float> raw_ksn_kp_map;
     /// map of raw derivative for the ksn value calculated per rivers. map[nodeindex] = dksn/dchi
-    map<int,float> raw_dksndchi_kp_map;
+    LSDNodeColumn<float> raw_dksndchi_kp_map;
     /// map of raw KDE, calculated using method/binning depending on the parameter file
-    map<int,float> raw_KDE_kp_map;
+    LSDNodeColumn<float> raw_KDE_kp_map;
     /// map of the automatically calculated bandwidth per source key
     map<int,float> KDE_bandwidth_per_source_key;
     /// Map[source_key] = flow_length_of_river (from source to base junction, not baselevel)
@@ -1417,13 +1440,13 @@ class LSDChiTools
     /// Map[source_key] = chi_length_of_river (from source to base junction, not baselevel)
     map<int,float> map_chi_length_source_key;
     // Map[node_index] = 0 if not outlier, 1 if outlier according to a simple Modified z score on dksn/dchi
-    map<int,int> map_outlier_MZS_dksndchi;
+    LSDNodeColumn<int> map_outlier_MZS_dksndchi;
     /// Map[node_index] = lumped m_chi
-    map<int,float> lumped_m_chi_map;
+    LSDNodeColumn<float> lumped_m_chi_map;
         /// Map[node_index] = TVDed m_chi
-    map<int,float> TVD_m_chi_map;
+    LSDNodeColumn<float> TVD_m_chi_map;
     /// Map[node_index] = TVDed m_chi
-    map<int,float> TVD_b_chi_map;
+    LSDNodeColumn<float> TVD_b_chi_map;
     /// Debugging map to check the TVD correctin (deprecated - I'll clean my code when I'll be sure I'll need it)
     map<int,float>TVD_m_chi_map_non_corrected;
     /// Grouped and processed knickpoints
@@ -1446,20 +1469,20 @@ class LSDChiTools
     map<int,int> nearest_node_centroid_kp;
     map<int,int> nearest_node_centroid_kp_stepped;
 
-    map<int,int> map_outlier_MZS_combined;
+    LSDNodeColumn<int> map_outlier_MZS_combined;
     map<int,float> kp_segdrop;
     map<int,float> raw_segchange;
-    map<int,float> TVD_segelev_diff;
-    map<int,float> segelev_diff;
-    map<int,float> segelev_diff_second;
-    map<int,float> raw_delta_segelev_from_TVDb_chi;
+    LSDNodeColumn<float> TVD_segelev_diff;
+    LSDNodeColumn<float> segelev_diff;
+    LSDNodeColumn<float> segelev_diff_second;
+    LSDNodeColumn<float> raw_delta_segelev_from_TVDb_chi;
     map<int,vector<int> > map_node_source_key_kp_stepped;
 
     /// Map of intermediate values for each node during TVD segmentation
     map<int,float> intermediate_TVD_m_chi;
     map<int,float> intermediate_TVD_b_chi;
-    map<int,float> mean_for_kp;
-    map<int,float> std_for_kp;
+    LSDNodeColumn<float> mean_for_kp;
+    LSDNodeColumn<float> std_for_kp;
 
 
 
@@ -1478,11 +1501,11 @@ class LSDChiTools
     ///  is the source key (sorry I know this is confusing). It means if you
     ///  have the node index you can look up the source key. Used for
     ///  visualisation.
-    map<int,int> source_keys_map;
+    LSDNodeColumn<int> source_keys_map;
 
     /// This has all the nodes. The key (in the map) is the node index, and the
     ///  value is the baselevel key. Again used for visualisation
-    map<int,int> baselevel_keys_map;
+    LSDNodeColumn<int> baselevel_keys_map;
 
     /// This has as many elements as there are sources. The key in the map is the
     ///  node index of the source, and the value is the source key.
@@ -1510,6 +1533,16 @@ class LSDChiTools
 
 
   private:
+    /// The node columns point at NodeSlots, so copying would leave the copy's
+    /// columns using this object's index. These are not defined.
+    LSDChiTools(const LSDChiTools&);
+    LSDChiTools& operator=(const LSDChiTools&);
+
+    /// @brief Points all the node columns at NodeSlots
+    /// @author agent
+    /// @date 16/10/2026
+    void attach_node_columns();
+
     void create(LSDRaster& Raster);
     void create(LSDIndexRaster& Raster);
     void create(LSDFlowInfo& FlowInfo);
@@ -0,0 +1,857 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDCompressedRaster
+// Land Surface Dynamics Compressed Raster
+//
+// A tiled, compressed raster container within the University
+//  of Edinburgh Land Surface Dynamics group topographic toolbox
+//
+// The drivers write a lot of intermediate rasters (fill, drainage area, flow
+// distance, chi...). This file format (extension .lsdc) stores them in square
+// tiles, each compressed on its own, so they take much less disk space than a
+// .bil and any tile can be read without reading the others.
+//
+// Each tile is compressed losslessly in three steps:
+//  1) every 32 bit value is replaced by the difference between its bit pattern
+//     and that of the previous value. Neighbouring values in a DEM or index
+//     raster are similar, so the high bytes of the differences are mostly 0.
+//  2) the bytes are shuffled so all the first bytes come first, then all the
+//     second bytes, and so on, which puts the runs of zeros together.
+//  3) the result is compressed with a small LZ77 coder in the style of LZ4.
+// If a tile does not get smaller it is stored as it is.
+//
+// Everything is in this header so the format can be read and written by
+// LSDRaster and LSDIndexRaster without adding source files to the makefiles.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDCompressedRaster_H
+#define LSDCompressedRaster_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <string.h>
+#include <stdint.h>
+#include "TNT/tnt.h"
+#include "LSDStatsTools.hpp"
+using namespace std;
+using namespace TNT;
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// The LZ coder.
+// A compressed block is a series of sequences. Each sequence is a token byte
+// whose high four bits are the number of literals and low four bits are the
+// match length minus 4 (15 means more length bytes follow, each adding up to
+// 255), then the literals, then a two byte little endian match offset. The
+// last sequence has only literals.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+///@brief Writes a length that did not fit in a token nibble
+inline void lsdc_write_length(vector<unsigned char>& out, size_t length)
+{
+  while (length >= 255)
+  {
+    out.push_back(255);
+    length -= 255;
+  }
+  out.push_back((unsigned char)length);
+}
+
+///@brief Writes one sequence of the LZ coder
+inline void lsdc_write_sequence(vector<unsigned char>& out, const unsigned char* literals,
+                                size_t n_literals, size_t offset, size_t match_length)
+{
+  size_t token_literals = (n_literals < 15) ? n_literals : 15;
+  size_t token_match = 0;
+  if (match_length > 0)
+  {
+    token_match = (match_length-4 < 15) ? match_length-4 : 15;
+  }
+  out.push_back((unsigned char)((token_literals << 4) | token_match));
+  if (token_literals == 15)
+  {
+    lsdc_write_length(out, n_literals-15);
+  }
+  out.insert(out.end(), literals, literals+n_literals);
+  if (match_length > 0)
+  {
+    out.push_back((unsigned char)(offset & 255));
+    out.push_back((unsigned char)(offset >> 8));
+    if (token_match == 15)
+    {
+      lsdc_write_length(out, match_length-4-15);
+    }
+  }
+}
+
+///@brief Compresses a block of bytes with the LZ coder
+///@param in the bytes to compress
+///@param n_in the number of bytes
+///@param out the compressed bytes. Replaced in function.
+///@author agent
+///@date 16/10/2026
+inline void lsdc_compress(const unsigned char* in, size_t n_in, vector<unsigned char>& out)
+{
+  const int hash_bits = 14;
+  const size_t max_offset = 65535;
+  vector<int> last_seen(size_t(1) << hash_bits, -1);
+  out.clear();
+  out.reserve(n_in/2+16);
+
+  size_t anchor = 0;
+  size_t i = 0;
+  while (i+4 <= n_in)
+  {
+    uint32_t sequence;
+    memcpy(&sequence, in+i, 4);
+    uint32_t hash = (sequence*2654435761U) >> (32-hash_bits);
+    int candidate = last_seen[hash];
+    last_seen[hash] = int(i);
+
+    if (candidate >= 0 && i-size_t(candidate) <= max_offset &&
+        memcmp(in+candidate, in+i, 4) == 0)
+    {
+      size_t match_length = 4;
+      while (i+match_length < n_in && in[candidate+match_length] == in[i+match_length])
+      {
+        match_length++;
+      }
+      lsdc_write_sequence(out, in+anchor, i-anchor, i-size_t(candidate), match_length);
+      i += match_length;
+      anchor = i;
+    }
+    else
+    {
+      i++;
+    }
+  }
+  if (anchor < n_in || out.empty())
+  {
+    lsdc_write_sequence(out, in+anchor, n_in-anchor, 0, 0);
+  }
+}
+
+///@brief Reads a length that did not fit in a token nibble
+inline bool lsdc_read_length(const unsigned char*& ip, const unsigned char* end, size_t& length)
+{
+  unsigned char b;
+  do
+  {
+    if (ip >= end)
+    {
+      return false;
+    }
+    b = *ip++;
+    length += b;
+  } while (b == 255);
+  return true;
+}
+
+///@brief Decompresses a block written by lsdc_compress
+///@param in the compressed bytes
+///@param n_in the number of compressed bytes
+///@param out where the bytes go
+///@param n_out the number of bytes expected
+///@return true if the block decompressed to exactly n_out bytes
+///@author agent
+///@date 16/10/2026
+inline bool lsdc_decompress(const unsigned char* in, size_t n_in, unsigned char* out, size_t n_out)
+{
+  const unsigned char* ip = in;
+  const unsigned char* end = in+n_in;
+  size_t op = 0;
+  while (ip < end)
+  {
+    unsigned char token = *ip++;
+    size_t n_literals = token >> 4;
+    if (n_literals == 15 && !lsdc_read_length(ip, end, n_literals))
+    {
+      return false;
+    }
+    if (n_literals > size_t(end-ip) || op+n_literals > n_out)
+    {
+      return false;
+    }
+    memcpy(out+op, ip, n_literals);
+    ip += n_literals;
+    op += n_literals;
+    if (ip >= end)
+    {
+      break;
+    }
+
+    if (end-ip < 2)
+    {
+      return false;
+    }
+    size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+    ip += 2;
+    size_t match_length = (token & 15);
+    if (match_length == 15 && !lsdc_read_length(ip, end, match_length))
+    {
+      return false;
+    }
+    match_length += 4;
+    if (offset == 0 || offset > op || op+match_length > n_out)
+    {
+      return false;
+    }
+    // the match can overlap what it is writing, so copy byte by byte
+    for (size_t k = 0; k<match_length; k++)
+    {
+      out[op+k] = out[op-offset+k];
+    }
+    op += match_length;
+  }
+  return op == n_out;
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// The tile filter: delta coding of the bit patterns followed by a byte shuffle
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+///@brief Delta codes and shuffles 32 bit values
+inline void lsdc_filter(const uint32_t* values, size_t n, vector<unsigned char>& out)
+{
+  out.resize(n*4);
+  uint32_t previous = 0;
+  for (size_t i = 0; i<n; i++)
+  {
+    uint32_t delta = values[i]-previous;
+    previous = values[i];
+    out[i] = (unsigned char)(delta & 255);
+    out[n+i] = (unsigned char)((delta >> 8) & 255);
+    out[2*n+i] = (unsigned char)((delta >> 16) & 255);
+    out[3*n+i] = (unsigned char)(delta >> 24);
+  }
+}
+
+///@brief Undoes lsdc_filter
+inline void lsdc_unfilter(const unsigned char* in, size_t n, uint32_t* values)
+{
+  uint32_t previous = 0;
+  for (size_t i = 0; i<n; i++)
+  {
+    uint32_t delta = uint32_t(in[i]) | (uint32_t(in[n+i]) << 8) |
+                     (uint32_t(in[2*n+i]) << 16) | (uint32_t(in[3*n+i]) << 24);
+    previous += delta;
+    values[i] = previous;
+  }
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// The file format
+//  - "LSDCTILE", version, value type (4 float, 3 int), NRows, NCols, tile size,
+//    nodata value, XMinimum, YMinimum, DataResolution
+//  - the number of bytes of georeferencing strings, then the strings as null
+//    terminated key and value pairs
+//  - the number of tiles and a table with the offset, stored size, a flag
+//    (0 stored as is, 1 compressed) and a checksum for each tile
+//  - the tiles, running along the rows of tiles
+// Numbers are little endian. The header and the table are written field by
+// field (48 bytes for the header and 24 for each table entry, with no
+// padding), so the files are the same whatever machine writes them.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+const char LSDC_MAGIC[8] = {'L','S','D','C','T','I','L','E'};
+const uint32_t LSDC_VERSION = 1;
+const size_t LSDC_HEADER_BYTES = 48;
+const size_t LSDC_TILE_ENTRY_BYTES = 24;
+
+struct LSDCFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t value_type;
+  int32_t NRows;
+  int32_t NCols;
+  int32_t TileSize;
+  int32_t NoDataValue;
+  float XMinimum;
+  float YMinimum;
+  float DataResolution;
+  uint32_t georef_bytes;
+};
+
+struct LSDCTileEntry
+{
+  uint64_t offset;
+  uint32_t stored_bytes;
+  uint32_t flags;
+  uint32_t checksum;
+  uint32_t reserved;
+};
+
+///@brief Appends a 32 bit number in little endian order
+inline void lsdc_put_u32(vector<unsigned char>& out, uint32_t value)
+{
+  for (int k = 0; k<4; k++)
+  {
+    out.push_back((unsigned char)((value >> (8*k)) & 255));
+  }
+}
+
+///@brief Appends a 64 bit number in little endian order
+inline void lsdc_put_u64(vector<unsigned char>& out, uint64_t value)
+{
+  for (int k = 0; k<8; k++)
+  {
+    out.push_back((unsigned char)((value >> (8*k)) & 255));
+  }
+}
+
+///@brief Appends a float as the little endian bytes of its bit pattern
+inline void lsdc_put_f32(vector<unsigned char>& out, float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, 4);
+  lsdc_put_u32(out, bits);
+}
+
+///@brief Reads a little endian 32 bit number
+inline uint32_t lsdc_get_u32(const unsigned char* in)
+{
+  return uint32_t(in[0]) | (uint32_t(in[1]) << 8) |
+         (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+}
+
+///@brief Reads a little endian 64 bit number
+inline uint64_t lsdc_get_u64(const unsigned char* in)
+{
+  return uint64_t(lsdc_get_u32(in)) | (uint64_t(lsdc_get_u32(in+4)) << 32);
+}
+
+///@brief Reads a float written by lsdc_put_f32
+inline float lsdc_get_f32(const unsigned char* in)
+{
+  uint32_t bits = lsdc_get_u32(in);
+  float value;
+  memcpy(&value, &bits, 4);
+  return value;
+}
+
+///@brief The bytes of a file header
+inline void lsdc_serialise_header(const LSDCFileHeader& header, vector<unsigned char>& out)
+{
+  out.assign(header.magic, header.magic+8);
+  lsdc_put_u32(out, header.version);
+  lsdc_put_u32(out, header.value_type);
+  lsdc_put_u32(out, uint32_t(header.NRows));
+  lsdc_put_u32(out, uint32_t(header.NCols));
+  lsdc_put_u32(out, uint32_t(header.TileSize));
+  lsdc_put_u32(out, uint32_t(header.NoDataValue));
+  lsdc_put_f32(out, header.XMinimum);
+  lsdc_put_f32(out, header.YMinimum);
+  lsdc_put_f32(out, header.DataResolution);
+  lsdc_put_u32(out, header.georef_bytes);
+}
+
+///@brief Reads a file header from its LSDC_HEADER_BYTES bytes
+inline void lsdc_parse_header(const unsigned char* in, LSDCFileHeader& header)
+{
+  memcpy(header.magic, in, 8);
+  header.version = lsdc_get_u32(in+8);
+  header.value_type = lsdc_get_u32(in+12);
+  header.NRows = int32_t(lsdc_get_u32(in+16));
+  header.NCols = int32_t(lsdc_get_u32(in+20));
+  header.TileSize = int32_t(lsdc_get_u32(in+24));
+  header.NoDataValue = int32_t(lsdc_get_u32(in+28));
+  header.XMinimum = lsdc_get_f32(in+32);
+  header.YMinimum = lsdc_get_f32(in+36);
+  header.DataResolution = lsdc_get_f32(in+40);
+  header.georef_bytes = lsdc_get_u32(in+44);
+}
+
+///@brief The bytes of a tile table
+inline void lsdc_serialise_table(const vector<LSDCTileEntry>& table, vector<unsigned char>& out)
+{
+  out.clear();
+  out.reserve(table.size()*LSDC_TILE_ENTRY_BYTES);
+  for (size_t i = 0; i<table.size(); i++)
+  {
+    lsdc_put_u64(out, table[i].offset);
+    lsdc_put_u32(out, table[i].stored_bytes);
+    lsdc_put_u32(out, table[i].flags);
+    lsdc_put_u32(out, table[i].checksum);
+    lsdc_put_u32(out, table[i].reserved);
+  }
+}
+
+///@brief Reads a tile table from its bytes
+inline void lsdc_parse_table(const unsigned char* in, vector<LSDCTileEntry>& table)
+{
+  for (size_t i = 0; i<table.size(); i++)
+  {
+    const unsigned char* entry = in+i*LSDC_TILE_ENTRY_BYTES;
+    table[i].offset = lsdc_get_u64(entry);
+    table[i].stored_bytes = lsdc_get_u32(entry+8);
+    table[i].flags = lsdc_get_u32(entry+12);
+    table[i].checksum = lsdc_get_u32(entry+16);
+    table[i].reserved = lsdc_get_u32(entry+20);
+  }
+}
+
+///@brief Checksum of the stored bytes of a tile: the low 32 bits of their
+/// 64 bit FNV-1a hash
+inline uint32_t lsdc_checksum(const unsigned char* bytes, size_t n)
+{
+  return uint32_t(fnv1a_hash(bytes, n));
+}
+
+///@brief the ENVI style type code of a value type
+inline uint32_t lsdc_value_type(const float&) { return 4; }
+inline uint32_t lsdc_value_type(const int&) { return 3; }
+
+///@brief Writes an Array2D of floats or ints as a tiled compressed raster
+///@param filename the full name of the file, including the extension
+///@param NRows number of rows
+///@param NCols number of columns
+///@param XMinimum the x coordinate of the lower left corner
+///@param YMinimum the y coordinate of the lower left corner
+///@param DataResolution the cell size
+///@param NoDataValue the nodata value
+///@param GeoReferencingStrings the georeferencing strings of the raster
+///@param data the data
+///@param TileSize the number of rows and columns in a tile
+///@author agent
+///@date 16/10/2026
+template<class T>
+void write_compressed_raster(string filename, int NRows, int NCols, float XMinimum,
+                             float YMinimum, float DataResolution, int NoDataValue,
+                             map<string,string> GeoReferencingStrings,
+                             Array2D<T>& data, int TileSize)
+{
+  string georef_str;
+  for (map<string,string>::iterator iter = GeoReferencingStrings.begin();
+       iter != GeoReferencingStrings.end(); ++iter)
+  {
+    georef_str += iter->first;
+    georef_str += '\0';
+    georef_str += iter->second;
+    georef_str += '\0';
+  }
+
+  LSDCFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, LSDC_MAGIC, 8);
+  header.version = LSDC_VERSION;
+  header.value_type = lsdc_value_type(T());
+  header.NRows = NRows;
+  header.NCols = NCols;
+  header.TileSize = TileSize;
+  header.NoDataValue = NoDataValue;
+  header.XMinimum = XMinimum;
+  header.YMinimum = YMinimum;
+  header.DataResolution = DataResolution;
+  header.georef_bytes = uint32_t(georef_str.size());
+
+  int NTileRows = (NRows+TileSize-1)/TileSize;
+  int NTileCols = (NCols+TileSize-1)/TileSize;
+  uint32_t NTiles = uint32_t(NTileRows*NTileCols);
+  vector<LSDCTileEntry> table(NTiles);
+
+  ofstream data_ofs(filename.c_str(), ios::out | ios::binary);
+  if( data_ofs.fail() )
+  {
+    cout << "\nFATAL ERROR: unable to write to " << filename << endl;
+    exit(EXIT_FAILURE);
+  }
+  vector<unsigned char> bytes;
+  lsdc_serialise_header(header, bytes);
+  data_ofs.write(reinterpret_cast<const char*>(&bytes[0]), streamsize(bytes.size()));
+  data_ofs.write(georef_str.data(), streamsize(georef_str.size()));
+  bytes.clear();
+  lsdc_put_u32(bytes, NTiles);
+  data_ofs.write(reinterpret_cast<const char*>(&bytes[0]), streamsize(bytes.size()));
+  streamoff table_position = data_ofs.tellp();
+  // the table is written again once the tiles are in place
+  lsdc_serialise_table(table, bytes);
+  data_ofs.write(reinterpret_cast<const char*>(&bytes[0]), streamsize(bytes.size()));
+
+  vector<uint32_t> tile_values;
+  vector<unsigned char> filtered;
+  vector<unsigned char> compressed;
+  for (int tile = 0; tile<int(NTiles); tile++)
+  {
+    int row_start = (tile/NTileCols)*TileSize;
+    int col_start = (tile%NTileCols)*TileSize;
+    int n_rows = (row_start+TileSize > NRows) ? NRows-row_start : TileSize;
+    int n_cols = (col_start+TileSize > NCols) ? NCols-col_start : TileSize;
+
+    tile_values.resize(size_t(n_rows)*size_t(n_cols));
+    for (int row = 0; row<n_rows; row++)
+    {
+      memcpy(&tile_values[size_t(row)*size_t(n_cols)], &data[row_start+row][col_start],
+             size_t(n_cols)*sizeof(T));
+    }
+    lsdc_filter(&tile_values[0], tile_values.size(), filtered);
+    lsdc_compress(&filtered[0], filtered.size(), compressed);
+
+    table[tile].offset = uint64_t(data_ofs.tellp());
+    if (compressed.size() < filtered.size())
+    {
+      table[tile].stored_bytes = uint32_t(compressed.size());
+      table[tile].flags = 1;
+      table[tile].checksum = lsdc_checksum(&compressed[0], compressed.size());
+      data_ofs.write(reinterpret_cast<const char*>(&compressed[0]), streamsize(compressed.size()));
+    }
+    else
+    {
+      table[tile].stored_bytes = uint32_t(filtered.size());
+      table[tile].flags = 0;
+      table[tile].checksum = lsdc_checksum(&filtered[0], filtered.size());
+      data_ofs.write(reinterpret_cast<const char*>(&filtered[0]), streamsize(filtered.size()));
+    }
+  }
+
+  data_ofs.seekp(table_position);
+  lsdc_serialise_table(table, bytes);
+  data_ofs.write(reinterpret_cast<const char*>(&bytes[0]), streamsize(bytes.size()));
+  data_ofs.close();
+}
+
+///@brief Object for reading a tiled compressed raster. The header and tile
+/// table are read when it is created; tiles are read when they are asked for.
+///@author agent
+///@date 16/10/2026
+class LSDCompressedRasterReader
+{
+  public:
+    /// @brief Opens a file and reads its header and tile table
+    /// @param filename the full name of the file, including the extension
+    LSDCompressedRasterReader(string filename)
+    {
+      string problem;
+      if (!read_index(filename, problem))
+      {
+        cout << "\nFATAL ERROR: " << problem << endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    /// @brief Checks a file without keeping any of its data. The header and
+    ///  tile table must be readable and every tile must match the checksum
+    ///  stored for it in the table. Unlike the constructor this never exits,
+    ///  so it can be used to decide whether a cached file can be trusted.
+    /// @param filename the full name of the file, including the extension
+    /// @return true if the file is intact
+    static bool is_intact(string filename)
+    {
+      LSDCompressedRasterReader reader;
+      string problem;
+      if (!reader.read_index(filename, problem))
+      {
+        return false;
+      }
+
+      ifstream ifs(filename.c_str(), ios::in | ios::binary | ios::ate);
+      uint64_t file_bytes = uint64_t(ifs.tellg());
+      vector<unsigned char> stored;
+      for (int tile = 0; tile<int(reader.Table.size()); tile++)
+      {
+        const LSDCTileEntry& entry = reader.Table[tile];
+        int row_start, col_start, n_rows, n_cols;
+        reader.get_tile_extent(tile, row_start, col_start, n_rows, n_cols);
+        size_t raw_bytes = size_t(n_rows)*size_t(n_cols)*4;
+        if (entry.offset+entry.stored_bytes > file_bytes ||
+            (entry.flags != 1 && entry.stored_bytes != raw_bytes))
+        {
+          return false;
+        }
+        stored.resize(entry.stored_bytes);
+        if (!stored.empty())
+        {
+          ifs.seekg(streamoff(entry.offset));
+          ifs.read(reinterpret_cast<char*>(&stored[0]), streamsize(stored.size()));
+          if (ifs.fail() || lsdc_checksum(&stored[0], stored.size()) != entry.checksum)
+          {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+    /// @return Number of rows
+    int get_NRows() const        { return Header.NRows; }
+    /// @return Number of columns
+    int get_NCols() const        { return Header.NCols; }
+    /// @return Minimum X coordinate
+    float get_XMinimum() const        { return Header.XMinimum; }
+    /// @return Minimum Y coordinate
+    float get_YMinimum() const        { return Header.YMinimum; }
+    /// @return Data resolution
+    float get_DataResolution() const        { return Header.DataResolution; }
+    /// @return No data value
+    int get_NoDataValue() const        { return Header.NoDataValue; }
+    /// @return the georeferencing strings
+    map<string,string> get_GeoReferencingStrings() const { return GeoReferencingStrings; }
+    /// @return the size of a tile
+    int get_TileSize() const        { return Header.TileSize; }
+    /// @return the number of tiles
+    int get_NTiles() const        { return int(Table.size()); }
+    /// @return the number of bytes used by the tiles
+    uint64_t get_stored_bytes() const
+    {
+      uint64_t total = 0;
+      for (size_t i = 0; i<Table.size(); i++)
+      {
+        total += Table[i].stored_bytes;
+      }
+      return total;
+    }
+
+    /// @brief Gets the rows and columns covered by a tile
+    /// @param tile the tile index, running along the rows of tiles
+    /// @param row_start first row. Replaced in function.
+    /// @param col_start first column. Replaced in function.
+    /// @param n_rows number of rows. Replaced in function.
+    /// @param n_cols number of columns. Replaced in function.
+    void get_tile_extent(int tile, int& row_start, int& col_start, int& n_rows, int& n_cols) const
+    {
+      int TileSize = Header.TileSize;
+      row_start = (tile/NTileCols)*TileSize;
+      col_start = (tile%NTileCols)*TileSize;
+      n_rows = (row_start+TileSize > Header.NRows) ? Header.NRows-row_start : TileSize;
+      n_cols = (col_start+TileSize > Header.NCols) ? Header.NCols-col_start : TileSize;
+    }
+
+    /// @brief Reads and decompresses one tile
+    /// @param ifs the open file
+    /// @param tile the tile index
+    /// @param out the values of the tile, row by row, converted to T.
+    ///  Replaced in function.
+    template<class T>
+    void read_tile(ifstream& ifs, int tile, vector<T>& out) const
+    {
+      int row_start, col_start, n_rows, n_cols;
+      get_tile_extent(tile, row_start, col_start, n_rows, n_cols);
+      size_t n_values = size_t(n_rows)*size_t(n_cols);
+
+      vector<unsigned char> stored(Table[tile].stored_bytes);
+      ifs.seekg(streamoff(Table[tile].offset));
+      if (!stored.empty())
+      {
+        ifs.read(reinterpret_cast<char*>(&stored[0]), streamsize(stored.size()));
+      }
+      vector<unsigned char> filtered;
+      bool ok = !ifs.fail() &&
+                (stored.empty() || lsdc_checksum(&stored[0], stored.size()) == Table[tile].checksum);
+      if (ok && Table[tile].flags == 1)
+      {
+        filtered.resize(n_values*4);
+        ok = lsdc_decompress(&stored[0], stored.size(), &filtered[0], filtered.size());
+      }
+      else
+      {
+        filtered.swap(stored);
+        ok = ok && (filtered.size() == n_values*4);
+      }
+      if (!ok)
+      {
+        cout << "\nFATAL ERROR: tile " << tile << " of \"" << FileName << "\" is corrupt" << endl;
+        exit(EXIT_FAILURE);
+      }
+
+      vector<uint32_t> bits(n_values);
+      lsdc_unfilter(&filtered[0], n_values, &bits[0]);
+      out.resize(n_values);
+      for (size_t i = 0; i<n_values; i++)
+      {
+        if (Header.value_type == 4)
+        {
+          float v;
+          memcpy(&v, &bits[i], 4);
+          out[i] = T(v);
+        }
+        else
+        {
+          int v;
+          memcpy(&v, &bits[i], 4);
+          out[i] = T(v);
+        }
+      }
+    }
+
+    /// @brief Reads a window, decompressing only the tiles it touches. Cells
+    ///  outside the raster are set to the nodata value.
+    /// @param row_start the first row of the window
+    /// @param col_start the first column of the window
+    /// @param data the window; its size sets the size of the window
+    template<class T>
+    void read_window(int row_start, int col_start, Array2D<T>& data) const
+    {
+      int n_rows = data.dim1();
+      int n_cols = data.dim2();
+      for (int row = 0; row<n_rows; row++)
+      {
+        for (int col = 0; col<n_cols; col++)
+        {
+          data[row][col] = T(Header.NoDataValue);
+        }
+      }
+
+      ifstream ifs(FileName.c_str(), ios::in | ios::binary);
+      vector<T> tile_values;
+      for (int tile = 0; tile<int(Table.size()); tile++)
+      {
+        int t_row, t_col, t_rows, t_cols;
+        get_tile_extent(tile, t_row, t_col, t_rows, t_cols);
+        int first_row = (t_row > row_start) ? t_row : row_start;
+        int last_row = (t_row+t_rows < row_start+n_rows) ? t_row+t_rows : row_start+n_rows;
+        int first_col = (t_col > col_start) ? t_col : col_start;
+        int last_col = (t_col+t_cols < col_start+n_cols) ? t_col+t_cols : col_start+n_cols;
+        if (first_row >= last_row || first_col >= last_col)
+        {
+          continue;
+        }
+        read_tile(ifs, tile, tile_values);
+        for (int row = first_row; row<last_row; row++)
+        {
+          for (int col = first_col; col<last_col; col++)
+          {
+            data[row-row_start][col-col_start] =
+                   tile_values[size_t(row-t_row)*size_t(t_cols)+size_t(col-t_col)];
+          }
+        }
+      }
+      ifs.close();
+    }
+
+    /// @brief Reads the whole raster
+    /// @param data the raster. Replaced in function.
+    template<class T>
+    void read_all(Array2D<T>& data) const
+    {
+      Array2D<T> all(Header.NRows, Header.NCols);
+      read_window(0, 0, all);
+      data = all;
+    }
+
+  private:
+    /// @brief Used by is_intact, which fills the reader in itself
+    LSDCompressedRasterReader() : NTileRows(0), NTileCols(0) {}
+
+    /// @brief Reads the header and tile table of a file
+    /// @param filename the full name of the file, including the extension
+    /// @param problem what went wrong. Replaced in function.
+    /// @return false if the file can't be opened or its header or table is corrupt
+    bool read_index(string filename, string& problem)
+    {
+      FileName = filename;
+      ifstream ifs(filename.c_str(), ios::in | ios::binary);
+      if( ifs.fail() )
+      {
+        problem = "the data file \""+filename+"\" doesn't exist";
+        return false;
+      }
+      unsigned char header_bytes[LSDC_HEADER_BYTES];
+      ifs.read(reinterpret_cast<char*>(header_bytes), LSDC_HEADER_BYTES);
+      lsdc_parse_header(header_bytes, Header);
+      if (ifs.fail() || memcmp(Header.magic, LSDC_MAGIC, 8) != 0 || Header.version != LSDC_VERSION ||
+          Header.TileSize <= 0 || Header.NRows < 0 || Header.NCols < 0)
+      {
+        problem = "\""+filename+"\" is not a compressed raster I can read";
+        return false;
+      }
+      vector<char> georef(Header.georef_bytes+1, '\0');
+      if (Header.georef_bytes > 0)
+      {
+        ifs.read(&georef[0], Header.georef_bytes);
+      }
+      if (ifs.fail())
+      {
+        problem = "the georeferencing of \""+filename+"\" is corrupt";
+        return false;
+      }
+      for (uint32_t start = 0; start<Header.georef_bytes; )
+      {
+        string key(&georef[start]);
+        start += uint32_t(key.size())+1;
+        string value(&georef[start]);
+        start += uint32_t(value.size())+1;
+        GeoReferencingStrings[key] = value;
+      }
+      unsigned char n_tiles_bytes[4] = {0,0,0,0};
+      ifs.read(reinterpret_cast<char*>(n_tiles_bytes), 4);
+      uint32_t NTiles = lsdc_get_u32(n_tiles_bytes);
+      NTileRows = (Header.NRows+Header.TileSize-1)/Header.TileSize;
+      NTileCols = (Header.NCols+Header.TileSize-1)/Header.TileSize;
+      if (ifs.fail() || NTiles != uint32_t(NTileRows*NTileCols))
+      {
+        problem = "the tile table of \""+filename+"\" is corrupt";
+        return false;
+      }
+      Table.resize(NTiles);
+      vector<unsigned char> table_bytes(NTiles*LSDC_TILE_ENTRY_BYTES);
+      if (!table_bytes.empty())
+      {
+        ifs.read(reinterpret_cast<char*>(&table_bytes[0]), streamsize(table_bytes.size()));
+      }
+      if (ifs.fail())
+      {
+        problem = "the tile table of \""+filename+"\" is corrupt";
+        return false;
+      }
+      lsdc_parse_table(table_bytes.empty() ? NULL : &table_bytes[0], Table);
+      ifs.close();
+      return true;
+    }
+
+    /// the name of the file
+    string FileName;
+    /// the header of the file
+    LSDCFileHeader Header;
+    /// the georeferencing strings
+    map<string,string> GeoReferencingStrings;
+    /// the tile table
+    vector<LSDCTileEntry> Table;
+    /// the number of rows of tiles
+    int NTileRows;
+    /// the number of columns of tiles
+    int NTileCols;
+};
+
+#endif
@@ -64,6 +64,7 @@
 #include "LSDJunctionNetwork.hpp"
 #include "LSDBasin.hpp"
 #include "LSDRasterInfo.hpp"
+#include "LSDNCEPAtmosphere.hpp"
 #include "TNT/tnt.h"
 using namespace std;
 using namespace TNT;
@@ -193,6 +194,16 @@ void LSDCosmoData::initiate_default_parameters()
   theta_step = 30;
   phi_step = 30;
 
+  // 0 means the horizon search for topographic shielding is not limited
+  max_shielding_distance = 0;
+
+  // the samples are run one after another unless more threads are asked for
+  n_threads = 1;
+
+  // the CRONUS muon flux is integrated at every depth unless a table is asked for
+  muon_table_tolerance = 0;
+  muon_table_file = "";
+
   // some environment variables
   prod_uncert_factor = 1;          // this is a legacy parameter.
   
@@ -683,6 +694,39 @@ void LSDCosmoData::load_parameters(string filename)
     {
       phi_step = atoi(value.c_str());
     }
+    else if (lower == "max_shielding_distance")
+    {
+      max_shielding_distance = atof(value.c_str());
+    }
+    else if (lower == "n_threads")
+    {
+      n_threads = atoi(value.c_str());
+      if (n_threads < 1)
+      {
+        cout << "The number of threads must be at least 1. Defaulting to 1." << endl;
+        n_threads = 1;
+      }
+      #ifndef _OPENMP
+      if (n_threads > 1)
+      {
+        cout << "WARNING: n_threads is " << n_threads << " but this program was compiled" << endl
+             << "without OpenMP (add -fopenmp to the makefile), so the samples will" << endl
+             << "be run one at a time." << endl;
+      }
+      #endif
+    }
+    else if (lower == "muon_table_tolerance")
+    {
+      muon_table_tolerance = atof(value.c_str());
+    }
+    else if (lower == "muon_table_file")
+    {
+      muon_table_file = value;
+      if (muon_table_file == "NULL" || muon_table_file == "Null" || muon_table_file == "null")
+      {
+        muon_table_file = "";
+      }
+    }
     else if (lower == "path_to_atmospheric_data")
     {
       path_to_atmospheric_data = value;
@@ -1243,33 +1287,35 @@ void LSDCosmoData::check_parameter_values()
     cout << "Production uncertainty factor must be 1." << endl;
     prod_uncert_factor = 1;
   }
-  
-  // Check the atmospheric data files
-  string filename = "NCEP2.bin";
-  filename = path_to_atmospheric_data+filename;
-  //cout << "Loading mean sea level, file is: " << endl << filename << endl;
 
-  ifstream ifs_data(filename.c_str(), ios::in | ios::binary);
-  if( ifs_data.fail() )
+  if (muon_table_tolerance < 0)
   {
-    cout << "\nFATAL ERROR: the data file \"" << filename
-         << "\" doesn't exist. You need to put the atmospheric data" << endl
-         << "In the correct path" << endl;
-    exit(EXIT_FAILURE);
-  }  
+    cout << "The muon table tolerance can't be negative. The muon flux will be integrated." << endl;
+    muon_table_tolerance = 0;
+  }
+  else if (muon_table_tolerance == 0 && muon_table_file != "")
+  {
+    cout << "You gave a muon table file but no muon_table_tolerance, so the muon" << endl
+         << "flux will be integrated and the file is not used." << endl;
+  }
   
-  // now the data with levels
-  filename = "NCEP_hgt.bin";
-  filename = path_to_atmospheric_data+filename;
-  //cout << "Loading hgt, file is: " << endl << filename << endl;
-
-  ifstream ifs_data2(filename.c_str(), ios::in | ios::binary);
-  if( ifs_data2.fail() )
+  // Check the atmospheric data files. If the NCEP data were compiled in
+  // they are not read from the path. The heights in NCEP_hgt.bin are not
+  // used by the pressure calculation so that file is no longer needed.
+  if (!LSDNCEPAtmosphere::has_embedded_data())
   {
-    cout << "\nFATAL ERROR: the data file \"" << filename
-         << "\" doesn't exist. You need to put the atmospheric data" << endl
-         << "In the correct path" << endl;
-    exit(EXIT_FAILURE);
+    string filename = "NCEP2.bin";
+    filename = path_to_atmospheric_data+filename;
+    //cout << "Loading mean sea level, file is: " << endl << filename << endl;
+
+    ifstream ifs_data(filename.c_str(), ios::in | ios::binary);
+    if( ifs_data.fail() )
+    {
+      cout << "\nFATAL ERROR: the data file \"" << filename
+           << "\" doesn't exist. You need to put the atmospheric data" << endl
+           << "In the correct path" << endl;
+      exit(EXIT_FAILURE);
+    }
   }
   
   // now check the phi and theta values. These must be a factor of 360 and 90, respectively
@@ -1384,6 +1430,20 @@ vector<string> LSDCosmoData::spawn_clipped_basins(string DEM_fname, int padding_
   string DEM_bil_extension = "bil";
   LSDRaster topo_test(DEM_fname, DEM_bil_extension);
   
+  // if the shielding search is limited, pad the basins by at least the
+  // search distance so the spawned DEMs hold all the topography that can
+  // shield them
+  if (max_shielding_distance > 0)
+  {
+    int shielding_padding = int(ceil(max_shielding_distance/topo_test.get_DataResolution()));
+    if (padding_pixels < shielding_padding)
+    {
+      cout << "Increasing the basin padding from " << padding_pixels << " to " 
+           << shielding_padding << " pixels to cover the shielding search distance" << endl;
+      padding_pixels = shielding_padding;
+    }
+  }
+  
   // Fill this raster
   LSDRaster filled_raster = topo_test.fill(min_slope);
   //cout << "Filled raster" << endl;
@@ -1646,7 +1706,15 @@ void LSDCosmoData::RunShielding(string path, string prefix)
     LSDRaster ForShield(dfnames[i], DEM_Format);
 
     // run shielding
-    LSDRaster Shielded = ForShield.TopographicShielding(theta_step, phi_step);
+    LSDRaster Shielded;
+    if (max_shielding_distance > 0)
+    {
+      Shielded = ForShield.TopographicShielding_limited(theta_step, max_shielding_distance);
+    }
+    else
+    {
+      Shielded = ForShield.TopographicShielding(theta_step, phi_step);
+    }
     
     //write the shielding raster to the working directory
     Shielded.write_raster((dfnames[i]+"_SH"),DEM_Format);
@@ -1756,6 +1824,57 @@ void LSDCosmoData::RunShielding(string path, string prefix)
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This gets the topographic shielding used by the basin analyses.
+// If max_shielding_distance is set, the horizon search is limited to that
+// distance and shielding is only computed for the cells in the basins of the
+// listed junctions. The DEM is processed in tiles with a halo as wide as the
+// search distance, so tiles shared by nested basins are only computed once.
+// Otherwise the whole DEM is shielded.
+//
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDRaster LSDCosmoData::calculate_topographic_shielding(LSDRaster& filled_raster,
+                                     LSDFlowInfo& FlowInfo, LSDJunctionNetwork& JNetwork,
+                                     vector<int>& basin_junctions)
+{
+  if (max_shielding_distance <= 0)
+  {
+    return filled_raster.TopographicShielding(theta_step, phi_step);
+  }
+  
+  // collect the cells of all the basins, visiting each cell once
+  Array2D<int> visited(filled_raster.get_NRows(),filled_raster.get_NCols(),0);
+  vector<int> rows;
+  vector<int> cols;
+  int row,col;
+  int n_basins = int(basin_junctions.size());
+  for (int b = 0; b<n_basins; b++)
+  {
+    int outlet_node = JNetwork.get_Node_of_Junction(basin_junctions[b]);
+    vector<int> basin_nodes = FlowInfo.get_upslope_nodes(outlet_node);
+    int n_nodes = int(basin_nodes.size());
+    for (int n = 0; n<n_nodes; n++)
+    {
+      FlowInfo.retrieve_current_row_and_col(basin_nodes[n],row,col);
+      if (visited[row][col] == 0)
+      {
+        visited[row][col] = 1;
+        rows.push_back(row);
+        cols.push_back(col);
+      }
+    }
+  }
+  cout << "Shielding " << rows.size() << " basin pixels with a search distance of " 
+       << max_shielding_distance << endl;
+  
+  int tile_size = 256;
+  return filled_raster.TopographicShielding_limited(theta_step, max_shielding_distance,
+                                                    rows, cols, tile_size);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // This function prints a production raster for a basin
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -1773,6 +1892,7 @@ LSDRaster LSDCosmoData::calculate_production_raster(LSDRaster& Elevation_Data,
 
   // now create the CRN parameters object
   LSDCRNParameters LSDCRNP;
+  set_muon_table(LSDCRNP);
   
   // get the atmospheric parameters
   LSDCRNP.load_parameters_for_atmospheric_scaling(path_to_atmospheric_data);
@@ -1896,6 +2016,17 @@ void LSDCosmoData::print_renamed_parameter_data(string path, string prefix)
   new_param_data << "threshold_stream_order: " << threshold_stream_order << endl;
   new_param_data << "theta_step: " << theta_step << endl;
   new_param_data << "phi_step: " << phi_step << endl; 
+  new_param_data << "max_shielding_distance: " << max_shielding_distance << endl;
+  new_param_data << "n_threads: " << n_threads << endl;
+  new_param_data << "muon_table_tolerance: " << muon_table_tolerance << endl;
+  if (muon_table_file == "")
+  {
+    new_param_data << "muon_table_file: NULL" << endl;
+  }
+  else
+  {
+    new_param_data << "muon_table_file: " << muon_table_file << endl;
+  }
   new_param_data << "Muon_scaling: " << Muon_scaling << endl;
   if (write_basin_index_raster)
   {
@@ -1925,6 +2056,20 @@ void LSDCosmoData::print_renamed_parameter_data(string path, string prefix)
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This has a parameter object use the CRONUS muon table from the parameter
+// file. The table is built (or read) once per run and shared by every object.
+// agent 17/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDCosmoData::set_muon_table(LSDCRNParameters& LSDCRNP)
+{
+  if (muon_table_tolerance > 0)
+  {
+    LSDCRNP.set_CRONUS_muon_table(muon_table_tolerance, muon_table_file);
+  }
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
 
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 // This prints the file structures to screen
@@ -1997,6 +2142,7 @@ void LSDCosmoData::print_all_data_parameters_and_filestructures(string outfilena
   outfile << "threshold_stream_order: " << threshold_stream_order << endl;
   outfile << "theta_step: " << theta_step << endl;
   outfile << "phi_step: " << phi_step << endl; 
+  outfile << "max_shielding_distance: " << max_shielding_distance << endl;
   outfile << "Muon_scaling: " << Muon_scaling << endl;
   outfile << "----------------------------------------------" << endl << endl;
   
@@ -2407,7 +2553,8 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis_nested(vector<string> Rast
     {
       // get the topographic shielding
       cout << "Starting topographic shielding" << endl;
-      LSDRaster T_shield = filled_raster.TopographicShielding(theta_step, phi_step);
+      LSDRaster T_shield = calculate_topographic_shielding(filled_raster, FlowInfo, JNetwork,
+                                                           snapped_junction_indices);
       Topographic_shielding = T_shield;
       
       if(write_TopoShield_raster)
@@ -2452,19 +2599,30 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis_nested(vector<string> Rast
       constant_self_depth = CRN_params[1];
     }
 
-    // some temporary doubles to hold the nuclide concentrations
-    double test_N10, test_dN10;   // concetration and uncertainty of 10Be in basin
-    double test_N26, test_dN26;   // concetration and uncertainty of 26Al in basin
-    double test_N, test_dN;       // concentration and uncertainty of the nuclide in basin  
-
     //========================
     // LOOPING THROUGH BASINS
     //========================
     // now loop through the valid points, getting the cosmo data 
     cout << "-----------------------------------------------------------" << endl;
     cout << "I found " << n_valid_points << " valid CRN basins in this raster! " << endl;
+    // The samples are independent, so if n_threads is more than 1 they are
+    // run in parallel, each thread taking the next sample when it has
+    // finished one. The basin index raster and the results are added in the
+    // ordered section, in sample order, so they do not depend on the number
+    // of threads, and a thread waits there until the samples before its own
+    // are done, so no more than n_threads basins are held at once.
+    #pragma omp parallel for ordered schedule(dynamic) num_threads(n_threads)
     for(int samp = 0; samp<n_valid_points; samp++)
     {
+      // what this sample has to say is kept until its turn in the ordered
+      // section, so the lines of different samples are not mixed together
+      ostringstream sample_log;
+
+      // some temporary doubles to hold the nuclide concentrations
+      double test_N10, test_dN10;   // concetration and uncertainty of 10Be in basin
+      double test_N26, test_dN26;   // concetration and uncertainty of 26Al in basin
+      double test_N, test_dN;       // concentration and uncertainty of the nuclide in basin
+
       if( valid_nuclide_names[samp] == "Be10")
       {
         test_N10 = valid_concentrations[samp];
@@ -2485,8 +2643,8 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis_nested(vector<string> Rast
       }
       else
       {
-        cout << "You did not select a valid nuclide name, options are Be10 and Al26" << endl;
-        cout << "Defaulting to Be10" << endl;
+        sample_log << "You did not select a valid nuclide name, options are Be10 and Al26" << endl;
+        sample_log << "Defaulting to Be10" << endl;
         valid_nuclide_names[samp] = "Be10";
         test_N10 = valid_concentrations[samp];
         test_dN10 = valid_concentration_uncertainties[samp];
@@ -2497,94 +2655,70 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis_nested(vector<string> Rast
       }
       
 
-      cout << endl << "Valid point is: " << valid_cosmo_points[samp]
-           << " Sample name: " << sample_name[ valid_cosmo_points[samp] ] << " Easting: " 
-           << UTM_easting[valid_cosmo_points[samp]] << " Northing: "
-           << UTM_northing[valid_cosmo_points[samp]] << endl;
-      cout << "Node index is: " <<  snapped_node_indices[samp] << " and junction is: " 
-           << snapped_junction_indices[samp] << endl;
-      cout << "-  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -" << endl;
+      sample_log << endl << "Valid point is: " << valid_cosmo_points[samp]
+                 << " Sample name: " << sample_name[ valid_cosmo_points[samp] ] << " Easting: " 
+                 << UTM_easting[valid_cosmo_points[samp]] << " Northing: "
+                 << UTM_northing[valid_cosmo_points[samp]] << endl;
+      sample_log << "Node index is: " <<  snapped_node_indices[samp] << " and junction is: " 
+                 << snapped_junction_indices[samp] << endl;
+      sample_log << "-  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -" << endl;
       LSDCosmoBasin thisBasin(snapped_junction_indices[samp],FlowInfo, JNetwork,
                               test_N10,test_dN10, test_N26,test_dN26);
 
-      // write the index basin if flag is set to true
-      if(write_basin_index_raster)
-      {
-        cout << "I'm writing a basin index number for you" << endl;
-      
-        if (not written_inital_basin_index)
-        {
-        
-          basin_number = valid_cosmo_points[samp];
-          basin_pixel_area = thisBasin.get_NumberOfCells();
-          basin_area_map[basin_number] = basin_pixel_area;
-          LSDIndexRaster NewBasinIndex = 
-             thisBasin.write_integer_data_to_LSDIndexRaster(basin_number, FlowInfo);
-          BasinIndex = NewBasinIndex;
-          written_inital_basin_index = true;
-        }
-        else
-        {
-          basin_number = valid_cosmo_points[samp];
-          thisBasin.add_basin_to_LSDIndexRaster(BasinIndex, FlowInfo,
-                                                basin_area_map,basin_number);
-        }
-      }
-
       // we need to scale the shielding parameters
       // now do the snow and self shielding
       if (have_snow_raster)
       {
-        cout << "I've got the snow raster" << endl;
+        sample_log << "I've got the snow raster" << endl;
       
         if(have_self_raster)
         {
-          cout << "I've also got the self raster." << endl;
+          sample_log << "I've also got the self raster." << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(FlowInfo, 
                                 Snow_shielding, Self_shielding);
-          cout << "Done with effective depths" << endl;                           
+          sample_log << "Done with effective depths" << endl;                           
         }
         else
         {
-          cout << "No self raster, but I'm getting the effective depths" << endl;
-          cout << "The constant self depth is: " <<  constant_self_depth << endl;
+          sample_log << "No self raster, but I'm getting the effective depths" << endl;
+          sample_log << "The constant self depth is: " <<  constant_self_depth << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(FlowInfo, 
                                 Snow_shielding, constant_self_depth);
-          cout << "Done with effective depths" << endl;        
+          sample_log << "Done with effective depths" << endl;        
         }
       }
       else
       {
         if(have_self_raster)
         {
-          cout << "Getting effective depths" << endl;
+          sample_log << "Getting effective depths" << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(FlowInfo, 
                                 constant_snow_depth, Self_shielding);
-          cout << "Done with effective depths" << endl;                                
+          sample_log << "Done with effective depths" << endl;                                
         }
         else
         {
-          cout << "Getting effective depths" << endl;
+          sample_log << "Getting effective depths" << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(constant_snow_depth, 
                                              constant_self_depth);
-          cout << "Done with effective depths" << endl;                                 
+          sample_log << "Done with effective depths" << endl;                                 
         }
       }
 
 
-      cout << "Now I will populate the scaling vectors." << endl;
+      sample_log << "Now I will populate the scaling vectors." << endl;
       // Now topographic shielding and production scaling
       thisBasin.populate_scaling_vectors(FlowInfo, filled_raster, 
                                          Topographic_shielding,
                                          path_to_atmospheric_data);
-      cout << "The scaling vectors are populated. I am moving on to the analysis" << endl;
+      sample_log << "The scaling vectors are populated. I am moving on to the analysis" << endl;
 
       // now do the analysis
-      cout << "Line 2571, doing analysis" << endl;
+      sample_log << "Line 2571, doing analysis" << endl;
       vector<double> erate_analysis = thisBasin.full_CRN_erosion_analysis_nested(known_eff_erosion, FlowInfo, test_N, 
                                           valid_nuclide_names[samp], test_dN, 
                                           prod_uncert_factor, Muon_scaling);
-       cout << "erate: " << erate_analysis[0] << endl;
+       sample_log << "erate: " << erate_analysis[0] << endl;
       
     
     
@@ -2594,30 +2728,60 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis_nested(vector<string> Rast
                                             FlowInfo, path_to_atmospheric_data, 
                                             known_eff_erosion);
 
-      cout << "Paramforcalc size: " << param_for_calc.size() << endl;              
-      cout << "Getting pressures" << endl;
+      sample_log << "Paramforcalc size: " << param_for_calc.size() << endl;              
+      sample_log << "Getting pressures" << endl;
 
 
-      // get the relief of the basin
-      float R = thisBasin.CalculateBasinRange(FlowInfo, filled_raster);
-      double relief = double(R);
+      // the shared results are added in sample order
+      #pragma omp ordered
+      {
+        cout << sample_log.str();
 
-      MapOfProdAndScaling["BasinRelief"][ valid_cosmo_points[samp] ] = relief;
-      MapOfProdAndScaling["AverageProdScaling"][ valid_cosmo_points[samp] ] = param_for_calc[0];
-      MapOfProdAndScaling["AverageTopoShielding"][ valid_cosmo_points[samp] ] = param_for_calc[1];
-      MapOfProdAndScaling["AverageSelfShielding"][ valid_cosmo_points[samp] ] = param_for_calc[2];
-      MapOfProdAndScaling["AverageSnowShielding"][ valid_cosmo_points[samp] ] = param_for_calc[3];
-      MapOfProdAndScaling["AverageShielding"][ valid_cosmo_points[samp] ] =  param_for_calc[11];
-      MapOfProdAndScaling["AverageCombinedScaling"][ valid_cosmo_points[samp] ] = param_for_calc[4];
-      MapOfProdAndScaling["outlet_lat"][ valid_cosmo_points[samp] ] = param_for_calc[5];
-      MapOfProdAndScaling["OutletPressure"][ valid_cosmo_points[samp] ] = param_for_calc[6];
-      MapOfProdAndScaling["OutletEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[7];
-      MapOfProdAndScaling["centroid_lat"][ valid_cosmo_points[samp] ] = param_for_calc[8];
-      MapOfProdAndScaling["CentroidPressure"][ valid_cosmo_points[samp] ] = param_for_calc[9];
-      MapOfProdAndScaling["CentroidEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[10];
+        // write the index basin if flag is set to true
+        if(write_basin_index_raster)
+        {
+          cout << "I'm writing a basin index number for you" << endl;
+      
+          if (not written_inital_basin_index)
+          {
+        
+            basin_number = valid_cosmo_points[samp];
+            basin_pixel_area = thisBasin.get_NumberOfCells();
+            basin_area_map[basin_number] = basin_pixel_area;
+            LSDIndexRaster NewBasinIndex = 
+               thisBasin.write_integer_data_to_LSDIndexRaster(basin_number, FlowInfo);
+            BasinIndex = NewBasinIndex;
+            written_inital_basin_index = true;
+          }
+          else
+          {
+            basin_number = valid_cosmo_points[samp];
+            thisBasin.add_basin_to_LSDIndexRaster(BasinIndex, FlowInfo,
+                                                  basin_area_map,basin_number);
+          }
+        }
+
+        // get the relief of the basin
+        float R = thisBasin.CalculateBasinRange(FlowInfo, filled_raster);
+        double relief = double(R);
+
+        MapOfProdAndScaling["BasinRelief"][ valid_cosmo_points[samp] ] = relief;
+        MapOfProdAndScaling["AverageProdScaling"][ valid_cosmo_points[samp] ] = param_for_calc[0];
+        MapOfProdAndScaling["AverageTopoShielding"][ valid_cosmo_points[samp] ] = param_for_calc[1];
+        MapOfProdAndScaling["AverageSelfShielding"][ valid_cosmo_points[samp] ] = param_for_calc[2];
+        MapOfProdAndScaling["AverageSnowShielding"][ valid_cosmo_points[samp] ] = param_for_calc[3];
+        MapOfProdAndScaling["AverageShielding"][ valid_cosmo_points[samp] ] =  param_for_calc[11];
+        MapOfProdAndScaling["AverageCombinedScaling"][ valid_cosmo_points[samp] ] = param_for_calc[4];
+        MapOfProdAndScaling["outlet_lat"][ valid_cosmo_points[samp] ] = param_for_calc[5];
+        MapOfProdAndScaling["OutletPressure"][ valid_cosmo_points[samp] ] = param_for_calc[6];
+        MapOfProdAndScaling["OutletEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[7];
+        MapOfProdAndScaling["centroid_lat"][ valid_cosmo_points[samp] ] = param_for_calc[8];
+        MapOfProdAndScaling["CentroidPressure"][ valid_cosmo_points[samp] ] = param_for_calc[9];
+        MapOfProdAndScaling["CentroidEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[10];
     
-      // add the erosion rate results to the holding data member
-      erosion_rate_results[ valid_cosmo_points[samp] ] = erate_analysis;
+        // add the erosion rate results to the holding data member
+        erosion_rate_results[ valid_cosmo_points[samp] ] = erate_analysis;
+      }
 
       //cout << "finished adding data" << endl;
 
@@ -2764,7 +2928,8 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis(vector<string> Raster_name
     {
       // get the topographic shielding
       cout << "Starting topographic shielding" << endl;
-      LSDRaster T_shield = filled_raster.TopographicShielding(theta_step, phi_step);
+      LSDRaster T_shield = calculate_topographic_shielding(filled_raster, FlowInfo, JNetwork,
+                                                           snapped_junction_indices);
       Topographic_shielding = T_shield;
       
       if(write_TopoShield_raster)
@@ -2809,19 +2974,30 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis(vector<string> Raster_name
       constant_self_depth = CRN_params[1];
     }
 
-    // some temporary doubles to hold the nuclide concentrations
-    double test_N10, test_dN10;   // concetration and uncertainty of 10Be in basin
-    double test_N26, test_dN26;   // concetration and uncertainty of 26Al in basin
-    double test_N, test_dN;       // concentration and uncertainty of the nuclide in basin  
-
     //========================
     // LOOPING THROUGH BASINS
     //========================
     // now loop through the valid points, getting the cosmo data 
     cout << "-----------------------------------------------------------" << endl;
     cout << "I found " << n_valid_points << " valid CRN basins in this raster! " << endl;
+    // The samples are independent, so if n_threads is more than 1 they are
+    // run in parallel, each thread taking the next sample when it has
+    // finished one. The basin index raster and the results are added in the
+    // ordered section, in sample order, so they do not depend on the number
+    // of threads, and a thread waits there until the samples before its own
+    // are done, so no more than n_threads basins are held at once.
+    #pragma omp parallel for ordered schedule(dynamic) num_threads(n_threads)
     for(int samp = 0; samp<n_valid_points; samp++)
     {
+      // what this sample has to say is kept until its turn in the ordered
+      // section, so the lines of different samples are not mixed together
+      ostringstream sample_log;
+
+      // some temporary doubles to hold the nuclide concentrations
+      double test_N10, test_dN10;   // concetration and uncertainty of 10Be in basin
+      double test_N26, test_dN26;   // concetration and uncertainty of 26Al in basin
+      double test_N, test_dN;       // concentration and uncertainty of the nuclide in basin
+
       if( valid_nuclide_names[samp] == "Be10")
       {
         test_N10 = valid_concentrations[samp];
@@ -2842,8 +3018,8 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis(vector<string> Raster_name
       }
       else
       {
-        cout << "You did not select a valid nuclide name, options are Be10 and Al26" << endl;
-        cout << "Defaulting to Be10" << endl;
+        sample_log << "You did not select a valid nuclide name, options are Be10 and Al26" << endl;
+        sample_log << "Defaulting to Be10" << endl;
         valid_nuclide_names[samp] = "Be10";
         test_N10 = valid_concentrations[samp];
         test_dN10 = valid_concentration_uncertainties[samp];
@@ -2854,94 +3030,70 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis(vector<string> Raster_name
       }
       
 
-      cout << endl << "Valid point is: " << valid_cosmo_points[samp]
-           << " Sample name: " << sample_name[ valid_cosmo_points[samp] ] << " Easting: " 
-           << UTM_easting[valid_cosmo_points[samp]] << " Northing: "
-           << UTM_northing[valid_cosmo_points[samp]] << endl;
-      cout << "Node index is: " <<  snapped_node_indices[samp] << " and junction is: " 
-           << snapped_junction_indices[samp] << endl;
-      cout << "-  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -" << endl;
+      sample_log << endl << "Valid point is: " << valid_cosmo_points[samp]
+                 << " Sample name: " << sample_name[ valid_cosmo_points[samp] ] << " Easting: " 
+                 << UTM_easting[valid_cosmo_points[samp]] << " Northing: "
+                 << UTM_northing[valid_cosmo_points[samp]] << endl;
+      sample_log << "Node index is: " <<  snapped_node_indices[samp] << " and junction is: " 
+                 << snapped_junction_indices[samp] << endl;
+      sample_log << "-  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -  -" << endl;
       LSDCosmoBasin thisBasin(snapped_junction_indices[samp],FlowInfo, JNetwork,
                               test_N10,test_dN10, test_N26,test_dN26);
 
-      // write the index basin if flag is set to true
-      if(write_basin_index_raster)
-      {
-        cout << "I'm writing a basin index number for you" << endl;
-      
-        if (not written_inital_basin_index)
-        {
-        
-          basin_number = valid_cosmo_points[samp];
-          basin_pixel_area = thisBasin.get_NumberOfCells();
-          basin_area_map[basin_number] = basin_pixel_area;
-          LSDIndexRaster NewBasinIndex = 
-             thisBasin.write_integer_data_to_LSDIndexRaster(basin_number, FlowInfo);
-          BasinIndex = NewBasinIndex;
-          written_inital_basin_index = true;
-        }
-        else
-        {
-          basin_number = valid_cosmo_points[samp];
-          thisBasin.add_basin_to_LSDIndexRaster(BasinIndex, FlowInfo,
-                                                basin_area_map,basin_number);
-        }
-      }
-
       // we need to scale the shielding parameters
       // now do the snow and self shielding
       if (have_snow_raster)
       {
-        cout << "I've got the snow raster" << endl;
+        sample_log << "I've got the snow raster" << endl;
       
         if(have_self_raster)
         {
-          cout << "I've also got the self raster." << endl;
+          sample_log << "I've also got the self raster." << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(FlowInfo, 
                                 Snow_shielding, Self_shielding);
-          cout << "Done with effective depths" << endl;                           
+          sample_log << "Done with effective depths" << endl;                           
         }
         else
         {
-          cout << "No self raster, but I'm getting the effective depths" << endl;
-          cout << "The constant self depth is: " <<  constant_self_depth << endl;
+          sample_log << "No self raster, but I'm getting the effective depths" << endl;
+          sample_log << "The constant self depth is: " <<  constant_self_depth << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(FlowInfo, 
                                 Snow_shielding, constant_self_depth);
-          cout << "Done with effective depths" << endl;        
+          sample_log << "Done with effective depths" << endl;        
         }
       }
       else
       {
         if(have_self_raster)
         {
-          cout << "Getting effective depths" << endl;
+          sample_log << "Getting effective depths" << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(FlowInfo, 
                                 constant_snow_depth, Self_shielding);
-          cout << "Done with effective depths" << endl;                                
+          sample_log << "Done with effective depths" << endl;                                
         }
         else
         {
-          cout << "Getting effective depths" << endl;
+          sample_log << "Getting effective depths" << endl;
           thisBasin.populate_snow_and_self_eff_depth_vectors(constant_snow_depth, 
                                              constant_self_depth);
-          cout << "Done with effective depths" << endl;                                 
+          sample_log << "Done with effective depths" << endl;                                 
         }
       }
 
 
-      cout << "Now I will populate the scaling vectors." << endl;
+      sample_log << "Now I will populate the scaling vectors." << endl;
       // Now topographic shielding and production scaling
       thisBasin.populate_scaling_vectors(FlowInfo, filled_raster, 
                                          Topographic_shielding,
                                          path_to_atmospheric_data);
-      cout << "Done populating the scaling vectors. " << endl;
+      sample_log << "Done populating the scaling vectors. " << endl;
 
       // now do the analysis
       vector<double> erate_analysis = thisBasin.full_CRN_erosion_analysis(test_N, 
                                           valid_nuclide_names[samp], test_dN, 
                                           prod_uncert_factor, Muon_scaling);
     
-      cout << "Line 2205, doing analysis" << endl;
+      sample_log << "Line 2205, doing analysis" << endl;
     
     
       // now get parameters for cosmogenic calculators
@@ -2949,30 +3101,60 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis(vector<string> Raster_name
           thisBasin.calculate_effective_pressures_for_calculators(filled_raster,
                                             FlowInfo, path_to_atmospheric_data);
         
-      cout << "Paramforcalc size: " << param_for_calc.size() << endl;              
-      cout << "Getting pressures" << endl;
+      sample_log << "Paramforcalc size: " << param_for_calc.size() << endl;              
+      sample_log << "Getting pressures" << endl;
 
 
-      // get the relief of the basin
-      float R = thisBasin.CalculateBasinRange(FlowInfo, filled_raster);
-      double relief = double(R);
+      // the shared results are added in sample order
+      #pragma omp ordered
+      {
+        cout << sample_log.str();
 
-      MapOfProdAndScaling["BasinRelief"][ valid_cosmo_points[samp] ] = relief;
-      MapOfProdAndScaling["AverageProdScaling"][ valid_cosmo_points[samp] ] = param_for_calc[0];
-      MapOfProdAndScaling["AverageTopoShielding"][ valid_cosmo_points[samp] ] = param_for_calc[1];
-      MapOfProdAndScaling["AverageSelfShielding"][ valid_cosmo_points[samp] ] = param_for_calc[2];
-      MapOfProdAndScaling["AverageSnowShielding"][ valid_cosmo_points[samp] ] = param_for_calc[3];
-      MapOfProdAndScaling["AverageShielding"][ valid_cosmo_points[samp] ] =  param_for_calc[11];
-      MapOfProdAndScaling["AverageCombinedScaling"][ valid_cosmo_points[samp] ] = param_for_calc[4];
-      MapOfProdAndScaling["outlet_lat"][ valid_cosmo_points[samp] ] = param_for_calc[5];
-      MapOfProdAndScaling["OutletPressure"][ valid_cosmo_points[samp] ] = param_for_calc[6];
-      MapOfProdAndScaling["OutletEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[7];
-      MapOfProdAndScaling["centroid_lat"][ valid_cosmo_points[samp] ] = param_for_calc[8];
-      MapOfProdAndScaling["CentroidPressure"][ valid_cosmo_points[samp] ] = param_for_calc[9];
-      MapOfProdAndScaling["CentroidEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[10];
+        // write the index basin if flag is set to true
+        if(write_basin_index_raster)
+        {
+          cout << "I'm writing a basin index number for you" << endl;
+      
+          if (not written_inital_basin_index)
+          {
+        
+            basin_number = valid_cosmo_points[samp];
+            basin_pixel_area = thisBasin.get_NumberOfCells();
+            basin_area_map[basin_number] = basin_pixel_area;
+            LSDIndexRaster NewBasinIndex = 
+               thisBasin.write_integer_data_to_LSDIndexRaster(basin_number, FlowInfo);
+            BasinIndex = NewBasinIndex;
+            written_inital_basin_index = true;
+          }
+          else
+          {
+            basin_number = valid_cosmo_points[samp];
+            thisBasin.add_basin_to_LSDIndexRaster(BasinIndex, FlowInfo,
+                                                  basin_area_map,basin_number);
+          }
+        }
+
+        // get the relief of the basin
+        float R = thisBasin.CalculateBasinRange(FlowInfo, filled_raster);
+        double relief = double(R);
+
+        MapOfProdAndScaling["BasinRelief"][ valid_cosmo_points[samp] ] = relief;
+        MapOfProdAndScaling["AverageProdScaling"][ valid_cosmo_points[samp] ] = param_for_calc[0];
+        MapOfProdAndScaling["AverageTopoShielding"][ valid_cosmo_points[samp] ] = param_for_calc[1];
+        MapOfProdAndScaling["AverageSelfShielding"][ valid_cosmo_points[samp] ] = param_for_calc[2];
+        MapOfProdAndScaling["AverageSnowShielding"][ valid_cosmo_points[samp] ] = param_for_calc[3];
+        MapOfProdAndScaling["AverageShielding"][ valid_cosmo_points[samp] ] =  param_for_calc[11];
+        MapOfProdAndScaling["AverageCombinedScaling"][ valid_cosmo_points[samp] ] = param_for_calc[4];
+        MapOfProdAndScaling["outlet_lat"][ valid_cosmo_points[samp] ] = param_for_calc[5];
+        MapOfProdAndScaling["OutletPressure"][ valid_cosmo_points[samp] ] = param_for_calc[6];
+        MapOfProdAndScaling["OutletEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[7];
+        MapOfProdAndScaling["centroid_lat"][ valid_cosmo_points[samp] ] = param_for_calc[8];
+        MapOfProdAndScaling["CentroidPressure"][ valid_cosmo_points[samp] ] = param_for_calc[9];
+        MapOfProdAndScaling["CentroidEffectivePressure"][ valid_cosmo_points[samp] ] = param_for_calc[10];
     
-      // add the erosion rate results to the holding data member
-      erosion_rate_results[ valid_cosmo_points[samp] ] = erate_analysis;
+        // add the erosion rate results to the holding data member
+        erosion_rate_results[ valid_cosmo_points[samp] ] = erate_analysis;
+      }
 
       //cout << "finished adding data" << endl;
 
@@ -3185,7 +3367,9 @@ void LSDCosmoData::full_shielding_cosmogenic_analysis_for_spawned(vector<string>
     {
       // get the topographic shielding
       cout << "No toposheild raster. Starting topographic shielding." << endl;
-      LSDRaster T_shield = filled_raster.TopographicShielding(theta_step, phi_step);
+      vector<int> spawned_junction(1,single_snapped_junction_index);
+      LSDRaster T_shield = calculate_topographic_shielding(filled_raster, FlowInfo, JNetwork,
+                                                           spawned_junction);
       Topographic_shielding = T_shield;
       
       if(write_TopoShield_raster)
@@ -3628,6 +3812,7 @@ void LSDCosmoData::Soil_sample_calculator(vector<string> Raster_names,
       // now get the scalings
       // now create the CRN parameters object
       LSDCRNParameters LSDCRNP;
+      set_muon_table(LSDCRNP);
       double this_elevation, this_pressure;
   
       // get the atmospheric parameters
@@ -3853,6 +4038,7 @@ vector<double> LSDCosmoData::full_CRN_erosion_analysis_point(double Nuclide_conc
   
   // get the difference in the pair
   LSDCRNParameters LSDCRNP;
+  set_muon_table(LSDCRNP);
   int pair_key = 0;       // this is for braucher-schaller
   vector<double> muon_uncert_diff = LSDCRNP.get_uncertainty_scaling_pair(pair_key);
   
@@ -4061,6 +4247,7 @@ double LSDCosmoData::predict_CRN_erosion_point(double Nuclide_conc, string Nucli
 
   // now create the CRN parameters object
   LSDCRNParameters LSDCRNP;
+  set_muon_table(LSDCRNP);
 
   // check the production uncertainty bools
   if(is_production_uncertainty_plus_on)
@@ -4284,6 +4471,7 @@ double LSDCosmoData::predict_mean_CRN_conc_point(double eff_erosion_rate, string
 
   // now create the CRN parameters object
   LSDCRNParameters LSDCRNP;
+  set_muon_table(LSDCRNP);
 
   // at this stage we will try to replicate the basin averaging that goes on in 
   // most paper
@@ -4500,7 +4688,8 @@ void LSDCosmoData::full_shielding_raster_printer(vector<string> Raster_names,
     {
       // get the topographic shielding
       cout << "Starting topographic shielding" << endl;
-      LSDRaster T_shield = filled_raster.TopographicShielding(theta_step, phi_step);
+      LSDRaster T_shield = calculate_topographic_shielding(filled_raster, FlowInfo, JNetwork,
+                                                           snapped_junction_indices);
       Topographic_shielding = T_shield;
       
       if(write_TopoShield_raster)
@@ -4822,6 +5011,7 @@ void LSDCosmoData::point_measurements(vector<int> valid_samples,vector<double> s
                               startdLoc, start_effdloc, startzLoc);
       
     LSDCRNParameters LSDCRNP;
+    set_muon_table(LSDCRNP);
     // at this stage we will try to replicate the basin averaging that goes on in 
     // most paper
     // set scaling parameters. This is necessary since the F values are
@@ -5059,7 +5249,8 @@ void LSDCosmoData::full_shielding_CRN_concentration_predictor(vector<string> Ras
     {
       // get the topographic shielding
       cout << "Starting topographic shielding" << endl;
-      LSDRaster T_shield = filled_raster.TopographicShielding(theta_step, phi_step);
+      LSDRaster T_shield = calculate_topographic_shielding(filled_raster, FlowInfo, JNetwork,
+                                                           snapped_junction_indices);
       Topographic_shielding = T_shield;
       
       if(write_TopoShield_raster)
@@ -5427,6 +5618,7 @@ void LSDCosmoData::print_results()
       LSDCRNParticle test_particle(startType, Xloc, Yloc,
                               startdLoc, start_effdloc, startzLoc);
       LSDCRNParameters LSDCRNP;
+      set_muon_table(LSDCRNP);
       string muon_string = "Braucher";
       double top_eff_depth = 0;     // even if there is shielding these
       double bottom_eff_depth = 0;  // get subsumed into the combined scaling 
@@ -5605,6 +5797,7 @@ void LSDCosmoData::print_scaling_and_shielding_complete_rasters()
 
     // now create the CRN parameters object
     LSDCRNParameters LSDCRNP;
+    set_muon_table(LSDCRNP);
     double gamma_spallation = 160;      // in g/cm^2: spallation attentuation depth
 
     // get the atmospheric parameters
@@ -54,6 +54,7 @@
 #include "LSDRaster.hpp"
 #include "LSDFlowInfo.hpp"
 #include "LSDJunctionNetwork.hpp"
+#include "LSDCRNParameters.hpp"
 using namespace std;
 
 #ifndef LSDCosmoData_HPP
@@ -177,6 +178,14 @@ class LSDCosmoData
     /// @author SMM
     /// @date 03/03/2015
     void check_parameter_values();
+
+    /// @brief Has a parameter object use the CRONUS muon table set with
+    ///  muon_table_tolerance and muon_table_file. Does nothing if the
+    ///  tolerance is 0.
+    /// @param LSDCRNP the parameter object
+    /// @author agent
+    /// @date 17/10/2026
+    void set_muon_table(LSDCRNParameters& LSDCRNP);
     
     /// @brief this function checks the existence and georeferencing of 
     ///  the rasters outlined in the file list
@@ -198,20 +207,43 @@ class LSDCosmoData
     /// @brief This dirves the spawning of basins
     /// @param path This is a string containing the path to the data files (needs / at the end)
     /// @param prefix the prefix of the data files
-    /// @param padding_pixels the number of pixels with which to pad the basins
+    /// @param padding_pixels the number of pixels with which to pad the basins.
+    ///  If max_shielding_distance is set, the padding is raised to cover it.
     /// @author SMM
     /// @date 10/07/2015
     void BasinSpawnerMaster(string path, string prefix, int padding_pixels);
 
     /// @brief This calculates topographic shielding for basins listed in the 
     ///   _CRNRasters.csv file
-    /// @detail Shielding rasters are printed to the same folder as the DEM
+    /// @detail Shielding rasters are printed to the same folder as the DEM.
+    ///  If max_shielding_distance is set the horizon search is limited to
+    ///  that distance.
     /// @param path This is a string containing the path to the data files (needs / at the end)
     /// @param prefix the prefix of the data files
     /// @author SMM
     /// @date 15/07/2015
     void RunShielding(string path, string prefix);
 
+    /// @brief This gets the topographic shielding for the basin analyses
+    /// @detail If max_shielding_distance is greater than 0, the horizon search
+    ///  is limited to that distance and only the pixels in the basins of the
+    ///  listed junctions are shielded (all others are nodata). The DEM is done in
+    ///  tiles, and tiles shared by nested basins are only computed once.
+    ///  Otherwise the whole DEM is shielded with TopographicShielding.
+    ///  Shielding used to be cast as shadows, which left the edge cells of the
+    ///  DEM at 1.0 and under shielded the next ring. Pixels near the DEM edge
+    ///  now get lower shielding, so pad basins that reach the edge.
+    /// @param filled_raster the filled DEM
+    /// @param FlowInfo the flow info object of the DEM
+    /// @param JNetwork the junction network of the DEM
+    /// @param basin_junctions the junctions at the outlets of the sampled basins
+    /// @return the topographic shielding raster
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRaster calculate_topographic_shielding(LSDRaster& filled_raster,
+                                     LSDFlowInfo& FlowInfo, LSDJunctionNetwork& JNetwork,
+                                     vector<int>& basin_junctions);
+
     /// @brief This function calculates and then returns a production raster
     /// @param Elevation_data a raster holding the elevations
     /// @param path_to_atmospheric_data a string that holds the path of the atmospheric data
@@ -255,6 +287,8 @@ class LSDCosmoData
     ///  It there is no DEM then this is set to "NULL"
     ///  @param CRN_params this contains the single shielding depths for snow
     ///   and self shielding if the rasters are not supplied. 
+    /// @details The samples are run on n_threads threads (set in the
+    ///  parameter file). The results are the same for any number of threads.
     /// @author SMM
     /// @date 28/02/2015
     void full_shielding_cosmogenic_analysis(vector<string> Raster_names,
@@ -274,6 +308,8 @@ class LSDCosmoData
     ///  @param CRN_params this contains the single shielding depths for snow
     ///   and self shielding if the rasters are not supplied. 
     /// @param known_eff_erosion an LSDRaster with known erosion rates in g/cm^2/yr
+    /// @details The samples are run on n_threads threads, as in
+    ///  full_shielding_cosmogenic_analysis.
     /// @author SMM
     /// @date 12/02/2016
     void full_shielding_cosmogenic_analysis_nested(vector<string> Raster_names,
@@ -716,6 +752,23 @@ class LSDCosmoData
     /// The inclination step for topographic sheilding calculations
     int phi_step;
 
+    /// The furthest distance searched for the horizon in topographic shielding
+    /// calculations. If 0 the search is not limited.
+    float max_shielding_distance;
+
+    /// The number of threads the samples of a DEM are run on. With 1 (the
+    /// default) they are run one after another.
+    int n_threads;
+
+    /// The largest relative error of the lookup table used for the CRONUS
+    /// muon production. If 0 (the default) the muon flux is integrated at
+    /// every depth instead.
+    double muon_table_tolerance;
+
+    /// The file the CRONUS muon table is read from, or written to if it does
+    /// not hold a good enough table. If empty the table is only kept in memory.
+    string muon_table_file;
+
     /// an uncertainty parameter which was superceded by the new
     /// error analyses but I have been too lazy to remove it. Does nothing 
     double prod_uncert_factor;
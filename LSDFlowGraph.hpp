@@ -0,0 +1,586 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDFlowGraph
+// Land Surface Dynamics Flow Graph
+//
+// A flow routing graph in which every cell passes fixed fractions of what it
+// holds to its downslope neighbours, within the University of Edinburgh Land
+// Surface Dynamics group topographic toolbox
+//
+// The graph is built either from D-infinity flow directions or from the
+// elevations with a multiple flow direction partitioning, in which the flow
+// is split between the lower neighbours in proportion to a power of the slope
+// (Freeman, 1991; Quinn et al., 1991; Holmgren, 1994). Once built it can be
+// used for any number of accumulations, each of which is one pass over the
+// cells.
+//
+// The receivers of each cell and the fraction sent to each are stored in
+// compressed rows: the receivers of cell k are Receivers[ReceiverStart[k]] to
+// Receivers[ReceiverStart[k+1]-1]. Cells are numbered row*NCols+col.
+//
+// Accumulation visits the cells in a topological order, in which every donor
+// comes before all of its receivers, so it is a single loop over the cells.
+// The order comes from the number of donors of each cell: cells with no
+// donors go on a stack, and a cell is pushed once all of its donors have been
+// visited. Because flow only goes downslope the graph has no cycles and this
+// is equivalent to sorting the cells by elevation, without needing the
+// elevations or a sort.
+//
+// Cells that are joined by flow form drainage basins that share nothing with
+// each other, so they can be accumulated in parallel. The basins are found
+// by going up the flow from the outlets, merging outlets whose areas meet,
+// and the topological order is kept within each basin, so the parallel and serial accumulations add the same
+// numbers in the same order and give identical results.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDFlowGraph_H
+#define LSDFlowGraph_H
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include "TNT/tnt.h"
+#include "LSDRasterBuffer.hpp"
+using namespace std;
+using namespace TNT;
+
+///@brief Receivers and flow fractions of every cell of a raster, with a
+/// topological order for accumulating along the flow.
+///@details Cells that are not part of the graph (nodata) have no receivers and
+/// are never visited, so accumulation leaves their values alone.
+///@author agent
+///@date 16/10/2026
+class LSDFlowGraph
+{
+  public:
+    /// @brief An empty graph
+    LSDFlowGraph() : NRows(0), NCols(0), NBasins(0) {}
+
+    /// @brief Builds the graph from D-infinity flow directions
+    /// @details The directions are in degrees clockwise from north, as returned
+    ///  by LSDRaster::D_inf_FlowDir. Each cell sends flow to the two neighbours
+    ///  either side of its direction, in proportion to the angle, following
+    ///  Tarboton (1997). Cells flagged with negative directions (pits) have no
+    ///  receivers, and flow is not sent to nodata cells.
+    /// @param FlowDir the D-infinity flow directions
+    /// @param NoDataValue the nodata value
+    LSDFlowGraph(Array2D<float>& FlowDir, float NoDataValue)
+                                          { create_dinf(FlowDir, NoDataValue); }
+
+    /// @brief Builds a multiple flow direction graph from elevations
+    /// @details Each cell sends flow to every lower neighbour k in proportion to
+    ///  L_k * tan_k^exponent, where tan_k is the drop to the neighbour divided by
+    ///  the distance to it. L_k is 1, or with contour length weighting the
+    ///  contour lengths of Quinn et al. (1991): 0.5 for cardinal and 0.354 for
+    ///  diagonal neighbours. This covers:
+    ///   Freeman (1991): exponent 1.1, no contour length weighting
+    ///   Quinn et al. (1991): exponent 1, contour length weighting
+    ///   Holmgren (1994): any exponent, no contour length weighting
+    ///  As in the multiple flow direction routines of LSDRaster, cells on the
+    ///  edge of the raster do not pass flow on, and neither do pits.
+    /// @param Elevation the elevations, which should be filled
+    /// @param NoDataValue the nodata value
+    /// @param DataResolution the cell size
+    /// @param exponent the exponent on the slope
+    /// @param contour_length_weighting true to weight by the contour lengths
+    LSDFlowGraph(Array2D<float>& Elevation, float NoDataValue, float DataResolution,
+                 float exponent, bool contour_length_weighting)
+    {
+      create_mfd(Elevation, NoDataValue, DataResolution, exponent,
+                 contour_length_weighting);
+    }
+
+    /// @return Number of rows
+    int get_NRows() const { return NRows; }
+    /// @return Number of columns
+    int get_NCols() const { return NCols; }
+    /// @return Number of cells in the graph
+    int get_NActiveCells() const { return int(Order.size()); }
+
+    /// @brief Finds the drainage basins: groups of cells joined by flow. This
+    ///  is done by accumulate when it is asked to work basin by basin, so it
+    ///  only needs calling directly to get the number of basins.
+    /// @return The number of basins
+    int find_basins()
+    {
+      if (NBasins == 0 && not Order.empty())
+      {
+        group_order_by_basin();
+      }
+      return NBasins;
+    }
+
+    /// @brief Accumulates values down the flow: each cell ends up with its own
+    ///  value plus everything passed to it from upslope.
+    /// @param values a view the size of the raster, holding the value of each
+    ///  cell on the way in and the accumulated values on the way out
+    /// @param split_by_basin if true the basins are accumulated in parallel
+    ///  when the code is compiled with OpenMP. The results are identical to
+    ///  the serial accumulation.
+    void accumulate(LSDRasterView<float> values, bool split_by_basin)
+    {
+      check_view(values);
+      accumulate_packed(values.begin(), 1, split_by_basin);
+    }
+
+    /// @brief Accumulates several rasters down the flow in one pass
+    /// @details The values are interleaved so that the values of each cell are
+    ///  next to each other, and the graph is traversed once for all of them.
+    /// @param values views the size of the raster, holding the value of each
+    ///  cell on the way in and the accumulated values on the way out
+    /// @param split_by_basin if true the basins are accumulated in parallel
+    void accumulate(vector< LSDRasterView<float> >& values, bool split_by_basin)
+    {
+      int NFields = int(values.size());
+      if (NFields == 1)
+      {
+        accumulate(values[0], split_by_basin);
+        return;
+      }
+      for (int f = 0; f<NFields; ++f)
+      {
+        check_view(values[f]);
+      }
+
+      long NCells = long(NRows)*long(NCols);
+      vector<float> packed(NCells*NFields);
+      #pragma omp parallel for schedule(static)
+      for (long k = 0; k<NCells; ++k)
+      {
+        for (int f = 0; f<NFields; ++f)
+        {
+          packed[k*NFields+f] = values[f].begin()[k];
+        }
+      }
+
+      accumulate_packed(&packed[0], NFields, split_by_basin);
+
+      #pragma omp parallel for schedule(static)
+      for (long k = 0; k<NCells; ++k)
+      {
+        for (int f = 0; f<NFields; ++f)
+        {
+          values[f].begin()[k] = packed[k*NFields+f];
+        }
+      }
+    }
+
+  private:
+    /// Number of rows
+    int NRows;
+    /// Number of columns
+    int NCols;
+    /// Start of the receivers of each cell; NRows*NCols+1 long
+    vector<int> ReceiverStart;
+    /// The receivers of all the cells
+    vector<int> Receivers;
+    /// The fraction of a cell's value sent to each receiver
+    vector<float> Fractions;
+    /// The cells in the graph in topological order. Once the basins have been
+    /// found the cells are grouped by basin, in topological order within each
+    /// basin
+    vector<int> Order;
+    /// The number of basins, 0 if they have not been found
+    int NBasins;
+    /// Start of each basin in Order; NBasins+1 long
+    vector<int> BasinStart;
+
+    /// @brief Adds a receiver to the cell being built, at position n of the
+    ///  receiver arrays, and moves n on
+    void add_receiver(int row, int col, float fraction, Array2D<float>& FlowDir,
+                      float NoDataValue, int& n)
+    {
+      if (fraction > 0 && row >= 0 && row < NRows && col >= 0 && col < NCols
+          && FlowDir[row][col] != NoDataValue)
+      {
+        Receivers[n] = row*NCols+col;
+        Fractions[n] = fraction;
+        n++;
+      }
+    }
+
+    /// @brief Builds the D-infinity receivers and the topological order
+    void create_dinf(Array2D<float>& FlowDir, float NoDataValue)
+    {
+      NRows = FlowDir.dim1();
+      NCols = FlowDir.dim2();
+      NBasins = 0;
+
+      // the two neighbours bounding each 45 degree sector, clockwise from north.
+      // The last sector also takes directions of exactly 360
+      float FD_Low[] = {0, 45, 90, 135, 180, 225, 270, 315};
+      float FD_High[] = {45, 90, 135, 180, 225, 270, 315, 360};
+      int Di1[] = {-1, -1, 0, 1, 1, 1, 0, -1};
+      int Dj1[] = {0, 1, 1, 1, 0, -1, -1, -1};
+      int Di2[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+      int Dj2[] = {1, 1, 1, 0, -1, -1, -1, 0};
+
+      int NCells = NRows*NCols;
+      ReceiverStart.assign(NCells+1,0);
+      Receivers.resize(2*NCells);
+      Fractions.resize(2*NCells);
+      vector<char> active(NCells,0);
+      int n = 0;
+      for (int i = 0; i<NRows; ++i)
+      {
+        for (int j = 0; j<NCols; ++j)
+        {
+          int k = i*NCols+j;
+          ReceiverStart[k] = n;
+          float flowDir = FlowDir[i][j];
+          if (flowDir == NoDataValue)
+          {
+            continue;
+          }
+          active[k] = 1;
+          if (flowDir < 0 || flowDir > 360)
+          {
+            continue;
+          }
+
+          // the sector, corrected for rounding in the division
+          int q = min(int(flowDir/45),7);
+          if (flowDir < FD_Low[q])
+          {
+            q--;
+          }
+          else if (q < 7 && flowDir >= FD_High[q])
+          {
+            q++;
+          }
+          add_receiver(i+Di1[q], j+Dj1[q], (FD_High[q]-flowDir)/45,
+                       FlowDir, NoDataValue, n);
+          add_receiver(i+Di2[q], j+Dj2[q], (flowDir-FD_Low[q])/45,
+                       FlowDir, NoDataValue, n);
+        }
+      }
+      ReceiverStart[NCells] = n;
+      Receivers.resize(n);
+      Fractions.resize(n);
+
+      build_order(active);
+    }
+
+    /// @brief Builds the multiple flow direction receivers and the
+    ///  topological order
+    void create_mfd(Array2D<float>& Elevation, float NoDataValue, float DataResolution,
+                    float exponent, bool contour_length_weighting)
+    {
+      NRows = Elevation.dim1();
+      NCols = Elevation.dim2();
+      NBasins = 0;
+
+      // the neighbours, the distances to them and their contour lengths
+      int di[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+      int dj[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+      float distance[8];
+      float contour_length[8];
+      for (int n = 0; n<8; ++n)
+      {
+        bool diagonal = (di[n] != 0 && dj[n] != 0);
+        distance[n] = diagonal ? DataResolution*sqrt(2.0) : DataResolution;
+        contour_length[n] = 1;
+        if (contour_length_weighting)
+        {
+          contour_length[n] = diagonal ? 0.354 : 0.5;
+        }
+      }
+
+      // count the receivers of each cell, then fill them in
+      int NCells = NRows*NCols;
+      vector<char> active(NCells,0);
+      vector<unsigned char> n_receivers(NCells,0);
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i<NRows; ++i)
+      {
+        for (int j = 0; j<NCols; ++j)
+        {
+          float z = Elevation[i][j];
+          if (z == NoDataValue)
+          {
+            continue;
+          }
+          active[i*NCols+j] = 1;
+          if (i == 0 || j == 0 || i == NRows-1 || j == NCols-1)
+          {
+            continue;
+          }
+          int count = 0;
+          for (int n = 0; n<8; ++n)
+          {
+            float zn = Elevation[i+di[n]][j+dj[n]];
+            if (zn != NoDataValue && zn < z)
+            {
+              count++;
+            }
+          }
+          n_receivers[i*NCols+j] = count;
+        }
+      }
+      ReceiverStart.assign(NCells+1,0);
+      for (int k = 0; k<NCells; ++k)
+      {
+        ReceiverStart[k+1] = ReceiverStart[k]+n_receivers[k];
+      }
+      Receivers.resize(ReceiverStart[NCells]);
+      Fractions.resize(ReceiverStart[NCells]);
+
+      #pragma omp parallel for schedule(static)
+      for (int i = 1; i<NRows-1; ++i)
+      {
+        for (int j = 1; j<NCols-1; ++j)
+        {
+          int k = i*NCols+j;
+          if (n_receivers[k] == 0)
+          {
+            continue;
+          }
+          float z = Elevation[i][j];
+          int r = ReceiverStart[k];
+          float total = 0;
+          for (int n = 0; n<8; ++n)
+          {
+            float zn = Elevation[i+di[n]][j+dj[n]];
+            if (zn != NoDataValue && zn < z)
+            {
+              float tan_slope = (z-zn)/distance[n];
+              float weight = (exponent == 1) ? tan_slope : pow(tan_slope,exponent);
+              weight *= contour_length[n];
+              Receivers[r] = k+di[n]*NCols+dj[n];
+              Fractions[r] = weight;
+              total += weight;
+              r++;
+            }
+          }
+          for (r = ReceiverStart[k]; r<ReceiverStart[k+1]; ++r)
+          {
+            Fractions[r] /= total;
+          }
+        }
+      }
+
+      build_order(active);
+    }
+
+    /// @brief Orders the active cells so that donors come before receivers
+    void build_order(vector<char>& active)
+    {
+      // no cell has more than eight donors
+      int NCells = NRows*NCols;
+      vector<unsigned char> n_donors(NCells,0);
+      for (int r = 0; r<int(Receivers.size()); ++r)
+      {
+        n_donors[Receivers[r]]++;
+      }
+
+      Order.clear();
+      Order.reserve(NCells);
+      vector<int> stack;
+      for (int k = 0; k<NCells; ++k)
+      {
+        if (active[k] && n_donors[k] == 0)
+        {
+          stack.push_back(k);
+        }
+      }
+      while (not stack.empty())
+      {
+        int k = stack.back();
+        stack.pop_back();
+        Order.push_back(k);
+        for (int r = ReceiverStart[k]; r<ReceiverStart[k+1]; ++r)
+        {
+          if (--n_donors[Receivers[r]] == 0)
+          {
+            stack.push_back(Receivers[r]);
+          }
+        }
+      }
+    }
+
+    /// @brief Groups Order by basin, keeping the topological order within
+    ///  each basin
+    void group_order_by_basin()
+    {
+      // Go up the flow from the outlets, so every cell is reached after its
+      // receivers. A cell joins the basin of its receivers, and if they are in
+      // different basins those basins are merged. The union-find is over the
+      // outlets rather than all the cells.
+      int NCells = NRows*NCols;
+      int NOrder = int(Order.size());
+      vector<int> label(NCells,-1);
+      vector<int> parent;
+      for (int n = NOrder-1; n>=0; --n)
+      {
+        int k = Order[n];
+        int first = ReceiverStart[k];
+        int last = ReceiverStart[k+1];
+        if (first == last)
+        {
+          label[k] = int(parent.size());
+          parent.push_back(label[k]);
+          continue;
+        }
+        int l = find_root(parent, label[Receivers[first]]);
+        for (int r = first+1; r<last; ++r)
+        {
+          int m = find_root(parent, label[Receivers[r]]);
+          if (m != l)
+          {
+            parent[max(l,m)] = min(l,m);
+            l = min(l,m);
+          }
+        }
+        label[k] = l;
+      }
+
+      // number the basins, then sort the order by basin
+      vector<int> basin_of_root(parent.size(),-1);
+      vector<int> basin(NOrder);
+      NBasins = 0;
+      for (int n = 0; n<NOrder; ++n)
+      {
+        int root = find_root(parent, label[Order[n]]);
+        if (basin_of_root[root] == -1)
+        {
+          basin_of_root[root] = NBasins++;
+        }
+        basin[n] = basin_of_root[root];
+      }
+      BasinStart.assign(NBasins+1,0);
+      for (int n = 0; n<NOrder; ++n)
+      {
+        BasinStart[basin[n]+1]++;
+      }
+      for (int b = 0; b<NBasins; ++b)
+      {
+        BasinStart[b+1] += BasinStart[b];
+      }
+      vector<int> next(BasinStart.begin(), BasinStart.end()-1);
+      vector<int> grouped(NOrder);
+      for (int n = 0; n<NOrder; ++n)
+      {
+        grouped[next[basin[n]]++] = Order[n];
+      }
+      Order.swap(grouped);
+    }
+
+    /// @brief The root of an outlet in the union-find
+    static int find_root(vector<int>& parent, int k)
+    {
+      while (parent[k] != k)
+      {
+        parent[k] = parent[parent[k]];
+        k = parent[k];
+      }
+      return k;
+    }
+
+    /// @brief Stops if a view does not match the graph
+    void check_view(LSDRasterView<float>& values) const
+    {
+      if (values.get_NRows() != NRows || values.get_NCols() != NCols
+          || not values.is_contiguous())
+      {
+        cout << "LSDFlowGraph::accumulate: the values need to be a contiguous raster"
+             << " the same size as the graph" << endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+
+    /// @brief Accumulates NFields interleaved values per cell, over the whole
+    ///  order or basin by basin
+    void accumulate_packed(float* v, int NFields, bool split_by_basin)
+    {
+      if (not split_by_basin)
+      {
+        accumulate_range(v, NFields, 0, int(Order.size()));
+        return;
+      }
+
+      find_basins();
+      #pragma omp parallel for schedule(dynamic,64)
+      for (int b = 0; b<NBasins; ++b)
+      {
+        accumulate_range(v, NFields, BasinStart[b], BasinStart[b+1]);
+      }
+    }
+
+    /// @brief Passes values down the flow for a range of Order
+    void accumulate_range(float* v, int NFields, int start, int end) const
+    {
+      if (NFields == 1)
+      {
+        for (int n = start; n<end; ++n)
+        {
+          int k = Order[n];
+          float value = v[k];
+          for (int r = ReceiverStart[k]; r<ReceiverStart[k+1]; ++r)
+          {
+            v[Receivers[r]] += value*Fractions[r];
+          }
+        }
+        return;
+      }
+
+      for (int n = start; n<end; ++n)
+      {
+        int k = Order[n];
+        const float* source = v+long(k)*NFields;
+        for (int r = ReceiverStart[k]; r<ReceiverStart[k+1]; ++r)
+        {
+          float fraction = Fractions[r];
+          float* target = v+long(Receivers[r])*NFields;
+          #pragma omp simd
+          for (int f = 0; f<NFields; ++f)
+          {
+            target[f] += source[f]*fraction;
+          }
+        }
+      }
+    }
+};
+
+#endif
@@ -80,6 +80,7 @@ It is the object that is used to generate contributing area, etc.
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <stdint.h>
 #include "TNT/tnt.h"
 #include "LSDRaster.hpp"
 #include "LSDIndexRaster.hpp"
@@ -87,6 +88,136 @@ using namespace std;
 using namespace TNT;
 
 
+///@brief A read only view of a binary FlowInfo file (.FIbin) mapped into
+/// memory.
+///@details It is filled in by LSDFlowInfo::unpickle_binary, which checks the
+/// whole file first. The arrays point straight into the mapped file, so
+/// nothing is copied, and every process that maps the same file shares the
+/// same pages. The pointers are only valid while the view exists and until
+/// unmap is called. The grids are stored row by row. The node vectors have
+/// NDataNodes values, except DeltaVector, which has NDataNodes+1, and
+/// BaseLevelNodeList, which has NBaseLevelNodes.
+///@author agent
+///@date 17/10/2026
+class LSDFlowInfoView
+{
+  public:
+    /// @brief Makes an empty view. Use LSDFlowInfo::unpickle_binary to map a file.
+    /// @author agent
+    /// @date 17/10/2026
+    LSDFlowInfoView()            { create(); }
+
+    /// @brief Unmaps the file
+    ~LSDFlowInfoView();
+
+    /// @brief Unmaps the file and empties the view
+    /// @author agent
+    /// @date 17/10/2026
+    void unmap();
+
+    /// @return true if a file is mapped
+    bool is_mapped() const                { return MappedData != NULL; }
+
+    /// @return the number of rows
+    int get_NRows() const                 { return NRows; }
+    /// @return the number of columns
+    int get_NCols() const                 { return NCols; }
+    /// @return the number of nodes with data
+    int get_NDataNodes() const            { return NDataNodes; }
+    /// @return the nodata value
+    int get_NoDataValue() const           { return NoDataValue; }
+    /// @return the x coordinate of the lower left corner
+    float get_XMinimum() const            { return XMinimum; }
+    /// @return the y coordinate of the lower left corner
+    float get_YMinimum() const            { return YMinimum; }
+    /// @return the size of a cell
+    float get_DataResolution() const      { return DataResolution; }
+    /// @return the boundary conditions
+    vector<string> get_BoundaryConditions() const  { return BoundaryConditions; }
+    /// @return the georeferencing strings
+    map<string,string> get_GeoReferencingStrings() const  { return GeoReferencingStrings; }
+    /// @return the number of base level nodes
+    int get_NBaseLevelNodes() const       { return NBaseLevelNodes; }
+
+    /// @return the node index of each cell
+    const int* get_NodeIndex() const          { return NodeIndex; }
+    /// @return the flow direction of each cell
+    const int* get_FlowDirection() const      { return FlowDirection; }
+    /// @return the flow length code of each cell
+    const int* get_FlowLengthCode() const     { return FlowLengthCode; }
+    /// @return the row of each node
+    const int* get_RowIndex() const           { return RowIndex; }
+    /// @return the column of each node
+    const int* get_ColIndex() const           { return ColIndex; }
+    /// @return the base level nodes
+    const int* get_BaseLevelNodeList() const  { return BaseLevelNodeList; }
+    /// @return the number of donors of each node
+    const int* get_NDonorsVector() const      { return NDonorsVector; }
+    /// @return the receiver of each node
+    const int* get_ReceiverVector() const     { return ReceiverVector; }
+    /// @return the delta vector
+    const int* get_DeltaVector() const        { return DeltaVector; }
+    /// @return the donor stack
+    const int* get_DonorStackVector() const   { return DonorStackVector; }
+    /// @return the nodes in stack order
+    const int* get_SVector() const            { return SVector; }
+    /// @return the base level node of the basin of each node
+    const int* get_BLBasinVector() const      { return BLBasinVector; }
+    /// @return the position of each node in the stack
+    const int* get_SVectorIndex() const       { return SVectorIndex; }
+    /// @return the number of nodes upslope of each node, itself included
+    const int* get_NContributingNodes() const { return NContributingNodes; }
+
+    /// @brief Gets the node index of a cell
+    /// @param row the row of the cell
+    /// @param col the column of the cell
+    /// @return the node index, or NoDataValue if the cell has no data
+    /// @author agent
+    /// @date 17/10/2026
+    int get_NodeIndex(int row, int col) const
+                               { return NodeIndex[size_t(row)*size_t(NCols)+size_t(col)]; }
+
+  private:
+    friend class LSDFlowInfo;
+
+    /// the start of the mapping
+    char* MappedData;
+    /// the length of the mapping in bytes
+    size_t MappedLength;
+
+    int NRows;
+    int NCols;
+    int NDataNodes;
+    int NoDataValue;
+    float XMinimum;
+    float YMinimum;
+    float DataResolution;
+    vector<string> BoundaryConditions;
+    map<string,string> GeoReferencingStrings;
+    int NBaseLevelNodes;
+
+    const int* NodeIndex;
+    const int* FlowDirection;
+    const int* FlowLengthCode;
+    const int* RowIndex;
+    const int* ColIndex;
+    const int* BaseLevelNodeList;
+    const int* NDonorsVector;
+    const int* ReceiverVector;
+    const int* DeltaVector;
+    const int* DonorStackVector;
+    const int* SVector;
+    const int* BLBasinVector;
+    const int* SVectorIndex;
+    const int* NContributingNodes;
+
+    void create();
+
+    /// the mapping cannot be shared between copies
+    LSDFlowInfoView(const LSDFlowInfoView&);
+    LSDFlowInfoView& operator=(const LSDFlowInfoView&);
+};
+
 /// @brief Object to perform flow routing.
 class LSDFlowInfo
 {
@@ -121,6 +252,14 @@ class LSDFlowInfo
   LSDFlowInfo(vector<string>& BoundaryConditions, LSDRaster& TopoRaster)
                    { create(BoundaryConditions, TopoRaster); }
 
+  /// @brief Creates a FlowInfo object from a binary FlowInfo file that has
+  /// been mapped with unpickle_binary. The data are copied out of the file.
+  /// @param View the mapped file
+  /// @author agent
+  /// @date 17/10/2026
+  LSDFlowInfo(const LSDFlowInfoView& View)
+                   { create(View); }
+
   /// @brief Copy of the LSDJunctionNetwork description here when written.
   friend class LSDJunctionNetwork;
 
@@ -356,6 +495,9 @@ class LSDFlowInfo
   /// @return Georeferencing information
   map<string,string> get_GeoReferencingStrings() const { return GeoReferencingStrings; }
 
+  /// @return The boundary conditions (North, East, South, West)
+  vector<string> get_BoundaryConditions() const { return BoundaryConditions; }
+
   /// @return Number of nodes with data as an integer.
   int get_NDataNodes () const          { return NDataNodes; }
   /// @return Vector of all base level nodes.
@@ -365,6 +507,10 @@ class LSDFlowInfo
   vector <int> get_donorStack() const { return DonorStackVector; }
   /// @return the S vector, which is a sorted list of nodes (see Braun and Willett 2012)
   vector <int> get_SVector() const { return SVector; }
+  /// @return the delta vector, the index into the donor stack of the first donor of each node (see Braun and Willett 2012)
+  vector <int> get_DeltaVector() const { return DeltaVector; }
+  /// @return the base level node of every node in the S vector
+  vector <int> get_BLBasinVector() const { return BLBasinVector; }
   /// @return FlowDirection values as a 2D Array.
   Array2D<int> get_FlowDirection() const { return FlowDirection; }
 
@@ -375,6 +521,18 @@ class LSDFlowInfo
   ///@param bl_node Integer
   void add_to_stack(int lm_index, int& j_index, int bl_node);
 
+  ///@brief Non-recursive version of add_to_stack that adds the whole drainage
+  ///tree of a base level node to the stack.
+  ///@details Uses a depth first search with an explicit stack so that the
+  ///depth of the tree is not limited by the call stack. The resulting SVector
+  ///and BLBasinVector are identical to those from add_to_stack.
+  ///@param bl_node The base level node.
+  ///@param j_index The next free position in the stack; updated.
+  ///@param node_stack Workspace for the search, reused between calls.
+  ///@author agent
+  ///@date 16/10/2026
+  void add_to_stack_iterative(int bl_node, int& j_index, vector<int>& node_stack);
+
   // some functions that print out indices to rasters
   ///@brief Write NodeIndex to an LSDIndexRaster.
   ///@return LSDIndexRaster of node index data.
@@ -457,6 +615,70 @@ class LSDFlowInfo
   /// @date 01/016/12
   void pickle(string filename);
 
+  ///@brief Writes the flow information to a single binary cache file
+  /// (extension .FIbin) that loads much faster than the text pickle.
+  ///@details The file has a versioned header, a section table with a
+  /// checksum for every section, and each array starts on a 64 byte boundary.
+  /// Unlike pickle it also stores the georeferencing strings.
+  ///@param filename the name of the file without extension
+  /// @author agent
+  /// @date 16/10/2026
+  void pickle_binary(string filename);
+
+  ///@brief Writes the flow information to a .FIbin file along with a hash of
+  /// whatever it was calculated from.
+  ///@param filename the name of the file without extension
+  ///@param source_hash a hash of the DEM and parameters used for the flow
+  /// routing. unpickle_binary can be asked to refuse a file with another hash.
+  /// @author agent
+  /// @date 16/10/2026
+  void pickle_binary(string filename, uint64_t source_hash);
+
+  ///@brief Reads a file written by pickle_binary.
+  ///@details Every checksum is verified before any data member is changed.
+  /// The data are then copied into the members, so every object loaded
+  /// from the file has its own copy. The overloads that take an
+  /// LSDFlowInfoView map the file without copying it.
+  ///@param filename the name of the file without extension
+  ///@return true if the file was loaded, false if it is missing or invalid,
+  /// in which case the object is not changed
+  /// @author agent
+  /// @date 16/10/2026
+  bool unpickle_binary(string filename);
+
+  ///@brief Reads a file written by pickle_binary, but only if it was written
+  /// with the given source hash, so stale flow routing is not reused.
+  ///@param filename the name of the file without extension
+  ///@param source_hash the hash the file must have been written with; 0
+  /// accepts any file
+  ///@return true if the file was loaded, false if it is missing, invalid or
+  /// has a different source hash, in which case the object is not changed
+  /// @author agent
+  /// @date 16/10/2026
+  bool unpickle_binary(string filename, uint64_t source_hash);
+
+  ///@brief Maps a file written by pickle_binary read only, without copying it.
+  ///@details Every checksum is verified before the view is changed.
+  ///@param filename the name of the file without extension
+  ///@param View the view of the file. Any file it already maps is unmapped.
+  ///@return true if the file was mapped, false if it is missing or invalid,
+  /// in which case the view is not changed
+  /// @author agent
+  /// @date 17/10/2026
+  static bool unpickle_binary(string filename, LSDFlowInfoView& View);
+
+  ///@brief Maps a file written by pickle_binary read only, without copying
+  /// it, but only if it was written with the given source hash.
+  ///@param filename the name of the file without extension
+  ///@param source_hash the hash the file must have been written with; 0
+  /// accepts any file
+  ///@param View the view of the file. Any file it already maps is unmapped.
+  ///@return true if the file was mapped, false if it is missing, invalid or
+  /// has a different source hash, in which case the view is not changed
+  /// @author agent
+  /// @date 17/10/2026
+  static bool unpickle_binary(string filename, uint64_t source_hash, LSDFlowInfoView& View);
+
   /// @brief This loads a csv file, putting the data into a data map
   /// @param filename The name of the csv file including path and extension
   /// @author SMM (ported into FlowInfo FJC 23/03/17)
@@ -583,12 +805,37 @@ class LSDFlowInfo
   ///The most probably use is to accumulate precipitation in order
   ///to get a discharge raster
   ///@param A raster that contains the variable to be accumulated (e.g., precipitation)
-  ///@return A raster containing the accumulated variable: NOTE the accumulation
-  ///does not include the node itself
+  ///@return A raster containing the accumulated variable, including the node
+  ///itself. Nodata in accum_raster counts as zero.
   ///@author SMM
   ///@date 09/06/2014
   LSDRaster upslope_variable_accumulator(LSDRaster& accum_raster);
 
+  ///@brief This function accumulates many variables at once
+  ///@details The rasters are gathered into a node-indexed matrix and
+  ///accumulated with the matrix version of this function, so the stack is
+  ///walked only once however many rasters there are. Nodata in the rasters
+  ///counts as zero. Each accumulated value includes the node itself.
+  ///@param accum_rasters The rasters to be accumulated (e.g., precipitation,
+  ///production rates or lithology fractions)
+  ///@return The accumulated rasters, in the same order
+  ///@author agent
+  ///@date 16/10/2026
+  vector<LSDRaster> upslope_variable_accumulator(vector<LSDRaster>& accum_rasters);
+
+  ///@brief This function accumulates many variables held in a node-indexed
+  ///matrix
+  ///@details The matrix has one row per node and one column per variable, so
+  ///the values of a node sit next to each other in memory. The SVector is
+  ///walked in reverse once and each donor adds its whole row to its receiver,
+  ///which the compiler vectorises across the variables.
+  ///@param node_values A matrix of NDataNodes rows, one column per variable
+  ///@return A matrix of the same shape with the accumulated values, each of
+  ///which includes the node itself
+  ///@author agent
+  ///@date 16/10/2026
+  Array2D<float> upslope_variable_accumulator(Array2D<float>& node_values);
+
   ///@brief This function tests whether one node is upstream of another node
   ///@param current_node
   ///@param test_node
@@ -1349,6 +1596,7 @@ void get_nodeindices_from_csv(string csv_filename, vector<int>& NIs, vector<floa
     void create(string fname);
     void create(LSDRaster& TopoRaster);
     void create(vector<string>& temp_BoundaryConditions, LSDRaster& TopoRaster);
+    void create(const LSDFlowInfoView& View);
 };
 
 #endif
@@ -0,0 +1,634 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDHorizonAngles
+// Land Surface Dynamics Horizon Angles
+//
+// Horizon angles of every cell of a DEM and the topographic shielding
+// computed from them, within the University of Edinburgh Land Surface
+// Dynamics group topographic toolbox
+//
+// The shielding of a cell from cosmic rays depends only on how high the
+// horizon is in each direction. For an azimuth the DEM is cut into scan lines
+// parallel to that azimuth. Walking each line from the end that the azimuth
+// points to, the cells already passed form an upper convex hull, and the
+// horizon of the next cell is the tangent from that cell to the hull
+// (Stewart, 1998, IEEE TVCG 4, 82-93). Every cell is pushed onto and popped
+// from the hull at most once, so one azimuth costs O(NRows*NCols).
+//
+// With the horizon H in each of N azimuths, the cosmic ray intensity
+// I0 sin^m(elevation) integrates analytically over elevation, and the
+// shielding factor is
+//   S = 1 - (1/N) sum sin^(m+1)(H)
+// (Dunne et al., 1999, Geomorphology 27, 3-11).
+//
+// The horizon search can be limited to a maximum distance, and
+// LSDShieldingTileCache uses that to compute shielding only for the tiles of
+// a DEM that are asked for, keeping each tile for reuse.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDHorizonAngles_H
+#define LSDHorizonAngles_H
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "LSDRasterBuffer.hpp"
+using namespace std;
+
+///@brief Computes horizon angles of a DEM along scan lines, and the
+/// topographic shielding factor that follows from them.
+///@details Azimuths are in degrees clockwise from north, and north is towards
+/// row 0. Horizons are returned as the tangent of the horizon elevation angle.
+/// A cell whose horizon lies below the horizontal gets 0. Scan lines stop at
+/// nodata and at the edge of the DEM, so nothing beyond them casts a horizon,
+/// as in LSDRaster::Shadows.
+///
+/// The search can be limited to a maximum distance. The scan line is then cut
+/// into blocks as long as that distance. The cells ahead of a cell lie in its
+/// own block, where the hull is kept as before, or in the block beyond it.
+/// The hull of the block beyond is built once, and points that drop out of
+/// range are removed by undoing their insertion, so the limited search is
+/// still exact and costs O(log) per cell.
+///
+/// The engine can work on a window of a larger DEM. The scan lines are laid
+/// out in the coordinates of the whole DEM, so a distance limited horizon
+/// computed in a window that holds every cell within that distance is the
+/// same as one computed on the whole DEM.
+///@author agent
+///@date 16/10/2026
+class LSDHorizonAngles
+{
+  public:
+    /// @brief Sets up the engine for a DEM. No data is copied: the
+    ///  elevations must stay alive as long as the engine.
+    /// @param zeta the elevations
+    /// @param NoDataValue the nodata value
+    /// @param DataResolution the cell size
+    LSDHorizonAngles(LSDRasterView<const float> zeta, float NoDataValue, float DataResolution)
+      : Zeta(zeta), NoData(NoDataValue), Resolution(DataResolution),
+        MaxDistance(0), RowOffset(0), ColOffset(0) {}
+
+    /// @brief Sets up the engine for a window of a DEM with a limited search.
+    /// @param zeta the elevations of the window
+    /// @param NoDataValue the nodata value
+    /// @param DataResolution the cell size
+    /// @param max_distance the furthest distance searched for the horizon. If
+    ///  this is 0 or less the search is not limited.
+    /// @param row_offset the row of the DEM at the top of the window
+    /// @param col_offset the column of the DEM at the left of the window
+    LSDHorizonAngles(LSDRasterView<const float> zeta, float NoDataValue, float DataResolution,
+                     float max_distance, int row_offset, int col_offset)
+      : Zeta(zeta), NoData(NoDataValue), Resolution(DataResolution),
+        MaxDistance(max_distance), RowOffset(row_offset), ColOffset(col_offset) {}
+
+    /// @brief Computes the horizon of every cell looking towards one azimuth.
+    /// @param azimuth the direction of the horizon in degrees clockwise from north
+    /// @param tan_horizon a view the same size as the DEM that gets the
+    ///  tangent of the horizon angle. Nodata cells get the nodata value.
+    void calculate_horizon(float azimuth, LSDRasterView<float> tan_horizon) const
+    {
+      int NRows = Zeta.get_NRows();
+      int NCols = Zeta.get_NCols();
+      double az = azimuth*M_PI/180.0;
+      double dcol = sin(az);
+      double drow = -cos(az);
+
+      // the major axis is the one the scan line advances along by one cell
+      // per step; the minor index shifts by at most one cell per step
+      bool col_major = (fabs(dcol) >= fabs(drow));
+      int NMajor = col_major ? NCols : NRows;
+      int NMinor = col_major ? NRows : NCols;
+      int major_offset = col_major ? ColOffset : RowOffset;
+      int minor_offset = col_major ? RowOffset : ColOffset;
+      double d_major = col_major ? dcol : drow;
+      double d_minor = col_major ? drow : dcol;
+      int major_sign = (d_major >= 0) ? 1 : -1;
+      double minor_slope = d_minor/fabs(d_major);
+      double step_length = Resolution*sqrt(1.0+minor_slope*minor_slope);
+
+      // the number of steps within the search distance
+      int max_steps = (MaxDistance > 0) ? int(floor(MaxDistance/step_length)) : 0;
+
+      // scan line o holds the cells with minor = o + shift[major], so every
+      // cell is on exactly one line. The shift is taken from the whole DEM
+      vector<int> shift(NMajor);
+      int min_shift = 0;
+      int max_shift = 0;
+      for (int major = 0; major<NMajor; major++)
+      {
+        shift[major] = int(floor(minor_slope*(major+major_offset)+0.5))-minor_offset;
+        if (major == 0 || shift[major] < min_shift) { min_shift = shift[major]; }
+        if (major == 0 || shift[major] > max_shift) { max_shift = shift[major]; }
+      }
+
+      // the cells of one line, from the far end to the near end
+      vector<int> line_row(NMajor);
+      vector<int> line_col(NMajor);
+      vector<double> line_z(NMajor);
+      vector<float> line_tan(NMajor);
+      ScanLineWork work(NMajor);
+      for (int o = -max_shift; o<NMinor-min_shift; o++)
+      {
+        int n_cells = 0;
+        for (int step = 0; step<NMajor; step++)
+        {
+          int major = (major_sign > 0) ? NMajor-1-step : step;
+          int minor = o+shift[major];
+          if (minor < 0 || minor >= NMinor)
+          {
+            continue;
+          }
+          int row = col_major ? minor : major;
+          int col = col_major ? major : minor;
+          line_row[n_cells] = row;
+          line_col[n_cells] = col;
+          line_z[n_cells] = Zeta(row,col);
+          n_cells++;
+        }
+
+        if (max_steps > 0)
+        {
+          limited_line_horizon(n_cells, step_length, max_steps, line_z, line_tan, work);
+        }
+        else if (MaxDistance > 0)
+        {
+          // nothing is within the search distance
+          for (int n = 0; n<n_cells; n++)
+          {
+            line_tan[n] = (line_z[n] == NoData) ? NoData : 0;
+          }
+        }
+        else
+        {
+          line_horizon(n_cells, step_length, line_z, line_tan, work);
+        }
+
+        for (int n = 0; n<n_cells; n++)
+        {
+          tan_horizon(line_row[n],line_col[n]) = line_tan[n];
+        }
+      }
+    }
+
+    /// @brief Computes the topographic shielding factor of every cell.
+    /// @details The horizon is found at AzimuthStep, 2*AzimuthStep ... 360
+    ///  degrees and the integral over elevation is done analytically.
+    ///  Azimuths are processed in parallel when the code is compiled with
+    ///  OpenMP; each thread keeps one horizon and one running sum the size of
+    ///  the DEM.
+    /// @param AzimuthStep the spacing of the azimuths in degrees. It should
+    ///  be a factor of 360.
+    /// @param shielding_exponent the exponent m of the angular distribution of
+    ///  the cosmic ray intensity, I0 sin^m(elevation). 2.3 is the usual value.
+    /// @return the shielding factors. Nodata cells get the nodata value.
+    LSDRasterBuffer<float> calculate_shielding(int AzimuthStep, float shielding_exponent) const
+    {
+      int NRows = Zeta.get_NRows();
+      int NCols = Zeta.get_NCols();
+      long NCells = long(NRows)*long(NCols);
+      if (AzimuthStep < 1)
+      {
+        cout << "LSDHorizonAngles::calculate_shielding: the azimuth step must be at least 1 degree" << endl;
+        exit(EXIT_FAILURE);
+      }
+      int NAzimuths = 360/AzimuthStep;
+      double exponent = shielding_exponent+1.0;
+
+      vector<double> shielded(NCells,0.0);
+
+      #pragma omp parallel
+      {
+        LSDRasterBuffer<float> tan_horizon(NRows,NCols,0.0);
+        vector<double> thread_shielded(NCells,0.0);
+
+        #pragma omp for schedule(dynamic)
+        for (int a = 0; a<NAzimuths; a++)
+        {
+          calculate_horizon(float((a+1)*AzimuthStep), tan_horizon.view());
+          for (int row = 0; row<NRows; row++)
+          {
+            const float* tan_row = tan_horizon.row(row);
+            double* shielded_row = &thread_shielded[long(row)*long(NCols)];
+            for (int col = 0; col<NCols; col++)
+            {
+              float tan_h = tan_row[col];
+              if (tan_h > 0 && tan_h != NoData)
+              {
+                // sin(atan(x)) = x/sqrt(1+x^2)
+                shielded_row[col] += pow(tan_h/sqrt(1.0+double(tan_h)*tan_h), exponent);
+              }
+            }
+          }
+        }
+
+        #pragma omp critical
+        {
+          for (long i = 0; i<NCells; i++)
+          {
+            shielded[i] += thread_shielded[i];
+          }
+        }
+      }
+
+      LSDRasterBuffer<float> shielding(NRows,NCols,NoData);
+      for (int row = 0; row<NRows; row++)
+      {
+        for (int col = 0; col<NCols; col++)
+        {
+          if (Zeta(row,col) != NoData)
+          {
+            shielding(row,col) = 1.0-shielded[long(row)*long(NCols)+col]/NAzimuths;
+          }
+        }
+      }
+      return shielding;
+    }
+
+  private:
+    /// Scratch space for the hulls of one scan line
+    struct ScanLineWork
+    {
+      ScanLineWork(int n) : hull_t(n), hull_z(n), far_t(n), far_z(n),
+                            undo_pos(n), undo_n(n), undo_t(n), undo_z(n) {}
+      /// the hull of the cells passed, from the far end (bottom) to the
+      /// nearest cell (top)
+      vector<double> hull_t;
+      vector<double> hull_z;
+      /// the hull of the block beyond, from its near end to its far end
+      vector<double> far_t;
+      vector<double> far_z;
+      /// what each insertion into the far hull overwrote
+      vector<int> undo_pos;
+      vector<int> undo_n;
+      vector<double> undo_t;
+      vector<double> undo_z;
+    };
+
+    /// @brief The unlimited horizon along one scan line
+    void line_horizon(int n_cells, double step_length, const vector<double>& line_z,
+                      vector<float>& line_tan, ScanLineWork& work) const
+    {
+      double* hull_t = &work.hull_t[0];
+      double* hull_z = &work.hull_z[0];
+      int n_hull = 0;
+      for (int n = 0; n<n_cells; n++)
+      {
+        double z = line_z[n];
+        if (z == NoData)
+        {
+          line_tan[n] = NoData;
+          n_hull = 0;
+          continue;
+        }
+
+        // distance along the line, increasing towards the horizon
+        double t = -n*step_length;
+
+        // drop hull points that lie below the line from this cell to the
+        // point beneath them: they are hidden from here and from every
+        // cell still to come
+        while (n_hull >= 2 &&
+               (hull_z[n_hull-1]-z)*(hull_t[n_hull-2]-t) <=
+               (hull_z[n_hull-2]-z)*(hull_t[n_hull-1]-t))
+        {
+          n_hull--;
+        }
+
+        float tan_h = 0;
+        if (n_hull > 0)
+        {
+          double slope = (hull_z[n_hull-1]-z)/(hull_t[n_hull-1]-t);
+          if (slope > 0)
+          {
+            tan_h = slope;
+          }
+        }
+        line_tan[n] = tan_h;
+
+        hull_t[n_hull] = t;
+        hull_z[n_hull] = z;
+        n_hull++;
+      }
+    }
+
+    /// @brief The horizon along one scan line, searching at most max_steps
+    ///  cells ahead of each cell
+    void limited_line_horizon(int n_cells, double step_length, int max_steps,
+                              const vector<double>& line_z, vector<float>& line_tan,
+                              ScanLineWork& work) const
+    {
+      double* hull_t = &work.hull_t[0];
+      double* hull_z = &work.hull_z[0];
+      double* far_t = &work.far_t[0];
+      double* far_z = &work.far_z[0];
+      int n_hull = 0;
+      int n_far = 0;
+
+      // the cells of the block beyond that are in the far hull are
+      // far_first ... block_start-1
+      int far_first = 0;
+      int block_start = 0;
+      for (int n = 0; n<n_cells; n++)
+      {
+        if (n%max_steps == 0)
+        {
+          // a new block: build the hull of the previous block, from its near
+          // end outwards, stopping at nodata
+          int previous_start = n-max_steps;
+          block_start = n;
+          n_far = 0;
+          far_first = n;
+          for (int p = n-1; p>=0 && p>=previous_start; p--)
+          {
+            if (line_z[p] == NoData)
+            {
+              break;
+            }
+            double t = -p*step_length;
+            double z = line_z[p];
+
+            // keep the vertices up to the last one that lies above the line
+            // from the vertex before it to the new point
+            int keep = 0;
+            int lo = 1;
+            int hi = n_far-1;
+            while (lo <= hi)
+            {
+              int mid = (lo+hi)/2;
+              if ((far_z[mid]-far_z[mid-1])*(t-far_t[mid]) >
+                  (z-far_z[mid])*(far_t[mid]-far_t[mid-1]))
+              {
+                keep = mid;
+                lo = mid+1;
+              }
+              else
+              {
+                hi = mid-1;
+              }
+            }
+            int pos = (n_far == 0) ? 0 : keep+1;
+            int undo = n-1-p;
+            work.undo_pos[undo] = pos;
+            work.undo_n[undo] = n_far;
+            work.undo_t[undo] = far_t[pos];
+            work.undo_z[undo] = far_z[pos];
+            far_t[pos] = t;
+            far_z[pos] = z;
+            n_far = pos+1;
+            far_first = p;
+          }
+          n_hull = 0;
+        }
+
+        double z = line_z[n];
+        if (z == NoData)
+        {
+          line_tan[n] = NoData;
+          n_hull = 0;
+          // nothing beyond this cell is visible from the rest of the block
+          n_far = 0;
+          far_first = block_start;
+          continue;
+        }
+        double t = -n*step_length;
+
+        // remove the cells of the block beyond that are now out of range,
+        // undoing their insertions in reverse order
+        while (far_first < block_start && far_first < n-max_steps)
+        {
+          int undo = block_start-1-far_first;
+          int pos = work.undo_pos[undo];
+          far_t[pos] = work.undo_t[undo];
+          far_z[pos] = work.undo_z[undo];
+          n_far = work.undo_n[undo];
+          far_first++;
+        }
+
+        double best = 0;
+
+        // the tangent to the far hull: the slope to its vertices rises and
+        // then falls
+        if (n_far > 0)
+        {
+          int lo = 0;
+          int hi = n_far-1;
+          while (lo < hi)
+          {
+            int mid = (lo+hi)/2;
+            if ((far_z[mid+1]-z)*(far_t[mid]-t) > (far_z[mid]-z)*(far_t[mid+1]-t))
+            {
+              lo = mid+1;
+            }
+            else
+            {
+              hi = mid;
+            }
+          }
+          double slope = (far_z[lo]-z)/(far_t[lo]-t);
+          if (slope > best)
+          {
+            best = slope;
+          }
+        }
+
+        // the hull of this block, as in line_horizon
+        while (n_hull >= 2 &&
+               (hull_z[n_hull-1]-z)*(hull_t[n_hull-2]-t) <=
+               (hull_z[n_hull-2]-z)*(hull_t[n_hull-1]-t))
+        {
+          n_hull--;
+        }
+        if (n_hull > 0)
+        {
+          double slope = (hull_z[n_hull-1]-z)/(hull_t[n_hull-1]-t);
+          if (slope > best)
+          {
+            best = slope;
+          }
+        }
+        line_tan[n] = best;
+
+        hull_t[n_hull] = t;
+        hull_z[n_hull] = z;
+        n_hull++;
+      }
+    }
+
+    /// The elevations
+    LSDRasterView<const float> Zeta;
+    /// The nodata value
+    float NoData;
+    /// The cell size
+    float Resolution;
+    /// The furthest distance searched, or 0 for no limit
+    float MaxDistance;
+    /// The row of the whole DEM at the top of Zeta
+    int RowOffset;
+    /// The column of the whole DEM at the left of Zeta
+    int ColOffset;
+};
+
+///@brief Distance limited shielding factors of a DEM, computed a tile at a
+/// time and kept for reuse.
+///@details The DEM is divided into square tiles. The first time a cell of a
+/// tile is asked for, the shielding of the whole tile is computed from the
+/// distance limited horizons in a window made of the tile and a halo as wide
+/// as the search distance. Nothing outside that window can be within reach of
+/// the tile, so the result is the same as for the whole DEM. Later requests for
+/// any cell of the tile, for example from a basin nested inside one already
+/// done, are answered from the stored tile.
+///@author agent
+///@date 16/10/2026
+class LSDShieldingTileCache
+{
+  public:
+    /// @brief Sets up the cache. No data is copied: the elevations must stay
+    ///  alive as long as the cache.
+    /// @param zeta the elevations
+    /// @param NoDataValue the nodata value
+    /// @param DataResolution the cell size
+    /// @param AzimuthStep the spacing of the azimuths in degrees
+    /// @param shielding_exponent the exponent m of the cosmic ray intensity
+    /// @param max_distance the furthest distance searched for the horizon.
+    ///  It must be greater than 0.
+    /// @param tile_size the number of rows and columns in a tile
+    LSDShieldingTileCache(LSDRasterView<const float> zeta, float NoDataValue,
+                          float DataResolution, int AzimuthStep,
+                          float shielding_exponent, float max_distance, int tile_size)
+      : Zeta(zeta), NoData(NoDataValue), Resolution(DataResolution),
+        AzStep(AzimuthStep), Exponent(shielding_exponent),
+        MaxDistance(max_distance), TileSize(tile_size)
+    {
+      if (MaxDistance <= 0 || TileSize < 1)
+      {
+        cout << "LSDShieldingTileCache: the search distance and the tile size must be positive" << endl;
+        exit(EXIT_FAILURE);
+      }
+      Halo = int(ceil(MaxDistance/Resolution));
+      NTileRows = (Zeta.get_NRows()+TileSize-1)/TileSize;
+      NTileCols = (Zeta.get_NCols()+TileSize-1)/TileSize;
+      Tiles.resize(long(NTileRows)*long(NTileCols));
+      NComputed = 0;
+    }
+
+    /// @return the shielding factor of a cell, computing its tile if needed
+    /// @param row the row of the cell
+    /// @param col the column of the cell
+    float get_shielding(int row, int col)
+    {
+      int tile_row = row/TileSize;
+      int tile_col = col/TileSize;
+      LSDRasterBuffer<float>& tile = Tiles[long(tile_row)*long(NTileCols)+tile_col];
+      if (tile.get_NRows() == 0)
+      {
+        compute_tile(tile_row, tile_col);
+      }
+      return tile(row-tile_row*TileSize, col-tile_col*TileSize);
+    }
+
+    /// @return the number of tiles computed so far
+    int get_NTilesComputed() const { return NComputed; }
+    /// @return the number of tiles in the DEM
+    int get_NTiles() const { return NTileRows*NTileCols; }
+
+  private:
+    /// @brief Computes and stores the shielding of one tile
+    void compute_tile(int tile_row, int tile_col)
+    {
+      int NRows = Zeta.get_NRows();
+      int NCols = Zeta.get_NCols();
+      int core_row = tile_row*TileSize;
+      int core_col = tile_col*TileSize;
+      int core_rows = min(TileSize, NRows-core_row);
+      int core_cols = min(TileSize, NCols-core_col);
+
+      int win_row = max(0, core_row-Halo);
+      int win_col = max(0, core_col-Halo);
+      int win_rows = min(NRows, core_row+core_rows+Halo)-win_row;
+      int win_cols = min(NCols, core_col+core_cols+Halo)-win_col;
+
+      LSDHorizonAngles Horizons(Zeta.window(win_row,win_col,win_rows,win_cols),
+                                NoData, Resolution, MaxDistance, win_row, win_col);
+      LSDRasterBuffer<float> window_shielding = Horizons.calculate_shielding(AzStep, Exponent);
+
+      LSDRasterBuffer<float> tile(core_rows,core_cols,NoData);
+      for (int r = 0; r<core_rows; r++)
+      {
+        for (int c = 0; c<core_cols; c++)
+        {
+          tile(r,c) = window_shielding(core_row-win_row+r, core_col-win_col+c);
+        }
+      }
+      Tiles[long(tile_row)*long(NTileCols)+tile_col] = tile;
+      NComputed++;
+    }
+
+    /// The elevations
+    LSDRasterView<const float> Zeta;
+    /// The nodata value
+    float NoData;
+    /// The cell size
+    float Resolution;
+    /// The spacing of the azimuths in degrees
+    int AzStep;
+    /// The exponent of the cosmic ray intensity
+    float Exponent;
+    /// The furthest distance searched
+    float MaxDistance;
+    /// The number of rows and columns in a tile
+    int TileSize;
+    /// The width of the halo around a tile in cells
+    int Halo;
+    /// The number of rows of tiles
+    int NTileRows;
+    /// The number of columns of tiles
+    int NTileCols;
+    /// The number of tiles computed
+    int NComputed;
+    /// The shielding of each tile, row by row; empty until computed
+    vector< LSDRasterBuffer<float> > Tiles;
+};
+
+#endif
@@ -95,6 +95,7 @@
 #include "LSDRaster.hpp"
 #include "LSDStatsTools.hpp"
 #include "LSDShapeTools.hpp"
+#include "LSDCompressedRaster.hpp"
 
 using namespace std;
 using namespace TNT;
@@ -742,10 +743,26 @@ void LSDIndexRaster::read_raster(string filename, string extension)
     // now update the objects raster data
     RasterData = data.copy();
   }
+  else if (extension == "lsdc")
+  {
+    // tiled compressed raster. The georeferencing travels in the file itself
+    LSDCompressedRasterReader reader(string_filename);
+    NRows = reader.get_NRows();
+    NCols = reader.get_NCols();
+    XMinimum = reader.get_XMinimum();
+    YMinimum = reader.get_YMinimum();
+    DataResolution = reader.get_DataResolution();
+    NoDataValue = reader.get_NoDataValue();
+    GeoReferencingStrings = reader.get_GeoReferencingStrings();
+
+    Array2D<int> data;
+    reader.read_all(data);
+    RasterData = data;
+  }
   else
   {
     cout << "You did not enter and approprate extension!" << endl
-         << "You entered: " << extension << " options are .flt and .asc" << endl;
+         << "You entered: " << extension << " options are .flt, .bil, .asc and .lsdc" << endl;
     exit(EXIT_FAILURE);
   }
 
@@ -908,10 +925,17 @@ void LSDIndexRaster::write_raster(string filename, string extension)
     }
     data_ofs.close();
   }
+  else if (extension == "lsdc")
+  {
+    // tiled compressed raster, with the georeferencing in the file
+    write_compressed_raster(string_filename, NRows, NCols, XMinimum, YMinimum,
+                            DataResolution, NoDataValue, GeoReferencingStrings,
+                            RasterData, 256);
+  }
   else
   {
     cout << "You did not enter and approprate extension!" << endl
-         << "You entered: " << extension << " options are .flt, .bil and .asc" << endl;
+         << "You entered: " << extension << " options are .flt, .bil, .asc and .lsdc" << endl;
     exit(EXIT_FAILURE);
   }
 
@@ -6165,7 +6165,9 @@ LSDIndexRaster LSDJunctionNetwork::GetStreams(int min_order, int max_order)
 bool LSDJunctionNetwork::node_tester(LSDFlowInfo& FlowInfo, int input_junction)
 {
 
-  Array2D<int> FlowDirection = FlowInfo.get_FlowDirection();  //used as a proxy of the elevation data
+  // the flow directions are used as a proxy of the elevation data. They are
+  // read in place rather than copied so that basins can be tested from
+  // several threads at once
   bool flag = false;
 
   //get reciever junction of the input junction
@@ -6213,21 +6215,21 @@ bool LSDJunctionNetwork::node_tester(LSDFlowInfo& FlowInfo, int input_junction)
     return flag;}
 
     // check surrounding cells for NoDataValue
-    else if (FlowDirection[i+1][j+1] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i+1,j+1) == NoDataValue){flag = true;
     return flag;}
-    else if (FlowDirection[i+1][j] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i+1,j) == NoDataValue){flag = true;
     return flag;}
-    else if (FlowDirection[i+1][j-1] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i+1,j-1) == NoDataValue){flag = true;
     return flag;}
-    else if (FlowDirection[i][j+1] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i,j+1) == NoDataValue){flag = true;
     return flag;}
-    else if (FlowDirection[i][j-1] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i,j-1) == NoDataValue){flag = true;
     return flag;}
-    else if (FlowDirection[i-1][j+1] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i-1,j+1) == NoDataValue){flag = true;
     return flag;}
-    else if (FlowDirection[i-1][j] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i-1,j) == NoDataValue){flag = true;
     return flag;}
-    else if (FlowDirection[i-1][j-1] == NoDataValue){flag = true;
+    else if (FlowInfo.get_LocalFlowDirection(i-1,j-1) == NoDataValue){flag = true;
     return flag;}
   }
   return flag;
@@ -0,0 +1,320 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDMappedRaster
+// Land Surface Dynamics Mapped Raster
+//
+// An object within the University
+//  of Edinburgh Land Surface Dynamics group topographic toolbox
+//  for reading binary rasters (.flt and ENVI .bil) through a memory map
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDMappedRaster_CPP
+#define LSDMappedRaster_CPP
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "TNT/tnt.h"
+#include "LSDRaster.hpp"
+#include "LSDIndexRaster.hpp"
+#include "LSDMappedRaster.hpp"
+using namespace std;
+using namespace TNT;
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Reads the header and maps the data file
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDMappedRaster::create(string filename, string extension)
+{
+  FileDescriptor = -1;
+  MappedData = NULL;
+  MappedLength = 0;
+
+  if (extension != "flt" && extension != "bil")
+  {
+    cout << "\nFATAL ERROR: only flt and bil files can be mapped. You entered: "
+         << extension << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  DataType = 4;
+  ByteOrder = 0;
+  HeaderOffset = 0;
+  read_header(filename, extension);
+
+  BytesPerValue = envi_bytes_per_value(DataType);
+  if (BytesPerValue == 0)
+  {
+    cout << "\nFATAL ERROR: cannot map a raster with ENVI data type " << DataType << endl;
+    exit(EXIT_FAILURE);
+  }
+  NeedsSwap = ( (ByteOrder == 1) == host_is_little_endian() );
+
+  string string_filename = filename+"."+extension;
+  FileDescriptor = open(string_filename.c_str(), O_RDONLY);
+  if (FileDescriptor < 0)
+  {
+    cout << "\nFATAL ERROR: the data file \"" << string_filename
+         << "\" doesn't exist" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  struct stat file_info;
+  fstat(FileDescriptor, &file_info);
+  size_t expected_length = size_t(HeaderOffset)
+                          +size_t(NRows)*size_t(NCols)*size_t(BytesPerValue);
+  if (size_t(file_info.st_size) < expected_length)
+  {
+    cout << "\nFATAL ERROR: the data file \"" << string_filename << "\" has "
+         << file_info.st_size << " bytes but the header needs " << expected_length << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  MappedLength = expected_length;
+  void* mapping = mmap(NULL, MappedLength, PROT_READ, MAP_SHARED, FileDescriptor, 0);
+  if (mapping == MAP_FAILED)
+  {
+    cout << "\nFATAL ERROR: unable to map the data file \"" << string_filename << "\"" << endl;
+    exit(EXIT_FAILURE);
+  }
+  MappedData = static_cast<char*>(mapping);
+
+  // most access is a sweep down the rows
+  madvise(MappedData, MappedLength, MADV_SEQUENTIAL);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Unmaps the file
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDMappedRaster::~LSDMappedRaster()
+{
+  if (MappedData != NULL)
+  {
+    munmap(MappedData, MappedLength);
+  }
+  if (FileDescriptor >= 0)
+  {
+    close(FileDescriptor);
+  }
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// A float raster in host byte order whose data starts on a float boundary can
+// be used straight from the mapping
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+bool LSDMappedRaster::is_zero_copy() const
+{
+  return (DataType == 4 && !NeedsSwap && HeaderOffset % int(sizeof(float)) == 0);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// The view onto the mapping
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDRasterView<const float> LSDMappedRaster::get_view() const
+{
+  if (!is_zero_copy())
+  {
+    cout << "\nFATAL ERROR: this raster is not stored as floats in the byte order"
+         << " of this machine, so it cannot be viewed in place. Use read_rows instead." << endl;
+    exit(EXIT_FAILURE);
+  }
+  return LSDRasterView<const float>(reinterpret_cast<const float*>(row_pointer(0)),
+                                    NRows, NCols, NCols);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Converts one value in the file to a float. Values below -1e10 are treated as
+// nodata, as they are in LSDRaster::read_raster
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+float LSDMappedRaster::convert_value(const char* value) const
+{
+  return convert_raster_value(value, DataType, BytesPerValue, NeedsSwap, float(NoDataValue));
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Gets a single value
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+float LSDMappedRaster::get_value(int row, int col) const
+{
+  return convert_value(row_pointer(row)+size_t(col)*size_t(BytesPerValue));
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Converts whole rows. Native float rows are copied in one go.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDMappedRaster::read_rows(int row_start, int n_rows, float* out) const
+{
+  if (row_start < 0 || n_rows < 0 || row_start+n_rows > NRows)
+  {
+    cout << "\nFATAL ERROR: rows " << row_start << " to " << row_start+n_rows
+         << " are outside a raster with " << NRows << " rows" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  size_t n_values = size_t(n_rows)*size_t(NCols);
+  const char* in = row_pointer(row_start);
+  if (DataType == 4 && !NeedsSwap)
+  {
+    memcpy(out, in, n_values*sizeof(float));
+    for (size_t i = 0; i<n_values; i++)
+    {
+      if (out[i] < -1e10)
+      {
+        out[i] = NoDataValue;
+      }
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i<n_values; i++)
+    {
+      out[i] = convert_value(in+i*size_t(BytesPerValue));
+    }
+  }
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Converts a window. Only the rows of the window are touched, so only their
+// pages are read from disk.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDMappedRaster::read_window(int row_start, int col_start, int n_rows, int n_cols,
+                                  float* out) const
+{
+  // the part of the window that overlaps the raster
+  int first_col = (col_start < 0) ? 0 : col_start;
+  int last_col = (col_start+n_cols > NCols) ? NCols : col_start+n_cols;
+
+  for (int r = 0; r<n_rows; r++)
+  {
+    float* out_row = out+size_t(r)*size_t(n_cols);
+    int row = row_start+r;
+    if (row < 0 || row >= NRows || first_col >= last_col)
+    {
+      for (int c = 0; c<n_cols; c++)
+      {
+        out_row[c] = NoDataValue;
+      }
+      continue;
+    }
+
+    for (int c = 0; c<first_col-col_start; c++)
+    {
+      out_row[c] = NoDataValue;
+    }
+    const char* in = row_pointer(row)+size_t(first_col)*size_t(BytesPerValue);
+    for (int col = first_col; col<last_col; col++)
+    {
+      out_row[col-col_start] = convert_value(in);
+      in += BytesPerValue;
+    }
+    for (int c = last_col-col_start; c<n_cols; c++)
+    {
+      out_row[c] = NoDataValue;
+    }
+  }
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Paging hints. madvise needs a page aligned start, so the start is rounded
+// down to the page containing the first row.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDMappedRaster::advise_rows(int row_start, int n_rows, int advice) const
+{
+  if (n_rows <= 0)
+  {
+    return;
+  }
+  size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+  size_t start = size_t(row_pointer(row_start)-MappedData);
+  size_t end = size_t(row_pointer(row_start+n_rows)-MappedData);
+  if (end > MappedLength)
+  {
+    end = MappedLength;
+  }
+  size_t aligned_start = (start/page_size)*page_size;
+  madvise(MappedData+aligned_start, end-aligned_start, advice);
+}
+
+void LSDMappedRaster::prefetch_rows(int row_start, int n_rows) const
+{
+  advise_rows(row_start, n_rows, MADV_WILLNEED);
+}
+
+void LSDMappedRaster::release_rows(int row_start, int n_rows) const
+{
+  advise_rows(row_start, n_rows, MADV_DONTNEED);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Loads the whole raster
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDRaster LSDMappedRaster::get_LSDRaster() const
+{
+  Array2D<float> data(NRows,NCols);
+  if (NRows > 0 && NCols > 0)
+  {
+    read_rows(0, NRows, &data[0][0]);
+  }
+  LSDRaster Raster(NRows, NCols, XMinimum, YMinimum, DataResolution,
+                   NoDataValue, data, GeoReferencingStrings);
+  return Raster;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+#endif
@@ -0,0 +1,312 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDMappedRaster
+// Land Surface Dynamics Mapped Raster
+//
+// An object within the University
+//  of Edinburgh Land Surface Dynamics group topographic toolbox
+//  for reading binary rasters (.flt and ENVI .bil) through a memory map
+//
+// The data file is mapped into memory rather than read. The operating system
+// only pages in the parts of the file that are touched, so opening a very large
+// DEM costs almost nothing, and a float raster in the byte order of the host can
+// be used in place through an LSDRasterView without ever being copied.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDMappedRaster_H
+#define LSDMappedRaster_H
+
+#include <string>
+#include <string.h>
+#include "LSDRasterBuffer.hpp"
+#include "LSDRasterInfo.hpp"
+using namespace std;
+
+class LSDRaster;
+
+///@brief Checks the byte order of the machine we are running on
+///@return true if the host is little endian
+///@author agent
+///@date 16/10/2026
+inline bool host_is_little_endian()
+{
+  int one = 1;
+  return *(reinterpret_cast<char*>(&one)) == 1;
+}
+
+///@brief Reverses the bytes of a value of any size, in place
+///@param value pointer to the first byte
+///@param n_bytes the size of the value
+///@author agent
+///@date 16/10/2026
+inline void swap_bytes(char* value, int n_bytes)
+{
+  for (int i = 0; i<n_bytes/2; i++)
+  {
+    char temp = value[i];
+    value[i] = value[n_bytes-1-i];
+    value[n_bytes-1-i] = temp;
+  }
+}
+
+///@brief The size of a value of an ENVI data type
+///@param DataType the ENVI data type code
+///@return the number of bytes, or 0 if the type is not supported
+///@author agent
+///@date 16/10/2026
+inline int envi_bytes_per_value(int DataType)
+{
+  switch (DataType)
+  {
+    case 1: return 1;
+    case 2: return 2;
+    case 3: return 4;
+    case 4: return 4;
+    case 5: return 8;
+    case 12: return 2;
+    case 13: return 4;
+    default: return 0;
+  }
+}
+
+///@brief Converts one value stored in a binary raster file to a float.
+///@details Values below -1e10 are treated as nodata, as they are in
+/// LSDRaster::read_raster
+///@param value pointer to the first byte of the value
+///@param DataType the ENVI data type code
+///@param BytesPerValue the size of the value
+///@param NeedsSwap true if the file and the host have different byte orders
+///@param NoDataValue the value used for nodata
+///@return the value
+///@author agent
+///@date 16/10/2026
+inline float convert_raster_value(const char* value, int DataType, int BytesPerValue,
+                                  bool NeedsSwap, float NoDataValue)
+{
+  char bytes[8];
+  memcpy(bytes, value, BytesPerValue);
+  if (NeedsSwap)
+  {
+    swap_bytes(bytes, BytesPerValue);
+  }
+
+  float converted;
+  switch (DataType)
+  {
+    case 1:
+    {
+      unsigned char v;
+      memcpy(&v, bytes, 1);
+      converted = float(v);
+      break;
+    }
+    case 2:
+    {
+      short v;
+      memcpy(&v, bytes, 2);
+      converted = float(v);
+      break;
+    }
+    case 3:
+    {
+      int v;
+      memcpy(&v, bytes, 4);
+      converted = float(v);
+      break;
+    }
+    case 5:
+    {
+      double v;
+      memcpy(&v, bytes, 8);
+      converted = float(v);
+      break;
+    }
+    case 12:
+    {
+      unsigned short v;
+      memcpy(&v, bytes, 2);
+      converted = float(v);
+      break;
+    }
+    case 13:
+    {
+      unsigned int v;
+      memcpy(&v, bytes, 4);
+      converted = float(v);
+      break;
+    }
+    default:
+    {
+      memcpy(&converted, bytes, 4);
+      break;
+    }
+  }
+
+  if (converted < -1e10)
+  {
+    converted = NoDataValue;
+  }
+  return converted;
+}
+
+///@brief Object that maps a binary raster file into memory.
+///@details The header is read with LSDRasterInfo. The ENVI data types 1 (byte),
+/// 2 (16 bit int), 3 (32 bit int), 4 (float), 5 (double), 12 (16 bit unsigned)
+/// and 13 (32 bit unsigned) are supported, in either byte order. Only a float
+/// raster stored in the byte order of the host can be viewed without copying;
+/// anything else is converted row by row when it is read.
+///@author agent
+///@date 16/10/2026
+class LSDMappedRaster: public LSDRasterInfo
+{
+  public:
+    /// @brief Maps the data file of a raster. The header must exist.
+    /// @param filename the prefix of the file
+    /// @param extension either "flt" or "bil"
+    /// @author agent
+    /// @date 16/10/2026
+    LSDMappedRaster(string filename, string extension)
+                               { create(filename, extension); }
+
+    /// @brief Unmaps the file
+    ~LSDMappedRaster();
+
+    /// @return true if the file can be used in place through get_view
+    /// @author agent
+    /// @date 16/10/2026
+    bool is_zero_copy() const;
+
+    /// @brief Gets a view straight onto the mapped file. No data is read until
+    ///  it is touched. Only valid if is_zero_copy() is true, and only while this
+    ///  object exists.
+    /// @return a read only view of the whole raster
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRasterView<const float> get_view() const;
+
+    /// @brief Gets a single value, converted to float
+    /// @param row the row of the value
+    /// @param col the column of the value
+    /// @return the value
+    /// @author agent
+    /// @date 16/10/2026
+    float get_value(int row, int col) const;
+
+    /// @brief Converts a block of whole rows to floats
+    /// @param row_start the first row to read
+    /// @param n_rows the number of rows to read
+    /// @param out where the rows go. Must have room for n_rows*NCols floats.
+    /// @author agent
+    /// @date 16/10/2026
+    void read_rows(int row_start, int n_rows, float* out) const;
+
+    /// @brief Converts a rectangular window to floats. Parts of the window
+    ///  that fall outside the raster are set to NoDataValue, so a window can
+    ///  hang over the edge of the raster.
+    /// @param row_start the first row of the window (can be negative)
+    /// @param col_start the first column of the window (can be negative)
+    /// @param n_rows the number of rows in the window
+    /// @param n_cols the number of columns in the window
+    /// @param out where the window goes, row by row. Must have room for
+    ///  n_rows*n_cols floats.
+    /// @author agent
+    /// @date 16/10/2026
+    void read_window(int row_start, int col_start, int n_rows, int n_cols, float* out) const;
+
+    /// @brief Tells the operating system that a block of rows is about to be
+    ///  used so it can start paging them in
+    /// @param row_start the first row
+    /// @param n_rows the number of rows
+    /// @author agent
+    /// @date 16/10/2026
+    void prefetch_rows(int row_start, int n_rows) const;
+
+    /// @brief Tells the operating system that a block of rows is no longer
+    ///  needed so that the pages can be dropped. The file is not changed.
+    /// @param row_start the first row
+    /// @param n_rows the number of rows
+    /// @author agent
+    /// @date 16/10/2026
+    void release_rows(int row_start, int n_rows) const;
+
+    /// @brief Loads the whole raster into an LSDRaster
+    /// @return the raster
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRaster get_LSDRaster() const;
+
+    /// @return the number of bytes in each value in the file
+    int get_BytesPerValue() const        { return BytesPerValue; }
+
+  private:
+    /// the file descriptor of the data file
+    int FileDescriptor;
+    /// the start of the mapping
+    char* MappedData;
+    /// the length of the mapping in bytes
+    size_t MappedLength;
+    /// the number of bytes in each value
+    int BytesPerValue;
+    /// true if the values have to be byte swapped
+    bool NeedsSwap;
+
+    /// @return a pointer to the first byte of a row
+    const char* row_pointer(int row) const
+    {
+      return MappedData+size_t(HeaderOffset)+size_t(row)*size_t(NCols)*size_t(BytesPerValue);
+    }
+
+    /// @brief converts the value at a location in the file to a float
+    float convert_value(const char* value) const;
+
+    /// @brief applies an madvise hint to a block of rows
+    void advise_rows(int row_start, int n_rows, int advice) const;
+
+    void create(string filename, string extension);
+
+    /// the mapping cannot be shared between copies
+    LSDMappedRaster(const LSDMappedRaster&);
+    LSDMappedRaster& operator=(const LSDMappedRaster&);
+};
+
+#endif
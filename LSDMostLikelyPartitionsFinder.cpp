@@ -467,13 +467,20 @@ LSDMostLikelyPartitionsFinder LSDMostLikelyPartitionsFinder::spawn_thinned_data_
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_skip(int Mean_skip,int skip_range, vector<int>& node_ref)
 {
+  thin_data_monte_carlo_skip(Mean_skip, skip_range, node_ref, NULL);
+}
 
-
-
+void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_skip(int Mean_skip,int skip_range, vector<int>& node_ref,
+                                                               ran3_stream* stream)
+{
   int minimum_skip = Mean_skip - 0.5*skip_range;
+
+  // without a stream the numbers come from the global ran3 state, which
+  // is seeded from the clock the first time it is used
   long seed = time(NULL);
+  bool use_global = (stream == NULL);
 
-  int N = int((float(skip_range))*(ran3(&seed))+0.5)+minimum_skip;
+  int N = int((float(skip_range))*(use_global ? ran3(&seed) : ran3(*stream))+0.5)+minimum_skip;
   vector<float> thinned_x;
   vector<float> thinned_y;
   vector<int> node_reference;
@@ -534,7 +541,7 @@ void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_skip(int Mean_skip,int
 
     if (new_N_switch == 1)
     {
-      float random_N = ran3(&seed);
+      float random_N = use_global ? ran3(&seed) : ran3(*stream);
       float skippy = (float(skip_range));
       N = int(skippy*(random_N)+0.5)+minimum_skip;
       //cout << "N is: " << N << " and random: " << random_N << " and skppy: " << skippy
@@ -586,6 +593,12 @@ void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_skip(int Mean_skip,int
 //
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_dchi(float mean_dchi, float variation_dchi, vector<int>& node_ref)
+{
+  thin_data_monte_carlo_dchi(mean_dchi, variation_dchi, node_ref, NULL);
+}
+
+void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_dchi(float mean_dchi, float variation_dchi, vector<int>& node_ref,
+                                                               ran3_stream* stream)
 {
 
   //cout << "LSDMostLikelyPartitionsFinder, LINE 391, mean dchi: " << mean_dchi << endl;
@@ -605,9 +618,10 @@ void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_dchi(float mean_dchi,
   float range_chi = 2*variation_dchi;
 
   long seed = time(NULL);
+  bool use_global = (stream == NULL);
 
   // get dx using a random seed
-  float dx = ran3(&seed)*range_chi+min_dchi;
+  float dx = (use_global ? ran3(&seed) : ran3(*stream))*range_chi+min_dchi;
 
   thinned_x.push_back(x_data[0]);
   thinned_y.push_back(y_data[0]);
@@ -628,7 +642,7 @@ void LSDMostLikelyPartitionsFinder::thin_data_monte_carlo_dchi(float mean_dchi,
       thinned_y.push_back(y_data[i]);
       node_reference.push_back(i);
 
-      dx = ran3(&seed)*range_chi+min_dchi;
+      dx = (use_global ? ran3(&seed) : ran3(*stream))*range_chi+min_dchi;
       next_x += dx;
       last_picked = i;
     }
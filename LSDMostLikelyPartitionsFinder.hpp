@@ -160,6 +160,19 @@ class LSDMostLikelyPartitionsFinder
         /// @date 01/05/13
     void thin_data_monte_carlo_skip(int Mean_skip,int skip_range, vector<int>& node_ref);
 
+    /// @brief Skips nodes using a Monte Carlo scheme, drawing the random
+    /// numbers from a stream rather than the global ran3 state. This is
+    /// the version to use when channels are fitted on several threads.
+    /// @param Mean_skip
+    /// @param skip_range
+    /// @param node_ref An index vector of the data points that were selected.
+    /// @param stream The random stream. If NULL the global ran3 state is used
+    /// and seeded from the clock, as in the version without a stream.
+    /// @author agent
+    /// @date 16/10/2026
+    void thin_data_monte_carlo_skip(int Mean_skip,int skip_range, vector<int>& node_ref,
+                                    ran3_stream* stream);
+
     /// @brief Thins object based on a monte carlo approach using a mean, max and minimum dchi.
     /// @param mean_dchi
     /// @param variation_dchi
@@ -168,6 +181,17 @@ class LSDMostLikelyPartitionsFinder
     /// @date 01/03/13
     void thin_data_monte_carlo_dchi(float mean_dchi, float variation_dchi, vector<int>& node_ref);
 
+    /// @brief Thins object based on a monte carlo approach using a mean, max and
+    /// minimum dchi, drawing the random numbers from a stream.
+    /// @param mean_dchi
+    /// @param variation_dchi
+    /// @param node_ref An index vector of the data points that were selected.
+    /// @param stream The random stream. If NULL the global ran3 state is used.
+    /// @author agent
+    /// @date 16/10/2026
+    void thin_data_monte_carlo_dchi(float mean_dchi, float variation_dchi, vector<int>& node_ref,
+                                    ran3_stream* stream);
+
     /// @brief Function for looking at the x and y data.
     /// @author SMM
     /// @date 01/03/13
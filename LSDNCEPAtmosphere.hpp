@@ -0,0 +1,384 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDNCEPAtmosphere
+// Land Surface Dynamics NCEP Atmosphere
+//
+// The NCEP reanalysis sea level pressure and 1000 mb temperature used to turn
+// elevation into atmospheric pressure for cosmogenic nuclide production
+// scaling, within the University of Edinburgh Land Surface Dynamics group
+// topographic toolbox
+//
+// The data are loaded once per process, the first time they are asked for,
+// and then shared by every LSDCRNParameters object (and every thread). The
+// grids can also be compiled in: build the NCEP_embed driver in
+// driver_functions_CRNBasinwide, run it to write LSDNCEPAtmosphere_data.hpp
+// from NCEP2.bin, and compile with -DLSD_NCEP_EMBEDDED. The .bin files are
+// then not needed at run time.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDNCEPAtmosphere_H
+#define LSDNCEPAtmosphere_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+using namespace std;
+
+#ifdef LSD_NCEP_EMBEDDED
+#include "LSDNCEPAtmosphere_data.hpp"
+#endif
+
+///@brief Sea level pressure and 1000 mb temperature from the NCEP
+/// reanalysis, and the site pressure from them (as in the CRONUS NCEPatm_2).
+///@details The grids are held with latitude and longitude both increasing.
+/// The NCEP_hgt.bin heights are not used by NCEPatm_2 and are not loaded.
+///@author agent
+///@date 16/10/2026
+class LSDNCEPAtmosphere
+{
+  public:
+    /// @return the data in NCEP2.bin in a folder, loaded the first time it is
+    ///  asked for. If the data were compiled in, those are returned and the
+    ///  folder is not read. Safe to call from several threads.
+    /// @param path_to_data the folder, ending in a slash
+    static const LSDNCEPAtmosphere& get(string path_to_data)
+    {
+      static map<string, LSDNCEPAtmosphere> loaded;
+      const LSDNCEPAtmosphere* data;
+      #pragma omp critical(LSDNCEPAtmosphere_get)
+      {
+        string key = has_embedded_data() ? string("embedded") : path_to_data;
+        map<string, LSDNCEPAtmosphere>::iterator iter = loaded.find(key);
+        if (iter == loaded.end())
+        {
+          iter = loaded.insert(make_pair(key, LSDNCEPAtmosphere())).first;
+          if (has_embedded_data())
+          {
+            iter->second.load_embedded();
+          }
+          else
+          {
+            iter->second.load(path_to_data);
+          }
+        }
+        data = &(iter->second);
+      }
+      return *data;
+    }
+
+    /// @return true if the data were compiled in
+    static bool has_embedded_data()
+    {
+      #ifdef LSD_NCEP_EMBEDDED
+      return true;
+      #else
+      return false;
+      #endif
+    }
+
+    /// @return the site pressure in hPa
+    /// @param site_lat latitude in decimal degrees, south negative
+    /// @param site_lon longitude in decimal degrees, west negative or 0-360
+    /// @param site_elev elevation in m
+    double NCEPatm_2(double site_lat, double site_lon, double site_elev) const
+    {
+      double pressure;
+      NCEPatm_2(1, &site_lat, &site_lon, &site_elev, &pressure);
+      return pressure;
+    }
+
+    /// @brief The site pressures of many sites at once
+    /// @param n_sites the number of sites
+    /// @param site_lat latitudes in decimal degrees
+    /// @param site_lon longitudes in decimal degrees
+    /// @param site_elev elevations in m
+    /// @param pressure replaced with the pressures in hPa, or -9999 for a site
+    ///  outside the grid
+    void NCEPatm_2(int n_sites, const double* site_lat, const double* site_lon,
+                   const double* site_elev, double* pressure) const
+    {
+      // Assorted constants (from Greg Balco's code) and the lapse rate of the
+      // standard atmosphere
+      double gmr = -0.03417;
+      double dtdz = 0.0065;
+      int n_outside = 0;
+
+      #pragma omp simd reduction(+:n_outside)
+      for (int s = 0; s<n_sites; s++)
+      {
+        double lon = (site_lon[s] < 0) ? site_lon[s]+360.0 : site_lon[s];
+        double site_slp, site_T;
+        if (interpolate(site_lat[s], lon, site_slp, site_T))
+        {
+          double site_T_degK = site_T + 273.15;
+          pressure[s] = site_slp*exp( (gmr/dtdz)*( log(site_T_degK)
+                                      - log(site_T_degK - (site_elev[s]*dtdz)) ) );
+        }
+        else
+        {
+          pressure[s] = -9999;
+          n_outside++;
+        }
+      }
+      if (n_outside > 0)
+      {
+        cout << "LSDNCEPAtmosphere, " << n_outside << " sites are outside the NCEP grid, "
+             << "their pressure is -9999" << endl;
+      }
+    }
+
+    /// @brief The site pressures of many sites at once
+    /// @param site_lat latitudes in decimal degrees
+    /// @param site_lon longitudes in decimal degrees
+    /// @param site_elev elevations in m
+    /// @return the pressures in hPa
+    vector<double> NCEPatm_2(vector<double>& site_lat, vector<double>& site_lon,
+                             vector<double>& site_elev) const
+    {
+      int n_sites = int(site_lat.size());
+      vector<double> pressure(n_sites);
+      if (n_sites > 0)
+      {
+        NCEPatm_2(n_sites, &site_lat[0], &site_lon[0], &site_elev[0], &pressure[0]);
+      }
+      return pressure;
+    }
+
+    /// @brief Writes the grids as a C++ header that can be compiled in with
+    ///  -DLSD_NCEP_EMBEDDED
+    /// @param filename the name of the header, usually LSDNCEPAtmosphere_data.hpp
+    void write_embedded_table(string filename) const
+    {
+      ofstream out(filename.c_str());
+      out.precision(17);
+      out << "// The NCEP2.bin sea level pressure and 1000 mb temperature grids," << endl
+          << "// written by LSDNCEPAtmosphere::write_embedded_table. Do not edit." << endl
+          << "// Latitude and longitude increase, and the grids are by latitude" << endl
+          << "// then longitude." << endl
+          << "#ifndef LSDNCEPAtmosphere_data_H" << endl
+          << "#define LSDNCEPAtmosphere_data_H" << endl << endl
+          << "const int NCEP_embedded_NLat = " << NLat << ";" << endl
+          << "const int NCEP_embedded_NLon = " << NLon << ";" << endl << endl;
+      write_embedded_array(out, "NCEP_embedded_lat", Lat);
+      write_embedded_array(out, "NCEP_embedded_lon", Lon);
+      write_embedded_array(out, "NCEP_embedded_slp", MeanSLP);
+      write_embedded_array(out, "NCEP_embedded_t1000", MeanT1000);
+      out << "#endif" << endl;
+      out.close();
+    }
+
+  private:
+    LSDNCEPAtmosphere() : NLat(0), NLon(0) {}
+
+    /// @brief Reads NCEP2.bin. The file holds the 73x145 sea level pressure and
+    ///  then the 1000 mb temperature, each column by column, and then the
+    ///  latitudes and longitudes, all as doubles.
+    void load(string path_to_data)
+    {
+      int NRows = 73;
+      int NCols = 145;
+      string filename = path_to_data+"NCEP2.bin";
+      ifstream ifs_data(filename.c_str(), ios::in | ios::binary);
+      if( ifs_data.fail() )
+      {
+        cout << "\nFATAL ERROR: the data file \"" << filename
+             << "\" doesn't exist" << endl;
+        exit(EXIT_FAILURE);
+      }
+      vector<double> slp(NRows*NCols);
+      vector<double> t1000(NRows*NCols);
+      vector<double> lat(NRows);
+      vector<double> lon(NCols);
+      ifs_data.read(reinterpret_cast<char*>(&slp[0]), sizeof(double)*slp.size());
+      ifs_data.read(reinterpret_cast<char*>(&t1000[0]), sizeof(double)*t1000.size());
+      ifs_data.read(reinterpret_cast<char*>(&lat[0]), sizeof(double)*lat.size());
+      ifs_data.read(reinterpret_cast<char*>(&lon[0]), sizeof(double)*lon.size());
+      if( ifs_data.fail() )
+      {
+        cout << "\nFATAL ERROR: the data file \"" << filename
+             << "\" is too short" << endl;
+        exit(EXIT_FAILURE);
+      }
+      ifs_data.close();
+      set_grids(lat, lon, slp, t1000);
+    }
+
+    /// @brief Takes the compiled in grids
+    void load_embedded()
+    {
+      #ifdef LSD_NCEP_EMBEDDED
+      NLat = NCEP_embedded_NLat;
+      NLon = NCEP_embedded_NLon;
+      Lat.assign(NCEP_embedded_lat(), NCEP_embedded_lat()+NLat);
+      Lon.assign(NCEP_embedded_lon(), NCEP_embedded_lon()+NLon);
+      MeanSLP.assign(NCEP_embedded_slp(), NCEP_embedded_slp()+NLat*NLon);
+      MeanT1000.assign(NCEP_embedded_t1000(), NCEP_embedded_t1000()+NLat*NLon);
+      #endif
+    }
+
+    /// @brief Stores the grids, which are given column by column as in
+    ///  NCEP2.bin, row by row with latitude and longitude increasing
+    void set_grids(vector<double>& lat, vector<double>& lon,
+                   vector<double>& slp, vector<double>& t1000)
+    {
+      NLat = int(lat.size());
+      NLon = int(lon.size());
+      bool lat_reversed = (lat[0] > lat[NLat-1]);
+      bool lon_reversed = (lon[0] > lon[NLon-1]);
+      Lat.resize(NLat);
+      Lon.resize(NLon);
+      MeanSLP.resize(NLat*NLon);
+      MeanT1000.resize(NLat*NLon);
+      for (int i = 0; i<NLat; i++)
+      {
+        int row = lat_reversed ? NLat-1-i : i;
+        Lat[i] = lat[row];
+        for (int j = 0; j<NLon; j++)
+        {
+          int col = lon_reversed ? NLon-1-j : j;
+          Lon[j] = lon[col];
+          MeanSLP[i*NLon+j] = slp[col*NLat+row];
+          MeanT1000[i*NLon+j] = t1000[col*NLat+row];
+        }
+      }
+    }
+
+    /// @brief Bilinear interpolation of the sea level pressure and temperature,
+    ///  with the cells chosen as in interp2D_bilinear. A longitude past the
+    ///  last grid line wraps around to the first.
+    /// @return false if the site is outside the grid
+    bool interpolate(double lat, double lon, double& slp, double& T) const
+    {
+      if (lat < Lat[0] || lat > Lat[NLat-1] || lon < Lon[0] || lon > Lon[0]+360.0)
+      {
+        return false;
+      }
+      int i = upper_index(Lat, lat);
+      double x1 = Lat[i-1];
+      double x2 = Lat[i];
+      int j, jm;
+      double y1, y2;
+      if (lon > Lon[NLon-1])
+      {
+        jm = NLon-1;
+        j = 0;
+        y1 = Lon[NLon-1];
+        y2 = Lon[0]+360.0;
+      }
+      else
+      {
+        j = upper_index(Lon, lon);
+        jm = j-1;
+        y1 = Lon[jm];
+        y2 = Lon[j];
+      }
+      double wx2 = (x2-lat)/(x2-x1);
+      double wx1 = (lat-x1)/(x2-x1);
+      double wy2 = (y2-lon)/(y2-y1);
+      double wy1 = (lon-y1)/(y2-y1);
+
+      const double* slp_lo = &MeanSLP[(i-1)*NLon];
+      const double* slp_hi = &MeanSLP[i*NLon];
+      slp = wy2*(wx2*slp_lo[jm] + wx1*slp_hi[jm]) + wy1*(wx2*slp_lo[j] + wx1*slp_hi[j]);
+      const double* T_lo = &MeanT1000[(i-1)*NLon];
+      const double* T_hi = &MeanT1000[i*NLon];
+      T = wy2*(wx2*T_lo[jm] + wx1*T_hi[jm]) + wy1*(wx2*T_lo[j] + wx1*T_hi[j]);
+      return true;
+    }
+
+    /// @return the first index i >= 1 with x <= locs[i]; locs is increasing
+    static int upper_index(const vector<double>& locs, double x)
+    {
+      int lo = 1;
+      int hi = int(locs.size())-1;
+      while (lo < hi)
+      {
+        int mid = (lo+hi)/2;
+        if (x > locs[mid])
+        {
+          lo = mid+1;
+        }
+        else
+        {
+          hi = mid;
+        }
+      }
+      return lo;
+    }
+
+    /// @brief Writes one grid as a function returning a static array, so the
+    ///  data are only compiled in once
+    static void write_embedded_array(ofstream& out, string name, const vector<double>& values)
+    {
+      out << "inline const double* " << name << "()" << endl << "{" << endl
+          << "  static const double data[" << values.size() << "] = {" << endl << "    ";
+      for (size_t k = 0; k<values.size(); k++)
+      {
+        out << values[k];
+        if (k+1 < values.size())
+        {
+          out << ((k % 6 == 5) ? ",\n    " : ", ");
+        }
+      }
+      out << "};" << endl << "  return data;" << endl << "}" << endl << endl;
+    }
+
+    /// The number of latitudes
+    int NLat;
+    /// The number of longitudes
+    int NLon;
+    /// The latitudes, increasing
+    vector<double> Lat;
+    /// The longitudes, increasing, in 0-360
+    vector<double> Lon;
+    /// Mean sea level pressure in hPa, by latitude then longitude
+    vector<double> MeanSLP;
+    /// Mean 1000 mb temperature in C, by latitude then longitude
+    vector<double> MeanT1000;
+};
+
+#endif
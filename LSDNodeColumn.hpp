@@ -0,0 +1,250 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDNodeColumn
+// Land Surface Dynamics Node Column
+//
+// Columns of data indexed by FlowInfo node, within the University of
+// Edinburgh Land Surface Dynamics group topographic toolbox
+//
+// Objects such as LSDChiTools keep many variables (chi, elevation, M_chi,
+// source keys...) on the same set of nodes, usually the channel network.
+// Rather than one map per variable, each of which stores the node and the
+// tree links again for every entry, the nodes are given slots once in an
+// LSDNodeSlots index and each variable is a column of values by slot. Looking
+// up a node is two array reads rather than a walk down a tree.
+//
+// An LSDNodeColumn can be used like the map<int,T> it replaces: reading or
+// writing column[node] adds the node if it is not there, count() tells if a
+// node is there and size() is the number of nodes with a value.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDNodeColumn_H
+#define LSDNodeColumn_H
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <cstdlib>
+using namespace std;
+
+///@brief Gives every node that has data a slot, which indexes the columns.
+///@details The slots are handed out in the order the nodes are added. Node
+/// numbers index a dense vector, so it is as long as the largest node added;
+/// any negative keys go in a small map. Slots are only ever added, so columns
+/// sharing the index never have their slots moved.
+///@author agent
+///@date 16/10/2026
+class LSDNodeSlots
+{
+  public:
+    /// @brief An empty index
+    LSDNodeSlots() {}
+
+    /// @brief Reserves room for nodes up to NNodes-1 and for NSlots slots
+    /// @param NNodes the number of nodes, e.g. NDataNodes of the FlowInfo
+    /// @param NSlots the expected number of slots, e.g. the channel nodes
+    void reserve(int NNodes, int NSlots)
+    {
+      if (NNodes > int(SlotOfNode.size()))
+      {
+        SlotOfNode.resize(NNodes,-1);
+      }
+      NodeOfSlot.reserve(NSlots);
+    }
+
+    /// @return the slot of a node, or -1 if the node has no slot
+    /// @param node the node index
+    int get_slot(int node) const
+    {
+      if (node >= 0)
+      {
+        return (node < int(SlotOfNode.size())) ? SlotOfNode[node] : -1;
+      }
+      map<int,int>::const_iterator iter = NegativeSlots.find(node);
+      return (iter == NegativeSlots.end()) ? -1 : iter->second;
+    }
+
+    /// @return the slot of a node, giving it one if it does not have one
+    /// @param node the node index
+    int add_node(int node)
+    {
+      int slot = get_slot(node);
+      if (slot < 0)
+      {
+        slot = int(NodeOfSlot.size());
+        NodeOfSlot.push_back(node);
+        if (node >= 0)
+        {
+          if (node >= int(SlotOfNode.size()))
+          {
+            SlotOfNode.resize(max(node+1,2*int(SlotOfNode.size())),-1);
+          }
+          SlotOfNode[node] = slot;
+        }
+        else
+        {
+          NegativeSlots[node] = slot;
+        }
+      }
+      return slot;
+    }
+
+    /// @return the node in a slot
+    /// @param slot the slot
+    int get_node(int slot) const { return NodeOfSlot[slot]; }
+
+    /// @return the number of slots
+    int size() const { return int(NodeOfSlot.size()); }
+
+    /// @brief Removes all the slots. Every column using the index needs to be
+    ///  cleared as well.
+    void clear()
+    {
+      SlotOfNode.clear();
+      NodeOfSlot.clear();
+      NegativeSlots.clear();
+    }
+
+  private:
+    /// The slot of each node, -1 if it has none
+    vector<int> SlotOfNode;
+    /// The node in each slot
+    vector<int> NodeOfSlot;
+    /// Slots of negative keys
+    map<int,int> NegativeSlots;
+};
+
+///@brief The values of one variable on the nodes of an LSDNodeSlots index.
+///@details The values are held in a deque by slot. Adding slots to a deque
+/// does not move the values already there, so as with a map a reference to
+/// one value stays good while others are added, e.g. in
+/// column[node] = column[receiver]-column[node].
+///@author agent
+///@date 16/10/2026
+template<typename T>
+class LSDNodeColumn
+{
+  public:
+    /// @brief A column that is not attached to an index yet
+    LSDNodeColumn() : Slots(NULL), NSet(0) {}
+
+    /// @brief Attaches the column to the index of the object that owns it
+    /// @param slots the index
+    void attach(LSDNodeSlots* slots) { Slots = slots; }
+
+    /// @return the value at a node, adding the node with a value of T() if
+    ///  it is not there
+    /// @param node the node index
+    T& operator[](int node)
+    {
+      int slot = Slots->add_node(node);
+      if (slot >= int(Values.size()))
+      {
+        Values.resize(Slots->size(),T());
+        IsSet.resize(Slots->size(),0);
+      }
+      if (IsSet[slot] == 0)
+      {
+        IsSet[slot] = 1;
+        Values[slot] = T();
+        NSet++;
+      }
+      return Values[slot];
+    }
+
+    /// @return 1 if the node has a value and 0 if not
+    /// @param node the node index
+    size_t count(int node) const
+    {
+      int slot = Slots->get_slot(node);
+      return (slot >= 0 && slot < int(IsSet.size()) && IsSet[slot] != 0) ? 1 : 0;
+    }
+
+    /// @return the number of nodes with a value
+    size_t size() const { return size_t(NSet); }
+
+    /// @return the values at some nodes, adding any that are not there
+    /// @param nodes the node indices
+    vector<T> get_values(vector<int>& nodes)
+    {
+      vector<T> values(nodes.size());
+      for (size_t i = 0; i<nodes.size(); i++)
+      {
+        values[i] = (*this)[nodes[i]];
+      }
+      return values;
+    }
+
+    /// @brief Removes all the values. The slots stay in the index.
+    void clear()
+    {
+      Values.clear();
+      IsSet.clear();
+      NSet = 0;
+    }
+
+    /// @brief Replaces the values with those in a map keyed by node
+    LSDNodeColumn<T>& operator=(const map<int,T>& node_map)
+    {
+      clear();
+      for (typename map<int,T>::const_iterator iter = node_map.begin();
+           iter != node_map.end(); ++iter)
+      {
+        (*this)[iter->first] = iter->second;
+      }
+      return *this;
+    }
+
+  private:
+    /// The index shared with the other columns of the owner
+    LSDNodeSlots* Slots;
+    /// The values by slot
+    deque<T> Values;
+    /// Whether each slot has a value in this column
+    deque<unsigned char> IsSet;
+    /// The number of slots with a value
+    int NSet;
+};
+
+#endif
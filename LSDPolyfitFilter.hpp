@@ -0,0 +1,369 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDPolyfitFilter
+// Land Surface Dynamics Polyfit Filter
+//
+// Least squares fitting of z = ax^2 + by^2 + cxy + dx + ey + f over a moving
+// window within the University of Edinburgh Land Surface Dynamics group
+// topographic toolbox
+//
+// The polyfit routines in LSDRaster fit the surface to every cell by building
+// the vector of moments of the window and solving the 6x6 normal equations.
+// The matrix of the normal equations depends only on the shape of the window,
+// so each coefficient is a fixed weighted sum of the elevations in the window:
+// a linear filter. This object inverts the matrix once and applies the six
+// filters.
+//
+// Each filter weight is a quadratic in the column offset within a row of the
+// window, so a filter can be applied from three moments of the elevations
+// along each row of the window (the sum, the sum weighted by the column offset
+// and the sum weighted by its square). These moments are updated as the
+// window slides along a row, so the cost per cell is proportional to the
+// window width rather than its area.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDPolyfitFilter_H
+#define LSDPolyfitFilter_H
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include "TNT/tnt.h"
+#include "TNT/jama_lu.h"
+#include "LSDRasterBuffer.hpp"
+using namespace std;
+using namespace TNT;
+using namespace JAMA;
+
+///@brief The six least squares filters of a polynomial surface fit.
+///@details The kernel is (2*kr+1) by (2*kr+1) with a mask marking the points
+/// used in the fit. As in the rest of the toolbox, x runs along the rows and y
+/// along the columns of the kernel. Every row of the mask has to be a single
+/// run of points centred on the middle column, which is true of the circular
+/// windows used by the polyfit routines.
+///@author agent
+///@date 16/10/2026
+class LSDPolyfitFilter
+{
+  public:
+    /// @brief Builds the filters for a window
+    /// @param kernel_radius the radius of the kernel in cells
+    /// @param mask the kernel mask: 1 for the points used in the fit
+    /// @param DataResolution the cell size
+    LSDPolyfitFilter(int kernel_radius, Array2D<int>& mask, float DataResolution)
+                               { create(kernel_radius, mask, DataResolution); }
+
+    /// @brief Builds the filters for a circular window. The window is the one
+    ///  used by calculate_polyfit_surface_metrics: it holds the points no
+    ///  further than window_radius from the centre, and the radius is raised
+    ///  to the diagonal of a cell if it is smaller than that.
+    /// @param window_radius the radius of the window
+    /// @param DataResolution the cell size
+    LSDPolyfitFilter(float window_radius, float DataResolution)
+    {
+      if (window_radius < sqrt(2.0)*DataResolution)
+      {
+        window_radius = sqrt(2.0)*DataResolution;
+      }
+      int kernel_radius = int(ceil(window_radius/DataResolution));
+      int kw = 2*kernel_radius+1;
+      Array2D<int> mask(kw,kw,0);
+      for (int krow = 0; krow<kw; ++krow)
+      {
+        for (int kcol = 0; kcol<kw; ++kcol)
+        {
+          float x = (krow-kernel_radius)*DataResolution;
+          float y = (kcol-kernel_radius)*DataResolution;
+          if (sqrt(x*x+y*y) <= window_radius)
+          {
+            mask[krow][kcol] = 1;
+          }
+        }
+      }
+      create(kernel_radius, mask, DataResolution);
+    }
+
+    /// @return the radius of the kernel in cells
+    int get_KernelRadius() const { return kr; }
+
+    /// @brief Fits the surface to every cell in a range of rows. Rows are
+    ///  processed in parallel when the code is compiled with OpenMP.
+    /// @details A cell is fitted if its whole kernel lies inside the raster and
+    ///  contains no nodata. Cells too close to the edge, or that are nodata
+    ///  themselves, get NoDataValue. Cells with nodata elsewhere in their
+    ///  kernel get window_nodata_value.
+    /// @param zeta the elevations
+    /// @param NoDataValue the nodata value
+    /// @param row_start the first row to fit
+    /// @param row_end one past the last row to fit
+    /// @param window_nodata_value the value given to cells with nodata in their kernel
+    /// @param coefficients views of the a, b, c, d, e and f rasters, the same
+    ///  size as zeta
+    void apply(LSDRasterView<const float> zeta, float NoDataValue, int row_start,
+               int row_end, float window_nodata_value,
+               vector< LSDRasterView<float> >& coefficients) const
+    {
+      int NRows = zeta.get_NRows();
+      int NCols = zeta.get_NCols();
+      int kw = 2*kr+1;
+
+      #pragma omp parallel for schedule(dynamic)
+      for (int i = row_start; i<row_end; ++i)
+      {
+        float* out[6];
+        for (int k = 0; k<6; ++k)
+        {
+          out[k] = coefficients[k].row(i);
+        }
+        const float* centre_row = zeta.row(i);
+
+        bool row_fits = (i-kr >= 0 && i+kr < NRows && NCols >= kw);
+        if (not row_fits)
+        {
+          for (int j = 0; j<NCols; ++j)
+          {
+            for (int k = 0; k<6; ++k)
+            {
+              out[k][j] = NoDataValue;
+            }
+          }
+          continue;
+        }
+
+        // the number of nodata cells in each column of the kernel rows, and then
+        // in each kernel
+        vector<int> column_nodata(NCols,0);
+        for (int krow = 0; krow<kw; ++krow)
+        {
+          const float* z = zeta.row(i-kr+krow);
+          for (int j = 0; j<NCols; ++j)
+          {
+            column_nodata[j] += (z[j] == NoDataValue) ? 1 : 0;
+          }
+        }
+        vector<int> window_nodata(NCols,0);
+        int running = 0;
+        for (int j = 0; j<kw; ++j)
+        {
+          running += column_nodata[j];
+        }
+        window_nodata[kr] = running;
+        for (int j = kr+1; j<NCols-kr; ++j)
+        {
+          running += column_nodata[j+kr]-column_nodata[j-kr-1];
+          window_nodata[j] = running;
+        }
+
+        // accumulate the filters one kernel row at a time
+        vector<double> acc(6*NCols,0.0);
+        for (int krow = 0; krow<kw; ++krow)
+        {
+          int w = HalfWidth[krow];
+          if (w < 0)
+          {
+            continue;
+          }
+          const float* z = zeta.row(i-kr+krow);
+          double alpha[6], beta[6];
+          for (int k = 0; k<6; ++k)
+          {
+            alpha[k] = Alpha[krow][k];
+            beta[k] = Beta[krow][k];
+          }
+
+          double S0 = 0, S1 = 0, S2 = 0;
+          for (int j = kr; j<NCols-kr; ++j)
+          {
+            // the moments are summed directly at the start and every so often
+            // after that, and updated as the run slides in between
+            if ((j-kr)%256 == 0)
+            {
+              S0 = 0; S1 = 0; S2 = 0;
+              for (int dc = -w; dc<=w; ++dc)
+              {
+                double zz = z[j+dc];
+                S0 += zz;
+                S1 += dc*zz;
+                S2 += double(dc)*dc*zz;
+              }
+            }
+            else
+            {
+              double z_out = z[j-w-1];
+              double z_in = z[j+w];
+              // the run moves one column right, so every offset drops by one
+              double S0_new = S0 - z_out + z_in;
+              double S1_new = S1 - S0 + (w+1)*z_out + w*z_in;
+              double S2_new = S2 - double(w)*w*z_out - 2*(S1 + w*z_out)
+                              + (S0 - z_out) + double(w)*w*z_in;
+              S0 = S0_new;
+              S1 = S1_new;
+              S2 = S2_new;
+            }
+            double* a = &acc[6*j];
+            for (int k = 0; k<6; ++k)
+            {
+              a[k] += alpha[k]*S0 + beta[k]*S1 + Gamma[k]*S2;
+            }
+          }
+        }
+
+        for (int j = 0; j<NCols; ++j)
+        {
+          if (j-kr < 0 || j+kr >= NCols || centre_row[j] == NoDataValue)
+          {
+            for (int k = 0; k<6; ++k)
+            {
+              out[k][j] = NoDataValue;
+            }
+          }
+          else if (window_nodata[j] > 0)
+          {
+            for (int k = 0; k<6; ++k)
+            {
+              out[k][j] = window_nodata_value;
+            }
+          }
+          else
+          {
+            for (int k = 0; k<6; ++k)
+            {
+              out[k][j] = float(acc[6*j+k]);
+            }
+          }
+        }
+      }
+    }
+
+  private:
+    /// @brief builds the filters from a mask
+    void create(int kernel_radius, Array2D<int>& mask, float DataResolution)
+    {
+      kr = kernel_radius;
+      int kw = 2*kr+1;
+
+      // the half width of the run of points in each row of the mask
+      HalfWidth.assign(kw,-1);
+      for (int krow = 0; krow<kw; ++krow)
+      {
+        int n_in_row = 0;
+        for (int kcol = 0; kcol<kw; ++kcol)
+        {
+          n_in_row += mask[krow][kcol];
+        }
+        if (n_in_row > 0)
+        {
+          int w = (n_in_row-1)/2;
+          for (int kcol = 0; kcol<kw; ++kcol)
+          {
+            int expected = (kcol-kr >= -w && kcol-kr <= w) ? 1 : 0;
+            if (mask[krow][kcol] != expected)
+            {
+              cout << "LSDPolyfitFilter: the rows of the mask must be centred runs" << endl;
+              exit(EXIT_FAILURE);
+            }
+          }
+          HalfWidth[krow] = w;
+        }
+      }
+
+      // the normal equations. The basis is x^2, y^2, xy, x, y, 1
+      double res = DataResolution;
+      Array2D<double> A(6,6,0.0);
+      for (int krow = 0; krow<kw; ++krow)
+      {
+        for (int kcol = kr-HalfWidth[krow]; kcol<=kr+HalfWidth[krow]; ++kcol)
+        {
+          double x = (krow-kr)*res;
+          double y = (kcol-kr)*res;
+          double basis[6] = {x*x, y*y, x*y, x, y, 1.0};
+          for (int k = 0; k<6; ++k)
+          {
+            for (int l = 0; l<6; ++l)
+            {
+              A[k][l] += basis[k]*basis[l];
+            }
+          }
+        }
+      }
+      Array2D<double> I(6,6,0.0);
+      for (int k = 0; k<6; ++k)
+      {
+        I[k][k] = 1.0;
+      }
+      LU<double> sol_A(A);
+      Array2D<double> A_inv = sol_A.solve(I);
+
+      // the weight of a point in row krow, column offset dc is
+      // Alpha[krow][k] + Beta[krow][k]*dc + Gamma[k]*dc^2
+      Alpha = Array2D<double>(kw,6,0.0);
+      Beta = Array2D<double>(kw,6,0.0);
+      for (int krow = 0; krow<kw; ++krow)
+      {
+        double x = (krow-kr)*res;
+        for (int k = 0; k<6; ++k)
+        {
+          Alpha[krow][k] = A_inv[k][0]*x*x + A_inv[k][3]*x + A_inv[k][5];
+          Beta[krow][k] = res*(A_inv[k][2]*x + A_inv[k][4]);
+        }
+      }
+      for (int k = 0; k<6; ++k)
+      {
+        Gamma[k] = res*res*A_inv[k][1];
+      }
+    }
+
+    /// the radius of the kernel in cells
+    int kr;
+    /// the half width of the run of mask points in each kernel row, -1 if empty
+    vector<int> HalfWidth;
+    /// the constant part of the weights of each kernel row, for each coefficient
+    Array2D<double> Alpha;
+    /// the part of the weights linear in the column offset
+    Array2D<double> Beta;
+    /// the part of the weights quadratic in the column offset
+    double Gamma[6];
+};
+
+#endif
@@ -105,9 +105,11 @@ Tools are included to:
 #include <string>
 #include <vector>
 #include <map>
+#include <fstream>
 #include "TNT/tnt.h"
 #include "LSDIndexRaster.hpp"
 #include "LSDShapeTools.hpp"
+#include "LSDFlowGraph.hpp"
 using namespace std;
 using namespace TNT;
 
@@ -766,6 +768,32 @@ class LSDRaster
   LSDRaster hillshade();
   LSDRaster hillshade(float altitude, float azimuth, float z_factor);
 
+  /// @brief Computes any subset of the 3x3 terrain derivatives in one pass.
+  ///
+  /// @details Uses LSDTerrainKernel. The raster_selection vector has 8
+  /// elements; set an element to 1 to compute that raster:
+  ///        0 -> Slope
+  ///        1 -> Aspect
+  ///        2 -> Hillshade
+  ///        3 -> Curvature
+  ///        4 -> Planform Curvature
+  ///        5 -> Profile Curvature
+  ///        6 -> Tangential Curvature
+  ///        7 -> D8 slope
+  /// Slope, aspect and the curvatures are those of
+  /// calculate_polyfit_surface_metrics with the smallest window (the 3x3
+  /// neighbourhood). The hillshade is that of hillshade(altitude,azimuth,z_factor).
+  /// Rasters not selected are returned as a 1x1 raster of nodata.
+  /// @param raster_selection the rasters to compute
+  /// @param altitude the altitude of the illumination source in degrees
+  /// @param azimuth the azimuth of the illumination source in degrees
+  /// @param z_factor the vertical exaggeration of the hillshade
+  /// @return a vector of 8 rasters, in the order above
+  /// @author agent
+  /// @date 16/10/2026
+  vector<LSDRaster> calculate_terrain_derivatives(vector<int> raster_selection,
+                                    float altitude, float azimuth, float z_factor);
+
   /// @brief This function generates a hillshade derivative raster using the
   /// algorithm outlined in Codilean (2006).
   ///
@@ -811,11 +839,67 @@ class LSDRaster
   /// @date Feb 2015
   Array2D<float> Shadows(int Azimuth, int ZenithAngle);
 
+  /// @brief This function generates a topographic shielding raster from the
+  /// horizon angle of every cell.
+  ///
+  /// @details Creating a raster of values between 0 and 1 which can be used as a
+  /// scaling factor in Cosmo analysis. The horizons are computed by LSDHorizonAngles
+  /// in one sweep per azimuth and the integral over zenith angle is analytic,
+  /// so ZenithStep is ignored. A notice is printed if it is not 5. Azimuths are
+  /// processed in parallel with OpenMP.
+  ///
+  /// This does not match TopographicShielding_Codilean at the DEM edge, and the
+  /// gap does not close with a smaller ZenithStep. The shadow casting never shades
+  /// the outermost cells, so they get 1.0 there. Here they are shielded by the
+  /// topography in the DEM. The ring inside them is also shielded more. Interior
+  /// cells agree to about 0.01. Shielding from LSDCosmoData near the DEM edge is
+  /// lower than before, so pad the DEM when basins reach its edge.
+  /// @param AzimuthStep Spacing of sampled azimuths in degrees.
+  /// @param ZenithStep Ignored; kept so existing calls still compile.
+  /// @pre AzimuthStep must be a factor of 360.
+  /// @author agent
+  /// @date 16/10/2026
+  LSDRaster TopographicShielding(int AzimuthStep, int ZenithStep);
+  LSDRaster TopographicShielding();
+
+  /// @brief Topographic shielding with the horizon search limited to a
+  /// maximum distance.
+  ///
+  /// @details Only topography within MaxDistance of a cell can shield it.
+  /// @param AzimuthStep Spacing of sampled azimuths in degrees.
+  /// @param MaxDistance The furthest distance searched for the horizon, in
+  /// the units of the DEM.
+  /// @return The shielding raster.
+  /// @author agent
+  /// @date 16/10/2026
+  LSDRaster TopographicShielding_limited(int AzimuthStep, float MaxDistance);
+
+  /// @brief Distance limited topographic shielding computed only for a set of
+  /// cells.
+  ///
+  /// @details The DEM is split into tiles of tile_size cells and only the
+  /// tiles that hold the listed cells are processed, each with a halo as wide
+  /// as the search distance (see LSDShieldingTileCache). The values match
+  /// TopographicShielding_limited for the listed cells. All other cells get
+  /// NoDataValue.
+  /// @param AzimuthStep Spacing of sampled azimuths in degrees.
+  /// @param MaxDistance The furthest distance searched for the horizon.
+  /// @param rows The rows of the cells needed.
+  /// @param cols The columns of the cells needed.
+  /// @param tile_size The number of rows and columns in a tile.
+  /// @return The shielding raster.
+  /// @author agent
+  /// @date 16/10/2026
+  LSDRaster TopographicShielding_limited(int AzimuthStep, float MaxDistance,
+                                         vector<int>& rows, vector<int>& cols,
+                                         int tile_size);
+
   /// @brief This function generates a topographic shielding raster using the algorithm
   /// outlined in Codilean (2006).
   ///
   /// @details Creating a raster of values between 0 and 1 of shadowed cells which can
-  /// be used as a scaling factor in Cosmo analysis.
+  /// be used as a scaling factor in Cosmo analysis. This calls Shadows for every
+  /// azimuth, zenith pair and is kept as a reference for TopographicShielding.
   ///
   /// Goes further than the original algorithm allowing a theoretical theta,
   /// phi pair of 1,1 to be supplied and although this will increase the
@@ -831,8 +915,7 @@ class LSDRaster
   /// @pre phi_step must be a factor of 360.
   /// @author SWDG
   /// @date 11/4/13
-  LSDRaster TopographicShielding(int theta_step, int phi_step);
-  LSDRaster TopographicShielding();
+  LSDRaster TopographicShielding_Codilean(int theta_step, int phi_step);
 
   /// @brief Surface polynomial fitting and extraction of topographic metrics
   ///
@@ -1356,19 +1439,19 @@ class LSDRaster
   /// v1.0 is slow as it requires many iterations through the dem
   ///
   /// Martin Hurst, June 2010
+  ///
+  ///---------------------------------------------------------------------------------
+  ///
+  /// v2.0 the recursive fill_iterator has been replaced by a queue based flood
+  /// from the DEM boundary that visits each node once. Nodes that are not above
+  /// the node they are reached from are raised 1mm above it.
+  ///
+  /// agent, 16/10/2026
   /// @return Filled LSDRaster.
   /// @author MDH
   /// @date 01/06/10
   LSDRaster fill();
 
-  /// @brief This is a recursive algorithm that is called by the fill function.
-  /// @param fill_data
-  /// @param i
-  /// @param j
-  /// @author MDH
-  /// @date 01/06/10
-  void fill_iterator(Array2D<float>& fill_data, int i, int j);
-
 
   /// @brief This function fills pits/sinks in a DEM by checking for pits from
   ///lowest to highest elevation, starting at the DEM boundary (raster edge or
@@ -1388,6 +1471,63 @@ class LSDRaster
   /// @date 12/3/13
   LSDRaster fill(float& MinSlope);
 
+  /// @brief A tiled, parallel version of fill(MinSlope).
+  ///
+  /// @details Follows the parallel priority flood of Barnes (2016). Each tile
+  /// is filled once on its own, with the nodes on its edge as outlets, and the
+  /// lowest spill elevations between the areas these outlets drain, and to the
+  /// edge of the DEM, are recorded. This small graph is priority flooded to get
+  /// the level each area fills to, and each tile is then raised to those levels
+  /// in one more pass. If MinSlope is greater than zero the gradients are laid
+  /// over the flats with fill_flat. Tiles are processed concurrently using
+  /// OpenMP, but the flats are not. The result is identical to fill(MinSlope).
+  /// @param MinSlope The minimum slope between two Nodes once filled. If set
+  /// to zero will create flats.
+  /// @param TileSize The number of rows and columns in each tile.
+  /// @return Filled LSDRaster object.
+  /// @author agent
+  /// @date 17/10/2026
+  LSDRaster fill_parallel(float& MinSlope, int TileSize);
+
+  /// @brief Fills a single tile for fill_parallel, with no minimum slope, and
+  /// labels the area drained by each node on the edge of the tile.
+  /// @param RowStart The first row of the tile.
+  /// @param RowEnd One past the last row of the tile.
+  /// @param ColStart The first column of the tile.
+  /// @param ColEnd One past the last column of the tile.
+  /// @param FilledZeta The filled surface, updated within the tile.
+  /// @param Labels The labels, -1 for nodes not yet reached. Set within the
+  /// tile to 0 for the outlets of the DEM and from 1 up for the other labels.
+  /// @param SpillElevations The lowest spill elevation between each pair of
+  /// labels that touch in the tile, keyed with the smaller label first.
+  /// @return The number of labels, not counting label 0.
+  /// @author agent
+  /// @date 17/10/2026
+  int fill_tile(int RowStart, int RowEnd, int ColStart, int ColEnd,
+                Array2D<float>& FilledZeta, Array2D<int>& Labels,
+                map< pair<int,int>, float >& SpillElevations);
+
+  /// @brief Lays the gradients of fill(MinSlope) over the flats of a surface
+  /// that has been filled with no minimum slope, for fill_parallel.
+  ///
+  /// @details The flood of fill(MinSlope) is run in serial, but only over the
+  /// flats and the nodes around them.
+  /// @param MinSlope The minimum slope between two Nodes once filled.
+  /// @param FilledZeta The filled surface, updated in place.
+  /// @param FlatIndex Scratch space the size of the raster.
+  /// @author agent
+  /// @date 17/10/2026
+  void fill_flat(float MinSlope, Array2D<float>& FilledZeta, Array2D<int>& FlatIndex);
+
+  /// @brief Checks whether a node seeds the priority flood fill, i.e. whether
+  /// it is on the edge of the DEM or next to nodata.
+  /// @param row The row of the node.
+  /// @param col The column of the node.
+  /// @return true if the node is a seed.
+  /// @author agent
+  /// @date 17/10/2026
+  bool is_fill_seed(int row, int col);
+
   // multidirection flow routing
   /// @brief Generate a flow area raster using a multi direction algorithm.
   ///
@@ -1416,7 +1556,8 @@ class LSDRaster
   /// Diagonal Weighting = ((elevation_drop/total_elevation_drop)*(1/root(2)))^1.1
   ///
   /// Can <b>NOT</b> handle DEMs containing flats or pits -  must be filled using the new
-  /// LSDRaster fill. Function built around original c++ code by Martin Hurst.
+  /// LSDRaster fill. Function built around original c++ code by Martin Hurst;
+  /// the routing is now done by an LSDFlowGraph: see MFD_FlowGraph.
   /// @return LSDRaster of flow area.
   /// @author SWDG
   /// @date 18/4/13
@@ -1458,12 +1599,60 @@ class LSDRaster
   /// Diagonal Weighting = ((elevation_drop/total_elevation_drop)*(1/root(2)))* DataResolution*0.354
   ///
   /// Can <b>NOT</b> handle DEMs containing flats or pits -  must be filled using the new
-  /// LSDRaster fill. Function built around original c++ code by Martin Hurst.
+  /// LSDRaster fill. Function built around original c++ code by Martin Hurst;
+  /// the routing is now done by an LSDFlowGraph: see MFD_FlowGraph.
   /// @return LSDRaster of flow area.
   /// @author SWDG
   /// @date 18/4/13
   LSDRaster QuinnMDFlow();
 
+  /// @brief Generate a flow area raster using the multi direction algorithm of
+  /// Holmgren (1994).
+  ///
+  /// @details Flow is split between the lower neighbours in proportion to
+  /// tan(slope)^exponent. An exponent of 1 spreads flow widely and large
+  /// exponents approach steepest descent; Holmgren suggested 4 to 6.
+  ///
+  /// Can <b>NOT</b> handle DEMs containing flats or pits -  must be filled using the new
+  /// LSDRaster fill.
+  /// @param exponent the exponent on the slope
+  /// @return LSDRaster of flow area.
+  /// @author agent
+  /// @date 16/10/2026
+  LSDRaster HolmgrenMDFlow(float exponent);
+
+  /// @brief Builds the multiple flow direction graph of this DEM, for repeated
+  /// accumulations.
+  ///
+  /// @details Each cell sends flow to its lower neighbours in proportion to
+  /// L*tan(slope)^exponent, where L is 1, or the contour length of Quinn et al.
+  /// (1991) if contour_length_weighting is true. FreemanMDFlow uses an exponent
+  /// of 1.1 without contour lengths, QuinnMDFlow an exponent of 1 with them, and
+  /// HolmgrenMDFlow any exponent without them. The cells are put in flow order
+  /// once, so each accumulation with the graph is a single pass.
+  /// @param exponent the exponent on the slope
+  /// @param contour_length_weighting true to weight by the contour lengths
+  /// @return The flow graph
+  /// @author agent
+  /// @date 16/10/2026
+  LSDFlowGraph MFD_FlowGraph(float exponent, bool contour_length_weighting);
+
+  /// @brief Accumulates a batch of rasters down a flow graph in one pass.
+  ///
+  /// @details Each output cell holds its own value plus everything passed to it
+  /// from upslope. Nodata in the weights counts as zero, and cells that are
+  /// nodata in this raster are nodata in the output. To get drainage area use
+  /// the cell area as the weight; to get discharge use precipitation rate times
+  /// cell area.
+  /// @param Graph a graph from MFD_FlowGraph, or any graph the size of this raster
+  /// @param WeightRasters the rasters to accumulate
+  /// @param split_by_basin true to accumulate the drainage basins in parallel
+  /// @return The accumulated rasters, in the order of WeightRasters
+  /// @author agent
+  /// @date 16/10/2026
+  vector<LSDRaster> MFD_accumulate(LSDFlowGraph& Graph, vector<LSDRaster>& WeightRasters,
+                                   bool split_by_basin);
+
   /// @brief Generate a flow area raster using a multi 2-direction algorithm.
   ///
   /// @details Computes the proportion of all downslope flows for each cell in the input
@@ -1814,41 +2003,31 @@ class LSDRaster
 
   /// @brief Main function for generating a D-infinity flow area raster after Tarboton (1997).
   ///
-  /// @details Calls the recurisve D_infAccum function to get flow area for each pixel.
-  /// Returns flow area in pixels.
+  /// @details The flow directions are turned into an LSDFlowGraph and the area is
+  /// accumulated in one pass over the cells in topological order, so every cell
+  /// is visited after all the cells that flow into it. Returns flow area in pixels.
   ///
-  /// Code is ported and optimised from a Java implementation of the algorithm
+  /// The routing follows the Java implementation of the algorithm
   /// supplied under the GNU GPL licence through WhiteBox GAT:
-  /// http://www.uoguelph.ca/~hydrogeo/Whitebox/ and provides identical results
-  /// to the whitebox tool.
+  /// http://www.uoguelph.ca/~hydrogeo/Whitebox/
   /// @param FlowDir_array Array of Flowdirections generated by D_inf_FlowDir().
   /// @return LSDRaster of D-inf flow areas in pixels.
   /// @author SWDG
   /// @date 26/07/13
   LSDRaster D_inf_FlowArea(Array2D<float> FlowDir_array);
 
-  /// @brief Recursive function to calculate accumulating area for a given pixel.
+  /// @brief D-infinity flow area, optionally accumulating the drainage basins
+  /// in parallel.
   ///
-  /// @details Called by the driver for every cell which has no contributing
-  /// cells - eg the highest points on the landscape. Avoids the need to flatten
-  /// and sort the DEM as required in the original Tarboton (1997)
-  /// implementation. For more detail on the recursive algorithm following
-  /// channels see Mark (1998) "Network Models in Geomorphology".
-  ///
-  /// Code is ported and optimised from a Java implementation of the algorithm
-  /// supplied under the GNU GPL licence through WhiteBox GAT:
-  /// http://www.uoguelph.ca/~hydrogeo/Whitebox/ and provides identical results
-  /// to the whitebox tool.
-  ///
-  /// @param i Row index of the target cell.
-  /// @param j Column index of the target cell.
-  /// @param CountGrid Array showing the number of cells flowing into each cell.
-  /// @param Flowarea_Raster Array of the flow areas which is populated using this function.
+  /// @details Basins that share no cells are independent, so with
+  /// split_by_basin they are accumulated on separate threads when the code is
+  /// compiled with OpenMP. The result is identical to the serial accumulation.
   /// @param FlowDir_array Array of Flowdirections generated by D_inf_FlowDir().
-  /// @author SWDG
-  /// @date 26/07/13
-  void D_infAccum(int i, int j, Array2D<float> CountGrid, Array2D<float> Flowarea_Raster,
-                  Array2D<float> FlowDir_array);
+  /// @param split_by_basin true to accumulate the basins in parallel
+  /// @return LSDRaster of D-inf flow areas in pixels.
+  /// @author agent
+  /// @date 16/10/2026
+  LSDRaster D_inf_FlowArea(Array2D<float> FlowDir_array, bool split_by_basin);
 
   /// @brief Wrapper Function to create a D-infinity flow area raster with one function call.
   /// @return LSDRaster of D-inf flow areas in pixels.
@@ -1856,12 +2035,28 @@ class LSDRaster
   /// @date 26/07/13
   LSDRaster D_inf();
 
+  /// @brief Wrapper Function to create a D-infinity flow area raster with one
+  /// function call, optionally accumulating the drainage basins in parallel.
+  /// @param split_by_basin true to accumulate the basins in parallel
+  /// @return LSDRaster of D-inf flow areas in pixels.
+  /// @author agent
+  /// @date 16/10/2026
+  LSDRaster D_inf(bool split_by_basin);
+
   /// @brief Wrapper Function to create a D-infinity flow area raster, in spatial units, with one function call.
   /// @return LSDRaster of D-inf flow areas in spatial units.
   /// @author SWDG
   /// @date 16/10/13
   LSDRaster D_inf_units();
 
+  /// @brief Wrapper Function to create a D-infinity flow area raster, in
+  /// spatial units, optionally accumulating the drainage basins in parallel.
+  /// @param split_by_basin true to accumulate the basins in parallel
+  /// @return LSDRaster of D-inf flow areas in spatial units.
+  /// @author agent
+  /// @date 16/10/2026
+  LSDRaster D_inf_units(bool split_by_basin);
+
   ///@brief Wrapper Function to convert a D-infinity flow raster into spatial units.
   /// @return LSDRaster of D-inf flow areas in spatial units.
   /// @author MDH (after SWDG)
@@ -2353,6 +2548,23 @@ protected:
   void create(int ncols, int nrows, float xmin, float ymin,
               float cellsize, float ndv, Array2D<float> data, map<string,string> GRS);
 
+  /// @brief Reads a block of binary floats straight into the contiguous data
+  ///  of an Array2D, swapping the bytes if the file and this machine differ
+  /// @param ifs_data the open data file
+  /// @param data the array, already sized
+  /// @param ByteOrder the byte order of the file: 0 little endian, 1 big endian
+  /// @author agent
+  /// @date 16/10/2026
+  void read_float_block(ifstream& ifs_data, Array2D<float>& data, int ByteOrder);
+
+  /// @brief Writes the contiguous data of an Array2D as little endian
+  ///  binary floats in one go
+  /// @param data_ofs the open data file
+  /// @param data the array to write
+  /// @author agent
+  /// @date 16/10/2026
+  void write_float_block(ofstream& data_ofs, Array2D<float>& data);
+
 };
 
 #endif
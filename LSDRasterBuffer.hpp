@@ -0,0 +1,232 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDRasterBuffer
+// Land Surface Dynamics Raster Buffer
+//
+// Contiguous, row-major storage for raster data within the University
+//  of Edinburgh Land Surface Dynamics group topographic toolbox
+//
+// The rasters in the toolbox keep their data in TNT::Array2D objects, which
+// are indexed through an array of row pointers. The data behind those row
+// pointers is a single contiguous block, so an Array2D can be looked at
+// through an LSDRasterView without copying it. Kernels written against a view
+// index rows with a stride and a pointer, which lets the compiler keep the row
+// pointers in registers and vectorise loops along a row.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDRasterBuffer_H
+#define LSDRasterBuffer_H
+
+#include <vector>
+#include "TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+///@brief A non-owning view of a block of raster data stored row by row.
+///@details Element (row,col) lives at data[row*stride+col]. The stride can be
+/// larger than the number of columns, so a view can describe a window of a
+/// larger raster. T can be const for read only views.
+///@author agent
+///@date 16/10/2026
+template<class T>
+class LSDRasterView
+{
+  public:
+    /// @brief An empty view
+    LSDRasterView() : data(0), NRows(0), NCols(0), Stride(0) {}
+
+    /// @brief A view of existing memory
+    /// @param data_ptr pointer to the first element
+    /// @param n_rows the number of rows
+    /// @param n_cols the number of columns
+    /// @param stride the distance between the starts of successive rows
+    LSDRasterView(T* data_ptr, int n_rows, int n_cols, int stride)
+      : data(data_ptr), NRows(n_rows), NCols(n_cols), Stride(stride) {}
+
+    /// @return Number of rows
+    int get_NRows() const { return NRows; }
+    /// @return Number of columns
+    int get_NCols() const { return NCols; }
+    /// @return The distance between the starts of successive rows
+    int get_Stride() const { return Stride; }
+    /// @return true if the rows follow each other without gaps
+    bool is_contiguous() const { return Stride == NCols; }
+    /// @return The total number of elements in the view
+    long size() const { return long(NRows)*long(NCols); }
+
+    /// @return A pointer to the start of a row
+    T* row(int r) const { return data + long(r)*long(Stride); }
+    /// @return A pointer to the first element
+    T* begin() const { return data; }
+
+    /// @return The element at row r and column c
+    T& operator()(int r, int c) const { return data[long(r)*long(Stride)+c]; }
+
+    /// @brief A view of a rectangular window of this view. No data is copied.
+    /// @param row_start the first row of the window
+    /// @param col_start the first column of the window
+    /// @param n_rows the number of rows in the window
+    /// @param n_cols the number of columns in the window
+    /// @return The window, which shares this view's stride
+    LSDRasterView<T> window(int row_start, int col_start, int n_rows, int n_cols) const
+    {
+      return LSDRasterView<T>(row(row_start)+col_start, n_rows, n_cols, Stride);
+    }
+
+  private:
+    /// The first element
+    T* data;
+    /// Number of rows
+    int NRows;
+    /// Number of columns
+    int NCols;
+    /// Distance between successive rows
+    int Stride;
+};
+
+///@brief Adapter from a TNT Array2D to a view. The Array2D keeps its data in
+/// one contiguous block, so this does not copy anything. The view is only valid
+/// while the Array2D (or another Array2D sharing its data) is alive.
+///@author agent
+///@date 16/10/2026
+template<class T>
+inline LSDRasterView<T> make_raster_view(Array2D<T>& A)
+{
+  if (A.dim1() == 0 || A.dim2() == 0)
+  {
+    return LSDRasterView<T>();
+  }
+  return LSDRasterView<T>(&A[0][0], A.dim1(), A.dim2(), A.dim2());
+}
+
+///@brief Read only adapter from a TNT Array2D to a view.
+///@author agent
+///@date 16/10/2026
+template<class T>
+inline LSDRasterView<const T> make_const_raster_view(const Array2D<T>& A)
+{
+  if (A.dim1() == 0 || A.dim2() == 0)
+  {
+    return LSDRasterView<const T>();
+  }
+  return LSDRasterView<const T>(&A[0][0], A.dim1(), A.dim2(), A.dim2());
+}
+
+///@brief An owning, contiguous, row-major raster buffer.
+///@details Used where a kernel needs scratch storage that never has to become
+/// an Array2D. Use to_Array2D to hand the data back to an LSDRaster.
+///@author agent
+///@date 16/10/2026
+template<class T>
+class LSDRasterBuffer
+{
+  public:
+    /// @brief An empty buffer
+    LSDRasterBuffer() : NRows(0), NCols(0) {}
+
+    /// @brief A buffer filled with a value
+    /// @param n_rows the number of rows
+    /// @param n_cols the number of columns
+    /// @param value the initial value of every element
+    LSDRasterBuffer(int n_rows, int n_cols, T value)
+      : Data(long(n_rows)*long(n_cols),value), NRows(n_rows), NCols(n_cols) {}
+
+    /// @brief A buffer holding a copy of an Array2D
+    /// @param A the array to copy
+    LSDRasterBuffer(const Array2D<T>& A) : NRows(A.dim1()), NCols(A.dim2())
+    {
+      if (NRows > 0 && NCols > 0)
+      {
+        Data.assign(&A[0][0], &A[0][0]+long(NRows)*long(NCols));
+      }
+    }
+
+    /// @return Number of rows
+    int get_NRows() const { return NRows; }
+    /// @return Number of columns
+    int get_NCols() const { return NCols; }
+
+    /// @return A view of the whole buffer
+    LSDRasterView<T> view()
+    {
+      return LSDRasterView<T>(Data.empty() ? 0 : &Data[0], NRows, NCols, NCols);
+    }
+    /// @return A read only view of the whole buffer
+    LSDRasterView<const T> view() const
+    {
+      return LSDRasterView<const T>(Data.empty() ? 0 : &Data[0], NRows, NCols, NCols);
+    }
+
+    /// @return A pointer to the start of a row
+    T* row(int r) { return &Data[long(r)*long(NCols)]; }
+    /// @return The element at row r and column c
+    T& operator()(int r, int c) { return Data[long(r)*long(NCols)+c]; }
+    /// @return The element at row r and column c
+    const T& operator()(int r, int c) const { return Data[long(r)*long(NCols)+c]; }
+
+    /// @return A copy of the data as an Array2D
+    Array2D<T> to_Array2D() const
+    {
+      Array2D<T> A(NRows,NCols);
+      if (NRows > 0 && NCols > 0)
+      {
+        T* out = &A[0][0];
+        long n = long(NRows)*long(NCols);
+        for (long i = 0; i<n; i++)
+        {
+          out[i] = Data[i];
+        }
+      }
+      return A;
+    }
+
+  private:
+    /// The data, row by row
+    vector<T> Data;
+    /// Number of rows
+    int NRows;
+    /// Number of columns
+    int NCols;
+};
+
+#endif
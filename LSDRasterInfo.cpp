@@ -52,6 +52,7 @@
 #define LSDRasterInfo_CPP
 
 #include <fstream>
+#include <iomanip>
 #include <string>
 #include <map>
 #include "LSDRaster.hpp"
@@ -66,7 +67,11 @@ using namespace std;
 //
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 void LSDRasterInfo::create()
-{}
+{
+  DataType = 4;
+  ByteOrder = 0;
+  HeaderOffset = 0;
+}
 
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 //
@@ -75,6 +80,9 @@ void LSDRasterInfo::create()
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 void LSDRasterInfo::create(string filename, string extension)
 {
+  DataType = 4;
+  ByteOrder = 0;
+  HeaderOffset = 0;
   read_header(filename, extension);
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
@@ -94,6 +102,9 @@ void LSDRasterInfo::create(LSDRaster& Raster)
   DataResolution = Raster.get_DataResolution();
   NoDataValue = Raster.get_NoDataValue();
   GeoReferencingStrings = Raster.get_GeoReferencingStrings();
+  DataType = 4;
+  ByteOrder = 0;
+  HeaderOffset = 0;
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -112,6 +123,9 @@ void LSDRasterInfo::create(LSDIndexRaster& IRaster)
   DataResolution = IRaster.get_DataResolution();
   NoDataValue = IRaster.get_NoDataValue();
   GeoReferencingStrings = IRaster.get_GeoReferencingStrings();
+  DataType = 4;
+  ByteOrder = 0;
+  HeaderOffset = 0;
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
@@ -263,6 +277,16 @@ void LSDRasterInfo::read_header(string filename, string extension)
       ifs >> str >> XMinimum >> str >> YMinimum
           >> str >> DataResolution
           >> str >> NoDataValue;
+
+      // the byte order line is optional; arcmap writes LSBFIRST or MSBFIRST
+      string byteorder_str;
+      if (ifs >> str >> byteorder_str)
+      {
+        if (str == "byteorder" && byteorder_str == "MSBFIRST")
+        {
+          ByteOrder = 1;
+        }
+      }
     }
     ifs.close();
 
@@ -280,7 +304,6 @@ void LSDRasterInfo::read_header(string filename, string extension)
     string header_extension = "hdr";
     header_filename = filename+dot+header_extension;
     int NoDataExists = 0;
-    int DataType = 4;     // default is float data
 
     ifstream ifs(header_filename.c_str());
     if( ifs.fail() )
@@ -413,6 +436,44 @@ void LSDRasterInfo::read_header(string filename, string extension)
           }
         }  
         
+        // get the byte order
+        counter = 0;
+        str_find = "byte order";
+        while (counter < NLines)
+        {
+          found = lines[counter].find(str_find);
+          if (found!=string::npos)
+          {
+            istringstream iss(lines[counter]);
+            iss >> str >> str >> str >> str;
+            ByteOrder = atoi(str.c_str());
+            counter = lines.size();
+          }
+          else
+          {
+            counter++;
+          }
+        }
+
+        // get the header offset
+        counter = 0;
+        str_find = "header offset";
+        while (counter < NLines)
+        {
+          found = lines[counter].find(str_find);
+          if (found!=string::npos)
+          {
+            istringstream iss(lines[counter]);
+            iss >> str >> str >> str >> str;
+            HeaderOffset = atoi(str.c_str());
+            counter = lines.size();
+          }
+          else
+          {
+            counter++;
+          }
+        }
+
         // get the map info
         counter = 0;
         string this_map_info = "empty";
@@ -543,6 +604,86 @@ void LSDRasterInfo::read_header(string filename, string extension)
 }
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// This writes the header of a binary float raster. LSDRaster::write_raster
+// uses it too, so the headers are identical.
+//
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterInfo::write_header(string filename, string extension)
+{
+  string dot = ".";
+  string string_filename = filename+dot+extension;
+  string header_filename = filename+dot+"hdr";
+
+  if (extension == "flt")
+  {
+    ofstream header_ofs(header_filename.c_str());
+    header_ofs <<  "ncols         " << NCols
+      << "\nnrows         " << NRows
+      << "\nxllcorner     " << setprecision(14) << XMinimum
+      << "\nyllcorner     " << setprecision(14) << YMinimum
+      << "\ncellsize      " << DataResolution
+      << "\nNODATA_value  " << NoDataValue
+      << "\nbyteorder     LSBFIRST" << endl;
+    header_ofs.close();
+  }
+  else if (extension == "bil")
+  {
+    // you need to strip the filename
+    string frontslash = "/";
+    size_t found = string_filename.find_last_of(frontslash);
+    int length = int(string_filename.length());
+    string this_fname = string_filename.substr(found+1,length-found-1);
+
+    ofstream header_ofs(header_filename.c_str());
+    header_ofs <<  "ENVI" << endl;
+    header_ofs << "description = {" << endl << this_fname << "}" << endl;
+    header_ofs <<  "samples = " << NCols << endl;
+    header_ofs <<  "lines = " << NRows << endl;
+    header_ofs <<  "bands = 1" << endl;
+    header_ofs <<  "header offset = 0" << endl;
+    header_ofs <<  "file type = ENVI Standard" << endl;
+    header_ofs <<  "data type = 4" << endl;
+    header_ofs <<  "interleave = bsq" << endl;
+    header_ofs <<  "byte order = 0" << endl;
+
+    // now check to see if there are the map info and coordinate system
+    map<string,string>::iterator iter;
+    iter = GeoReferencingStrings.find("ENVI_map_info");
+    if (iter != GeoReferencingStrings.end() )
+    {
+      header_ofs <<  "map info = {"<<(*iter).second<<"}" << endl;
+    }
+    else
+    {
+      cout << "Warning, writing ENVI file but no map info string" << endl;
+    }
+    iter = GeoReferencingStrings.find("ENVI_coordinate_system");
+    if (iter != GeoReferencingStrings.end() )
+    {
+      header_ofs <<  "coordinate system string = {"<<(*iter).second<<"}" << endl;
+    }
+    else
+    {
+      cout << "Warning, writing ENVI file but no coordinate system string" << endl;
+    }
+    header_ofs <<  "data ignore value = " << NoDataValue << endl;
+    header_ofs.close();
+  }
+  else
+  {
+    cout << "You did not enter and approprate extension!" << endl
+         << "You entered: " << extension << " options are flt and bil" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  DataType = 4;
+  ByteOrder = 0;
+  HeaderOffset = 0;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
 //
 // This function gets the UTM zone
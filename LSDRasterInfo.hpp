@@ -58,7 +58,7 @@ using namespace std;
 
 // declare classes. Implementation is included in cpp file
 class LSDRaster;
-class LSDTindexRaster;
+class LSDIndexRaster;
 
 ///@brief Object that stores georeferencing information. This information is
 /// also stored with the raster, it is seperated here mainly to compare 
@@ -97,6 +97,16 @@ class LSDRasterInfo
     /// @date 22/12/2014
     void get_UTM_information(int& UTM_zone, bool& is_North);
 
+    /// @brief Writes a header for a binary float raster with this georeferencing.
+    /// @details This is the header LSDRaster::write_raster writes: little
+    ///  endian 32 bit floats. Only the header is written, so a large raster
+    ///  can be written piece by piece afterwards.
+    /// @param filename the prefix of the file
+    /// @param extension either "flt" or "bil"
+    /// @author agent
+    /// @date 16/10/2026
+    void write_header(string filename, string extension);
+
     /// @brief this check to see if a point is within the raster
     /// @param X_coordinate the x location of the point
     /// @param Y_coordinate the y location of the point
@@ -120,6 +130,12 @@ class LSDRasterInfo
     int get_NoDataValue() const        { return NoDataValue; }
     /// @return map containing the georeferencing strings
     map<string,string> get_GeoReferencingStrings() const { return GeoReferencingStrings; }
+    /// @return The ENVI data type code of the data file (4 is a 32 bit float)
+    int get_DataType() const        { return DataType; }
+    /// @return The byte order of the data file: 0 is little endian, 1 is big endian
+    int get_ByteOrder() const        { return ByteOrder; }
+    /// @return The number of bytes before the data in the data file
+    int get_HeaderOffset() const        { return HeaderOffset; }
 
   protected:
 
@@ -155,6 +171,13 @@ class LSDRasterInfo
     ///A map of strings for holding georeferencing information
     map<string,string> GeoReferencingStrings;
 
+    ///ENVI data type code of the data file. flt files are always 4 (float).
+    int DataType;
+    ///Byte order of the data file. 0 is little endian, 1 is big endian.
+    int ByteOrder;
+    ///Number of bytes before the data in the data file.
+    int HeaderOffset;
+
 
   private:
     void create();
@@ -0,0 +1,556 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDRasterTiles
+// Land Surface Dynamics Raster Tiles
+//
+// An object within the University
+//  of Edinburgh Land Surface Dynamics group topographic toolbox
+//  for reading rasters piece by piece so that DEMs that do not fit in memory
+//  can be processed
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDRasterTiles_CPP
+#define LSDRasterTiles_CPP
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <math.h>
+#include "TNT/tnt.h"
+#include "LSDRaster.hpp"
+#include "LSDIndexRaster.hpp"
+#include "LSDRasterInfo.hpp"
+#include "LSDMappedRaster.hpp"
+#include "LSDRasterTiles.hpp"
+#include "LSDRasterBuffer.hpp"
+#include "LSDPolyfitFilter.hpp"
+using namespace std;
+using namespace TNT;
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Reads the header and works out the tiling
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::create(string filename, string extension, int tile_size, int halo)
+{
+  if (tile_size < 1 || halo < 0)
+  {
+    cout << "\nFATAL ERROR: the tile size must be positive and the halo cannot be negative" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  FileName = filename;
+  Extension = extension;
+  Info = LSDRasterInfo(filename, extension);
+  TileSize = tile_size;
+  Halo = halo;
+  NTileRows = (Info.get_NRows()+TileSize-1)/TileSize;
+  NTileCols = (Info.get_NCols()+TileSize-1)/TileSize;
+  OutputDataFile = "";
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Reads a window. The window gets the georeferencing of its position within
+// the raster: row 0 is the northern edge.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDRaster LSDRasterTiles::read_window(int row_start, int col_start, int n_rows, int n_cols)
+{
+  if (n_rows < 1 || n_cols < 1)
+  {
+    cout << "\nFATAL ERROR: a window needs at least one row and one column" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  float NoDataValue = Info.get_NoDataValue();
+  float DataResolution = Info.get_DataResolution();
+  Array2D<float> data(n_rows,n_cols,NoDataValue);
+
+  if (Extension == "asc")
+  {
+    read_ascii_window(row_start, col_start, data);
+  }
+  else
+  {
+    read_binary_window(row_start, col_start, data);
+  }
+
+  float XMinimum = Info.get_XMinimum()+col_start*DataResolution;
+  float YMinimum = Info.get_YMinimum()+(Info.get_NRows()-row_start-n_rows)*DataResolution;
+  LSDRaster Window(n_rows, n_cols, XMinimum, YMinimum, DataResolution, NoDataValue,
+                   data, Info.get_GeoReferencingStrings());
+  if (Extension == "bil")
+  {
+    Window.Update_GeoReferencingStrings();
+  }
+  return Window;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Converts a bounding box to a window
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDRaster LSDRasterTiles::read_window_UTM(float X_minimum, float Y_minimum,
+                                          float X_maximum, float Y_maximum)
+{
+  float DataResolution = Info.get_DataResolution();
+  float YMax = Info.get_YMinimum()+Info.get_NRows()*DataResolution;
+
+  int col_start = int(floor((X_minimum-Info.get_XMinimum())/DataResolution));
+  int col_end = int(ceil((X_maximum-Info.get_XMinimum())/DataResolution));
+  int row_start = int(floor((YMax-Y_maximum)/DataResolution));
+  int row_end = int(ceil((YMax-Y_minimum)/DataResolution));
+
+  if (col_start < 0) col_start = 0;
+  if (row_start < 0) row_start = 0;
+  if (col_end > Info.get_NCols()) col_end = Info.get_NCols();
+  if (row_end > Info.get_NRows()) row_end = Info.get_NRows();
+
+  if (col_end <= col_start || row_end <= row_start)
+  {
+    cout << "\nFATAL ERROR: the bounding box does not overlap the raster" << endl;
+    exit(EXIT_FAILURE);
+  }
+  return read_window(row_start, col_start, row_end-row_start, col_end-col_start);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Binary files: seek to the start of the overlap in each row and read it in
+// one go
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::read_binary_window(int row_start, int col_start, Array2D<float>& data)
+{
+  int NRows = Info.get_NRows();
+  int NCols = Info.get_NCols();
+  int first_row = (row_start < 0) ? 0 : row_start;
+  int last_row = (row_start+data.dim1() > NRows) ? NRows : row_start+data.dim1();
+  int first_col = (col_start < 0) ? 0 : col_start;
+  int last_col = (col_start+data.dim2() > NCols) ? NCols : col_start+data.dim2();
+  if (first_row >= last_row || first_col >= last_col)
+  {
+    return;
+  }
+
+  int DataType = Info.get_DataType();
+  int BytesPerValue = envi_bytes_per_value(DataType);
+  if (BytesPerValue == 0)
+  {
+    cout << "\nFATAL ERROR: cannot read a raster with ENVI data type " << DataType << endl;
+    exit(EXIT_FAILURE);
+  }
+  bool NeedsSwap = ( (Info.get_ByteOrder() == 1) == host_is_little_endian() );
+  float NoDataValue = Info.get_NoDataValue();
+
+  string string_filename = FileName+"."+Extension;
+  ifstream ifs_data(string_filename.c_str(), ios::in | ios::binary);
+  if( ifs_data.fail() )
+  {
+    cout << "\nFATAL ERROR: the data file \"" << string_filename
+         << "\" doesn't exist" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  int n_overlap = last_col-first_col;
+  vector<char> row_buffer(size_t(n_overlap)*size_t(BytesPerValue));
+  for (int row = first_row; row<last_row; row++)
+  {
+    streamoff offset = streamoff(Info.get_HeaderOffset())
+                      +(streamoff(row)*streamoff(NCols)+streamoff(first_col))*streamoff(BytesPerValue);
+    ifs_data.seekg(offset);
+    ifs_data.read(&row_buffer[0], streamsize(row_buffer.size()));
+    if (ifs_data.fail())
+    {
+      cout << "\nFATAL ERROR: the data file \"" << string_filename
+           << "\" is shorter than its header says" << endl;
+      exit(EXIT_FAILURE);
+    }
+
+    float* out_row = data[row-row_start];
+    for (int col = first_col; col<last_col; col++)
+    {
+      out_row[col-col_start] = convert_raster_value(&row_buffer[size_t(col-first_col)*size_t(BytesPerValue)],
+                                                    DataType, BytesPerValue, NeedsSwap, NoDataValue);
+    }
+  }
+  ifs_data.close();
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Ascii files cannot be seeked into, so the rows above the window are read
+// and thrown away. Reading stops at the last row of the window.
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::read_ascii_window(int row_start, int col_start, Array2D<float>& data)
+{
+  int NRows = Info.get_NRows();
+  int NCols = Info.get_NCols();
+  int last_row = (row_start+data.dim1() > NRows) ? NRows : row_start+data.dim1();
+  int first_col = (col_start < 0) ? 0 : col_start;
+  int last_col = (col_start+data.dim2() > NCols) ? NCols : col_start+data.dim2();
+
+  string string_filename = FileName+"."+Extension;
+  ifstream data_in(string_filename.c_str());
+  if( data_in.fail() )
+  {
+    cout << "\nFATAL ERROR: the data file \"" << string_filename
+         << "\" doesn't exist" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // skip the six header lines
+  string str;
+  for (int i = 0; i<6; i++)
+  {
+    data_in >> str >> str;
+  }
+
+  float value;
+  for (int row = 0; row<last_row; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      data_in >> value;
+      if (row >= row_start && col >= first_col && col < last_col)
+      {
+        data[row-row_start][col-col_start] = value;
+      }
+    }
+  }
+  data_in.close();
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// The core of a tile
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::get_tile_core(int tile, int& row_start, int& col_start,
+                                   int& n_rows, int& n_cols)
+{
+  if (tile < 0 || tile >= get_NTiles())
+  {
+    cout << "\nFATAL ERROR: tile " << tile << " does not exist, there are "
+         << get_NTiles() << " tiles" << endl;
+    exit(EXIT_FAILURE);
+  }
+  row_start = (tile/NTileCols)*TileSize;
+  col_start = (tile%NTileCols)*TileSize;
+  n_rows = (row_start+TileSize > Info.get_NRows()) ? Info.get_NRows()-row_start : TileSize;
+  n_cols = (col_start+TileSize > Info.get_NCols()) ? Info.get_NCols()-col_start : TileSize;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// A tile with its halo
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDRaster LSDRasterTiles::get_tile(int tile)
+{
+  int row_start, col_start, n_rows, n_cols;
+  get_tile_core(tile, row_start, col_start, n_rows, n_cols);
+  return read_window(row_start-Halo, col_start-Halo, n_rows+2*Halo, n_cols+2*Halo);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Removes the halo
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+LSDRaster LSDRasterTiles::trim_halo(int tile, LSDRaster& TileRaster)
+{
+  int row_start, col_start, n_rows, n_cols;
+  get_tile_core(tile, row_start, col_start, n_rows, n_cols);
+  if (TileRaster.get_NRows() != n_rows+2*Halo || TileRaster.get_NCols() != n_cols+2*Halo)
+  {
+    cout << "\nFATAL ERROR: the raster is not the size of tile " << tile << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  Array2D<float> core(n_rows,n_cols);
+  for (int row = 0; row<n_rows; row++)
+  {
+    for (int col = 0; col<n_cols; col++)
+    {
+      core[row][col] = TileRaster.get_data_element(row+Halo,col+Halo);
+    }
+  }
+
+  float DataResolution = Info.get_DataResolution();
+  float XMinimum = Info.get_XMinimum()+col_start*DataResolution;
+  float YMinimum = Info.get_YMinimum()+(Info.get_NRows()-row_start-n_rows)*DataResolution;
+  LSDRaster Core(n_rows, n_cols, XMinimum, YMinimum, DataResolution,
+                 TileRaster.get_NoDataValue(), core, TileRaster.get_GeoReferencingStrings());
+  if (Extension == "bil")
+  {
+    Core.Update_GeoReferencingStrings();
+  }
+  return Core;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Starts the output that write_tile writes to
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::start_output(string filename, string extension)
+{
+  OutputDataFile = create_output(filename, extension);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Writes the core of a tile into the output
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::write_tile(int tile, LSDRaster& TileRaster)
+{
+  if (OutputDataFile == "")
+  {
+    cout << "\nFATAL ERROR: call start_output before writing tiles" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  int row_start, col_start, n_rows, n_cols;
+  get_tile_core(tile, row_start, col_start, n_rows, n_cols);
+  if (TileRaster.get_NRows() != n_rows+2*Halo || TileRaster.get_NCols() != n_cols+2*Halo)
+  {
+    cout << "\nFATAL ERROR: the raster is not the size of tile " << tile << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  Array2D<float> tile_data = TileRaster.get_RasterData();
+  write_tile_data(tile, make_const_raster_view(tile_data), Halo, OutputDataFile);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Fits all of the radii to each tile before moving to the next one
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::write_polyfit_coefficients(vector<float> window_radii,
+                                                string out_prefix, string out_extension)
+{
+  write_polyfit_coefficients(window_radii, "abcdef", out_prefix, out_extension);
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Fits all of the radii to each tile before moving to the next one, writing
+// only the selected coefficients
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::write_polyfit_coefficients(vector<float> window_radii, string coefficients,
+                                                string out_prefix, string out_extension)
+{
+  int NRadii = int(window_radii.size());
+  if (NRadii == 0)
+  {
+    cout << "\nFATAL ERROR: no window radii were given" << endl;
+    exit(EXIT_FAILURE);
+  }
+  float NoDataValue = Info.get_NoDataValue();
+  float DataResolution = Info.get_DataResolution();
+
+  // the filters of each radius, and the halo needed by the widest
+  vector<LSDPolyfitFilter> Filters;
+  int max_kr = 0;
+  for (int r = 0; r<NRadii; r++)
+  {
+    Filters.push_back(LSDPolyfitFilter(window_radii[r], DataResolution));
+    if (Filters[r].get_KernelRadius() > max_kr)
+    {
+      max_kr = Filters[r].get_KernelRadius();
+    }
+  }
+
+  // the coefficients to write, in the order of the filter's outputs
+  string coefficient_names = "abcdef";
+  vector<int> selected;
+  for (int k = 0; k<6; k++)
+  {
+    if (coefficients.find(coefficient_names[k]) != string::npos)
+    {
+      selected.push_back(k);
+    }
+  }
+  for (size_t i = 0; i<coefficients.size(); i++)
+  {
+    if (coefficient_names.find(coefficients[i]) == string::npos)
+    {
+      cout << "\nFATAL ERROR: " << coefficients[i] << " is not a polyfit coefficient,"
+           << " the options are a, b, c, d, e and f" << endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  int NSelected = int(selected.size());
+
+  // start the outputs
+  vector< vector<string> > data_files(NRadii);
+  for (int r = 0; r<NRadii; r++)
+  {
+    stringstream radius_ss;
+    radius_ss << window_radii[r];
+    for (int s = 0; s<NSelected; s++)
+    {
+      string out_name = out_prefix+"_polyfit_"+coefficient_names[selected[s]]+"_R"+radius_ss.str();
+      data_files[r].push_back(create_output(out_name, out_extension));
+    }
+  }
+
+  for (int tile = 0; tile<get_NTiles(); tile++)
+  {
+    int row_start, col_start, n_rows, n_cols;
+    get_tile_core(tile, row_start, col_start, n_rows, n_cols);
+
+    // the tile is read once and shared by all of the radii. Halo cells outside
+    // the raster are nodata, so the windows of cells near the edge of the
+    // raster contain nodata and the cells get nodata, as they would if the
+    // whole raster were fitted at once
+    LSDRaster TileRaster = read_window(row_start-max_kr, col_start-max_kr,
+                                       n_rows+2*max_kr, n_cols+2*max_kr);
+    Array2D<float> zeta = TileRaster.get_RasterData();
+    LSDRasterView<const float> zeta_view = make_const_raster_view(zeta);
+
+    vector< Array2D<float> > coefficient_arrays(6);
+    vector< LSDRasterView<float> > coefficient_views(6);
+    for (int k = 0; k<6; k++)
+    {
+      coefficient_arrays[k] = Array2D<float>(zeta.dim1(),zeta.dim2(),NoDataValue);
+      coefficient_views[k] = make_raster_view(coefficient_arrays[k]);
+    }
+
+    for (int r = 0; r<NRadii; r++)
+    {
+      Filters[r].apply(zeta_view, NoDataValue, max_kr, max_kr+n_rows,
+                       NoDataValue, coefficient_views);
+      for (int s = 0; s<NSelected; s++)
+      {
+        write_tile_data(tile, make_const_raster_view(coefficient_arrays[selected[s]]), max_kr,
+                        data_files[r][s]);
+      }
+    }
+  }
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Writes the header of an output and fills its data file with nodata, one
+// row at a time so the whole raster is never in memory
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+string LSDRasterTiles::create_output(string filename, string extension)
+{
+  LSDRasterInfo OutInfo = Info;
+  OutInfo.write_header(filename, extension);
+  string data_file = filename+"."+extension;
+
+  ofstream data_ofs(data_file.c_str(), ios::out | ios::binary);
+  if( data_ofs.fail() )
+  {
+    cout << "\nFATAL ERROR: unable to write to " << data_file << endl;
+    exit(EXIT_FAILURE);
+  }
+  float NoDataValue = Info.get_NoDataValue();
+  if (!host_is_little_endian())
+  {
+    swap_bytes(reinterpret_cast<char*>(&NoDataValue), int(sizeof(float)));
+  }
+  vector<float> nodata_row(Info.get_NCols(), NoDataValue);
+  for (int row = 0; row<Info.get_NRows(); row++)
+  {
+    data_ofs.write(reinterpret_cast<const char*>(&nodata_row[0]),
+                   streamsize(nodata_row.size()*sizeof(float)));
+  }
+  data_ofs.close();
+  return data_file;
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+// Writes the rows of the core of a tile into their place in a data file
+// agent 16/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+void LSDRasterTiles::write_tile_data(int tile, LSDRasterView<const float> tile_data,
+                                     int halo, string data_file)
+{
+  int row_start, col_start, n_rows, n_cols;
+  get_tile_core(tile, row_start, col_start, n_rows, n_cols);
+  fstream data_fs(data_file.c_str(), ios::in | ios::out | ios::binary);
+  if( data_fs.fail() )
+  {
+    cout << "\nFATAL ERROR: unable to write to " << data_file << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  bool swap = !host_is_little_endian();
+  vector<float> row_buffer(n_cols);
+  for (int row = 0; row<n_rows; row++)
+  {
+    const float* tile_row = tile_data.row(row+halo)+halo;
+    for (int col = 0; col<n_cols; col++)
+    {
+      row_buffer[col] = tile_row[col];
+      if (swap)
+      {
+        swap_bytes(reinterpret_cast<char*>(&row_buffer[col]), int(sizeof(float)));
+      }
+    }
+    streamoff offset = (streamoff(row_start+row)*streamoff(Info.get_NCols())
+                       +streamoff(col_start))*streamoff(sizeof(float));
+    data_fs.seekp(offset);
+    data_fs.write(reinterpret_cast<const char*>(&row_buffer[0]),
+                  streamsize(n_cols*sizeof(float)));
+  }
+  data_fs.close();
+}
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
+
+#endif
@@ -0,0 +1,239 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDRasterTiles
+// Land Surface Dynamics Raster Tiles
+//
+// An object within the University
+//  of Edinburgh Land Surface Dynamics group topographic toolbox
+//  for reading rasters piece by piece so that DEMs that do not fit in memory
+//  can be processed
+//
+// Windows of a raster file are read without loading the rest of the file.
+// Binary files (.flt and .bil) are read by seeking straight to the rows of
+// the window. The raster is also split into tiles, each of which is read with
+// a halo of extra cells around it so that neighbourhood operations (slope,
+// curvature, hillshade...) give the same answer in the tile as they would on
+// the whole raster. The cores of the processed tiles can then be written into
+// a single output raster.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDRasterTiles_H
+#define LSDRasterTiles_H
+
+#include <string>
+#include <vector>
+#include "LSDRaster.hpp"
+#include "LSDIndexRaster.hpp"
+#include "LSDRasterInfo.hpp"
+#include "LSDRasterBuffer.hpp"
+using namespace std;
+
+///@brief Object for windowed and tiled reading of raster files.
+///@author agent
+///@date 16/10/2026
+class LSDRasterTiles
+{
+  public:
+    /// @brief Reads the header of a raster and splits it into tiles
+    /// @param filename the prefix of the file
+    /// @param extension "asc", "flt" or "bil"
+    /// @param tile_size the number of rows and columns in the core of a tile
+    /// @param halo the number of extra cells read on each side of a tile
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRasterTiles(string filename, string extension, int tile_size, int halo)
+                               { create(filename, extension, tile_size, halo); }
+
+    /// @brief Reads a window of the raster. Parts of the window that are
+    ///  outside the raster are filled with nodata.
+    /// @param row_start the first row of the window (row 0 is the top)
+    /// @param col_start the first column of the window
+    /// @param n_rows the number of rows in the window
+    /// @param n_cols the number of columns in the window
+    /// @return a raster of the window, georeferenced to its position
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRaster read_window(int row_start, int col_start, int n_rows, int n_cols);
+
+    /// @brief Reads the window that covers a bounding box. The box is
+    ///  expanded to whole cells and clipped to the raster.
+    /// @param X_minimum the western edge of the box
+    /// @param Y_minimum the southern edge of the box
+    /// @param X_maximum the eastern edge of the box
+    /// @param Y_maximum the northern edge of the box
+    /// @return a raster of the window
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRaster read_window_UTM(float X_minimum, float Y_minimum,
+                              float X_maximum, float Y_maximum);
+
+    /// @return the number of tiles
+    int get_NTiles() const        { return NTileRows*NTileCols; }
+    /// @return the number of rows of tiles
+    int get_NTileRows() const        { return NTileRows; }
+    /// @return the number of columns of tiles
+    int get_NTileCols() const        { return NTileCols; }
+    /// @return the size of the core of a tile
+    int get_TileSize() const        { return TileSize; }
+    /// @return the width of the halo
+    int get_Halo() const        { return Halo; }
+    /// @return the header of the whole raster
+    LSDRasterInfo get_RasterInfo() const        { return Info; }
+
+    /// @brief Gets the rows and columns of the core of a tile. Tiles on the
+    ///  bottom and right edges can be smaller than the tile size.
+    /// @param tile the tile index, running along the rows of tiles
+    /// @param row_start the first row of the core. Replaced in function.
+    /// @param col_start the first column of the core. Replaced in function.
+    /// @param n_rows the number of rows in the core. Replaced in function.
+    /// @param n_cols the number of columns in the core. Replaced in function.
+    /// @author agent
+    /// @date 16/10/2026
+    void get_tile_core(int tile, int& row_start, int& col_start, int& n_rows, int& n_cols);
+
+    /// @brief Reads a tile with its halo. Halo cells outside the raster are nodata.
+    /// @param tile the tile index
+    /// @return the tile
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRaster get_tile(int tile);
+
+    /// @brief Cuts the halo off a tile that was read with get_tile
+    /// @param tile the tile index
+    /// @param TileRaster the tile, or a raster derived from it
+    /// @return the core of the tile
+    /// @author agent
+    /// @date 16/10/2026
+    LSDRaster trim_halo(int tile, LSDRaster& TileRaster);
+
+    /// @brief Starts an output raster the size of the whole raster. The header
+    ///  is written and the data file is filled with nodata.
+    /// @param filename the prefix of the output file
+    /// @param extension "flt" or "bil"
+    /// @author agent
+    /// @date 16/10/2026
+    void start_output(string filename, string extension);
+
+    /// @brief Writes the core of a tile into the output raster
+    /// @param tile the tile index
+    /// @param TileRaster the tile with its halo, as returned by get_tile or
+    ///  derived from it
+    /// @author agent
+    /// @date 16/10/2026
+    void write_tile(int tile, LSDRaster& TileRaster);
+
+    /// @brief Fits polynomial surfaces with several window radii in one pass
+    ///  over the raster, and writes the six coefficient rasters of each radius.
+    /// @details Each tile is read once, with a halo as wide as the largest
+    ///  kernel, and all of the radii are fitted to it before the next tile is
+    ///  read. The windows are those of calculate_polyfit_surface_metrics.
+    ///  Cells near the edge of the raster, or with nodata in their window, get
+    ///  nodata. The outputs are written tile by tile, so only one tile of each
+    ///  is in memory. The halo given to the constructor is not used.
+    ///  The coefficient of x^2 for a radius of 10 is written to
+    ///  out_prefix_polyfit_a_R10, and so on for b to f.
+    /// @param window_radii the window radii
+    /// @param out_prefix the prefix of the output files
+    /// @param out_extension "flt" or "bil"
+    /// @author agent
+    /// @date 16/10/2026
+    void write_polyfit_coefficients(vector<float> window_radii, string out_prefix,
+                                    string out_extension);
+
+    /// @brief As above, but only writes some of the coefficients.
+    /// @details All six coefficients are still fitted, but only the rasters
+    ///  of the selected ones are written, so a caller that needs, say, the
+    ///  curvature does not fill the disk with rasters it never reads.
+    /// @param window_radii the window radii
+    /// @param coefficients the coefficients to write, as letters from a to f,
+    ///  e.g. "ab" for the coefficients of x^2 and y^2
+    /// @param out_prefix the prefix of the output files
+    /// @param out_extension "flt" or "bil"
+    /// @author agent
+    /// @date 16/10/2026
+    void write_polyfit_coefficients(vector<float> window_radii, string coefficients,
+                                    string out_prefix, string out_extension);
+
+  protected:
+
+    /// the prefix of the raster file
+    string FileName;
+    /// the extension of the raster file
+    string Extension;
+    /// the header of the raster
+    LSDRasterInfo Info;
+    /// the size of the core of a tile
+    int TileSize;
+    /// the width of the halo
+    int Halo;
+    /// the number of rows of tiles
+    int NTileRows;
+    /// the number of columns of tiles
+    int NTileCols;
+    /// the data file of the output raster
+    string OutputDataFile;
+
+  private:
+    void create(string filename, string extension, int tile_size, int halo);
+
+    /// @brief reads the part of a window that overlaps a binary file
+    void read_binary_window(int row_start, int col_start, Array2D<float>& data);
+
+    /// @brief reads the part of a window that overlaps an ascii file
+    void read_ascii_window(int row_start, int col_start, Array2D<float>& data);
+
+    /// @brief writes the header of an output raster and fills its data file
+    ///  with nodata
+    /// @return the name of the data file
+    string create_output(string filename, string extension);
+
+    /// @brief writes the core of a tile into a data file
+    /// @param tile the tile index
+    /// @param tile_data the tile with a halo of the given width
+    /// @param halo the width of the halo around the core in tile_data
+    /// @param data_file the data file to write to
+    void write_tile_data(int tile, LSDRasterView<const float> tile_data, int halo,
+                         string data_file);
+};
+
+#endif
@@ -101,12 +101,16 @@ using namespace JAMA;
 
 
 
-float ran3(long *idum)
-{
-   //cout << &idum << endl;
-   static int inext,inextp;
-   static long ma[56];
-   static int iff=0;
+// ran3 keeps its state in a ran3_stream. The original interface uses a single
+// stream for the whole program, so calls to it from different threads
+// interfere with each other; threaded code should pass its own stream.
+// agent 16/10/2026
+float ran3(long *idum, ran3_stream& stream)
+{
+   int& inext = stream.inext;
+   int& inextp = stream.inextp;
+   long* ma = stream.ma;
+   int& iff = stream.iff;
    long mj,mk;
    int i,ii,k;
 
@@ -143,6 +147,31 @@ float ran3(long *idum)
    ma[inext]=mj;
    return fabs(mj*FAC);
 }
+
+float ran3(long *idum)
+{
+   static ran3_stream global_stream;
+   return ran3(idum, global_stream);
+}
+
+float ran3(ran3_stream& stream)
+{
+   return ran3(&stream.idum, stream);
+}
+
+// Mixes a seed and a stream number so that neighbouring streams do not start
+// from neighbouring seeds. The result is always negative, which is what ran3
+// expects when it is (re)started.
+long ran3_stream_seed(long seed, int stream_number)
+{
+   unsigned long h = (unsigned long)(seed) * 2654435761UL
+                     + (unsigned long)(stream_number) * 40503UL + 1UL;
+   h ^= (h >> 15);
+   h *= 2246822519UL;
+   h ^= (h >> 13);
+   long mixed = long(h % 900000000UL);
+   return -(mixed+1);
+}
 #undef MBIG
 #undef MSEED
 #undef MZ
@@ -8467,4 +8496,28 @@ vector<double> TV1D_denoise_v2(vector<double> input,  double lambda) {
 
 
 
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// 64 bit FNV-1a hash of a block of bytes, starting from the FNV offset basis
+// agent 17/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+uint64_t fnv1a_hash(const void* bytes, size_t n_bytes)
+{
+  return fnv1a_hash(bytes, n_bytes, FNV1A_OFFSET_BASIS);
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// 64 bit FNV-1a hash of a block of bytes, continuing from a running hash
+// agent 17/10/2026
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+uint64_t fnv1a_hash(const void* bytes, size_t n_bytes, uint64_t hash)
+{
+  const unsigned char* data = static_cast<const unsigned char*>(bytes);
+  for (size_t i = 0; i<n_bytes; i++)
+  {
+    hash = (hash ^ data[i])*1099511628211ULL;
+  }
+  return hash;
+}
+
+
 #endif
@@ -53,6 +53,8 @@
 #include <vector>
 #include <map>
 #include <math.h>
+#include <stdint.h>
+#include <cstddef>
 #include "TNT/tnt.h"
 using namespace std;
 using namespace TNT;
@@ -364,6 +366,30 @@ float calculate_RMSE_from_residuals(vector<float>& residuals);
 
 // a random number generator
 float ran3( long *idum );
+
+// The state of a ran3 generator. ran3(long*) keeps a single state for the whole
+// program, so code that draws numbers on several threads, or that needs the
+// same numbers every time it is run, gives each task its own stream.
+// A stream is started from its seed on the first draw.
+// agent 16/10/2026
+struct ran3_stream
+{
+  ran3_stream() : idum(-1), inext(0), inextp(0), iff(0) {}
+  ran3_stream(long seed) : idum(seed), inext(0), inextp(0), iff(0) {}
+
+  long idum;
+  int inext;
+  int inextp;
+  long ma[56];
+  int iff;
+};
+
+// ran3 drawing from a stream rather than the global state
+float ran3( long *idum, ran3_stream& stream );
+float ran3( ran3_stream& stream );
+
+// seeds for independent streams, e.g. one per channel, from one seed
+long ran3_stream_seed(long seed, int stream_number);
 // Randomly sample from a vector without replacement DTM 21/04/2014
 vector<float> sample_without_replacement(vector<float> population_vector, int N);
 vector<int> sample_without_replacement(vector<int> population_vector, int N);
@@ -873,4 +899,11 @@ class UnivariateDensityDerivative{
 
 vector<double> TV1D_denoise_v2(vector<double> input,  double lambda);
 
+// 64 bit FNV-1a hash of a block of bytes. The two argument version starts from
+// the FNV offset basis, the three argument version carries on from a running hash
+// so that several blocks can be hashed together
+const uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+uint64_t fnv1a_hash(const void* bytes, size_t n_bytes);
+uint64_t fnv1a_hash(const void* bytes, size_t n_bytes, uint64_t hash);
+
 #endif
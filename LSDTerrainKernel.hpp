@@ -0,0 +1,391 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// LSDTerrainKernel
+// Land Surface Dynamics Terrain Kernel
+//
+// Terrain derivatives from the 3x3 neighbourhood of every cell, computed
+// together in one pass, within the University of Edinburgh Land Surface
+// Dynamics group topographic toolbox
+//
+// Slope, aspect and the curvatures come from the six term polynomial
+// z = ax^2 + by^2 + cxy + dx + ey + f fitted by least squares to the nine
+// cells of the neighbourhood (Evans, 1980). On a 3x3 window the fit has a
+// closed form, so each coefficient is a short sum of the nine elevations.
+// The hillshade uses the same gradient as LSDRaster::hillshade, and the D8
+// slope is the steepest descent to one of the eight neighbours.
+//
+// Each row is done in two stages: the first computes the derivatives of
+// every cell in the row, the second the requested metrics. Nodata is handled
+// with masks rather than branches, so the compiler can vectorise the
+// derivatives and most of the metrics. Rows are processed in parallel in
+// blocks.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifndef LSDTerrainKernel_H
+#define LSDTerrainKernel_H
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "LSDRasterBuffer.hpp"
+using namespace std;
+
+///@brief Computes any subset of slope, aspect, hillshade, curvature, planform,
+/// profile and tangential curvature and D8 slope from the 3x3 neighbourhood
+/// of each cell, in one pass over the raster.
+///@details The outputs are numbered:
+///        0 -> Slope (from the fitted surface)
+///        1 -> Aspect (degrees, as in calculate_polyfit_surface_metrics)
+///        2 -> Hillshade (as in LSDRaster::hillshade)
+///        3 -> Curvature
+///        4 -> Planform Curvature
+///        5 -> Profile Curvature
+///        6 -> Tangential Curvature
+///        7 -> D8 slope (steepest descent to a neighbour)
+/// Cells on the edge of the raster and nodata cells get nodata. Slope, aspect
+/// and the curvatures are also nodata if any cell of the neighbourhood is
+/// nodata. As in LSDRaster::hillshade, the hillshade only needs the centre cell,
+/// and the D8 slope ignores nodata neighbours.
+///@author agent
+///@date 16/10/2026
+class LSDTerrainKernel
+{
+  public:
+    /// The number of outputs
+    static const int NOutputs = 8;
+
+    /// @brief Sets up the kernel
+    /// @param DataResolution the cell size
+    /// @param NoDataValue the nodata value
+    /// @param altitude the altitude of the illumination source for the
+    ///  hillshade in degrees
+    /// @param azimuth the azimuth of the illumination source in degrees
+    /// @param z_factor the vertical exaggeration of the hillshade
+    LSDTerrainKernel(float DataResolution, float NoDataValue, float altitude,
+                     float azimuth, float z_factor)
+      : Resolution(DataResolution), NoData(NoDataValue), ZFactor(z_factor)
+    {
+      // the illumination terms, with the conventions of LSDRaster::hillshade
+      float zenith_rad = (90 - altitude) * M_PI / 180.0;
+      float azimuth_math = 360-azimuth + 90;
+      if (azimuth_math >= 360.0) azimuth_math = azimuth_math - 360;
+      float azimuth_rad = azimuth_math * M_PI /180.0;
+      CosZenith = cos(zenith_rad);
+      SinZenith = sin(zenith_rad);
+      CosAzimuth = cos(azimuth_rad);
+      SinAzimuth = sin(azimuth_rad);
+    }
+
+    /// @brief Computes the selected outputs for a range of rows. Blocks of rows
+    ///  are processed in parallel when the code is compiled with OpenMP.
+    /// @param zeta the elevations
+    /// @param row_start the first row
+    /// @param row_end one past the last row
+    /// @param outputs views of the output rasters, the same size as zeta, in the
+    ///  order listed above. An empty view (with no rows) is not computed.
+    void apply(LSDRasterView<const float> zeta, int row_start, int row_end,
+               vector< LSDRasterView<float> >& outputs) const
+    {
+      int NRows = zeta.get_NRows();
+      int NCols = zeta.get_NCols();
+      bool want[NOutputs];
+      for (int k = 0; k<NOutputs; k++)
+      {
+        want[k] = (k < int(outputs.size()) && outputs[k].get_NRows() > 0);
+      }
+
+      int block_rows = 32;
+      int n_blocks = (row_end-row_start+block_rows-1)/block_rows;
+
+      #pragma omp parallel
+      {
+        // the derivatives of one row
+        vector<float> fx(NCols), fy(NCols), fxx(NCols), fyy(NCols), fxy(NCols);
+        vector<float> gx(NCols), gy(NCols), d8(NCols);
+        vector<char> centre_ok(NCols), window_ok(NCols);
+
+        #pragma omp for schedule(static)
+        for (int block = 0; block<n_blocks; block++)
+        {
+          int first = row_start+block*block_rows;
+          int last = min(row_end, first+block_rows);
+          for (int i = first; i<last; i++)
+          {
+            if (i == 0 || i == NRows-1 || NCols < 3)
+            {
+              for (int k = 0; k<NOutputs; k++)
+              {
+                if (want[k])
+                {
+                  fill(outputs[k].row(i), outputs[k].row(i)+NCols, NoData);
+                }
+              }
+              continue;
+            }
+            derivatives_of_row(zeta.row(i-1), zeta.row(i), zeta.row(i+1), NCols,
+                               fx, fy, fxx, fyy, fxy, gx, gy, d8, centre_ok, window_ok);
+            metrics_of_row(NCols, want, fx, fy, fxx, fyy, fxy, gx, gy, d8,
+                           centre_ok, window_ok, outputs, i);
+          }
+        }
+      }
+    }
+
+  private:
+    /// @brief The derivatives of the interior cells of one row
+    void derivatives_of_row(const float* above, const float* here, const float* below,
+                            int NCols,
+                            vector<float>& fx, vector<float>& fy, vector<float>& fxx,
+                            vector<float>& fyy, vector<float>& fxy, vector<float>& gx,
+                            vector<float>& gy, vector<float>& d8,
+                            vector<char>& centre_ok, vector<char>& window_ok) const
+    {
+      float nd = NoData;
+      float inv_6res = 1.0/(6.0*Resolution);
+      float inv_3res2 = 1.0/(3.0*Resolution*Resolution);
+      float inv_4res2 = 1.0/(4.0*Resolution*Resolution);
+      float inv_8res = 1.0/(8.0*Resolution);
+      float inv_res = 1.0/Resolution;
+      float inv_diag = 1.0/(sqrt(2.0)*Resolution);
+
+      float* p_fx = &fx[0];
+      float* p_fy = &fy[0];
+      float* p_fxx = &fxx[0];
+      float* p_fyy = &fyy[0];
+      float* p_fxy = &fxy[0];
+      float* p_gx = &gx[0];
+      float* p_gy = &gy[0];
+      float* p_d8 = &d8[0];
+      char* p_centre = &centre_ok[0];
+      char* p_window = &window_ok[0];
+
+      #pragma omp simd
+      for (int j = 1; j<NCols-1; j++)
+      {
+        float z1 = above[j-1], z2 = above[j], z3 = above[j+1];
+        float z4 = here[j-1],  z5 = here[j],  z6 = here[j+1];
+        float z7 = below[j-1], z8 = below[j], z9 = below[j+1];
+
+        p_centre[j] = (z5 != nd);
+        p_window[j] = (z1 != nd) & (z2 != nd) & (z3 != nd) & (z4 != nd) & (z5 != nd)
+                      & (z6 != nd) & (z7 != nd) & (z8 != nd) & (z9 != nd);
+
+        // x runs down the rows and y along the columns, as in the polyfit
+        // routines; fxx = 2a, fyy = 2b, fxy = c, fx = d, fy = e
+        float s_above = z1+z2+z3;
+        float s_row = z4+z5+z6;
+        float s_below = z7+z8+z9;
+        float s_left = z1+z4+z7;
+        float s_col = z2+z5+z8;
+        float s_right = z3+z6+z9;
+        p_fx[j] = (s_below-s_above)*inv_6res;
+        p_fy[j] = (s_right-s_left)*inv_6res;
+        p_fxx[j] = (s_above+s_below-2*s_row)*inv_3res2;
+        p_fyy[j] = (s_left+s_right-2*s_col)*inv_3res2;
+        p_fxy[j] = (z1-z3-z7+z9)*inv_4res2;
+
+        // the gradient used by LSDRaster::hillshade
+        p_gx[j] = ((z6 + 2*z8 + z9) - (z1 + 2*z2 + z3))*inv_8res;
+        p_gy[j] = ((z3 + 2*z6 + z9) - (z1 + 2*z4 + z7))*inv_8res;
+
+        // steepest descent to a neighbour that has data
+        float s = 0;
+        s = max(s, (z2 != nd) ? (z5-z2)*inv_res : 0.0f);
+        s = max(s, (z4 != nd) ? (z5-z4)*inv_res : 0.0f);
+        s = max(s, (z6 != nd) ? (z5-z6)*inv_res : 0.0f);
+        s = max(s, (z8 != nd) ? (z5-z8)*inv_res : 0.0f);
+        s = max(s, (z1 != nd) ? (z5-z1)*inv_diag : 0.0f);
+        s = max(s, (z3 != nd) ? (z5-z3)*inv_diag : 0.0f);
+        s = max(s, (z7 != nd) ? (z5-z7)*inv_diag : 0.0f);
+        s = max(s, (z9 != nd) ? (z5-z9)*inv_diag : 0.0f);
+        p_d8[j] = s;
+      }
+    }
+
+    /// @brief The requested metrics of the interior cells of one row
+    void metrics_of_row(int NCols, const bool* want, const vector<float>& fx,
+                        const vector<float>& fy, const vector<float>& fxx,
+                        const vector<float>& fyy, const vector<float>& fxy,
+                        const vector<float>& gx, const vector<float>& gy,
+                        const vector<float>& d8, const vector<char>& centre_ok,
+                        const vector<char>& window_ok,
+                        vector< LSDRasterView<float> >& outputs, int i) const
+    {
+      float nd = NoData;
+      const float* p_fx = &fx[0];
+      const float* p_fy = &fy[0];
+      const float* p_fxx = &fxx[0];
+      const float* p_fyy = &fyy[0];
+      const float* p_fxy = &fxy[0];
+      const char* p_window = &window_ok[0];
+      const char* p_centre = &centre_ok[0];
+
+      for (int k = 0; k<NOutputs; k++)
+      {
+        if (want[k])
+        {
+          outputs[k].row(i)[0] = nd;
+          outputs[k].row(i)[NCols-1] = nd;
+        }
+      }
+
+      if (want[0])
+      {
+        float* out = outputs[0].row(i);
+        #pragma omp simd
+        for (int j = 1; j<NCols-1; j++)
+        {
+          float s = sqrt(p_fx[j]*p_fx[j]+p_fy[j]*p_fy[j]);
+          out[j] = p_window[j] ? s : nd;
+        }
+      }
+      if (want[1])
+      {
+        float* out = outputs[1].row(i);
+        for (int j = 1; j<NCols-1; j++)
+        {
+          float d = p_fx[j];
+          float e = p_fy[j];
+          float aspect;
+          if (d==0 && e==0) aspect = nd;
+          else if (d==0 && e>0) aspect = 90;
+          else if (d==0 && e<0) aspect = 270;
+          else
+          {
+            aspect = 270. - (180./M_PI)*atan(e/d) + 90.*(d/abs(d));
+            if (aspect > 360.0) aspect -= 360;
+          }
+          out[j] = p_window[j] ? aspect : nd;
+        }
+      }
+      if (want[2])
+      {
+        float* out = outputs[2].row(i);
+        const float* p_gx = &gx[0];
+        const float* p_gy = &gy[0];
+        float zf = ZFactor;
+        float cz = CosZenith;
+        float sz = SinZenith;
+        float ca = CosAzimuth;
+        float sa = SinAzimuth;
+        #pragma omp simd
+        for (int j = 1; j<NCols-1; j++)
+        {
+          // 255*(cos(zenith)cos(slope) + sin(zenith)sin(slope)cos(azimuth-aspect))
+          // with slope = atan(zf*|g|) and aspect = atan2(gy,-gx), without the trig
+          float g2 = p_gx[j]*p_gx[j]+p_gy[j]*p_gy[j];
+          float shade = 255.0f*(cz + sz*zf*(p_gy[j]*sa - p_gx[j]*ca))/sqrt(1.0f+zf*zf*g2);
+          shade = max(shade, 0.0f);
+          out[j] = p_centre[j] ? shade : nd;
+        }
+      }
+      if (want[3])
+      {
+        float* out = outputs[3].row(i);
+        #pragma omp simd
+        for (int j = 1; j<NCols-1; j++)
+        {
+          float c = p_fxx[j]+p_fyy[j];
+          out[j] = p_window[j] ? c : nd;
+        }
+      }
+      if (want[4] || want[5] || want[6])
+      {
+        float* out_pl = want[4] ? outputs[4].row(i) : 0;
+        float* out_pr = want[5] ? outputs[5].row(i) : 0;
+        float* out_ta = want[6] ? outputs[6].row(i) : 0;
+        for (int j = 1; j<NCols-1; j++)
+        {
+          float dx = p_fx[j], dy = p_fy[j];
+          float dxx = p_fxx[j], dyy = p_fyy[j], dxy = p_fxy[j];
+          float p = dx*dx + dy*dy;
+          float q = p + 1;
+          float plan_num = dxx*dy*dy - 2*dxy*dx*dy + dyy*dx*dx;
+          bool ok = p_window[j];
+          if (out_pl)
+          {
+            out_pl[j] = ok ? plan_num/sqrt(q*q*q) : nd;
+          }
+          if (out_pr)
+          {
+            float denom = p*sqrt(q*q*q);
+            out_pr[j] = (ok && denom != 0) ? (dxx*dx*dx + 2*dxy*dx*dy + dyy*dy*dy)/denom : nd;
+          }
+          if (out_ta)
+          {
+            float denom = p*sqrt(q);
+            out_ta[j] = (ok && denom != 0) ? plan_num/denom : nd;
+          }
+        }
+      }
+      if (want[7])
+      {
+        float* out = outputs[7].row(i);
+        const float* p_d8 = &d8[0];
+        #pragma omp simd
+        for (int j = 1; j<NCols-1; j++)
+        {
+          out[j] = p_centre[j] ? p_d8[j] : nd;
+        }
+      }
+    }
+
+    /// The cell size
+    float Resolution;
+    /// The nodata value
+    float NoData;
+    /// The vertical exaggeration of the hillshade
+    float ZFactor;
+    /// Cosine of the zenith angle of the illumination
+    float CosZenith;
+    /// Sine of the zenith angle of the illumination
+    float SinZenith;
+    /// Cosine of the azimuth of the illumination, in the hillshade convention
+    float CosAzimuth;
+    /// Sine of the azimuth of the illumination, in the hillshade convention
+    float SinAzimuth;
+};
+
+#endif
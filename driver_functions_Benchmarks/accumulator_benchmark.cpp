@@ -0,0 +1,214 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// accumulator_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times LSDFlowInfo::upslope_variable_accumulator. A batch of
+// rasters is accumulated together in one walk down the stack, and also one
+// raster at a time. Both are compared with a reference that sums the upslope
+// nodes of every node, which is how a raster was accumulated before.
+//
+// The DEM is synthetic and filled, so the benchmark can be run anywhere. The
+// arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//  3) the number of rasters in the batch
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDFlowInfo.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// the largest difference between two rasters, relative to the second
+float max_relative_difference(LSDRaster& A, LSDRaster& B)
+{
+  float max_diff = 0;
+  for (int row = 0; row<A.get_NRows(); row++)
+  {
+    for (int col = 0; col<A.get_NCols(); col++)
+    {
+      float a = A.get_data_element(row,col);
+      float b = B.get_data_element(row,col);
+      if (b != B.get_NoDataValue() && b != 0)
+      {
+        max_diff = max(max_diff, float(fabs(a-b)/fabs(b)));
+      }
+    }
+  }
+  return max_diff;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the accumulator benchmark!               ||" << endl;
+    cout << "|| This times the batched upslope accumulator.         ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of rows, e.g. 1000." << endl;
+    cout << "* The number of columns, e.g. 1000." << endl;
+    cout << "* The number of rasters, e.g. 24." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  int NFields = atoi(argv[3]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // a rough synthetic surface, filled
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.05*row+0.02*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+  float MinSlope = 0.0001;
+  LSDRaster Filled = Topo.fill(MinSlope);
+  vector<string> BoundaryConditions(4,"n");
+  LSDFlowInfo FlowInfo(BoundaryConditions,Filled);
+
+  // the fields, e.g. precipitation scenarios or lithology fractions
+  vector<LSDRaster> Fields;
+  for (int f = 0; f<NFields; f++)
+  {
+    Array2D<float> field(NRows,NCols);
+    for (int row = 0; row<NRows; row++)
+    {
+      for (int col = 0; col<NCols; col++)
+      {
+        field[row][col] = 1+0.1*f+0.001*row+0.0005*((row*col+f) % 7);
+      }
+    }
+    Fields.push_back(LSDRaster(NRows,NCols,0,0,DataResolution,NoDataValue,field));
+  }
+
+  // the reference: the sum over the upslope nodes of every node, for the
+  // first raster only
+  double start = wall_time();
+  Array2D<float> reference(NRows,NCols,NoDataValue);
+  int NDataNodes = FlowInfo.get_NDataNodes();
+  for (int node = 0; node<NDataNodes; node++)
+  {
+    vector<int> upslope = FlowInfo.get_upslope_nodes(node);
+    float total = 0;
+    int row, col;
+    for (int n = 0; n<int(upslope.size()); n++)
+    {
+      FlowInfo.retrieve_current_row_and_col(upslope[n],row,col);
+      total += Fields[0].get_data_element(row,col);
+    }
+    FlowInfo.retrieve_current_row_and_col(node,row,col);
+    reference[row][col] = total;
+  }
+  LSDRaster Reference(NRows,NCols,0,0,DataResolution,NoDataValue,reference);
+  double reference_time = wall_time()-start;
+
+  start = wall_time();
+  vector<LSDRaster> Batch = FlowInfo.upslope_variable_accumulator(Fields);
+  double batch_time = wall_time()-start;
+
+  start = wall_time();
+  vector<LSDRaster> Singles;
+  for (int f = 0; f<NFields; f++)
+  {
+    Singles.push_back(FlowInfo.upslope_variable_accumulator(Fields[f]));
+  }
+  double single_time = wall_time()-start;
+
+  // the node matrix on its own, without gathering and scattering rasters
+  Array2D<float> node_values(NDataNodes,NFields);
+  for (int node = 0; node<NDataNodes; node++)
+  {
+    int row, col;
+    FlowInfo.retrieve_current_row_and_col(node,row,col);
+    for (int f = 0; f<NFields; f++)
+    {
+      node_values[node][f] = Fields[f].get_data_element(row,col);
+    }
+  }
+  start = wall_time();
+  Array2D<float> accumulated = FlowInfo.upslope_variable_accumulator(node_values);
+  double matrix_time = wall_time()-start;
+
+  float max_batch_single = 0;
+  for (int f = 0; f<NFields; f++)
+  {
+    max_batch_single = max(max_batch_single, max_relative_difference(Batch[f],Singles[f]));
+  }
+
+  cout << "nodes\tfields\treference_1_field_s\tbatch_s\tone_at_a_time_s\tmatrix_only_s" << endl;
+  cout << NDataNodes << "\t" << NFields << "\t" << reference_time << "\t" << batch_time
+       << "\t" << single_time << "\t" << matrix_time << endl << endl;
+  cout << "max relative difference, batch vs reference: "
+       << max_relative_difference(Batch[0],Reference) << endl;
+  cout << "max relative difference, batch vs one at a time: " << max_batch_single << endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// compressed_raster_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program writes a DEM and its filled DEM as .bil and as tiled
+// compressed .lsdc rasters, reads them back, and reports the file sizes,
+// the time taken and whether the rasters read back match the originals.
+// It also times reading a single window from the .lsdc file, which only
+// decompresses the tiles under the window.
+//
+// The arguments are:
+//  1) the path to the DEM (with a slash at the end)
+//  2) the name of the DEM without extension
+//  3) the extension of the DEM (bil, flt or asc)
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDCompressedRaster.hpp"
+#include "../LSDStatsTools.hpp"
+using namespace std;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// size of a file in bytes
+long file_size(string filename)
+{
+  struct stat stat_buf;
+  int rc = stat(filename.c_str(), &stat_buf);
+  return rc == 0 ? long(stat_buf.st_size) : -1;
+}
+
+// writes a raster in both formats, reads it back and prints the comparison.
+// Returns the number of cells that were not read back bit for bit
+int compare_formats(LSDRaster& Raster, string prefix)
+{
+  double start = wall_time();
+  Raster.write_raster(prefix, "bil");
+  double bil_write = wall_time()-start;
+  start = wall_time();
+  Raster.write_raster(prefix, "lsdc");
+  double lsdc_write = wall_time()-start;
+
+  start = wall_time();
+  LSDRaster bil_raster(prefix, "bil");
+  double bil_read = wall_time()-start;
+  start = wall_time();
+  LSDRaster lsdc_raster(prefix, "lsdc");
+  double lsdc_read = wall_time()-start;
+
+  Array2D<float> original = Raster.get_RasterData();
+  Array2D<float> read_back = lsdc_raster.get_RasterData();
+  int n_mismatch = 0;
+  for (int row = 0; row<Raster.get_NRows(); row++)
+  {
+    for (int col = 0; col<Raster.get_NCols(); col++)
+    {
+      if (memcmp(&original[row][col], &read_back[row][col], sizeof(float)) != 0)
+      {
+        n_mismatch++;
+      }
+    }
+  }
+
+  long bil_bytes = file_size(prefix+".bil");
+  long lsdc_bytes = file_size(prefix+".lsdc");
+  cout << prefix << endl;
+  cout << "  bil:  " << bil_bytes << " bytes, write " << bil_write << " s, read "
+       << bil_read << " s" << endl;
+  cout << "  lsdc: " << lsdc_bytes << " bytes, write " << lsdc_write << " s, read "
+       << lsdc_read << " s" << endl;
+  cout << "  lsdc/bil size: " << double(lsdc_bytes)/double(bil_bytes) << endl;
+  cout << "  Mismatched nodes: " << n_mismatch << endl;
+  return n_mismatch;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the compressed raster benchmark!         ||" << endl;
+    cout << "|| This compares .bil and tiled compressed rasters.    ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The path to the DEM, with a slash at the end." << endl;
+    cout << "* The name of the DEM without extension." << endl;
+    cout << "* The extension of the DEM (bil, flt or asc)." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  string path_name = FixPath(argv[1]);
+  string DEM_name = argv[2];
+  string DEM_ext = argv[3];
+
+  LSDRaster topography_raster(path_name+DEM_name, DEM_ext);
+  float MinSlope = 0.0001;
+  LSDRaster filled_raster = topography_raster.fill(MinSlope);
+
+  int n_mismatch = compare_formats(topography_raster, path_name+DEM_name+"_CMP");
+  n_mismatch += compare_formats(filled_raster, path_name+DEM_name+"_CMP_Fill");
+
+  // random access: a window in the middle of the raster
+  LSDCompressedRasterReader reader(path_name+DEM_name+"_CMP_Fill.lsdc");
+  int window_size = reader.get_TileSize();
+  Array2D<float> window(window_size, window_size);
+  double start = wall_time();
+  reader.read_window(reader.get_NRows()/2, reader.get_NCols()/2, window);
+  double window_time = wall_time()-start;
+  cout << "Reading a " << window_size << " by " << window_size << " window took "
+       << window_time << " s" << endl;
+
+  if (n_mismatch != 0)
+  {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// cosmo_samples_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the basinwide erosion rate analysis of
+// LSDCosmoData::full_shielding_cosmogenic_analysis with the samples run one
+// after another and with the samples run on several threads (the n_threads
+// parameter), and checks that the results files are the same.
+//
+// The DEM and the samples are synthetic, so the benchmark can be run
+// anywhere with the NCEP data. The files are written to the working path.
+// The arguments are:
+//  1) the working path
+//  2) the path to the atmospheric data, e.g. ../driver_functions_CRNBasinwide/
+//  3) the number of rows and columns of the DEM
+//  4) the number of samples
+//  5) the number of threads
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDFlowInfo.hpp"
+#include "../LSDJunctionNetwork.hpp"
+#include "../LSDShapeTools.hpp"
+#include "../LSDCosmoData.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// reads a whole file into a string
+string read_file(string filename)
+{
+  ifstream ifs(filename.c_str());
+  stringstream ss;
+  ss << ifs.rdbuf();
+  return ss.str();
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=6)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the cosmogenic samples benchmark!        ||" << endl;
+    cout << "|| This times basinwide erosion rates on threads.      ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires five inputs: " << endl;
+    cout << "* The working path, where the DEM and files are written." << endl;
+    cout << "* The path to NCEP2.bin." << endl;
+    cout << "* The number of rows and columns of the DEM, e.g. 300." << endl;
+    cout << "* The number of samples, e.g. 16." << endl;
+    cout << "* The number of threads, e.g. 4." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  string path = FixPath(argv[1]);
+  string path_to_atmospheric_data = FixPath(argv[2]);
+  int NRows = atoi(argv[3]);
+  int NCols = NRows;
+  int NSamples = atoi(argv[4]);
+  int NThreads = atoi(argv[5]);
+  float NoDataValue = -9999;
+  float DataResolution = 30;
+
+  // a synthetic landscape of ridges and valleys draining to the south, in
+  // UTM zone 13 north (Colorado)
+  double XMinimum = 450000;
+  double YMinimum = 4400000;
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 2000+3*(NRows-row)+150*sin(0.05*col)*sin(0.02*row)
+                      +40*fabs(sin(0.03*col+0.01*row))+0.5*float(rand()%100);
+    }
+  }
+  map<string,string> GRS;
+  stringstream map_info;
+  map_info.precision(10);
+  map_info << "UTM, 1, 1, " << XMinimum << ", " << YMinimum+NRows*DataResolution
+           << ", " << DataResolution << ", " << DataResolution << ", 13, North,WGS-84";
+  GRS["ENVI_map_info"] = map_info.str();
+  LSDRaster Topo(NRows,NCols,float(XMinimum),float(YMinimum),DataResolution,NoDataValue,zeta,GRS);
+  string DEM_name = path+"cosmo_bench_DEM";
+  Topo.write_raster(DEM_name,"bil");
+
+  // the samples are at channel junctions spread through the network
+  int source_threshold = 20;
+  float MinSlope = 0.0001;
+  LSDRaster Filled = Topo.fill(MinSlope);
+  vector<string> BoundaryConditions(4,"n");
+  LSDFlowInfo FlowInfo(BoundaryConditions,Filled);
+  LSDIndexRaster ContributingPixels = FlowInfo.write_NContributingNodes_to_LSDIndexRaster();
+  vector<int> sources = FlowInfo.get_sources_index_threshold(ContributingPixels, source_threshold);
+  LSDJunctionNetwork JNetwork(sources, FlowInfo);
+  vector<int> StreamOrder = JNetwork.get_StreamOrderVector();
+  vector<int> candidate_junctions;
+  for (int j = 0; j<JNetwork.get_NJunctions(); j++)
+  {
+    if (StreamOrder[j] >= 2)
+    {
+      candidate_junctions.push_back(j);
+    }
+  }
+  if (int(candidate_junctions.size()) < NSamples)
+  {
+    NSamples = int(candidate_junctions.size());
+  }
+
+  LSDCoordinateConverterLLandUTM Converter;
+  string CRN_name = path+"cosmo_bench_CRNData.csv";
+  ofstream CRN_out(CRN_name.c_str());
+  CRN_out.precision(10);
+  CRN_out << "sample_name,latitude,longitude,nuclide,concentration,uncertainty,standardisation" << endl;
+  for (int s = 0; s<NSamples; s++)
+  {
+    int junction = candidate_junctions[(s*int(candidate_junctions.size()))/NSamples];
+    int row,col;
+    FlowInfo.retrieve_current_row_and_col(JNetwork.get_Node_of_Junction(junction),row,col);
+    double Easting = XMinimum+(double(col)+0.5)*DataResolution;
+    double Northing = YMinimum+(double(NRows-row)-0.5)*DataResolution;
+    double lat,longitude;
+    Converter.UTMtoLL(22, Northing, Easting, 13, true, lat, longitude);
+    double conc = 100000+5000*(s%7);
+    CRN_out << "S" << s << "," << lat << "," << longitude << ",Be10,"
+            << conc << "," << 0.03*conc << ",07KNSTD" << endl;
+  }
+  CRN_out.close();
+
+  cout << "DEM: " << NRows << "x" << NCols << " samples: " << NSamples
+       << " threads: " << NThreads << endl;
+
+  // run the analysis with one thread and then with NThreads
+  vector<int> threads_to_run;
+  threads_to_run.push_back(1);
+  threads_to_run.push_back(NThreads);
+  vector<double> times;
+  vector<string> results;
+  for (int r = 0; r<int(threads_to_run.size()); r++)
+  {
+    stringstream prefix_ss;
+    prefix_ss << "cosmo_bench_t" << threads_to_run[r];
+    string prefix = prefix_ss.str();
+
+    string copy_name = path+prefix+"_CRNData.csv";
+    ofstream copy_out(copy_name.c_str());
+    copy_out << read_file(CRN_name);
+    copy_out.close();
+
+    string rasters_name = path+prefix+"_CRNRasters.csv";
+    ofstream rasters_out(rasters_name.c_str());
+    rasters_out << DEM_name << ",0,0" << endl;
+    rasters_out.close();
+
+    string param_name = path+prefix+".CRNParam";
+    ofstream param_out(param_name.c_str());
+    param_out << "min_slope: 0.0001" << endl;
+    param_out << "source_threshold: " << source_threshold << endl;
+    param_out << "search_radius_nodes: 1" << endl;
+    param_out << "threshold_stream_order: 1" << endl;
+    param_out << "theta_step: 30" << endl;
+    param_out << "phi_step: 30" << endl;
+    param_out << "Muon_scaling: Braucher" << endl;
+    param_out << "path_to_atmospheric_data: " << path_to_atmospheric_data << endl;
+    param_out << "write_toposhield_raster: false" << endl;
+    param_out << "write_basin_index_raster: true" << endl;
+    param_out << "n_threads: " << threads_to_run[r] << endl;
+    param_out.close();
+
+    LSDCosmoData CosmoData(path,prefix);
+    double t0 = wall_time();
+    CosmoData.calculate_erosion_rates(1);
+    times.push_back(wall_time()-t0);
+    CosmoData.print_results();
+    results.push_back(read_file(path+prefix+"_CRNResults.csv"));
+  }
+
+  cout << endl << "==========================================" << endl;
+  cout << "DEM: " << NRows << "x" << NCols << " samples: " << NSamples << endl;
+  for (int r = 0; r<int(threads_to_run.size()); r++)
+  {
+    cout << "  " << threads_to_run[r] << " thread(s): " << times[r] << " s" << endl;
+  }
+  cout << "Results files identical: " << ((results[0] == results[1]) ? "yes" : "no") << endl;
+}
@@ -0,0 +1,266 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// crn_kernel_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the basinwide erosion rate inversion with snow and self
+// shielding. The reference is the pixel by pixel loop of
+// LSDCosmoBasin::predict_mean_CRN_conc_with_snow_and_self, which is called
+// twice on every Newton-Raphson iteration. It is compared with
+// LSDCRNConcentrationKernel, which is prepared once per basin.
+//
+// The basin is synthetic, so the benchmark can be run anywhere. The
+// arguments are:
+//  1) the number of pixels in the basin
+//  2) the nuclide, Be10 or Al26
+//  3) the muon scaling, e.g. Braucher
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDCRNParameters.hpp"
+#include "../LSDParticle.hpp"
+#include "../LSDCRNKernel.hpp"
+using namespace std;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// the pixel by pixel loop of predict_mean_CRN_conc_with_snow_and_self
+double reference_mean_conc(double eff_erosion_rate, string Nuclide, string Muon_scaling,
+                           double prod_uncert_factor, double NoDataValue,
+                           vector<double>& production_scaling,
+                           vector<double>& topographic_shielding,
+                           vector<double>& snow_shield_eff_depth,
+                           vector<double>& self_shield_eff_depth)
+{
+  double Total_N = 0;
+  int count_samples = 0;
+  LSDCRNParticle eroded_particle(0, 0, 0, 0.0, 0.0, 0.0);
+  LSDCRNParameters LSDCRNP;
+  vector<bool> nuclide_scaling_switches(4,false);
+  if (Nuclide == "Be10")
+  {
+    nuclide_scaling_switches[0] = true;
+  }
+  else
+  {
+    nuclide_scaling_switches[1] = true;
+  }
+
+  for (int q = 0; q < int(topographic_shielding.size()); ++q)
+  {
+    if(topographic_shielding[q] != NoDataValue)
+    {
+      count_samples++;
+      if (Muon_scaling == "Schaller" )
+      {
+        LSDCRNP.set_Schaller_parameters();
+      }
+      else if (Muon_scaling == "Granger" )
+      {
+        LSDCRNP.set_Granger_parameters();
+      }
+      else if (Muon_scaling == "newCRONUS" )
+      {
+        LSDCRNP.set_newCRONUS_parameters();
+      }
+      else
+      {
+        LSDCRNP.set_Braucher_parameters();
+      }
+
+      double total_shielding = prod_uncert_factor*production_scaling[q]*topographic_shielding[q];
+      LSDCRNP.scale_F_values(total_shielding,nuclide_scaling_switches);
+
+      double this_top_eff_depth = snow_shield_eff_depth[q];
+      double this_bottom_eff_depth = this_top_eff_depth+self_shield_eff_depth[q];
+      if (Nuclide == "Be10")
+      {
+        eroded_particle.update_10Be_SSfull_depth_integrated(eff_erosion_rate,LSDCRNP,
+                                           this_top_eff_depth, this_bottom_eff_depth);
+        Total_N+=eroded_particle.getConc_10Be();
+      }
+      else
+      {
+        eroded_particle.update_26Al_SSfull_depth_integrated(eff_erosion_rate,LSDCRNP,
+                                           this_top_eff_depth, this_bottom_eff_depth);
+        Total_N+=eroded_particle.getConc_26Al();
+      }
+    }
+  }
+  return Total_N/double(count_samples);
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the CRN kernel benchmark!                ||" << endl;
+    cout << "|| This times the basinwide erosion rate inversion.    ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of pixels, e.g. 100000." << endl;
+    cout << "* The nuclide, Be10 or Al26." << endl;
+    cout << "* The muon scaling, e.g. Braucher." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NPixels = atoi(argv[1]);
+  string Nuclide = argv[2];
+  string Muon_scaling = argv[3];
+  double NoDataValue = -9999;
+  double prod_uncert_factor = 1;
+
+  // a synthetic basin, with a few nodata pixels
+  srand(1);
+  vector<double> production_scaling(NPixels);
+  vector<double> topographic_shielding(NPixels);
+  vector<double> snow_shield_eff_depth(NPixels);
+  vector<double> self_shield_eff_depth(NPixels);
+  for (int q = 0; q<NPixels; q++)
+  {
+    production_scaling[q] = 2+4*double(rand())/double(RAND_MAX);
+    topographic_shielding[q] = (q % 997 == 0) ? NoDataValue
+                               : 0.8+0.2*double(rand())/double(RAND_MAX);
+    snow_shield_eff_depth[q] = (q % 3 == 0) ? 0 : 20*double(rand())/double(RAND_MAX);
+    // update_26Al_SSfull prints every pixel, so only 10Be has pixels with
+    // no self shielding
+    self_shield_eff_depth[q] = (q % 5 == 0 && Nuclide == "Be10") ? 0
+                               : 1+100*double(rand())/double(RAND_MAX);
+  }
+
+  // the concentration to invert for
+  double true_erate = 0.003;
+  double Nuclide_conc = reference_mean_conc(true_erate, Nuclide, Muon_scaling,
+                           prod_uncert_factor, NoDataValue, production_scaling,
+                           topographic_shielding, snow_shield_eff_depth, self_shield_eff_depth);
+
+  double tolerance = 1e-10;
+  double eff_e_displace = 1e-6;
+  // from below, as the neutron only guess of predict_CRN_erosion is
+  double eff_e_guess = 0.001;
+
+  // the reference inversion
+  double start = wall_time();
+  double eff_e_ref = eff_e_guess;
+  double eff_e_change;
+  int ref_iterations = 0;
+  do
+  {
+    double f_x = reference_mean_conc(eff_e_ref, Nuclide, Muon_scaling,
+                           prod_uncert_factor, NoDataValue, production_scaling,
+                           topographic_shielding, snow_shield_eff_depth,
+                           self_shield_eff_depth)-Nuclide_conc;
+    double f_x_displace = reference_mean_conc(eff_e_ref+eff_e_displace, Nuclide, Muon_scaling,
+                           prod_uncert_factor, NoDataValue, production_scaling,
+                           topographic_shielding, snow_shield_eff_depth,
+                           self_shield_eff_depth)-Nuclide_conc;
+    double N_derivative = (f_x_displace-f_x)/eff_e_displace;
+    eff_e_change = (N_derivative != 0) ? f_x/N_derivative : 0;
+    eff_e_ref -= eff_e_change;
+    ref_iterations++;
+  } while(fabs(eff_e_change) > tolerance);
+  double ref_time = wall_time()-start;
+
+  // the kernel inversion, including preparing the kernel
+  start = wall_time();
+  LSDCRNConcentrationKernel ConcKernel(production_scaling, topographic_shielding,
+                                       snow_shield_eff_depth, self_shield_eff_depth,
+                                       NoDataValue, Nuclide, Muon_scaling, prod_uncert_factor,
+                                       false, false);
+  double prep_time = wall_time()-start;
+  double eff_e_kernel = eff_e_guess;
+  int kernel_iterations = 0;
+  do
+  {
+    double f_x = ConcKernel.mean_concentration(eff_e_kernel)-Nuclide_conc;
+    double f_x_displace = ConcKernel.mean_concentration(eff_e_kernel+eff_e_displace)-Nuclide_conc;
+    double N_derivative = (f_x_displace-f_x)/eff_e_displace;
+    eff_e_change = (N_derivative != 0) ? f_x/N_derivative : 0;
+    eff_e_kernel -= eff_e_change;
+    kernel_iterations++;
+  } while(fabs(eff_e_change) > tolerance);
+  double kernel_time = wall_time()-start;
+
+  // the concentrations over a range of erosion rates
+  double max_conc_diff = 0;
+  for (int k = 0; k<20; k++)
+  {
+    double e = 1e-4*pow(10.0,0.15*k);
+    double N_ref = reference_mean_conc(e, Nuclide, Muon_scaling,
+                           prod_uncert_factor, NoDataValue, production_scaling,
+                           topographic_shielding, snow_shield_eff_depth, self_shield_eff_depth);
+    double N_kernel = ConcKernel.mean_concentration(e);
+    max_conc_diff = max(max_conc_diff, fabs(N_kernel-N_ref)/N_ref);
+  }
+
+  // the concentrations of the pixels
+  vector<double> concentrations;
+  start = wall_time();
+  ConcKernel.pixel_concentrations(eff_e_kernel, concentrations);
+  double pixel_time = wall_time()-start;
+
+  cout << "pixels\tnuclide\treference_s\treference_iterations\tkernel_prep_s\tkernel_total_s\tkernel_iterations\tpixel_concs_s" << endl;
+  cout << ConcKernel.get_NPixels() << "\t" << Nuclide << "\t" << ref_time << "\t" << ref_iterations
+       << "\t" << prep_time << "\t" << kernel_time << "\t" << kernel_iterations
+       << "\t" << pixel_time << endl << endl;
+  cout << "true erosion rate: " << true_erate << " reference: " << eff_e_ref
+       << " kernel: " << eff_e_kernel << endl;
+  cout << "relative difference of the erosion rates: " << fabs(eff_e_kernel-eff_e_ref)/eff_e_ref << endl;
+  cout << "max relative difference of the concentrations: " << max_conc_diff << endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,288 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// dinf_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the D-infinity flow area, which is accumulated in one
+// pass over the cells in topological order, serially and with the drainage
+// basins in parallel, against a reference that accumulates recursively from
+// the cells with no inflowing neighbours, which is how the area was computed
+// before. It reports the largest relative difference from the reference.
+//
+// The DEM is synthetic and filled, so the benchmark can be run anywhere. The
+// arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reference accumulation. This is the recursive routine that was used in
+// LSDRaster::D_inf_FlowArea
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void reference_accum(int i, int j, Array2D<float>& CountGrid, Array2D<float>& Flowarea,
+                     Array2D<float>& FlowDir, float NoDataValue)
+{
+  float flowAccumVal = Flowarea[i][j];
+  float flowDir = FlowDir[i][j];
+  float FD_Low[] = {0, 45, 90, 135, 180, 225, 270, 315};
+  float FD_High_361[] = {45, 90, 135, 180, 225, 270, 315, 361};
+  float FD_High[] = {45, 90, 135, 180, 225, 270, 315, 360};
+  int Di1[] = {-1, -1, 0, 1, 1, 1, 0, -1};
+  int Dj1[] = {0, 1, 1, 1, 0, -1, -1, -1};
+  int Di2[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+  int Dj2[] = {1, 1, 1, 0, -1, -1, -1, 0};
+  float proportion1 = 0;
+  float proportion2 = 0;
+  int a1 = 0, b1 = 0, a2 = 0, b2 = 0;
+
+  CountGrid[i][j] = -1;
+  if (flowDir >= 0)
+  {
+    for (int q = 0; q < 8; ++q)
+    {
+      if (flowDir >= FD_Low[q] && flowDir < FD_High_361[q])
+      {
+        proportion1 = (FD_High[q] - flowDir) / 45;
+        a1 = i + Di1[q];
+        b1 = j + Dj1[q];
+        proportion2 = (flowDir - FD_Low[q]) / 45;
+        a2 = i + Di2[q];
+        b2 = j + Dj2[q];
+      }
+    }
+    if (proportion1 > 0 && Flowarea[a1][b1] != NoDataValue)
+    {
+      Flowarea[a1][b1] += flowAccumVal * proportion1;
+      CountGrid[a1][b1] -= 1;
+      if (CountGrid[a1][b1] == 0)
+      {
+        reference_accum(a1, b1, CountGrid, Flowarea, FlowDir, NoDataValue);
+      }
+    }
+    if (proportion2 > 0 && Flowarea[a2][b2] != NoDataValue)
+    {
+      Flowarea[a2][b2] += flowAccumVal * proportion2;
+      CountGrid[a2][b2] -= 1;
+      if (CountGrid[a2][b2] == 0)
+      {
+        reference_accum(a2, b2, CountGrid, Flowarea, FlowDir, NoDataValue);
+      }
+    }
+  }
+}
+
+Array2D<float> reference_flow_area(Array2D<float>& FlowDir, float NoDataValue)
+{
+  int NRows = FlowDir.dim1();
+  int NCols = FlowDir.dim2();
+  int dX[] = {1, 1, 1, 0, -1, -1, -1, 0};
+  int dY[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+  float startFD[] = {180, 225, 270, 315, 0, 45, 90, 135};
+  float endFD[] = {270, 315, 360, 45, 90, 135, 180, 225};
+
+  Array2D<float> Flowarea(NRows,NCols,1);
+  Array2D<float> CountGrid(NRows,NCols,NoDataValue);
+  for (int i = 0; i < NRows; ++i)
+  {
+    for (int j = 0; j < NCols; ++j)
+    {
+      if (FlowDir[i][j] != NoDataValue)
+      {
+        int inflow_neighbours = 0;
+        for (int c = 0; c < 8; ++c)
+        {
+          float flowDir = FlowDir[i + dY[c]][j + dX[c]];
+          if (flowDir >= 0 && flowDir <= 360)
+          {
+            if (c != 3)
+            {
+              if (flowDir > startFD[c] && flowDir < endFD[c]) ++inflow_neighbours;
+            }
+            else
+            {
+              if (flowDir > startFD[c] || flowDir < endFD[c]) ++inflow_neighbours;
+            }
+          }
+        }
+        CountGrid[i][j] = inflow_neighbours;
+      }
+      else
+      {
+        Flowarea[i][j] = NoDataValue;
+      }
+    }
+  }
+  for (int i = 0; i < NRows; ++i)
+  {
+    for (int j = 0; j < NCols; ++j)
+    {
+      if (CountGrid[i][j] == 0)
+      {
+        reference_accum(i, j, CountGrid, Flowarea, FlowDir, NoDataValue);
+      }
+    }
+  }
+  return Flowarea;
+}
+
+// the largest difference relative to the reference
+float max_relative_difference(LSDRaster& A, Array2D<float>& ref, float NoDataValue)
+{
+  float max_diff = 0;
+  for (int row = 0; row<ref.dim1(); row++)
+  {
+    for (int col = 0; col<ref.dim2(); col++)
+    {
+      float a = A.get_data_element(row,col);
+      float b = ref[row][col];
+      if ((a == NoDataValue) != (b == NoDataValue))
+      {
+        return -1;
+      }
+      if (b != NoDataValue)
+      {
+        max_diff = max(max_diff, float(fabs(a-b)/b));
+      }
+    }
+  }
+  return max_diff;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=3)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the D-infinity benchmark!                ||" << endl;
+    cout << "|| This times the D-infinity flow area against the     ||" << endl;
+    cout << "|| recursive accumulation it replaced.                 ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires two inputs: " << endl;
+    cout << "* The number of rows, e.g. 2000." << endl;
+    cout << "* The number of columns, e.g. 2000." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // a rough synthetic surface with some nodata holes in it, then filled
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.05*row+0.02*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+      if (rand()%20000 == 0)
+      {
+        zeta[row][col] = NoDataValue;
+      }
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+  float MinSlope = 0.0001;
+  LSDRaster Filled = Topo.fill(MinSlope);
+  Array2D<float> FlowDir = Filled.D_inf_FlowDir();
+
+  double start = wall_time();
+  Array2D<float> reference = reference_flow_area(FlowDir,NoDataValue);
+  double reference_time = wall_time()-start;
+
+  start = wall_time();
+  LSDRaster Serial = Filled.D_inf_FlowArea(FlowDir,false);
+  double serial_time = wall_time()-start;
+
+  start = wall_time();
+  LSDRaster ByBasin = Filled.D_inf_FlowArea(FlowDir,true);
+  double basin_time = wall_time()-start;
+
+  int n_threads = 1;
+  #ifdef _OPENMP
+  n_threads = omp_get_max_threads();
+  #endif
+
+  cout << "threads\treference_s\tserial_s\tby_basin_s" << endl;
+  cout << n_threads << "\t" << reference_time << "\t" << serial_time << "\t"
+       << basin_time << endl << endl;
+  cout << "max relative difference from the reference (-1 if the nodata differs)" << endl;
+  cout << "serial\t" << max_relative_difference(Serial,reference,NoDataValue) << endl;
+  cout << "by_basin\t" << max_relative_difference(ByBasin,reference,NoDataValue) << endl;
+
+  float max_serial_basin = 0;
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      max_serial_basin = max(max_serial_basin, float(fabs(Serial.get_data_element(row,col)
+                                                     -ByBasin.get_data_element(row,col))));
+    }
+  }
+  cout << "largest difference between serial and by_basin: " << max_serial_basin << endl;
+
+  return EXIT_SUCCESS;
+}
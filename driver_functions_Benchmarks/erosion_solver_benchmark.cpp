@@ -0,0 +1,406 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// erosion_solver_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the search for basinwide erosion rates with
+// LSDCRNErosionSolver, which uses the derivative of the concentration from
+// LSDCRNConcentrationKernel and advances many searches together.
+//
+// It reports:
+//  * for a nested basin (a quarter of the pixels have a known erosion rate),
+//    the reference: the pixel by pixel loop of
+//    LSDCosmoBasin::predict_mean_CRN_conc_with_snow_and_self_nested called
+//    twice on every Newton-Raphson iteration, against the nested kernel
+//    (prepared once) and the solver
+//  * for many basins, each with the seven uncertainty inversions of
+//    full_CRN_erosion_analysis, Newton-Raphson with a displaced erosion rate
+//    one inversion at a time against the solver doing all of them together
+//  * the same from first guesses far from the roots
+//
+// The basins are synthetic, so the benchmark can be run anywhere. The
+// arguments are:
+//  1) the number of pixels in each basin
+//  2) the number of basins
+//  3) the nuclide, Be10 or Al26
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDCRNParameters.hpp"
+#include "../LSDParticle.hpp"
+#include "../LSDCRNKernel.hpp"
+using namespace std;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// the pixel by pixel loop of predict_mean_CRN_conc_with_snow_and_self_nested
+double reference_mean_conc_nested(double eff_erosion_rate, string Nuclide, double NoDataValue,
+                           vector<double>& production_scaling,
+                           vector<double>& topographic_shielding,
+                           vector<double>& snow_shield_eff_depth,
+                           vector<double>& self_shield_eff_depth,
+                           vector<double>& known_eff_erosion)
+{
+  double Total_N = 0;
+  double Total_Mass = 0;
+  LSDCRNParticle eroded_particle(0, 0, 0, 0.0, 0.0, 0.0);
+  LSDCRNParameters LSDCRNP;
+  vector<bool> nuclide_scaling_switches(4,false);
+  if (Nuclide == "Be10")
+  {
+    nuclide_scaling_switches[0] = true;
+  }
+  else
+  {
+    nuclide_scaling_switches[1] = true;
+  }
+
+  for (int q = 0; q < int(topographic_shielding.size()); ++q)
+  {
+    if(topographic_shielding[q] != NoDataValue)
+    {
+      LSDCRNP.set_Braucher_parameters();
+      double total_shielding = production_scaling[q]*topographic_shielding[q];
+      LSDCRNP.scale_F_values(total_shielding,nuclide_scaling_switches);
+
+      double this_top_eff_depth = snow_shield_eff_depth[q];
+      double this_bottom_eff_depth = this_top_eff_depth+self_shield_eff_depth[q];
+      double this_erosion_rate = (known_eff_erosion[q] != NoDataValue) ?
+                                  known_eff_erosion[q] : eff_erosion_rate;
+      if (Nuclide == "Be10")
+      {
+        eroded_particle.update_10Be_SSfull_depth_integrated(this_erosion_rate,LSDCRNP,
+                                           this_top_eff_depth, this_bottom_eff_depth);
+        Total_N+=this_erosion_rate*eroded_particle.getConc_10Be();
+      }
+      else
+      {
+        eroded_particle.update_26Al_SSfull_depth_integrated(this_erosion_rate,LSDCRNP,
+                                           this_top_eff_depth, this_bottom_eff_depth);
+        Total_N+=this_erosion_rate*eroded_particle.getConc_26Al();
+      }
+      Total_Mass+=this_erosion_rate;
+    }
+  }
+  return Total_N/Total_Mass;
+}
+
+// Newton-Raphson with a displaced erosion rate, as in predict_CRN_erosion
+// before the solver. Gives up after max_steps.
+double displaced_newton(const LSDCRNConcentrationKernel& ConcKernel, double Nuclide_conc,
+                        double eff_e_guess, int max_steps, int& n_evaluations)
+{
+  double tolerance = 1e-10;
+  double eff_e_displace = 1e-6;
+  double eff_e = eff_e_guess;
+  double eff_e_change;
+  int n_steps = 0;
+  do
+  {
+    double f_x = ConcKernel.mean_concentration(eff_e)-Nuclide_conc;
+    double f_x_displace = ConcKernel.mean_concentration(eff_e+eff_e_displace)-Nuclide_conc;
+    n_evaluations += 2;
+    double N_derivative = (f_x_displace-f_x)/eff_e_displace;
+    eff_e_change = (N_derivative != 0) ? f_x/N_derivative : 0;
+    eff_e -= eff_e_change;
+    n_steps++;
+  } while(fabs(eff_e_change) > tolerance && n_steps < max_steps);
+  return eff_e;
+}
+
+// a synthetic basin, with a few nodata pixels
+void make_basin(int NPixels, string Nuclide, double NoDataValue,
+                vector<double>& production_scaling,
+                vector<double>& topographic_shielding,
+                vector<double>& snow_shield_eff_depth,
+                vector<double>& self_shield_eff_depth)
+{
+  production_scaling.resize(NPixels);
+  topographic_shielding.resize(NPixels);
+  snow_shield_eff_depth.resize(NPixels);
+  self_shield_eff_depth.resize(NPixels);
+  double base_scaling = 1+6*double(rand())/double(RAND_MAX);
+  for (int q = 0; q<NPixels; q++)
+  {
+    production_scaling[q] = base_scaling*(0.7+0.6*double(rand())/double(RAND_MAX));
+    topographic_shielding[q] = (q % 997 == 0) ? NoDataValue
+                               : 0.8+0.2*double(rand())/double(RAND_MAX);
+    snow_shield_eff_depth[q] = (q % 3 == 0) ? 0 : 20*double(rand())/double(RAND_MAX);
+    // update_26Al_SSfull prints every pixel, so only 10Be has pixels with
+    // no self shielding
+    self_shield_eff_depth[q] = (q % 5 == 0 && Nuclide == "Be10") ? 0
+                               : 1+100*double(rand())/double(RAND_MAX);
+  }
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the erosion solver benchmark!            ||" << endl;
+    cout << "|| This times the search for basinwide erosion rates.  ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of pixels in each basin, e.g. 20000." << endl;
+    cout << "* The number of basins, e.g. 100." << endl;
+    cout << "* The nuclide, Be10 or Al26." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NPixels = atoi(argv[1]);
+  int NBasins = atoi(argv[2]);
+  string Nuclide = argv[3];
+  double NoDataValue = -9999;
+  double tolerance = 1e-10;
+  srand(1);
+
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  // a nested basin
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  vector<double> production_scaling, topographic_shielding;
+  vector<double> snow_shield_eff_depth, self_shield_eff_depth;
+  make_basin(NPixels, Nuclide, NoDataValue, production_scaling, topographic_shielding,
+             snow_shield_eff_depth, self_shield_eff_depth);
+  vector<double> known_eff_erosion(NPixels, NoDataValue);
+  for (int q = 0; q<NPixels/4; q++)
+  {
+    known_eff_erosion[q] = 0.001+0.01*double(rand())/double(RAND_MAX);
+  }
+  double true_erate = 0.003;
+  double Nuclide_conc = reference_mean_conc_nested(true_erate, Nuclide, NoDataValue,
+                           production_scaling, topographic_shielding,
+                           snow_shield_eff_depth, self_shield_eff_depth, known_eff_erosion);
+  double eff_e_guess = 0.001;
+
+  // the reference
+  double start = wall_time();
+  double eff_e_ref = eff_e_guess;
+  double eff_e_change;
+  double eff_e_displace = 1e-6;
+  int ref_passes = 0;
+  do
+  {
+    double f_x = reference_mean_conc_nested(eff_e_ref, Nuclide, NoDataValue,
+                           production_scaling, topographic_shielding,
+                           snow_shield_eff_depth, self_shield_eff_depth,
+                           known_eff_erosion)-Nuclide_conc;
+    double f_x_displace = reference_mean_conc_nested(eff_e_ref+eff_e_displace, Nuclide,
+                           NoDataValue, production_scaling, topographic_shielding,
+                           snow_shield_eff_depth, self_shield_eff_depth,
+                           known_eff_erosion)-Nuclide_conc;
+    ref_passes += 2;
+    double N_derivative = (f_x_displace-f_x)/eff_e_displace;
+    eff_e_change = (N_derivative != 0) ? f_x/N_derivative : 0;
+    eff_e_ref -= eff_e_change;
+  } while(fabs(eff_e_change) > tolerance);
+  double ref_time = wall_time()-start;
+
+  // the nested kernel and the solver
+  start = wall_time();
+  LSDCRNConcentrationKernel NestedKernel(production_scaling, topographic_shielding,
+                                       snow_shield_eff_depth, self_shield_eff_depth,
+                                       known_eff_erosion, NoDataValue, Nuclide, "Braucher",
+                                       1.0, false, false);
+  vector<const LSDCRNConcentrationKernel*> nested_kernels(1,&NestedKernel);
+  vector<double> nested_conc(1,Nuclide_conc);
+  vector<double> nested_erate(1,eff_e_guess);
+  LSDCRNErosionSolver ErosionSolver;
+  int nested_steps = ErosionSolver.solve(nested_kernels, nested_conc, nested_erate);
+  double nested_time = wall_time()-start;
+
+  // the nested concentrations and derivatives over a range of erosion rates
+  double max_conc_diff = 0;
+  double max_deriv_diff = 0;
+  for (int k = 0; k<20; k++)
+  {
+    double e = 1e-4*pow(10.0,0.15*k);
+    double N_ref = reference_mean_conc_nested(e, Nuclide, NoDataValue,
+                           production_scaling, topographic_shielding,
+                           snow_shield_eff_depth, self_shield_eff_depth, known_eff_erosion);
+    double dN_de;
+    double N_kernel = NestedKernel.mean_concentration(e, dN_de);
+    max_conc_diff = max(max_conc_diff, fabs(N_kernel-N_ref)/N_ref);
+    double de = 1e-4*e;
+    double dN_de_numerical = (NestedKernel.mean_concentration(e+de)-
+                              NestedKernel.mean_concentration(e-de))/(2*de);
+    max_deriv_diff = max(max_deriv_diff, fabs(dN_de-dN_de_numerical)/fabs(dN_de_numerical));
+  }
+
+  cout << "Nested basin, " << NestedKernel.get_NPixels() << " pixels, "
+       << NestedKernel.get_NUnknown() << " with unknown erosion rates:" << endl;
+  cout << "  reference: " << ref_time << " s, " << ref_passes << " passes over the basin, erosion rate "
+       << eff_e_ref << endl;
+  cout << "  kernel and solver: " << nested_time << " s, 1 pass over the basin, "
+       << nested_steps << " steps, erosion rate " << nested_erate[0] << endl;
+  cout << "  relative difference of the erosion rates: "
+       << fabs(nested_erate[0]-eff_e_ref)/eff_e_ref << endl;
+  cout << "  max relative difference of the concentrations: " << max_conc_diff << endl;
+  cout << "  max relative difference of the derivative from a central difference: "
+       << max_deriv_diff << endl;
+
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  // many basins, each with the seven uncertainty inversions
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  const int n_inversions = 7;
+  double inversion_prod_uncert_factor[n_inversions] = {1.1, 1, 1, 1, 1, 1, 1};
+  string inversion_muon_scaling[n_inversions] = {"Braucher", "Braucher", "Braucher",
+                                         "Schaller", "Braucher", "Schaller", "Schaller"};
+  bool inversion_plus_on[n_inversions] = {false,false,false,false,false,true,false};
+  bool inversion_minus_on[n_inversions] = {false,false,false,false,false,false,true};
+
+  int NVariants = NBasins*n_inversions;
+  vector<LSDCRNConcentrationKernel> ConcKernels(NVariants);
+  vector<double> variant_conc(NVariants);
+  vector<double> variant_guess(NVariants);
+  start = wall_time();
+  for (int b = 0; b<NBasins; b++)
+  {
+    make_basin(NPixels, Nuclide, NoDataValue, production_scaling, topographic_shielding,
+               snow_shield_eff_depth, self_shield_eff_depth);
+    double basin_erate = 1e-4*pow(10.0, 3.0*double(rand())/double(RAND_MAX));
+    for (int inv = 0; inv<n_inversions; inv++)
+    {
+      int v = b*n_inversions+inv;
+      ConcKernels[v] = LSDCRNConcentrationKernel(production_scaling, topographic_shielding,
+                                       snow_shield_eff_depth, self_shield_eff_depth,
+                                       NoDataValue, Nuclide, inversion_muon_scaling[inv],
+                                       inversion_prod_uncert_factor[inv],
+                                       inversion_plus_on[inv], inversion_minus_on[inv]);
+      double conc_error = (inv == 1) ? 1.05 : ((inv == 2) ? 0.95 : 1.0);
+      variant_conc[v] = conc_error*ConcKernels[v].mean_concentration(basin_erate);
+      // a neutron only guess is below the root
+      variant_guess[v] = 0.5*basin_erate;
+    }
+  }
+  double prep_time = wall_time()-start;
+  vector<const LSDCRNConcentrationKernel*> kernels(NVariants);
+  for (int v = 0; v<NVariants; v++)
+  {
+    kernels[v] = &ConcKernels[v];
+  }
+
+  // guesses below the roots, and far from them on either side
+  double guess_factor[3] = {1.0, 0.01, 50.0};
+  string guess_name[3] = {"guesses below the roots", "guesses 100 times too low",
+                          "guesses 25 times too high"};
+  int NRepeats = max(1, 100000/NVariants);
+  for (int g = 0; g<3; g++)
+  {
+    vector<double> guess(NVariants);
+    for (int v = 0; v<NVariants; v++)
+    {
+      guess[v] = guess_factor[g]*variant_guess[v];
+    }
+
+    // one at a time with a displaced erosion rate
+    vector<double> erate_displaced(NVariants);
+    int n_evaluations = 0;
+    start = wall_time();
+    for (int r = 0; r<NRepeats; r++)
+    {
+      n_evaluations = 0;
+      for (int v = 0; v<NVariants; v++)
+      {
+        erate_displaced[v] = displaced_newton(ConcKernels[v], variant_conc[v], guess[v],
+                                              200, n_evaluations);
+      }
+    }
+    double displaced_time = (wall_time()-start)/double(NRepeats);
+
+    // all together with the solver
+    vector<double> erate_solver;
+    int n_steps = 0;
+    start = wall_time();
+    for (int r = 0; r<NRepeats; r++)
+    {
+      erate_solver = guess;
+      n_steps = ErosionSolver.solve(kernels, variant_conc, erate_solver);
+    }
+    double solver_time = (wall_time()-start)/double(NRepeats);
+
+    // the residuals of the concentrations
+    double max_residual_displaced = 0;
+    double max_residual_solver = 0;
+    int n_failed_displaced = 0;
+    for (int v = 0; v<NVariants; v++)
+    {
+      double residual = fabs(ConcKernels[v].mean_concentration(erate_displaced[v])-variant_conc[v])
+                        /variant_conc[v];
+      if (!(residual < 1e-6) || erate_displaced[v] <= 0)
+      {
+        n_failed_displaced++;
+      }
+      else
+      {
+        max_residual_displaced = max(max_residual_displaced, residual);
+      }
+      max_residual_solver = max(max_residual_solver,
+                 fabs(ConcKernels[v].mean_concentration(erate_solver[v])-variant_conc[v])
+                 /variant_conc[v]);
+    }
+
+    cout << NBasins << " basins of " << NPixels << " pixels, " << NVariants
+         << " inversions (kernels prepared in " << prep_time << " s), " << guess_name[g] << ":" << endl;
+    cout << "  displaced, one at a time: " << displaced_time << " s, "
+         << n_evaluations << " concentrations, largest relative residual "
+         << max_residual_displaced << ", " << n_failed_displaced << " failed" << endl;
+    cout << "  solver, together:         " << solver_time << " s, "
+         << n_steps << " steps, largest relative residual " << max_residual_solver << endl;
+  }
+
+  return EXIT_SUCCESS;
+}
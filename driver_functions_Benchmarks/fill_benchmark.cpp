@@ -0,0 +1,139 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// fill_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the serial priority flood fill against the tiled
+// parallel fill and checks that the two filled surfaces are identical.
+//
+// The arguments are:
+//  1) the path to the DEM (with a slash at the end)
+//  2) the name of the DEM without extension
+//  3) the extension of the DEM (bil, flt or asc)
+//  4) the minimum slope for fill
+//  5) the tile size for the parallel fill
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDStatsTools.hpp"
+using namespace std;
+
+// wall clock time in seconds. clock() adds up the time of all threads
+// so it cannot be used to time the parallel code
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=6)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the fill benchmark!                      ||" << endl;
+    cout << "|| This compares the serial and parallel fill routines.||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires five inputs: " << endl;
+    cout << "* The path to the DEM, with a slash at the end." << endl;
+    cout << "* The name of the DEM without extension." << endl;
+    cout << "* The extension of the DEM (bil, flt or asc)." << endl;
+    cout << "* The minimum slope for fill, e.g. 0.0001." << endl;
+    cout << "* The tile size of the parallel fill, e.g. 512." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  string path_name = FixPath(argv[1]);
+  string DEM_name = argv[2];
+  string DEM_ext = argv[3];
+  float MinSlope = atof(argv[4]);
+  int TileSize = atoi(argv[5]);
+
+  LSDRaster topography_raster(path_name+DEM_name, DEM_ext);
+  int NRows = topography_raster.get_NRows();
+  int NCols = topography_raster.get_NCols();
+  cout << "Loaded DEM with " << NRows << " rows and " << NCols << " columns" << endl;
+  #ifdef _OPENMP
+  cout << "Running with up to " << omp_get_max_threads() << " threads" << endl;
+  #endif
+
+  double start = wall_time();
+  LSDRaster serial_fill = topography_raster.fill(MinSlope);
+  double serial_time = wall_time()-start;
+
+  start = wall_time();
+  LSDRaster parallel_fill = topography_raster.fill_parallel(MinSlope,TileSize);
+  double parallel_time = wall_time()-start;
+
+  int n_mismatch = 0;
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      if (serial_fill.get_data_element(row,col) != parallel_fill.get_data_element(row,col))
+      {
+        n_mismatch++;
+      }
+    }
+  }
+
+  cout << "Serial fill took:   " << serial_time << " s" << endl;
+  cout << "Parallel fill took: " << parallel_time << " s" << endl;
+  cout << "Speedup:            " << serial_time/parallel_time << endl;
+  cout << "Mismatched nodes:   " << n_mismatch << endl;
+
+  if (n_mismatch != 0)
+  {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,304 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// flow_stack_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program checks the stack that LSDFlowInfo builds without recursion
+// (add_to_stack_iterative) against the recursive Braun and Willett (2012) build.
+//
+// First a small synthetic DEM is routed. Its DeltaVector and DonorStackVector
+// are rebuilt here from the receivers, and its SVector and BLBasinVector are
+// rebuilt by calling the recursive add_to_stack on a copy of the flow info.
+// All four vectors are compared with the ones LSDFlowInfo built.
+//
+// Then a synthetic DEM with a single outlet is routed. A channel snakes back
+// and forth between walls, so the longest flow path is about half of the
+// nodes. The recursive build would need one call per node on that path and
+// overflows the call stack, so this case is only built iteratively. The stack
+// is checked to hold every node once, with every receiver before its donors.
+//
+// The arguments are:
+//  1) the number of rows of the small DEM
+//  2) the number of columns of the small DEM
+//  3) the number of rows and columns of the single outlet DEM, e.g. 3200 for
+//     just over 10^7 nodes
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDFlowInfo.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// the number of places where two vectors differ, or -1 if their sizes differ
+int count_differences(const vector<int>& A, const vector<int>& B)
+{
+  if (A.size() != B.size())
+  {
+    return -1;
+  }
+  int n_diff = 0;
+  for (size_t i = 0; i<A.size(); i++)
+  {
+    if (A[i] != B[i])
+    {
+      n_diff++;
+    }
+  }
+  return n_diff;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the flow stack benchmark!                ||" << endl;
+    cout << "|| This checks the stack built without recursion.      ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of rows of the small DEM, e.g. 300." << endl;
+    cout << "* The number of columns of the small DEM, e.g. 400." << endl;
+    cout << "* The size of the single outlet DEM, e.g. 3200." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  int NSnake = atoi(argv[3]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+  bool all_match = true;
+
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  // The small DEM: iterative against recursive
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  // a rough synthetic surface, filled, draining to base level on two sides
+  // so there are many base level nodes
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.05*row+0.02*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+  float MinSlope = 0.0001;
+  LSDRaster Filled = Topo.fill(MinSlope);
+  vector<string> BoundaryConditions(4,"n");
+  BoundaryConditions[0] = "b";
+  BoundaryConditions[3] = "b";
+
+  double start = wall_time();
+  LSDFlowInfo FlowInfo(BoundaryConditions,Filled);
+  double iterative_time = wall_time()-start;
+  int NDataNodes = FlowInfo.get_NDataNodes();
+  vector<int> BaseLevelNodeList = FlowInfo.get_BaseLevelNodeList();
+
+  // the delta vector and donor stack, from Braun and Willett eq. 5 to 9
+  vector<int> receivers(NDataNodes);
+  for (int node = 0; node<NDataNodes; node++)
+  {
+    FlowInfo.retrieve_receiver_information(node,receivers[node]);
+  }
+  vector<int> n_donors(NDataNodes,0);
+  for (int node = 0; node<NDataNodes; node++)
+  {
+    n_donors[receivers[node]]++;
+  }
+  vector<int> delta(NDataNodes+1);
+  delta[NDataNodes] = NDataNodes;
+  for (int node = NDataNodes; node>0; node--)
+  {
+    delta[node-1] = delta[node]-n_donors[node-1];
+  }
+  vector<int> donor_stack(NDataNodes);
+  vector<int> w(NDataNodes,0);
+  for (int node = 0; node<NDataNodes; node++)
+  {
+    donor_stack[delta[receivers[node]]+w[receivers[node]]] = node;
+    w[receivers[node]]++;
+  }
+  // the base level node comes first among its own donors
+  for (int i = 0; i<int(BaseLevelNodeList.size()); i++)
+  {
+    int k = BaseLevelNodeList[i];
+    for (int m = delta[k]; m<delta[k+1]; m++)
+    {
+      if (donor_stack[m] == k)
+      {
+        donor_stack[m] = donor_stack[delta[k]];
+        donor_stack[delta[k]] = k;
+      }
+    }
+  }
+
+  // the S vector and base level basins, rebuilt with the recursive routine on
+  // a copy so the iterative vectors are kept for comparison
+  LSDFlowInfo Recursive = FlowInfo;
+  start = wall_time();
+  int j_index = 0;
+  for (int i = 0; i<int(BaseLevelNodeList.size()); i++)
+  {
+    int k = BaseLevelNodeList[i];
+    for (int m = delta[k]; m<delta[k+1]; m++)
+    {
+      Recursive.add_to_stack(donor_stack[m], j_index, k);
+    }
+  }
+  double recursive_time = wall_time()-start;
+
+  int diff_delta = count_differences(FlowInfo.get_DeltaVector(), delta);
+  int diff_donors = count_differences(FlowInfo.get_donorStack(), donor_stack);
+  int diff_S = count_differences(FlowInfo.get_SVector(), Recursive.get_SVector());
+  int diff_BL = count_differences(FlowInfo.get_BLBasinVector(), Recursive.get_BLBasinVector());
+  all_match = (j_index == NDataNodes && diff_delta == 0 && diff_donors == 0 &&
+               diff_S == 0 && diff_BL == 0);
+
+  cout << "Small DEM: " << NDataNodes << " nodes, " << BaseLevelNodeList.size()
+       << " base level nodes" << endl;
+  cout << "  whole flow info build (iterative stack): " << iterative_time << " s" << endl;
+  cout << "  recursive stack on its own: " << recursive_time << " s" << endl;
+  cout << "  nodes that differ (-1 means the sizes differ):" << endl;
+  cout << "    DeltaVector: " << diff_delta << endl;
+  cout << "    DonorStackVector: " << diff_donors << endl;
+  cout << "    SVector: " << diff_S << endl;
+  cout << "    BLBasinVector: " << diff_BL << endl;
+
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  // The single outlet DEM, iterative only
+  //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+  // the even rows are channels and the odd rows are walls, with one gap at
+  // alternate ends. The elevation rises by one along the channel from the
+  // outlet at the first cell, so every node but the outlet has a lower
+  // neighbour. Elevations stay below 2^24 so they are exact as floats.
+  Array2D<float> snake(NSnake,NSnake);
+  float wall = 16000000;
+  float along_channel = 0;
+  for (int row = 0; row<NSnake; row++)
+  {
+    bool left_to_right = ((row/2)%2 == 0);
+    if (row%2 == 0)
+    {
+      for (int c = 0; c<NSnake; c++)
+      {
+        int col = (left_to_right) ? c : NSnake-1-c;
+        snake[row][col] = along_channel;
+        along_channel++;
+      }
+    }
+    else
+    {
+      for (int col = 0; col<NSnake; col++)
+      {
+        snake[row][col] = wall;
+      }
+      snake[row][(left_to_right) ? NSnake-1 : 0] = along_channel;
+      along_channel++;
+    }
+  }
+  LSDRaster SnakeRaster(NSnake,NSnake,0,0,DataResolution,NoDataValue,snake);
+  vector<string> ClosedBoundaries(4,"n");
+
+  start = wall_time();
+  LSDFlowInfo SnakeFlow(ClosedBoundaries,SnakeRaster);
+  double snake_time = wall_time()-start;
+
+  int NSnakeNodes = SnakeFlow.get_NDataNodes();
+  vector<int> SVector = SnakeFlow.get_SVector();
+  vector<int> BLBasin = SnakeFlow.get_BLBasinVector();
+  int n_outlets = int(SnakeFlow.get_BaseLevelNodeList().size());
+
+  // every node must appear once, after its receiver. The depth of a node is
+  // the number of calls the recursive routine would have needed to reach it
+  vector<int> position(NSnakeNodes,-1);
+  vector<int> depth(NSnakeNodes,0);
+  bool stack_ok = (int(SVector.size()) == NSnakeNodes);
+  int max_depth = 0;
+  for (int i = 0; i<int(SVector.size()) && stack_ok; i++)
+  {
+    int node = SVector[i];
+    int receiver;
+    SnakeFlow.retrieve_receiver_information(node,receiver);
+    if (node < 0 || node >= NSnakeNodes || position[node] != -1 ||
+        (receiver != node && position[receiver] == -1) || BLBasin[i] != SVector[0])
+    {
+      stack_ok = false;
+    }
+    else
+    {
+      position[node] = i;
+      depth[node] = (receiver == node) ? 1 : depth[receiver]+1;
+      max_depth = max(max_depth, depth[node]);
+    }
+  }
+  all_match = all_match && stack_ok && n_outlets == 1;
+
+  cout << endl << "Single outlet DEM: " << NSnakeNodes << " nodes, " << n_outlets
+       << " base level nodes" << endl;
+  cout << "  whole flow info build (iterative stack): " << snake_time << " s" << endl;
+  cout << "  longest flow path, i.e. recursion depth avoided: " << max_depth << " nodes" << endl;
+  cout << "  every node once, receivers before donors: " << ((stack_ok) ? "yes" : "no") << endl;
+
+  cout << endl << ((all_match) ? "PASSED" : "FAILED") << endl;
+  return (all_match) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
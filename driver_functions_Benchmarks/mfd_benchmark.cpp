@@ -0,0 +1,296 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// mfd_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the multiple flow direction routing, which builds an
+// LSDFlowGraph once and accumulates with a single pass over it, against a
+// reference that sorts the DEM and spreads the flow cell by cell, which is
+// how FreemanMDFlow and QuinnMDFlow worked before. It reports the largest
+// relative difference from the reference. It then times the accumulation of
+// a batch of weight rasters, together and one at a time.
+//
+// The DEM is synthetic and filled, so the benchmark can be run anywhere. The
+// arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//  3) the number of weight rasters in the batch
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDStatsTools.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reference routing. This is the sorted loop that was used in FreemanMDFlow
+// (exponent 1.1, quinn false) and QuinnMDFlow (exponent 1, quinn true)
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+Array2D<float> reference_mfd(Array2D<float>& RasterData, float NoDataValue,
+                             float DataResolution, float p, bool quinn)
+{
+  int NRows = RasterData.dim1();
+  int NCols = RasterData.dim2();
+  Array2D<float> area(NRows, NCols, NoDataValue);
+  vector<float> flat;
+  vector<float> sorted;
+  vector<size_t> index_map;
+  float one_ov_root_2 = 0.707106781187;
+  float Lc = quinn ? DataResolution/2 : 1;
+  float Ld = quinn ? DataResolution * 0.354 : 1;
+  int di[] = {-1, -1, -1, 0, 1, 1, 1, 0};
+  int dj[] = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+  for (int i = 0; i < NRows; ++i)
+  {
+    for (int j = 0; j < NCols; ++j)
+    {
+      flat.push_back(RasterData[i][j]);
+      if (RasterData[i][j] != NoDataValue)
+      {
+        area[i][j] = DataResolution*DataResolution;
+      }
+    }
+  }
+  matlab_float_sort_descending(flat, sorted, index_map);
+
+  for (int q = 0 ;q < int(flat.size()); ++q)
+  {
+    if (sorted[q] == NoDataValue)
+    {
+      continue;
+    }
+    int i = index_map[q] / NCols;
+    int j = index_map[q] % NCols;
+    if (i == 0 || j == 0 || i == NRows-1 || j == NCols-1)
+    {
+      continue;
+    }
+    float total = 0;
+    float slope[8];
+    for (int n = 0; n<8; ++n)
+    {
+      slope[n] = 0;
+      float zn = RasterData[i+di[n]][j+dj[n]];
+      if (RasterData[i][j] > zn && zn != NoDataValue)
+      {
+        bool diagonal = (di[n] != 0 && dj[n] != 0);
+        float drop = RasterData[i][j] - zn;
+        slope[n] = diagonal ? pow(drop*one_ov_root_2,p)*Ld : pow(drop,p)*Lc;
+        total += slope[n];
+      }
+    }
+    if (total == 0)
+    {
+      continue;
+    }
+    for (int n = 0; n<8; ++n)
+    {
+      area[i+di[n]][j+dj[n]] += area[i][j] * (slope[n]/total);
+    }
+  }
+  return area;
+}
+
+// the largest difference relative to the reference
+float max_relative_difference(LSDRaster& A, Array2D<float>& ref, float NoDataValue)
+{
+  float max_diff = 0;
+  for (int row = 0; row<ref.dim1(); row++)
+  {
+    for (int col = 0; col<ref.dim2(); col++)
+    {
+      float a = A.get_data_element(row,col);
+      float b = ref[row][col];
+      if ((a == NoDataValue) != (b == NoDataValue))
+      {
+        return -1;
+      }
+      if (b != NoDataValue)
+      {
+        max_diff = max(max_diff, float(fabs(a-b)/b));
+      }
+    }
+  }
+  return max_diff;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the multiple flow direction benchmark!   ||" << endl;
+    cout << "|| This times the flow graph routing against the       ||" << endl;
+    cout << "|| sorted routing it replaced.                         ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of rows, e.g. 2000." << endl;
+    cout << "* The number of columns, e.g. 2000." << endl;
+    cout << "* The number of weight rasters, e.g. 8." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  int NWeights = atoi(argv[3]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // a rough synthetic surface with some nodata holes in it, then filled
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.05*row+0.02*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+      if (rand()%20000 == 0)
+      {
+        zeta[row][col] = NoDataValue;
+      }
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+  float MinSlope = 0.0001;
+  LSDRaster Filled = Topo.fill(MinSlope);
+  Array2D<float> filled_data = Filled.get_RasterData();
+
+  cout << "method\treference_s\tgraph_s\tmax_rel_diff" << endl;
+  double start = wall_time();
+  Array2D<float> ref_freeman = reference_mfd(filled_data,NoDataValue,DataResolution,1.1,false);
+  double ref_time = wall_time()-start;
+  start = wall_time();
+  LSDRaster Freeman = Filled.FreemanMDFlow();
+  double graph_time = wall_time()-start;
+  cout << "Freeman\t" << ref_time << "\t" << graph_time << "\t"
+       << max_relative_difference(Freeman,ref_freeman,NoDataValue) << endl;
+
+  start = wall_time();
+  Array2D<float> ref_quinn = reference_mfd(filled_data,NoDataValue,DataResolution,1,true);
+  ref_time = wall_time()-start;
+  start = wall_time();
+  LSDRaster Quinn = Filled.QuinnMDFlow();
+  graph_time = wall_time()-start;
+  cout << "Quinn\t" << ref_time << "\t" << graph_time << "\t"
+       << max_relative_difference(Quinn,ref_quinn,NoDataValue) << endl;
+
+  start = wall_time();
+  Array2D<float> ref_holmgren = reference_mfd(filled_data,NoDataValue,DataResolution,5,false);
+  ref_time = wall_time()-start;
+  start = wall_time();
+  LSDRaster Holmgren = Filled.HolmgrenMDFlow(5);
+  graph_time = wall_time()-start;
+  cout << "Holmgren5\t" << ref_time << "\t" << graph_time << "\t"
+       << max_relative_difference(Holmgren,ref_holmgren,NoDataValue) << endl << endl;
+
+  // a batch of weight rasters, e.g. precipitation scenarios
+  vector<LSDRaster> Weights;
+  for (int w = 0; w<NWeights; w++)
+  {
+    Array2D<float> weight(NRows,NCols);
+    for (int row = 0; row<NRows; row++)
+    {
+      for (int col = 0; col<NCols; col++)
+      {
+        weight[row][col] = DataResolution*DataResolution*(1+0.1*w+0.001*row);
+      }
+    }
+    Weights.push_back(LSDRaster(NRows,NCols,0,0,DataResolution,NoDataValue,weight));
+  }
+
+  start = wall_time();
+  LSDFlowGraph Graph = Filled.MFD_FlowGraph(1.1,false);
+  double build_time = wall_time()-start;
+
+  start = wall_time();
+  vector<LSDRaster> Batch = Filled.MFD_accumulate(Graph,Weights,false);
+  double batch_time = wall_time()-start;
+
+  start = wall_time();
+  vector<LSDRaster> Singles;
+  for (int w = 0; w<NWeights; w++)
+  {
+    vector<LSDRaster> One(1,Weights[w]);
+    vector<LSDRaster> Single = Filled.MFD_accumulate(Graph,One,false);
+    Singles.push_back(Single[0]);
+  }
+  double one_at_a_time = wall_time()-start;
+
+  float max_diff = 0;
+  for (int w = 0; w<NWeights; w++)
+  {
+    for (int row = 0; row<NRows; row++)
+    {
+      for (int col = 0; col<NCols; col++)
+      {
+        max_diff = max(max_diff, float(fabs(Singles[w].get_data_element(row,col)
+                                            -Batch[w].get_data_element(row,col))));
+      }
+    }
+  }
+
+  cout << "weights\tgraph_build_s\tbatch_s\tone_at_a_time_s\tmax_diff" << endl;
+  cout << NWeights << "\t" << build_time << "\t" << batch_time << "\t"
+       << one_at_a_time << "\t" << max_diff << endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,258 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// muon_table_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program compares the CRONUS muon production from the muon lookup table
+// (LSDCRNMuonTable) with the reference, which integrates the muon flux with
+// integrate_muon_flux at every depth (P_mu_total).
+//
+// It reports:
+//  * the time to build the table, and to read it back from a file
+//  * the error of the table flux against an accurate integral, which should
+//    be below the error the table was built to
+//  * the largest difference of the four muon production rates from the
+//    reference at random depths and pressures, and the time per call
+//  * the same for the production profiles of the CRONUS erosion rate
+//    calculation (get_CRONUS_P_mu_vectors) and the muogenic concentrations
+//    integrated from them over a range of erosion rates
+//
+// The arguments are:
+//  1) the tolerance of the table, e.g. 1e-6
+//  2) the number of random depths and pressures, e.g. 100
+//  3) the file to keep the table in, e.g. muon_table.bin
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDCRNParameters.hpp"
+#include "../LSDCRNMuonTable.hpp"
+#include "../LSDStatsTools.hpp"
+using namespace std;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// the largest relative difference between two sets of production rates
+double max_relative_difference(vector<double>& test, vector<double>& reference)
+{
+  double max_diff = 0;
+  for (int i = 0; i<int(reference.size()); i++)
+  {
+    max_diff = max(max_diff, fabs(test[i]-reference[i])/fabs(reference[i]));
+  }
+  return max_diff;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the muon table benchmark!                ||" << endl;
+    cout << "|| This compares the CRONUS muon production from the   ||" << endl;
+    cout << "|| lookup table with the integrated reference.         ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The tolerance of the table, e.g. 1e-6." << endl;
+    cout << "* The number of random depths and pressures, e.g. 100." << endl;
+    cout << "* The file to keep the table in, e.g. muon_table.bin." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  double tolerance = atof(argv[1]);
+  int NPoints = atoi(argv[2]);
+  string table_fname = argv[3];
+
+  LSDCRNParameters LSDCRNP;
+  LSDCRNP.set_CRONUS_data_maps();
+
+  // build the table
+  double t0 = wall_time();
+  LSDCRNMuonTable table;
+  LSDCRNP.build_CRONUS_muon_table(tolerance, table);
+  double t_build = wall_time()-t0;
+  cout << "Table: " << table.get_NDepths() << " depths by " << table.get_NPressures()
+       << " pressures, built in " << t_build << " s, relative error "
+       << table.get_max_error() << " (tolerance " << tolerance << ")" << endl;
+
+  // write it and read it back
+  remove(table_fname.c_str());
+  table.write(table_fname);
+  t0 = wall_time();
+  LSDCRNMuonTable read_table;
+  bool read_ok = read_table.read(table_fname);
+  double t_read = wall_time()-t0;
+  cout << "Read back from " << table_fname << " in " << t_read << " s"
+       << (read_ok ? "" : " FAILED") << endl;
+
+  // random depths, spread evenly in log depth, and pressures from sea level
+  // to about 5500 m
+  long seed = -23;
+  vector<double> z(NPoints), h(NPoints);
+  for (int i = 0; i<NPoints; i++)
+  {
+    z[i] = exp(log(2.0e5+1.0)*double(ran3(&seed)))-1.0;
+    h[i] = 500.0+513.25*double(ran3(&seed));
+  }
+
+  // the table flux against an accurate integral: each point on its own,
+  // split at the deeper depths of the table (which are where the stopping
+  // rate has kinks) and with many panels
+  // The reference (integrate_muon_flux, as called in P_mu_total) is compared
+  // with the accurate integral as well
+  double a = 258.5*(pow(100,2.66));
+  double b = 75*(pow(100,1.66));
+  double phi_200k = (a/((2.0e5+21000.0)*((pow((2.0e5+1000.0),1.66)) + b)))
+                      *exp(-5.5e-6 * 2.0e5);
+  double max_flux_error = 0;
+  double max_reference_flux_error = 0;
+  for (int i = 0; i<NPoints; i++)
+  {
+    vector<double> this_z(1,z[i]);
+    for (int k = 0; k<read_table.get_NDepths(); k++)
+    {
+      if (read_table.get_depth(k) > z[i])
+      {
+        this_z.push_back(read_table.get_depth(k));
+      }
+    }
+    vector<double> this_h(1,h[i]);
+    vector< vector<double> > phi;
+    LSDCRNP.integrate_muon_flux_on_grid(this_z, this_h, 64, phi);
+    double flux = read_table.phi_vert_site(z[i],h[i]);
+    max_flux_error = max(max_flux_error, fabs(flux-phi[0][0])/phi[0][0]);
+
+    double H = (1013.25 - h[i])*1.019716;
+    double phi_vert_slhl = (a/((z[i]+21000.0)*((pow((z[i]+1000),1.66)) + b)))
+                              *exp(-5.5e-6* z[i]);
+    double reference_flux = LSDCRNP.integrate_muon_flux(z[i], H, phi_vert_slhl*1e-4)
+                            + phi_200k;
+    max_reference_flux_error = max(max_reference_flux_error,
+                                   fabs(reference_flux-phi[0][0])/phi[0][0]);
+  }
+  cout << "Largest relative error of the flux against an accurate integral:" << endl
+       << "  table:                   " << max_flux_error << endl
+       << "  reference (integrated):  " << max_reference_flux_error << endl;
+
+  // the production rates: the reference
+  vector<double> P_reference, P_table;
+  t0 = wall_time();
+  for (int i = 0; i<NPoints; i++)
+  {
+    vector<double> P = LSDCRNP.calculate_muon_production_CRONUS(z[i],h[i]);
+    P_reference.insert(P_reference.end(), P.begin(), P.end());
+  }
+  double t_reference = wall_time()-t0;
+
+  // and the table, which is read from the file
+  t0 = wall_time();
+  LSDCRNP.set_CRONUS_muon_table(tolerance, table_fname);
+  double t_set = wall_time()-t0;
+  int NRepeats = 1000;
+  t0 = wall_time();
+  for (int r = 0; r<NRepeats; r++)
+  {
+    P_table.clear();
+    for (int i = 0; i<NPoints; i++)
+    {
+      vector<double> P = LSDCRNP.calculate_muon_production_CRONUS(z[i],h[i]);
+      P_table.insert(P_table.end(), P.begin(), P.end());
+    }
+  }
+  double t_table = (wall_time()-t0)/double(NRepeats);
+  cout << "Muon production at " << NPoints << " depths and pressures:" << endl;
+  cout << "  reference (integrated):  " << t_reference << " s, "
+       << t_reference/double(NPoints) << " s per call" << endl;
+  cout << "  table (set in " << t_set << " s): " << t_table << " s, "
+       << t_table/double(NPoints) << " s per call" << endl;
+  cout << "  largest relative difference: "
+       << max_relative_difference(P_table, P_reference) << endl;
+
+  // the CRONUS erosion rate calculation: production profiles of a sample
+  // and the muogenic nuclides for a range of erosion rates (g/cm^2/yr)
+  double pressure = 850.0;
+  double effective_dLoc = 5.0;
+  vector<double> z_mu_ref, P10_ref, P26_ref, z_mu, P10, P26;
+  LSDCRNP.clear_CRONUS_muon_table();
+  t0 = wall_time();
+  LSDCRNP.get_CRONUS_P_mu_vectors(pressure, effective_dLoc, z_mu_ref, P10_ref, P26_ref);
+  double t_profile_reference = wall_time()-t0;
+  LSDCRNP.set_CRONUS_muon_table(tolerance, table_fname);
+  t0 = wall_time();
+  LSDCRNP.get_CRONUS_P_mu_vectors(pressure, effective_dLoc, z_mu, P10, P26);
+  double t_profile_table = wall_time()-t0;
+  double max_N_diff = 0;
+  for (double E = 1e-5; E < 1.0; E = E*1.5)
+  {
+    double N10_ref, N26_ref, N10, N26;
+    LSDCRNP.integrate_muon_flux_for_erosion(E, z_mu_ref, P10_ref, P26_ref, N10_ref, N26_ref);
+    LSDCRNP.integrate_muon_flux_for_erosion(E, z_mu, P10, P26, N10, N26);
+    max_N_diff = max(max_N_diff, fabs(N10-N10_ref)/N10_ref);
+    max_N_diff = max(max_N_diff, fabs(N26-N26_ref)/N26_ref);
+  }
+  cout << "CRONUS muon production profile, " << z_mu.size() << " depths:" << endl;
+  cout << "  reference (integrated):  " << t_profile_reference << " s" << endl;
+  cout << "  table:                   " << t_profile_table << " s" << endl;
+  cout << "  largest relative difference of the profile: "
+       << max(max_relative_difference(P10, P10_ref), max_relative_difference(P26, P26_ref))
+       << endl;
+  cout << "  largest relative difference of the muogenic nuclides, erosion rates"
+       << " 1e-5 to 1 g/cm^2/yr: " << max_N_diff << endl;
+
+  remove(table_fname.c_str());
+  return 0;
+}
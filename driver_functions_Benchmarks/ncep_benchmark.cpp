@@ -0,0 +1,307 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// ncep_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the conversion of elevation to atmospheric pressure
+// with the NCEP reanalysis data. The reference reads NCEP2.bin and
+// NCEP_hgt.bin into TNT arrays every time the data are asked for and
+// interpolates each site with interp2D_bilinear, as LSDCRNParameters did.
+// It is compared with LSDNCEPAtmosphere, which is loaded once per process,
+// for single sites and for a batch of sites.
+//
+// The sites are random, so the benchmark can be run anywhere with the NCEP
+// data. The arguments are:
+//  1) the path to the atmospheric data, e.g. ../driver_functions_CRNBasinwide/
+//  2) the number of basins (each loads the data once)
+//  3) the number of sites (pixels) per basin
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDCRNParameters.hpp"
+#include "../LSDNCEPAtmosphere.hpp"
+#include "../LSDStatsTools.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// the data as LSDCRNParameters used to hold them
+struct reference_NCEP
+{
+  vector<double> NCEPlat;
+  vector<double> NCEPlon;
+  Array2D<double> meanslp;
+  Array2D<double> meant1000;
+  vector< Array2D<double> > gm_hgt;
+  vector< Array2D<double> > gp_hgt;
+};
+
+// the loading in the old LSDCRNParameters::load_parameters_for_atmospheric_scaling
+void reference_load(string path_to_data, reference_NCEP& NCEP)
+{
+  int n_levels = 8;
+  int NRows = 73;
+  int NCols = 145;
+  Array2D<double> new_slp(NRows,NCols,0.0);
+  Array2D<double> new_meant(NRows,NCols,0.0);
+
+  string filename = path_to_data+"NCEP2.bin";
+  ifstream ifs_data(filename.c_str(), ios::in | ios::binary);
+  if( ifs_data.fail() )
+  {
+    cout << "\nFATAL ERROR: the data file \"" << filename
+         << "\" doesn't exist" << endl;
+    exit(EXIT_FAILURE);
+  }
+
+  double temp;
+  for (int i=0; i<NCols; ++i)
+  {
+    for (int j=0; j<NRows; ++j)
+    {
+      ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
+      new_slp[j][i] = temp;
+    }
+  }
+  for (int i=0; i<NCols; ++i)
+  {
+    for (int j=0; j<NRows; ++j)
+    {
+      ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
+      new_meant[j][i] = temp;
+    }
+  }
+  vector<double> temp_lat(NRows,0.0);
+  for (int i=0; i<NRows; ++i)
+  {
+    ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
+    temp_lat[i] = temp;
+  }
+  vector<double> temp_long(NCols,0.0);
+  for (int i=0; i<NCols; ++i)
+  {
+    ifs_data.read(reinterpret_cast<char*>(&temp), sizeof(temp));
+    temp_long[i] = temp;
+  }
+  ifs_data.close();
+
+  filename = path_to_data+"NCEP_hgt.bin";
+  ifstream ifs_data2(filename.c_str(), ios::in | ios::binary);
+  if( ifs_data2.fail() )
+  {
+    cout << "\nFATAL ERROR: the data file \"" << filename
+         << "\" doesn't exist" << endl;
+    exit(EXIT_FAILURE);
+  }
+  vector< Array2D<double> > vec_hgt_gm_array;
+  vector< Array2D<double> > vec_hgt_gp_array;
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (int lvl = 0; lvl < n_levels; lvl++)
+    {
+      Array2D<double> current_hgt_array(NRows,NCols,0.0);
+      for (int i=0; i<NCols; ++i)
+      {
+        for (int j=0; j<NRows; ++j)
+        {
+          ifs_data2.read(reinterpret_cast<char*>(&temp), sizeof(temp));
+          current_hgt_array[j][i] = temp;
+        }
+      }
+      if (pass == 0)
+      {
+        vec_hgt_gm_array.push_back(current_hgt_array.copy());
+      }
+      else
+      {
+        vec_hgt_gp_array.push_back(current_hgt_array.copy());
+      }
+    }
+  }
+  ifs_data2.close();
+
+  NCEP.NCEPlat = temp_lat;
+  NCEP.NCEPlon = temp_long;
+  NCEP.meanslp = new_slp.copy();
+  NCEP.meant1000 = new_meant.copy();
+  NCEP.gm_hgt = vec_hgt_gm_array;
+  NCEP.gp_hgt = vec_hgt_gp_array;
+}
+
+// the old LSDCRNParameters::NCEPatm_2
+double reference_NCEPatm_2(reference_NCEP& NCEP, double site_lat, double site_lon,
+                           double site_elev)
+{
+  if(site_lon < 0)
+  {
+    site_lon = site_lon+360.0;
+  }
+  double site_slp = interp2D_bilinear(NCEP.NCEPlat, NCEP.NCEPlon, NCEP.meanslp,
+                        site_lat, site_lon);
+  double site_T = interp2D_bilinear(NCEP.NCEPlat, NCEP.NCEPlon, NCEP.meant1000,
+                        site_lat, site_lon);
+  double site_T_degK = site_T + 273.15;
+  double gmr = -0.03417;
+  double dtdz = 0.0065;
+  return site_slp*exp( (gmr/dtdz)*( log(site_T_degK) - log(site_T_degK - (site_elev*dtdz)) ) );
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the NCEP atmosphere benchmark!           ||" << endl;
+    cout << "|| This times elevation to pressure conversion.        ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The path to NCEP2.bin and NCEP_hgt.bin." << endl;
+    cout << "* The number of basins, e.g. 50." << endl;
+    cout << "* The number of sites per basin, e.g. 100000." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  string path_to_data = argv[1];
+  if (path_to_data.size() > 0 && path_to_data[path_to_data.size()-1] != '/')
+  {
+    path_to_data = path_to_data+"/";
+  }
+  int NBasins = atoi(argv[2]);
+  int NSites = atoi(argv[3]);
+
+  // random sites; the reference interpolation reads past the grid above the
+  // last longitude line (357.5) so the sites stay inside it
+  long seed = -17;
+  vector<double> site_lat(NSites), site_lon(NSites), site_elev(NSites);
+  for (int i = 0; i<NSites; i++)
+  {
+    site_lat[i] = -89.0+178.0*double(ran3(&seed));
+    site_lon[i] = -180.0+357.0*double(ran3(&seed));
+    site_elev[i] = 5000.0*double(ran3(&seed));
+  }
+
+  cout << "Basins: " << NBasins << " sites per basin: " << NSites;
+  #ifdef _OPENMP
+  cout << " threads: " << omp_get_max_threads();
+  #endif
+  #ifdef LSD_NCEP_EMBEDDED
+  cout << " (embedded NCEP data)";
+  #endif
+  cout << endl;
+
+  // loading: the reference loads the data for every basin
+  double t0 = wall_time();
+  for (int b = 0; b<NBasins; b++)
+  {
+    reference_NCEP NCEP;
+    reference_load(path_to_data, NCEP);
+  }
+  double t_ref_load = wall_time()-t0;
+
+  t0 = wall_time();
+  for (int b = 0; b<NBasins; b++)
+  {
+    LSDCRNParameters LSDCRNP;
+    LSDCRNP.load_parameters_for_atmospheric_scaling(path_to_data);
+  }
+  double t_new_load = wall_time()-t0;
+
+  // pressures, one basin's worth of sites
+  reference_NCEP NCEP;
+  reference_load(path_to_data, NCEP);
+  vector<double> ref_pressure(NSites);
+  t0 = wall_time();
+  for (int i = 0; i<NSites; i++)
+  {
+    ref_pressure[i] = reference_NCEPatm_2(NCEP, site_lat[i], site_lon[i], site_elev[i]);
+  }
+  double t_ref_sites = wall_time()-t0;
+
+  LSDCRNParameters LSDCRNP;
+  LSDCRNP.load_parameters_for_atmospheric_scaling(path_to_data);
+  vector<double> single_pressure(NSites);
+  t0 = wall_time();
+  for (int i = 0; i<NSites; i++)
+  {
+    single_pressure[i] = LSDCRNP.NCEPatm_2(site_lat[i], site_lon[i], site_elev[i]);
+  }
+  double t_single_sites = wall_time()-t0;
+
+  t0 = wall_time();
+  vector<double> batch_pressure = LSDCRNP.NCEPatm_2(site_lat, site_lon, site_elev);
+  double t_batch_sites = wall_time()-t0;
+
+  double max_diff_single = 0;
+  double max_diff_batch = 0;
+  for (int i = 0; i<NSites; i++)
+  {
+    max_diff_single = max(max_diff_single, fabs(single_pressure[i]-ref_pressure[i]));
+    max_diff_batch = max(max_diff_batch, fabs(batch_pressure[i]-ref_pressure[i]));
+  }
+
+  cout << "Loading, " << NBasins << " times:" << endl;
+  cout << "  reference (read every time): " << t_ref_load << " s" << endl;
+  cout << "  LSDNCEPAtmosphere (shared):  " << t_new_load << " s" << endl;
+  cout << "Pressures at " << NSites << " sites:" << endl;
+  cout << "  reference interp2D_bilinear: " << t_ref_sites << " s" << endl;
+  cout << "  LSDNCEPAtmosphere, single:   " << t_single_sites << " s" << endl;
+  cout << "  LSDNCEPAtmosphere, batch:    " << t_batch_sites << " s" << endl;
+  cout << "Largest difference from the reference, single: " << max_diff_single
+       << " batch: " << max_diff_batch << " mbar" << endl;
+}
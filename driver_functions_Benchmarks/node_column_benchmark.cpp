@@ -0,0 +1,211 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// node_column_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program compares the node columns that LSDChiTools keeps its channel
+// data in with the map<int,float> that were used before. A number of
+// variables is written on a set of channel nodes, then read back in the
+// order of the node sequence, as the print_data_maps_to_file functions do,
+// and at random nodes, as the knickpoint routines do when following
+// receivers. It reports the time of each pass and the heap used.
+//
+// The channel nodes are a random subset of the nodes in a random order, so
+// the benchmark can be run anywhere. The arguments are:
+//  1) the number of nodes in the DEM
+//  2) the number of channel nodes
+//  3) the number of variables
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <ctime>
+#include <malloc.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDNodeColumn.hpp"
+using namespace std;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// bytes in use on the heap
+double heap_in_use()
+{
+  struct mallinfo2 info = mallinfo2();
+  return double(info.uordblks)+double(info.hblkhd);
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the node column benchmark!               ||" << endl;
+    cout << "|| This compares node columns with maps.               ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of nodes in the DEM, e.g. 10000000." << endl;
+    cout << "* The number of channel nodes, e.g. 1000000." << endl;
+    cout << "* The number of variables, e.g. 26." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NDataNodes = atoi(argv[1]);
+  int NChannelNodes = atoi(argv[2]);
+  int NVariables = atoi(argv[3]);
+
+  // a random node sequence, and random nodes to look up
+  srand(1);
+  vector<int> all_nodes(NDataNodes);
+  for (int i = 0; i<NDataNodes; i++)
+  {
+    all_nodes[i] = i;
+  }
+  for (int i = 0; i<NChannelNodes; i++)
+  {
+    int j = i + rand() % (NDataNodes-i);
+    swap(all_nodes[i],all_nodes[j]);
+  }
+  vector<int> node_sequence(all_nodes.begin(),all_nodes.begin()+NChannelNodes);
+  vector<int>().swap(all_nodes);
+  vector<int> lookups(NChannelNodes);
+  for (int i = 0; i<NChannelNodes; i++)
+  {
+    lookups[i] = node_sequence[rand() % NChannelNodes];
+  }
+
+  cout << "store\tMB\twrite_s\tread_sequence_s\tread_random_s" << endl;
+  double checksum_map = 0, checksum_column = 0;
+
+  // the columns go first, since freeing the millions of map entries
+  // afterwards leaves the heap in a state that slows what is allocated next
+  {
+    double heap = heap_in_use();
+    double start = wall_time();
+    LSDNodeSlots Slots;
+    Slots.reserve(NDataNodes,NChannelNodes);
+    vector< LSDNodeColumn<float> > columns(NVariables);
+    for (int v = 0; v<NVariables; v++)
+    {
+      columns[v].attach(&Slots);
+    }
+    for (int n = 0; n<NChannelNodes; n++)
+    {
+      for (int v = 0; v<NVariables; v++)
+      {
+        columns[v][node_sequence[n]] = float(n+v);
+      }
+    }
+    double write_time = wall_time()-start;
+    double MB = (heap_in_use()-heap)/1.0e6;
+
+    start = wall_time();
+    for (int n = 0; n<NChannelNodes; n++)
+    {
+      for (int v = 0; v<NVariables; v++)
+      {
+        checksum_column += columns[v][node_sequence[n]];
+      }
+    }
+    double sequence_time = wall_time()-start;
+
+    start = wall_time();
+    for (int n = 0; n<NChannelNodes; n++)
+    {
+      for (int v = 0; v<NVariables; v++)
+      {
+        checksum_column += columns[v][lookups[n]];
+      }
+    }
+    double random_time = wall_time()-start;
+    cout << "column\t" << MB << "\t" << write_time << "\t" << sequence_time << "\t" << random_time << endl;
+  }
+
+  // the maps
+  {
+    double heap = heap_in_use();
+    double start = wall_time();
+    vector< map<int,float> > maps(NVariables);
+    for (int n = 0; n<NChannelNodes; n++)
+    {
+      for (int v = 0; v<NVariables; v++)
+      {
+        maps[v][node_sequence[n]] = float(n+v);
+      }
+    }
+    double write_time = wall_time()-start;
+    double MB = (heap_in_use()-heap)/1.0e6;
+
+    start = wall_time();
+    for (int n = 0; n<NChannelNodes; n++)
+    {
+      for (int v = 0; v<NVariables; v++)
+      {
+        checksum_map += maps[v][node_sequence[n]];
+      }
+    }
+    double sequence_time = wall_time()-start;
+
+    start = wall_time();
+    for (int n = 0; n<NChannelNodes; n++)
+    {
+      for (int v = 0; v<NVariables; v++)
+      {
+        checksum_map += maps[v][lookups[n]];
+      }
+    }
+    double random_time = wall_time()-start;
+    cout << "map\t" << MB << "\t" << write_time << "\t" << sequence_time << "\t" << random_time << endl;
+  }
+
+  cout << endl << "checksums agree: " << (checksum_map == checksum_column ? "yes" : "no") << endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,261 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// polyfit_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times calculate_polyfit_coefficient_matrices, which applies
+// six precomputed least squares filters, against a reference that solves the
+// normal equations with an LU decomposition at every cell, which is how the
+// coefficients were computed before. It reports the largest difference
+// between the two for each coefficient.
+//
+// The DEM is synthetic so the benchmark can be run anywhere. The arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//  3) the largest window radius, in cells. The radii 2, 4, 8... up to this
+//     value are timed
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../TNT/tnt.h"
+#include "../TNT/jama_lu.h"
+using namespace std;
+using namespace TNT;
+using namespace JAMA;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reference fit. This solves the normal equations at every cell, with the
+// same circular window and the same treatment of nodata and edges as
+// calculate_polyfit_coefficient_matrices
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void reference_polyfit(Array2D<float>& RasterData, float DataResolution,
+                       float NoDataValue, float window_radius,
+                       vector< Array2D<float> >& coefficients)
+{
+  int NRows = RasterData.dim1();
+  int NCols = RasterData.dim2();
+  int kr = int(ceil(window_radius/DataResolution));
+  int kw = 2*kr+1;
+
+  Array2D<int> mask(kw,kw,0);
+  for(int i=0;i<kw;++i)
+  {
+    for(int j=0;j<kw;++j)
+    {
+      float x = (i-kr)*DataResolution;
+      float y = (j-kr)*DataResolution;
+      if (floor(sqrt(x*x+y*y)) <= window_radius)
+      {
+        mask[i][j] = 1;
+      }
+    }
+  }
+
+  Array2D<float> A(6,6,0.0);
+  for(int i=0;i<kw;++i)
+  {
+    for(int j=0;j<kw;++j)
+    {
+      if (mask[i][j] == 1)
+      {
+        float x = (i-kr)*DataResolution;
+        float y = (j-kr)*DataResolution;
+        float basis[6] = {x*x, y*y, x*y, x, y, 1};
+        for (int k = 0; k<6; ++k)
+        {
+          for (int l = 0; l<6; ++l)
+          {
+            A[k][l] += basis[k]*basis[l];
+          }
+        }
+      }
+    }
+  }
+
+  coefficients.clear();
+  for (int k = 0; k<6; ++k)
+  {
+    coefficients.push_back(Array2D<float>(NRows,NCols,0.0));
+  }
+
+  for(int i=0;i<NRows;++i)
+  {
+    for(int j=0;j<NCols;++j)
+    {
+      if (i-kr < 0 || i+kr >= NRows || j-kr < 0 || j+kr >= NCols
+          || RasterData[i][j] == NoDataValue)
+      {
+        for (int k = 0; k<6; ++k)
+        {
+          coefficients[k][i][j] = NoDataValue;
+        }
+        continue;
+      }
+
+      Array1D<float> bb(6,0.0);
+      bool ndv_present = false;
+      for(int ki=0;ki<kw;++ki)
+      {
+        for(int kj=0;kj<kw;++kj)
+        {
+          float z = RasterData[i-kr+ki][j-kr+kj];
+          if (z == NoDataValue)
+          {
+            ndv_present = true;
+          }
+          else if (mask[ki][kj] == 1)
+          {
+            float x = (ki-kr)*DataResolution;
+            float y = (kj-kr)*DataResolution;
+            bb[0] += z*x*x;
+            bb[1] += z*y*y;
+            bb[2] += z*x*y;
+            bb[3] += z*x;
+            bb[4] += z*y;
+            bb[5] += z;
+          }
+        }
+      }
+      if (not ndv_present)
+      {
+        LU<float> sol_A(A);
+        Array1D<float> coeffs = sol_A.solve(bb);
+        for (int k = 0; k<6; ++k)
+        {
+          coefficients[k][i][j] = coeffs[k];
+        }
+      }
+    }
+  }
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the polyfit benchmark!                   ||" << endl;
+    cout << "|| This times the polyfit coefficient filters against  ||" << endl;
+    cout << "|| a least squares solution at every cell.             ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of rows, e.g. 1000." << endl;
+    cout << "* The number of columns, e.g. 1000." << endl;
+    cout << "* The largest window radius in cells, e.g. 32." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  int max_radius = atoi(argv[3]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // a rough synthetic surface with some nodata holes in it
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.05*row+0.02*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+      if (rand()%20000 == 0)
+      {
+        zeta[row][col] = NoDataValue;
+      }
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+
+  cout << "radius\treference_s\tfilter_s\tspeedup\tmax_diff_a..f" << endl;
+  for (int radius = 2; radius<=max_radius; radius *= 2)
+  {
+    float window_radius = radius*DataResolution;
+
+    double start = wall_time();
+    vector< Array2D<float> > ref;
+    reference_polyfit(zeta,DataResolution,NoDataValue,window_radius,ref);
+    double reference_time = wall_time()-start;
+
+    start = wall_time();
+    vector< Array2D<float> > fit(6);
+    Topo.calculate_polyfit_coefficient_matrices(window_radius,fit[0],fit[1],
+                                                fit[2],fit[3],fit[4],fit[5]);
+    double filter_time = wall_time()-start;
+
+    cout << radius << "\t" << reference_time << "\t" << filter_time << "\t"
+         << reference_time/filter_time;
+    for (int k = 0; k<6; ++k)
+    {
+      float max_diff = 0;
+      for (int row = 0; row<NRows; row++)
+      {
+        for (int col = 0; col<NCols; col++)
+        {
+          max_diff = max(max_diff, float(fabs(fit[k][row][col]-ref[k][row][col])));
+        }
+      }
+      cout << "\t" << max_diff;
+    }
+    cout << endl;
+  }
+
+  return EXIT_SUCCESS;
+}
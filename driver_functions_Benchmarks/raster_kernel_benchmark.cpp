@@ -0,0 +1,352 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// raster_kernel_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the raster kernels that work on contiguous raster views
+// against reference versions that index the TNT Array2D row pointers
+// element by element, which is how the kernels were written before. It also
+// checks that both versions give the same answer.
+//
+// The DEM is synthetic so the benchmark can be run anywhere. The arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//  3) the number of times each kernel is repeated
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reference kernels. These index the Array2D one element at a time. The
+// results are wrapped in an LSDRaster when they are timed so that both
+// versions pay for building the output raster.
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+Array2D<float> reference_add(Array2D<float>& A, Array2D<float>& B, float NoDataValue)
+{
+  int NRows = A.dim1();
+  int NCols = A.dim2();
+  Array2D<float> New_array(NRows,NCols,NoDataValue);
+  for(int row = 0; row< NRows; row++)
+  {
+    for(int col = 0; col<NCols; col++)
+    {
+      if (A[row][col] != NoDataValue && B[row][col] != NoDataValue)
+      {
+        New_array[row][col] = A[row][col]+B[row][col];
+      }
+    }
+  }
+  return New_array;
+}
+
+Array2D<float> reference_multiply(Array2D<float>& A, Array2D<float>& B, float NoDataValue)
+{
+  int NRows = A.dim1();
+  int NCols = A.dim2();
+  Array2D<float> New_array(NRows,NCols,NoDataValue);
+  for(int row = 0; row< NRows; row++)
+  {
+    for(int col = 0; col<NCols; col++)
+    {
+      if (A[row][col] != NoDataValue && B[row][col] != NoDataValue)
+      {
+        New_array[row][col] = A[row][col]*B[row][col];
+      }
+    }
+  }
+  return New_array;
+}
+
+Array2D<float> reference_mask(Array2D<float>& A, float threshold, float NoDataValue)
+{
+  int NRows = A.dim1();
+  int NCols = A.dim2();
+  Array2D<float> New_array(NRows,NCols,NoDataValue);
+  for(int row = 0; row< NRows; row++)
+  {
+    for(int col = 0; col<NCols; col++)
+    {
+      if (A[row][col] != NoDataValue && A[row][col] >= threshold)
+      {
+        New_array[row][col] = A[row][col];
+      }
+    }
+  }
+  return New_array;
+}
+
+Array2D<float> reference_slope_angles(Array2D<float>& A, float NoDataValue)
+{
+  int NRows = A.dim1();
+  int NCols = A.dim2();
+  Array2D<float> slope_angle(NRows,NCols,NoDataValue);
+  for(int row = 1; row < NRows - 1; row++)
+  {
+    for(int col = 1; col < NCols - 1; col++)
+    {
+      if(A[row][col] != NoDataValue)
+      {
+        slope_angle[row][col] = atan(A[row][col]);
+      }
+    }
+  }
+  return slope_angle;
+}
+
+Array2D<float> reference_hillshade(Array2D<float>& RasterData, float DataResolution,
+                                   float NoDataValue, float altitude, float azimuth,
+                                   float z_factor)
+{
+  int NRows = RasterData.dim1();
+  int NCols = RasterData.dim2();
+  Array2D<float> hillshade(NRows,NCols,NoDataValue);
+
+  float zenith_rad = (90 - altitude) * M_PI / 180.0;
+  float azimuth_math = 360-azimuth + 90;
+  if (azimuth_math >= 360.0) azimuth_math = azimuth_math - 360;
+  float azimuth_rad = azimuth_math * M_PI /180.0;
+
+  for (int i = 1; i < NRows-1; ++i)
+  {
+    for (int j = 1; j < NCols-1; ++j)
+    {
+      float slope_rad = 0;
+      float aspect_rad = 0;
+      float dzdx = 0;
+      float dzdy = 0;
+
+      if (RasterData[i][j] != NoDataValue)
+      {
+        dzdx = ((RasterData[i][j+1] + 2*RasterData[i+1][j] + RasterData[i+1][j+1]) -
+               (RasterData[i-1][j-1] + 2*RasterData[i-1][j] + RasterData[i-1][j+1]))
+                / (8 * DataResolution);
+        dzdy = ((RasterData[i-1][j+1] + 2*RasterData[i][j+1] + RasterData[i+1][j+1]) -
+               (RasterData[i-1][j-1] + 2*RasterData[i][j-1] + RasterData[i+1][j-1]))
+               / (8 * DataResolution);
+
+        slope_rad = atan(z_factor * sqrt((dzdx*dzdx) + (dzdy*dzdy)));
+
+        if (dzdx != 0)
+        {
+          aspect_rad = atan2(dzdy, (dzdx*-1));
+          if (aspect_rad < 0) aspect_rad = 2*M_PI + aspect_rad;
+        }
+        else
+        {
+          if (dzdy > 0) aspect_rad = M_PI/2;
+          else if (dzdy < 0) aspect_rad = 2 * M_PI - M_PI/2;
+        }
+        hillshade[i][j] = 255.0 * ((cos(zenith_rad) * cos(slope_rad)) +
+                          (sin(zenith_rad) * sin(slope_rad) *
+                          cos(azimuth_rad - aspect_rad)));
+
+        if (hillshade[i][j] < 0) hillshade[i][j] = 0;
+      }
+    }
+  }
+  return hillshade;
+}
+
+// counts the cells where two rasters differ
+int count_mismatches(LSDRaster& A, LSDRaster& B)
+{
+  int n_mismatch = 0;
+  for (int row = 0; row<A.get_NRows(); row++)
+  {
+    for (int col = 0; col<A.get_NCols(); col++)
+    {
+      if (A.get_data_element(row,col) != B.get_data_element(row,col))
+      {
+        n_mismatch++;
+      }
+    }
+  }
+  return n_mismatch;
+}
+
+// prints one line of the results table
+void print_result(string name, double reference_time, double view_time, int n_mismatch)
+{
+  cout << name << "\t" << reference_time << "\t" << view_time << "\t"
+       << reference_time/view_time << "\t" << n_mismatch << endl;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=4)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the raster kernel benchmark!             ||" << endl;
+    cout << "|| This times the raster kernels against reference     ||" << endl;
+    cout << "|| versions that index Array2D row pointers.           ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires three inputs: " << endl;
+    cout << "* The number of rows, e.g. 2000." << endl;
+    cout << "* The number of columns, e.g. 2000." << endl;
+    cout << "* The number of repeats of each kernel, e.g. 10." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  int n_repeats = atoi(argv[3]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // a rough synthetic surface with some nodata holes in it
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  Array2D<float> other(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.05*row+0.02*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+      other[row][col] = 0.01*float(rand()%1000);
+      if (rand()%1000 == 0)
+      {
+        zeta[row][col] = NoDataValue;
+      }
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+  LSDRaster Other(NRows,NCols,0,0,DataResolution,NoDataValue,other);
+
+  cout << "kernel\treference_s\tview_s\tspeedup\tmismatches" << endl;
+  double start, reference_time, view_time;
+  LSDRaster ref;
+  LSDRaster result;
+
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++)
+  {
+    ref = LSDRaster(NRows,NCols,0,0,DataResolution,NoDataValue,
+                    reference_add(zeta,other,NoDataValue));
+  }
+  reference_time = wall_time()-start;
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++) { result = Topo.MapAlgebra_add(Other); }
+  view_time = wall_time()-start;
+  print_result("add",reference_time,view_time,count_mismatches(ref,result));
+
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++)
+  {
+    ref = LSDRaster(NRows,NCols,0,0,DataResolution,NoDataValue,
+                    reference_multiply(zeta,other,NoDataValue));
+  }
+  reference_time = wall_time()-start;
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++) { result = Topo.MapAlgebra_multiply(Other); }
+  view_time = wall_time()-start;
+  print_result("multiply",reference_time,view_time,count_mismatches(ref,result));
+
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++)
+  {
+    ref = LSDRaster(NRows,NCols,0,0,DataResolution,NoDataValue,
+                    reference_mask(zeta,150,NoDataValue));
+  }
+  reference_time = wall_time()-start;
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++) { result = Topo.mask_to_nodata_using_threshold(150,true); }
+  view_time = wall_time()-start;
+  print_result("mask",reference_time,view_time,count_mismatches(ref,result));
+
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++)
+  {
+    ref = LSDRaster(NRows,NCols,0,0,DataResolution,NoDataValue,
+                    reference_slope_angles(other,NoDataValue));
+  }
+  reference_time = wall_time()-start;
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++) { result = Other.calculate_slope_angles(); }
+  view_time = wall_time()-start;
+  print_result("slope_angle",reference_time,view_time,count_mismatches(ref,result));
+
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++)
+  {
+    ref = LSDRaster(NRows,NCols,0,0,DataResolution,NoDataValue,
+                    reference_hillshade(zeta,DataResolution,NoDataValue,45,315,1));
+  }
+  reference_time = wall_time()-start;
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++) { result = Topo.hillshade(45,315,1); }
+  view_time = wall_time()-start;
+  print_result("hillshade",reference_time,view_time,count_mismatches(ref,result));
+
+  // the polyfit kernel is only timed here. polyfit_benchmark compares it
+  // with the per-cell least squares solution
+  Array2D<float> a,b,c,d,e,f;
+  start = wall_time();
+  for (int r = 0; r<n_repeats; r++)
+  {
+    Topo.calculate_polyfit_coefficient_matrices(3*DataResolution,a,b,c,d,e,f);
+  }
+  view_time = wall_time()-start;
+  cout << "polyfit\t-\t" << view_time << "\t-\t-" << endl;
+
+  return EXIT_SUCCESS;
+}
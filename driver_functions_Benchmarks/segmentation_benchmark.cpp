@@ -0,0 +1,242 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// segmentation_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times the Monte Carlo segment fitting of channels in chi space
+// as it is done by LSDChiTools::chi_map_automator: every channel is an
+// LSDChiNetwork with its own random stream, and the channels are fitted in
+// parallel. The channels are fitted with one thread and with all of them, and
+// again with the same seed, and the fitted M_chi values are compared: with a
+// fixed seed they should be the same whatever the number of threads.
+//
+// The DEM is synthetic and filled, so the benchmark can be run anywhere. The
+// arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//  3) the number of channels
+//  4) the seed
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDIndexRaster.hpp"
+#include "../LSDFlowInfo.hpp"
+#include "../LSDChiNetwork.hpp"
+#include "../LSDStatsTools.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// fits every channel as chi_map_automator does and returns the M_chi of each
+vector< vector<float> > fit_channels(LSDFlowInfo& FlowInfo, vector<int>& sources,
+                                     vector<int>& outlets, LSDRaster& Elevation,
+                                     LSDRaster& FlowDistance, LSDRaster& DrainageArea,
+                                     LSDRaster& Chi, long seed, int n_threads)
+{
+  float A_0 = 1;
+  float m_over_n = 0.5;
+  int target_nodes = 80;
+  int n_iterations = 20;
+  int skip = 2;
+  int minimum_segment_length = 10;
+  float sigma = 20;
+
+  int n_channels = int(sources.size());
+  vector< vector<float> > m_means(n_channels);
+
+  #ifdef _OPENMP
+  omp_set_num_threads(n_threads);
+  #endif
+  #pragma omp parallel for schedule(dynamic)
+  for (int chan = 0; chan<n_channels; chan++)
+  {
+    ran3_stream channel_stream(ran3_stream_seed(seed,chan));
+    LSDChiNetwork ThisChiChannel(FlowInfo, sources[chan], outlets[chan],
+                                 Elevation, FlowDistance, DrainageArea, Chi);
+    ThisChiChannel.set_random_stream(channel_stream);
+    ThisChiChannel.split_all_channels(A_0, m_over_n, n_iterations, skip, target_nodes,
+                                      minimum_segment_length, sigma);
+    ThisChiChannel.monte_carlo_sample_river_network_for_best_fit_after_breaks(A_0, m_over_n,
+                                      n_iterations, skip, minimum_segment_length, sigma);
+    m_means[chan] = ThisChiChannel.get_m_means()[0];
+  }
+  return m_means;
+}
+
+// the number of nodes whose M_chi differs between two fits
+int n_different(vector< vector<float> >& A, vector< vector<float> >& B)
+{
+  int n_diff = 0;
+  for (int chan = 0; chan<int(A.size()); chan++)
+  {
+    if (A[chan].size() != B[chan].size())
+    {
+      n_diff += max(A[chan].size(),B[chan].size());
+      continue;
+    }
+    for (int node = 0; node<int(A[chan].size()); node++)
+    {
+      if (A[chan][node] != B[chan][node])
+      {
+        n_diff++;
+      }
+    }
+  }
+  return n_diff;
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=5)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the segmentation benchmark!              ||" << endl;
+    cout << "|| This times the parallel Monte Carlo segment fitting ||" << endl;
+    cout << "|| of channels in chi space.                           ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires four inputs: " << endl;
+    cout << "* The number of rows, e.g. 300." << endl;
+    cout << "* The number of columns, e.g. 300." << endl;
+    cout << "* The number of channels, e.g. 16." << endl;
+    cout << "* The seed, e.g. 42." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  int NChannels = atoi(argv[3]);
+  long seed = atol(argv[4]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // a rough synthetic surface, filled
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.5*row+0.2*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+  float MinSlope = 0.0001;
+  LSDRaster Filled = Topo.fill(MinSlope);
+  vector<string> BoundaryConditions(4,"n");
+  LSDFlowInfo FlowInfo(BoundaryConditions,Filled);
+
+  LSDRaster FlowDistance = FlowInfo.distance_from_outlet();
+  LSDRaster DrainageArea = FlowInfo.write_DrainageArea_to_LSDRaster();
+  LSDRaster Chi = FlowInfo.get_upslope_chi_from_all_baselevel_nodes(0.5,1,0);
+
+  // channels from sources down to their base level
+  LSDIndexRaster FlowPixels = FlowInfo.write_NContributingNodes_to_LSDIndexRaster();
+  vector<int> all_sources = FlowInfo.get_sources_index_threshold(FlowPixels, 50);
+  vector<int> sources;
+  vector<int> outlets;
+  for (int s = 0; s<int(all_sources.size()) && int(sources.size())<NChannels; s++)
+  {
+    int outlet = FlowInfo.retrieve_base_level_node(all_sources[s]);
+    int row, col;
+    FlowInfo.retrieve_current_row_and_col(all_sources[s],row,col);
+    if (FlowDistance.get_data_element(row,col) > 100*DataResolution)
+    {
+      sources.push_back(all_sources[s]);
+      outlets.push_back(outlet);
+    }
+  }
+
+  int max_threads = 1;
+  #ifdef _OPENMP
+  max_threads = omp_get_max_threads();
+  #endif
+  int n_threads = max(max_threads,2);
+
+  double start = wall_time();
+  vector< vector<float> > serial = fit_channels(FlowInfo, sources, outlets, Filled,
+                                   FlowDistance, DrainageArea, Chi, seed, 1);
+  double serial_time = wall_time()-start;
+
+  start = wall_time();
+  vector< vector<float> > parallel = fit_channels(FlowInfo, sources, outlets, Filled,
+                                     FlowDistance, DrainageArea, Chi, seed, n_threads);
+  double parallel_time = wall_time()-start;
+
+  vector< vector<float> > again = fit_channels(FlowInfo, sources, outlets, Filled,
+                                  FlowDistance, DrainageArea, Chi, seed, n_threads);
+  vector< vector<float> > other_seed = fit_channels(FlowInfo, sources, outlets, Filled,
+                                       FlowDistance, DrainageArea, Chi, seed+1, n_threads);
+
+  int n_nodes = 0;
+  for (int chan = 0; chan<int(serial.size()); chan++)
+  {
+    n_nodes += int(serial[chan].size());
+  }
+
+  cout << "channels\tchannel_nodes\tthreads\tone_thread_s\tall_threads_s" << endl;
+  cout << sources.size() << "\t" << n_nodes << "\t" << n_threads << "\t"
+       << serial_time << "\t" << parallel_time << endl << endl;
+  cout << "nodes differing, one thread vs " << n_threads << " threads: "
+       << n_different(serial,parallel) << endl;
+  cout << "nodes differing, same seed run again: " << n_different(parallel,again) << endl;
+  cout << "nodes differing, another seed: " << n_different(parallel,other_seed) << endl;
+
+  return EXIT_SUCCESS;
+}
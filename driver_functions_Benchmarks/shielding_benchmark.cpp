@@ -0,0 +1,288 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// shielding_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program checks and times the horizon angle engine behind
+// LSDRaster::TopographicShielding.
+//  1) The convex hull horizons of LSDHorizonAngles are compared with a brute
+//     force search over the same scan lines, for a few azimuths, with and
+//     without a limit on the search distance.
+//  2) The distance limited shielding of LSDShieldingTileCache is compared
+//     with the same shielding computed over the whole DEM at once.
+//  3) TopographicShielding is timed against TopographicShielding_Codilean,
+//     which casts shadows for every azimuth and zenith pair, and the largest
+//     and mean differences between the shielding factors are reported.
+//
+// The DEM is synthetic so the benchmark can be run anywhere. The arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//  3) the azimuth step in degrees
+//  4) the zenith step in degrees used by the shadow casting reference
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDRasterBuffer.hpp"
+#include "../LSDHorizonAngles.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// Reference horizon. For every cell this visits every cell ahead of it on its
+// scan line, using the same scan lines as LSDHorizonAngles. If max_steps is
+// greater than 0 only that many cells are visited
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+void reference_horizon(Array2D<float>& zeta, float DataResolution, float NoDataValue,
+                       float azimuth, float max_distance, Array2D<float>& tan_horizon)
+{
+  int NRows = zeta.dim1();
+  int NCols = zeta.dim2();
+  double az = azimuth*M_PI/180.0;
+  double dcol = sin(az);
+  double drow = -cos(az);
+  bool col_major = (fabs(dcol) >= fabs(drow));
+  int NMajor = col_major ? NCols : NRows;
+  int NMinor = col_major ? NRows : NCols;
+  double d_major = col_major ? dcol : drow;
+  double d_minor = col_major ? drow : dcol;
+  int major_sign = (d_major >= 0) ? 1 : -1;
+  double minor_slope = d_minor/fabs(d_major);
+  double step_length = DataResolution*sqrt(1.0+minor_slope*minor_slope);
+  vector<int> shift(NMajor);
+  for (int major = 0; major<NMajor; major++)
+  {
+    shift[major] = int(floor(minor_slope*major+0.5));
+  }
+  int max_steps = (max_distance > 0) ? int(floor(max_distance/step_length)) : 0;
+
+  tan_horizon = Array2D<float>(NRows,NCols,0.0);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      float z = zeta[row][col];
+      if (z == NoDataValue)
+      {
+        tan_horizon[row][col] = NoDataValue;
+        continue;
+      }
+      int major = col_major ? col : row;
+      int minor = col_major ? row : col;
+      int o = minor-shift[major];
+      double best = 0;
+      for (int m = major+major_sign; m>=0 && m<NMajor; m += major_sign)
+      {
+        if (max_distance > 0 && abs(m-major) > max_steps)
+        {
+          break;
+        }
+        int n = o+shift[m];
+        if (n < 0 || n >= NMinor)
+        {
+          break;
+        }
+        float zn = col_major ? zeta[n][m] : zeta[m][n];
+        if (zn == NoDataValue)
+        {
+          break;
+        }
+        double slope = (zn-z)/(abs(m-major)*step_length);
+        if (slope > best)
+        {
+          best = slope;
+        }
+      }
+      tan_horizon[row][col] = best;
+    }
+  }
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=5)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the shielding benchmark!                 ||" << endl;
+    cout << "|| This times the horizon angle shielding against the  ||" << endl;
+    cout << "|| shadow casting of Codilean (2006).                  ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires four inputs: " << endl;
+    cout << "* The number of rows, e.g. 300." << endl;
+    cout << "* The number of columns, e.g. 300." << endl;
+    cout << "* The azimuth step in degrees, e.g. 5." << endl;
+    cout << "* The zenith step of the reference in degrees, e.g. 5." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  int AzimuthStep = atoi(argv[3]);
+  int ZenithStep = atoi(argv[4]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // steep synthetic valleys with some nodata holes in them
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 500+300*sin(0.03*row)*cos(0.021*col)+2*row
+                      +0.5*float(rand()%100);
+      if (rand()%20000 == 0)
+      {
+        zeta[row][col] = NoDataValue;
+      }
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+
+  // 1) the hull against the brute force search
+  float max_distance = 40*DataResolution;
+  LSDHorizonAngles Horizons(make_const_raster_view(zeta),NoDataValue,DataResolution);
+  LSDHorizonAngles LimitedHorizons(make_const_raster_view(zeta),NoDataValue,DataResolution,
+                                   max_distance,0,0);
+  float test_azimuths[6] = {0, 30, 45, 100, 225, 333};
+  cout << "azimuth\tmax_diff_tan_horizon\tmax_diff_limited" << endl;
+  for (int a = 0; a<6; a++)
+  {
+    cout << test_azimuths[a];
+    for (int limited = 0; limited<2; limited++)
+    {
+      Array2D<float> hull(NRows,NCols,0.0);
+      Array2D<float> ref;
+      if (limited == 0)
+      {
+        Horizons.calculate_horizon(test_azimuths[a],make_raster_view(hull));
+        reference_horizon(zeta,DataResolution,NoDataValue,test_azimuths[a],0,ref);
+      }
+      else
+      {
+        LimitedHorizons.calculate_horizon(test_azimuths[a],make_raster_view(hull));
+        reference_horizon(zeta,DataResolution,NoDataValue,test_azimuths[a],max_distance,ref);
+      }
+      float max_diff = 0;
+      for (int row = 0; row<NRows; row++)
+      {
+        for (int col = 0; col<NCols; col++)
+        {
+          max_diff = max(max_diff, float(fabs(hull[row][col]-ref[row][col])));
+        }
+      }
+      cout << "\t" << max_diff;
+    }
+    cout << endl;
+  }
+
+  // 2) the tiles against the whole DEM
+  double start = wall_time();
+  LSDRasterBuffer<float> whole = LimitedHorizons.calculate_shielding(AzimuthStep,2.3);
+  double whole_time = wall_time()-start;
+  start = wall_time();
+  LSDShieldingTileCache Cache(make_const_raster_view(zeta),NoDataValue,DataResolution,
+                              AzimuthStep,2.3,max_distance,64);
+  float max_tile_diff = 0;
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      max_tile_diff = max(max_tile_diff, float(fabs(Cache.get_shielding(row,col)-whole(row,col))));
+    }
+  }
+  double tile_time = wall_time()-start;
+  cout << endl << "limited_whole_s\ttiled_s\tn_tiles\tmax_diff" << endl;
+  cout << whole_time << "\t" << tile_time << "\t" << Cache.get_NTilesComputed()
+       << "\t" << max_tile_diff << endl;
+
+  // 3) the shielding against the shadow casting
+  start = wall_time();
+  LSDRaster Codilean = Topo.TopographicShielding_Codilean(AzimuthStep,ZenithStep);
+  double codilean_time = wall_time()-start;
+
+  start = wall_time();
+  LSDRaster Horizon = Topo.TopographicShielding(AzimuthStep,ZenithStep);
+  double horizon_time = wall_time()-start;
+
+  float max_diff = 0;
+  double sum_diff = 0;
+  double sum_shielding = 0;
+  long n_cells = 0;
+  for (int row = 1; row<NRows-1; row++)
+  {
+    for (int col = 1; col<NCols-1; col++)
+    {
+      float h = Horizon.get_data_element(row,col);
+      float c = Codilean.get_data_element(row,col);
+      if (h != NoDataValue && c != NoDataValue)
+      {
+        max_diff = max(max_diff, float(fabs(h-c)));
+        sum_diff += fabs(h-c);
+        sum_shielding += h;
+        n_cells++;
+      }
+    }
+  }
+  cout << endl << "codilean_s\thorizon_s\tspeedup\tmean_shielding\tmean_diff\tmax_diff" << endl;
+  cout << codilean_time << "\t" << horizon_time << "\t" << codilean_time/horizon_time
+       << "\t" << sum_shielding/n_cells << "\t" << sum_diff/n_cells << "\t" << max_diff << endl;
+
+  return EXIT_SUCCESS;
+}
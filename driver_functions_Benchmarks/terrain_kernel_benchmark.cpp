@@ -0,0 +1,220 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// terrain_kernel_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program times LSDRaster::calculate_terrain_derivatives, which computes
+// slope, aspect, hillshade, the curvatures and the D8 slope in one pass,
+// against the separate routines: hillshade, and
+// calculate_polyfit_surface_metrics with the smallest (3x3) window. It reports
+// the largest difference between the two for each raster.
+//
+// The DEM is synthetic so the benchmark can be run anywhere. The arguments are:
+//  1) the number of rows
+//  2) the number of columns
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../TNT/tnt.h"
+using namespace std;
+using namespace TNT;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+// the largest difference between two rasters, relative to the reference value
+// where that is larger than one, and the number of cells where only one of them
+// has data. Angles are compared around the circle
+void compare(LSDRaster& A, LSDRaster& B, float NoDataValue, bool is_angle,
+             float& max_diff, int& n_mismatch)
+{
+  max_diff = 0;
+  n_mismatch = 0;
+  for (int row = 0; row<A.get_NRows(); row++)
+  {
+    for (int col = 0; col<A.get_NCols(); col++)
+    {
+      float a = A.get_data_element(row,col);
+      float b = B.get_data_element(row,col);
+      if ((a == NoDataValue) != (b == NoDataValue))
+      {
+        n_mismatch++;
+      }
+      else if (a != NoDataValue)
+      {
+        float diff = fabs(a-b);
+        if (is_angle)
+        {
+          diff = min(diff, 360-diff);
+        }
+        max_diff = max(max_diff, diff/max(float(fabs(b)),float(1)));
+      }
+    }
+  }
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=3)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the terrain kernel benchmark!            ||" << endl;
+    cout << "|| This times the fused 3x3 terrain derivatives        ||" << endl;
+    cout << "|| against the separate routines.                      ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires two inputs: " << endl;
+    cout << "* The number of rows, e.g. 2000." << endl;
+    cout << "* The number of columns, e.g. 2000." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  int NRows = atoi(argv[1]);
+  int NCols = atoi(argv[2]);
+  float NoDataValue = -9999;
+  float DataResolution = 10;
+
+  // a rough synthetic surface with some nodata holes in it
+  srand(1);
+  Array2D<float> zeta(NRows,NCols);
+  for (int row = 0; row<NRows; row++)
+  {
+    for (int col = 0; col<NCols; col++)
+    {
+      zeta[row][col] = 100+0.05*row+0.02*col+10*sin(0.01*row)*cos(0.013*col)
+                      +0.1*float(rand()%100);
+      if (rand()%20000 == 0)
+      {
+        zeta[row][col] = NoDataValue;
+      }
+    }
+  }
+  LSDRaster Topo(NRows,NCols,0,0,DataResolution,NoDataValue,zeta);
+
+  // the separate routines
+  double start = wall_time();
+  LSDRaster Hillshade = Topo.hillshade(45,315,1);
+  vector<int> polyfit_selection(8,0);
+  for (int k = 1; k<7; k++)
+  {
+    polyfit_selection[k] = 1;
+  }
+  vector<LSDRaster> Polyfit = Topo.calculate_polyfit_surface_metrics(sqrt(2)*DataResolution,
+                                                                     polyfit_selection);
+  double separate_time = wall_time()-start;
+
+  // the fused kernel
+  start = wall_time();
+  vector<int> selection(8,1);
+  vector<LSDRaster> Fused = Topo.calculate_terrain_derivatives(selection,45,315,1);
+  double fused_time = wall_time()-start;
+
+  // a direct D8 slope for reference
+  Array2D<float> d8(NRows,NCols,NoDataValue);
+  for (int row = 1; row<NRows-1; row++)
+  {
+    for (int col = 1; col<NCols-1; col++)
+    {
+      if (zeta[row][col] == NoDataValue)
+      {
+        continue;
+      }
+      float steepest = 0;
+      for (int dr = -1; dr<=1; dr++)
+      {
+        for (int dc = -1; dc<=1; dc++)
+        {
+          float zn = zeta[row+dr][col+dc];
+          if ((dr != 0 || dc != 0) && zn != NoDataValue)
+          {
+            float dist = (dr != 0 && dc != 0) ? sqrt(2.0)*DataResolution : DataResolution;
+            steepest = max(steepest, (zeta[row][col]-zn)/dist);
+          }
+        }
+      }
+      d8[row][col] = steepest;
+    }
+  }
+  LSDRaster D8(NRows,NCols,0,0,DataResolution,NoDataValue,d8);
+
+  cout << "separate_s\tfused_s\tspeedup" << endl;
+  cout << separate_time << "\t" << fused_time << "\t" << separate_time/fused_time << endl << endl;
+
+  string names[8] = {"slope", "aspect", "hillshade", "curvature", "planform",
+                     "profile", "tangential", "D8_slope"};
+  cout << "raster\tmax_rel_diff\tnodata_mismatches" << endl;
+  for (int k = 0; k<8; k++)
+  {
+    float max_diff;
+    int n_mismatch;
+    if (k == 2)
+    {
+      compare(Fused[k],Hillshade,NoDataValue,(k==1),max_diff,n_mismatch);
+    }
+    else if (k == 7)
+    {
+      compare(Fused[k],D8,NoDataValue,(k==1),max_diff,n_mismatch);
+    }
+    else
+    {
+      // the polyfit rasters start with the smoothed elevation
+      int polyfit_index = (k<2) ? k+1 : k;
+      compare(Fused[k],Polyfit[polyfit_index],NoDataValue,(k==1),max_diff,n_mismatch);
+    }
+    cout << names[k] << "\t" << max_diff << "\t" << n_mismatch << endl;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// tiled_hillshade_benchmark.cpp
+// A driver function for use with the Land Surace Dynamics Topo Toolbox
+// This program hillshades a DEM tile by tile with LSDRasterTiles, writing
+// the tiles into a single output raster, and compares the result and the
+// time taken with a hillshade of the whole DEM loaded at once.
+//
+// The arguments are:
+//  1) the path to the DEM (with a slash at the end)
+//  2) the name of the DEM without extension
+//  3) the extension of the DEM (bil, flt or asc)
+//  4) the tile size
+//
+// The hillshade uses a 3x3 neighbourhood so the halo is one cell. Cells on
+// the edge of the DEM are not compared, since the whole DEM hillshade leaves
+// them as nodata while a tile sees them as interior cells.
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdlib>
+#include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "../LSDRaster.hpp"
+#include "../LSDRasterTiles.hpp"
+#include "../LSDStatsTools.hpp"
+using namespace std;
+
+// wall clock time in seconds
+double wall_time()
+{
+  #ifdef _OPENMP
+  return omp_get_wtime();
+  #else
+  return double(clock())/double(CLOCKS_PER_SEC);
+  #endif
+}
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs!=5)
+  {
+    cout << "=========================================================" << endl;
+    cout << "|| Welcome to the tiled hillshade benchmark!           ||" << endl;
+    cout << "|| This compares tiled and whole raster hillshading.   ||" << endl;
+    cout << "=========================================================" << endl;
+    cout << "This program requires four inputs: " << endl;
+    cout << "* The path to the DEM, with a slash at the end." << endl;
+    cout << "* The name of the DEM without extension." << endl;
+    cout << "* The extension of the DEM (bil, flt or asc)." << endl;
+    cout << "* The tile size, e.g. 1024." << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  string path_name = FixPath(argv[1]);
+  string DEM_name = argv[2];
+  string DEM_ext = argv[3];
+  int TileSize = atoi(argv[4]);
+  string out_ext = (DEM_ext == "asc") ? "flt" : DEM_ext;
+  int Halo = 1;
+
+  double start = wall_time();
+  LSDRasterTiles Tiles(path_name+DEM_name, DEM_ext, TileSize, Halo);
+  Tiles.start_output(path_name+DEM_name+"_HS_tiled", out_ext);
+  for (int tile = 0; tile<Tiles.get_NTiles(); tile++)
+  {
+    LSDRaster Tile = Tiles.get_tile(tile);
+    LSDRaster TileHillshade = Tile.hillshade(45,315,1);
+    Tiles.write_tile(tile, TileHillshade);
+  }
+  double tiled_time = wall_time()-start;
+
+  start = wall_time();
+  LSDRaster topography_raster(path_name+DEM_name, DEM_ext);
+  LSDRaster whole_hillshade = topography_raster.hillshade(45,315,1);
+  double whole_time = wall_time()-start;
+
+  LSDRaster tiled_hillshade(path_name+DEM_name+"_HS_tiled", out_ext);
+  int NRows = whole_hillshade.get_NRows();
+  int NCols = whole_hillshade.get_NCols();
+  int n_mismatch = 0;
+  for (int row = 1; row<NRows-1; row++)
+  {
+    for (int col = 1; col<NCols-1; col++)
+    {
+      if (whole_hillshade.get_data_element(row,col) != tiled_hillshade.get_data_element(row,col))
+      {
+        n_mismatch++;
+      }
+    }
+  }
+
+  cout << "Number of tiles:        " << Tiles.get_NTiles() << endl;
+  cout << "Tiled hillshade took:   " << tiled_time << " s" << endl;
+  cout << "Whole hillshade took:   " << whole_time << " s" << endl;
+  cout << "Mismatched nodes:       " << n_mismatch << endl;
+
+  if (n_mismatch != 0)
+  {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+//
+// NCEP_embed.cpp
+// This program reads the NCEP reanalysis data in NCEP2.bin and writes them
+// as a header, LSDNCEPAtmosphere_data.hpp, so they can be compiled into the
+// cosmogenic programs with -DLSD_NCEP_EMBEDDED
+//
+// usage: ./NCEP_embed.exe path_to_atmospheric_data output_header
+// e.g.   ./NCEP_embed.exe ./ ../LSDNCEPAtmosphere_data.hpp
+//
+// Developed by:
+//  Simon M. Mudd
+//  Martin D. Hurst
+//  David T. Milodowski
+//  Stuart W.D. Grieve
+//  Declan A. Valters
+//  Fiona Clubb
+//
+// Copyright (C) 2026 Simon M. Mudd 2026
+//
+// Developer can be contacted by simon.m.mudd _at_ ed.ac.uk
+//
+//    Simon Mudd
+//    University of Edinburgh
+//    School of GeoSciences
+//    Drummond Street
+//    Edinburgh, EH8 9XP
+//    Scotland
+//    United Kingdom
+//
+// This program is free software;
+// you can redistribute it and/or modify it under the terms of the
+// GNU General Public License as published by the Free Software Foundation;
+// either version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY;
+// without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU General Public License for more details.
+//
+// You should have received a copy of the
+// GNU General Public License along with this program;
+// if not, write to:
+// Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor,
+// Boston, MA 02110-1301
+// USA
+//
+//=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "../LSDNCEPAtmosphere.hpp"
+using namespace std;
+
+int main (int nNumberofArgs,char *argv[])
+{
+  if (nNumberofArgs != 3)
+  {
+    cout << "=========================================================" << endl;
+    cout << "This program writes the NCEP atmospheric data to a header" << endl;
+    cout << "so they can be compiled in." << endl;
+    cout << "usage: ./NCEP_embed.exe path_to_atmospheric_data output_header" << endl;
+    cout << "e.g.   ./NCEP_embed.exe ./ ../LSDNCEPAtmosphere_data.hpp" << endl;
+    cout << "Then compile with -DLSD_NCEP_EMBEDDED" << endl;
+    cout << "=========================================================" << endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  string path_to_data = argv[1];
+  string output_header = argv[2];
+
+  // make sure the path ends with a slash
+  if (path_to_data.size() > 0 && path_to_data[path_to_data.size()-1] != '/')
+  {
+    path_to_data = path_to_data+"/";
+  }
+
+  const LSDNCEPAtmosphere& NCEP = LSDNCEPAtmosphere::get(path_to_data);
+  NCEP.write_embedded_table(output_header);
+  cout << "Wrote the NCEP data to " << output_header << endl;
+}
@@ -130,7 +130,7 @@ int main (int nNumberofArgs,char *argv[])
   //get d infinity flowdirection and flow area
   Array2D<float> dinf = FilledDEM.D_inf_FlowDir();
   LSDRaster dinf_rast = FilledDEM.LSDRasterTemplate(dinf);
-  LSDRaster DinfArea = FilledDEM.D_inf_units();
+  LSDRaster DinfArea = FilledDEM.D_inf_units(true);
   
   cout << "Starting hilltop flow routing\n" << endl;
   
@@ -19,6 +19,11 @@
 // Output data is stored in the input directory in a file called <DEM_Name>_Window_Size_Data.txt
 // and can be plotted using WindowSize.py  found at https://github.com/sgrieve/GeneralAnalysis/
 //
+// The surfaces for all of the window sizes are fitted in one pass over a filled
+// copy of the DEM. The filled DEM and the two coefficient rasters of each window
+// size that the curvature needs are written to temporary files in the input
+// directory, starting <DEM_Name>_PolyFitTmp, which are deleted at the end.
+//
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 // Stuart W.D. Grieve
 // University of Edinburgh
@@ -29,9 +34,11 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <cstdio>
 #include "../LSDStatsTools.hpp"
 #include "../LSDRaster.hpp"
 #include "../LSDIndexRaster.hpp"
+#include "../LSDRasterTiles.hpp"
 #include "../LSDShapeTools.hpp"
 
 int main(int nNumberofArgs, char *argv[])
@@ -48,17 +55,12 @@ int main(int nNumberofArgs, char *argv[])
   string DEM_Name = argv[2];
   string DEM_Format = argv[3];
     
-  //surface fitting
-  vector<int> raster_selection;
-  raster_selection.push_back(0);
-  raster_selection.push_back(0);  
-  raster_selection.push_back(0); 
-  raster_selection.push_back(1); //curvature
-
   //load the DEM and fill it
   LSDRaster DEM((path+DEM_Name), DEM_Format);
 	float MinSlope = 0.0001;
   LSDRaster FilledDEM = DEM.fill(MinSlope);
+  string Tmp_Name = path+DEM_Name+"_PolyFitTmp";
+  FilledDEM.write_raster(Tmp_Name, "flt");
 
   //set up a writer to write the output data
   ofstream WriteData;
@@ -76,6 +78,12 @@ int main(int nNumberofArgs, char *argv[])
   //this is a little arbritrary but reflects the sizes used by Roering et al. 2010
   int WindowSizes[] = {1, 2, 3, 4, 5, 7, 8, 10,15,20,25,50,70,90,100};
   
+  //fit the surfaces for every window size in one pass over the filled DEM,
+  //keeping only the coefficients of x^2 and y^2
+  vector<float> WindowRadii(WindowSizes, WindowSizes+15);
+  LSDRasterTiles FilledTiles(Tmp_Name, "flt", 1024, 0);
+  FilledTiles.write_polyfit_coefficients(WindowRadii, "ab", Tmp_Name, "flt");
+  
   // floats to hold the stats about the fitted surface
   float Curv_mean;
   float Curv_stddev;
@@ -90,8 +98,19 @@ int main(int nNumberofArgs, char *argv[])
     
     cout << "Processing surface " << w+1 << " of " << "15" << endl;
                                             
-    vector<LSDRaster> Surfaces = FilledDEM.calculate_polyfit_surface_metrics(WindowSizes[w], raster_selection);
-    LSDRaster curvature = Surfaces[3];   
+    //curvature is 2a+2b, from the coefficients of x^2 and y^2
+    stringstream radius_ss;
+    radius_ss << WindowRadii[w];
+    string coef_a_name = Tmp_Name+"_polyfit_a_R"+radius_ss.str();
+    string coef_b_name = Tmp_Name+"_polyfit_b_R"+radius_ss.str();
+    LSDRaster coef_a(coef_a_name, "flt");
+    LSDRaster coef_b(coef_b_name, "flt");
+
+    //the coefficient rasters are not needed again
+    remove((coef_a_name+".flt").c_str());
+    remove((coef_a_name+".hdr").c_str());
+    remove((coef_b_name+".flt").c_str());
+    remove((coef_b_name+".hdr").c_str());
   
     //reset values for next run
     Curv_mean = 0;
@@ -104,10 +123,10 @@ int main(int nNumberofArgs, char *argv[])
     Curv_vec.clear();  
   
     //go through the landscape and get every curvature value into a 1D vector    
-    for (int i = 0; i < int(curvature.get_NRows()); ++i){
-      for (int j = 0; j < int(curvature.get_NCols()); ++j){
-        if (curvature.get_data_element(i,j) != curvature.get_NoDataValue()){
-          Curv_vec.push_back(curvature.get_data_element(i,j));
+    for (int i = 0; i < int(coef_a.get_NRows()); ++i){
+      for (int j = 0; j < int(coef_a.get_NCols()); ++j){
+        if (coef_a.get_data_element(i,j) != coef_a.get_NoDataValue()){
+          Curv_vec.push_back(2*coef_a.get_data_element(i,j)+2*coef_b.get_data_element(i,j));
         }
       }
     }  
@@ -124,4 +143,7 @@ int main(int nNumberofArgs, char *argv[])
                                           
   WriteData.close();
 
+  //nor is the filled DEM
+  remove((Tmp_Name+".flt").c_str());
+  remove((Tmp_Name+".hdr").c_str());
 }
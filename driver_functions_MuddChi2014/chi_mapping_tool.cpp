@@ -161,6 +161,7 @@ int main (int nNumberofArgs,char *argv[])
   bool_default_map["print_junctions_to_csv"] = false;
   bool_default_map["print_fill_raster"] = false;
   bool_default_map["print_DrainageArea_raster"] = false;
+  bool_default_map["use_FlowInfo_binary_cache"] = false;  // reuse the flow routing from an earlier run with the same OUT_ID
   bool_default_map["write_hillshade"] = false;
   bool_default_map["print_basic_M_chi_map_to_csv"] = false;
 
@@ -243,6 +244,8 @@ int main (int nNumberofArgs,char *argv[])
   int_default_map["target_nodes"] = 80;
   int_default_map["skip"] = 2;
   float_default_map["sigma"] = 20;
+  // seeds the Monte Carlo sampling of the segments, so a run can be repeated
+  int_default_map["random_seed"] = 1;
 
   // switches for chi analysis
   // These just print simple chi maps
@@ -454,6 +457,7 @@ int main (int nNumberofArgs,char *argv[])
   float sigma = this_float_map["sigma"];
   int target_nodes = this_int_map["target_nodes"];
   int skip = this_int_map["skip"];
+  long random_seed = this_int_map["random_seed"];
   int threshold_contributing_pixels = this_int_map["threshold_contributing_pixels"];
   int minimum_basin_size_pixels = this_int_map["minimum_basin_size_pixels"];
   int basic_Mchi_regression_nodes = this_int_map["basic_Mchi_regression_nodes"];
@@ -622,8 +626,66 @@ int main (int nNumberofArgs,char *argv[])
 
 
   cout << "\t Flow routing..." << endl;
-  // get a flow info object
-  LSDFlowInfo FlowInfo(boundary_conditions,filled_topography);
+  // get a flow info object. If the binary cache is switched on the flow routing
+  // is loaded from an earlier run, as long as it was calculated from the same
+  // filled DEM, with the same fill settings and boundary conditions. These are
+  // hashed and the hash is stored in the .FIbin header; if it doesn't match
+  // the cache counts as a miss.
+  LSDFlowInfo FlowInfo;
+  bool FlowInfo_is_loaded = false;
+  string FlowInfo_cache_name = OUT_DIR+OUT_ID+"_FlowInfo";
+  uint64_t FlowInfo_source_hash = 0;
+  if (this_bool_map["use_FlowInfo_binary_cache"])
+  {
+    int fill_NRows = filled_topography.get_NRows();
+    int fill_NCols = filled_topography.get_NCols();
+    float georef[3] = { filled_topography.get_XMinimum(), filled_topography.get_YMinimum(),
+                        filled_topography.get_DataResolution() };
+    float fill_slope = this_float_map["min_slope_for_fill"];
+    int is_filled = (this_bool_map["raster_is_filled"]) ? 1 : 0;
+
+    FlowInfo_source_hash = fnv1a_hash(&fill_NRows, sizeof(fill_NRows));
+    FlowInfo_source_hash = fnv1a_hash(&fill_NCols, sizeof(fill_NCols), FlowInfo_source_hash);
+    FlowInfo_source_hash = fnv1a_hash(georef, sizeof(georef), FlowInfo_source_hash);
+    FlowInfo_source_hash = fnv1a_hash(&fill_slope, sizeof(fill_slope), FlowInfo_source_hash);
+    FlowInfo_source_hash = fnv1a_hash(&is_filled, sizeof(is_filled), FlowInfo_source_hash);
+    for (int i = 0; i< int(boundary_conditions.size()); i++)
+    {
+      FlowInfo_source_hash = fnv1a_hash(boundary_conditions[i].c_str(),
+                                        boundary_conditions[i].size()+1, FlowInfo_source_hash);
+    }
+    // the rows of an Array2D are one contiguous block
+    Array2D<float> filled_data = filled_topography.get_RasterData();
+    if (fill_NRows > 0 && fill_NCols > 0)
+    {
+      FlowInfo_source_hash = fnv1a_hash(&filled_data[0][0],
+                                        size_t(fill_NRows)*size_t(fill_NCols)*sizeof(float),
+                                        FlowInfo_source_hash);
+    }
+
+    // the file is mapped read only and checked in place. The junction network
+    // and chi tools need an LSDFlowInfo, so it is then copied into one
+    LSDFlowInfoView FlowInfo_view;
+    if (LSDFlowInfo::unpickle_binary(FlowInfo_cache_name, FlowInfo_source_hash, FlowInfo_view))
+    {
+      cout << "\t Mapped the flow routing from " << FlowInfo_cache_name << ".FIbin, "
+           << FlowInfo_view.get_NDataNodes() << " nodes" << endl;
+      FlowInfo = LSDFlowInfo(FlowInfo_view);
+      FlowInfo_is_loaded = true;
+    }
+    else
+    {
+      cout << "\t No cached flow routing for this DEM and these settings, I'll calculate it." << endl;
+    }
+  }
+  if (FlowInfo_is_loaded == false)
+  {
+    FlowInfo = LSDFlowInfo(boundary_conditions,filled_topography);
+    if (this_bool_map["use_FlowInfo_binary_cache"])
+    {
+      FlowInfo.pickle_binary(FlowInfo_cache_name, FlowInfo_source_hash);
+    }
+  }
 
   // calculate the flow accumulation
   cout << "\t Calculating flow accumulation (in pixels)..." << endl;
@@ -1186,7 +1248,8 @@ int main (int nNumberofArgs,char *argv[])
       ChiTool.chi_map_automator(FlowInfo, source_nodes, outlet_nodes, baselevel_node_of_each_basin,
                             filled_topography, DistanceFromOutlet,
                             DrainageArea, chi_coordinate, target_nodes,
-                            n_iterations, skip, minimum_segment_length, sigma);
+                            n_iterations, skip, minimum_segment_length, sigma,
+                            random_seed);
       ChiTool.segment_counter(FlowInfo, maximum_segment_length);
       if (this_bool_map["print_segments_raster"])
       {
@@ -1200,7 +1263,8 @@ int main (int nNumberofArgs,char *argv[])
       ChiTool.chi_map_automator(FlowInfo, source_nodes, outlet_nodes, baselevel_node_of_each_basin,
                             filled_topography, DistanceFromOutlet,
                             DrainageArea, chi_coordinate, target_nodes,
-                            n_iterations, skip, minimum_segment_length, sigma);
+                            n_iterations, skip, minimum_segment_length, sigma,
+                            random_seed);
     }
 
     string csv_full_fname = OUT_DIR+OUT_ID+"_MChiSegmented.csv";
@@ -1865,7 +1929,8 @@ int main (int nNumberofArgs,char *argv[])
     ChiTool.chi_map_automator(FlowInfo, source_nodes, outlet_nodes, baselevel_node_of_each_basin,
                           filled_topography, DistanceFromOutlet,
                           DrainageArea, chi_coordinate, target_nodes,
-                          n_iterations, skip, minimum_segment_length, sigma);
+                          n_iterations, skip, minimum_segment_length, sigma,
+                          random_seed);
     ChiTool.segment_counter(FlowInfo, maximum_segment_length);
  
 